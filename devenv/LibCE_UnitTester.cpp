@@ -1,4 +1,10 @@
 ﻿#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
 #include "Indices.h"
 #include "RingedFrames.h"
 #include "Assertions.h"
@@ -10,6 +16,21 @@
 #include "Decoders.h"
 #include "bits.h"
 #include "Timers.h"
+#include "SpscFrames.h"
+#include "PackedFrames.h"
+#include "MappedFrames.h"
+#include "MergedFrames.h"
+#include "MpscFrames.h"
+#include "CompressedFrames.h"
+#include "WindowedAggregates.h"
+#include "CompactMap.h"
+#include "HashMap.h"
+
+// C11のアトミック操作(stdatomic.h)を使うモジュールは、stdatomic.hが無い
+// Visual Studio(v142)のLibCEプロジェクトではビルドしないので、試験もしない
+#if !defined(_MSC_VER)
+#define HAS_STDATOMIC
+#endif
 
 static int32_t ShowResults(const Assertions* assertions)
 {
@@ -43,6 +64,798 @@ static int32_t ShowResults(const Assertions* assertions)
 	return result;
 }
 
+/* -------------------------------------------------------------------
+*	Multi-thread tests
+*/
+
+#ifdef HAS_STDATOMIC
+// SPSCを別スレッドのPush/Popで回し、順序と内容が保たれることを確認する
+static void SpscFrames_StressTest(void)
+{
+	Assertions* assertions = Assertions_Instance();
+	const int32_t capacity = 64;
+	const int32_t frameSize = 32;
+	const int64_t frames = 1000000;
+	static int32_t buffer[SPSC_NEEDED_BUFFER_WORDS(64, 32)];
+	SpscFrames ring;
+	SpscFrames_Init(capacity, frameSize, buffer, &ring);
+
+	std::thread producer([&]()
+		{
+			uint8_t frame[32];
+			for (int64_t seq = 0; seq < frames; seq++)
+			{
+				// 長さと内容を連番から決める
+				int32_t length = (int32_t)(sizeof(int64_t) + 1 + (seq % (frameSize - 9)));
+				memset(frame, (int)(seq & 0xff), sizeof frame);
+				memcpy(frame, &seq, sizeof seq);
+				while (SpscFrames_Push(frame, length, seq, &ring) == 0)
+				{
+					std::this_thread::yield();
+				}
+			}
+		});
+
+	int64_t errors = 0;
+	uint8_t frame[32];
+	for (int64_t seq = 0; seq < frames; )
+	{
+		int64_t timestamp;
+		int32_t length = SpscFrames_Pop(frame, sizeof frame, &timestamp, &ring);
+		if (length < 0)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+		int64_t payloadSeq;
+		memcpy(&payloadSeq, frame, sizeof payloadSeq);
+		int32_t expectedLength = (int32_t)(sizeof(int64_t) + 1 + (seq % (frameSize - 9)));
+		if ((timestamp != seq) ||
+			(payloadSeq != seq) ||
+			(length != expectedLength) ||
+			(frame[length - 1] != (uint8_t)(seq & 0xff)))
+		{
+			errors += 1;
+		}
+		seq += 1;
+	}
+	producer.join();
+
+	Assertions_Assert(errors == 0, assertions);
+	Assertions_Assert(SpscFrames_Count(&ring) == 0, assertions);
+}
+#endif
+
+#ifdef HAS_STDATOMIC
+// MPSCに複数スレッドからPushし、生産者ごとの順序と内容が保たれることを確認する
+static void MpscFrames_StressTest(void)
+{
+	Assertions* assertions = Assertions_Instance();
+	const int32_t capacity = 64;
+	const int32_t frameSize = 32;
+	const int32_t producerCount = 4;
+	const int64_t framesPerProducer = 250000;
+	alignas(8) static int32_t buffer[MPSC_NEEDED_BUFFER_WORDS(64, 32)];
+	MpscFrames ring;
+	MpscFrames_Init(capacity, frameSize, buffer, &ring);
+
+	std::vector<std::thread> producers;
+	for (int32_t pi = 0; pi < producerCount; pi++)
+	{
+		producers.emplace_back([&, pi]()
+			{
+				uint8_t frame[32];
+				for (int64_t seq = 0; seq < framesPerProducer; seq++)
+				{
+					// 長さと内容を生産者と連番から決める
+					int32_t length = (int32_t)(sizeof(int64_t) + 1 + ((seq + pi) % (frameSize - 9)));
+					memset(frame, (int)((seq + pi) & 0xff), sizeof frame);
+					memcpy(frame, &seq, sizeof seq);
+					int64_t timestamp = ((int64_t)pi << 32) | seq;
+					while (MpscFrames_Push(frame, length, timestamp, &ring) == 0)
+					{
+						std::this_thread::yield();
+					}
+				}
+			});
+	}
+
+	int64_t errors = 0;
+	int64_t nextSeqs[4] = { 0 };
+	uint8_t frame[32];
+	for (int64_t popped = 0; popped < framesPerProducer * producerCount; )
+	{
+		int64_t timestamp;
+		int32_t length = MpscFrames_Pop(frame, sizeof frame, &timestamp, &ring);
+		if (length < 0)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+		int32_t pi = (int32_t)(timestamp >> 32);
+		int64_t seq = timestamp & 0xffffffffLL;
+		int64_t payloadSeq;
+		memcpy(&payloadSeq, frame, sizeof payloadSeq);
+		int32_t expectedLength = (int32_t)(sizeof(int64_t) + 1 + ((seq + pi) % (frameSize - 9)));
+		if ((pi < 0) || (producerCount <= pi) ||
+			(seq != nextSeqs[pi]) ||
+			(payloadSeq != seq) ||
+			(length != expectedLength) ||
+			(frame[length - 1] != (uint8_t)((seq + pi) & 0xff)))
+		{
+			errors += 1;
+		}
+		else
+		{
+			nextSeqs[pi] += 1;
+		}
+		popped += 1;
+	}
+	for (auto& producer : producers)
+	{
+		producer.join();
+	}
+
+	Assertions_Assert(errors == 0, assertions);
+	Assertions_Assert(MpscFrames_Count(&ring) == 0, assertions);
+}
+#endif
+
+#ifdef RF_SEQLOCK
+// Pushし続けるRingedFramesを、複数スレッドからReadStableで読み、壊れたフレームを受け取らないことを確認する
+static void RingedFrames_ReadStableStressTest(void)
+{
+	Assertions* assertions = Assertions_Instance();
+	const int32_t capacity = 8;
+	const int32_t frameSize = 64;
+	const int64_t frames = 1000000;
+	const int32_t readerCount = 2;
+	static int32_t buffer[RF_NEEDED_BUFFER_WORDS(8, 64)];
+	RingedFrames ring;
+	RingedFrames_Init(capacity, frameSize, buffer, &ring);
+
+	std::atomic<bool> done(false);
+	std::atomic<int64_t> errors(0);
+	std::vector<std::thread> readers;
+	for (int32_t ri = 0; ri < readerCount; ri++)
+	{
+		readers.emplace_back([&, ri]()
+			{
+				uint8_t data[64];
+				while (!done.load())
+				{
+					// 最新と、上書きされかけている最古に近いフレームを読む
+					int64_t updateCount = RingedFrames_UpdateCount(&ring);
+					int64_t updateNumber = updateCount - 1 - (ri * (capacity - 1));
+					int64_t timestamp;
+					int32_t length = RingedFrames_ReadStable(updateNumber, data, sizeof data, &timestamp, &ring);
+					if (length >= 0)
+					{
+						// 内容は全て更新番号から決まる
+						int32_t expectedLength = (int32_t)(1 + (updateNumber % frameSize));
+						int broken = (timestamp != updateNumber) || (length != expectedLength);
+						for (int32_t i = 0; (i < length) && (broken == 0); i++)
+						{
+							broken = (data[i] != (uint8_t)(updateNumber & 0xff));
+						}
+						if (broken != 0)
+						{
+							errors.fetch_add(1);
+						}
+					}
+					std::this_thread::yield();
+				}
+			});
+	}
+
+	uint8_t frame[64];
+	for (int64_t seq = 0; seq < frames; seq++)
+	{
+		memset(frame, (int)(seq & 0xff), sizeof frame);
+		RingedFrames_Push(frame, (int32_t)(1 + (seq % frameSize)), seq, &ring);
+	}
+	done.store(true);
+	for (auto& reader : readers)
+	{
+		reader.join();
+	}
+
+	Assertions_Assert(errors.load() == 0, assertions);
+	Assertions_Assert(RingedFrames_UpdateCount(&ring) == frames, assertions);
+}
+#endif
+
+/* -------------------------------------------------------------------
+*	Benchmarks
+*/
+
+// 処理時間を秒で計測する
+template <typename F>
+static double MeasureSeconds(F func)
+{
+	auto start = std::chrono::steady_clock::now();
+	func();
+	auto end = std::chrono::steady_clock::now();
+	return std::chrono::duration<double>(end - start).count();
+}
+
+// 計測結果を表示する
+static void ShowThroughput(const char* name, int64_t count, double seconds)
+{
+	std::cout
+		<< name << ": "
+		<< (int64_t)((double)count / seconds) << " frames/s"
+		<< std::endl;
+}
+
+#ifdef HAS_STDATOMIC
+// 2スレッド間の受け渡しを、mutex付きRingedFramesとSPSCで比較する
+static void SpscFrames_Benchmark(void)
+{
+	const int64_t frames = 10000000;
+	static int32_t buffer[RF_NEEDED_BUFFER_WORDS(1024, 64)];
+	uint8_t frame[64] = { 0 };
+
+	// mutexで保護したRingedFrames
+	{
+		RingedFrames ring;
+		std::mutex mutex;
+		RingedFrames_Init(1024, 64, buffer, &ring);
+		double seconds = MeasureSeconds([&]()
+			{
+				std::thread producer([&]()
+					{
+						for (int64_t seq = 0; seq < frames; )
+						{
+							std::unique_lock<std::mutex> lock(mutex);
+							if (RingedFrames_Count(&ring) < RingedFrames_Capacity(&ring))
+							{
+								RingedFrames_Push(frame, sizeof frame, seq, &ring);
+								seq += 1;
+							}
+							else
+							{
+								lock.unlock();
+								std::this_thread::yield();
+							}
+						}
+					});
+				uint8_t data[64];
+				for (int64_t seq = 0; seq < frames; )
+				{
+					std::unique_lock<std::mutex> lock(mutex);
+					if (RingedFrames_Pop(data, sizeof data, nullptr, &ring) >= 0)
+					{
+						seq += 1;
+					}
+					else
+					{
+						lock.unlock();
+						std::this_thread::yield();
+					}
+				}
+				producer.join();
+			});
+		ShowThroughput("RingedFrames + mutex", frames, seconds);
+	}
+
+	// SPSC
+	{
+		SpscFrames ring;
+		SpscFrames_Init(1024, 64, buffer, &ring);
+		double seconds = MeasureSeconds([&]()
+			{
+				std::thread producer([&]()
+					{
+						for (int64_t seq = 0; seq < frames; )
+						{
+							if (SpscFrames_Push(frame, sizeof frame, seq, &ring) != 0)
+							{
+								seq += 1;
+							}
+							else
+							{
+								std::this_thread::yield();
+							}
+						}
+					});
+				uint8_t data[64];
+				for (int64_t seq = 0; seq < frames; )
+				{
+					if (SpscFrames_Pop(data, sizeof data, nullptr, &ring) >= 0)
+					{
+						seq += 1;
+					}
+					else
+					{
+						std::this_thread::yield();
+					}
+				}
+				producer.join();
+			});
+		ShowThroughput("SpscFrames", frames, seconds);
+	}
+}
+#endif
+
+// 1フレームずつのPush/Popと、まとめてのPush/Popを比較する
+static void RingedFrames_BatchBenchmark(void)
+{
+	const int32_t batch = 64;
+	const int64_t rounds = 200000;
+	static int32_t buffer[RF_NEEDED_BUFFER_WORDS(1000, 64)];
+	static uint8_t frames[64][64];
+	const void* framePointers[64];
+	int32_t lengths[64];
+	int64_t timestamps[64];
+	static uint8_t data[64 * 64];
+	for (int32_t i = 0; i < batch; i++)
+	{
+		memset(frames[i], i, sizeof frames[i]);
+		framePointers[i] = frames[i];
+		lengths[i] = 1 + (i % 64);
+		timestamps[i] = i;
+	}
+
+	// 1フレームずつ
+	{
+		RingedFrames ring;
+		RingedFrames_Init(1000, 64, buffer, &ring);
+		double seconds = MeasureSeconds([&]()
+			{
+				for (int64_t round = 0; round < rounds; round++)
+				{
+					for (int32_t i = 0; i < batch; i++)
+					{
+						RingedFrames_Push(framePointers[i], lengths[i], timestamps[i], &ring);
+					}
+					for (int32_t i = 0; i < batch; i++)
+					{
+						RingedFrames_Pop(&data[64 * i], 64, &timestamps[i], &ring);
+					}
+				}
+			});
+		ShowThroughput("RingedFrames Push/Pop", rounds * batch, seconds);
+	}
+
+	// まとめて
+	{
+		RingedFrames ring;
+		RingedFrames_Init(1000, 64, buffer, &ring);
+		double seconds = MeasureSeconds([&]()
+			{
+				for (int64_t round = 0; round < rounds; round++)
+				{
+					RingedFrames_PushBatch(framePointers, lengths, timestamps, batch, &ring);
+					RingedFrames_PopBatch(data, sizeof data, lengths, timestamps, batch, &ring);
+				}
+			});
+		ShowThroughput("RingedFrames PushBatch/PopBatch", rounds * batch, seconds);
+	}
+}
+
+// 最大蓄積可能フレーム数が2のべき乗(マスク)の場合と、そうでない場合(分岐)を比較する
+static void RingedFrames_Pow2Benchmark(void)
+{
+	const int64_t frames = 20000000;
+	static int32_t buffer[RF_NEEDED_BUFFER_WORDS(1024, 16)];
+	uint8_t frame[16] = { 0 };
+	const int32_t capacities[] = { 1000, 1024 };
+	const char* names[] = { "RingedFrames capacity 1000", "RingedFrames capacity 1024" };
+
+	for (int32_t ci = 0; ci < 2; ci++)
+	{
+		RingedFrames ring;
+		RingedFrames_Init(capacities[ci], 16, buffer, &ring);
+		int64_t sum = 0;
+		double seconds = MeasureSeconds([&]()
+			{
+				for (int64_t seq = 0; seq < frames; seq++)
+				{
+					RingedFrames_Push(frame, sizeof frame, seq, &ring);
+					int64_t timestamp;
+					RingedFrames_ReferWithOld((int32_t)(seq & 511), nullptr, &timestamp, &ring);
+					sum += timestamp;
+				}
+			});
+		ShowThroughput(names[ci], frames, seconds);
+		// 最適化で消されないように結果を使う
+		if (sum == 0)
+		{
+			std::cout << "(no frames)" << std::endl;
+		}
+	}
+}
+
+#ifdef HAS_STDATOMIC
+// 複数の生産者から1つの消費者への受け渡しを、mutex付きRingedFramesとMPSCで比較する
+static void MpscFrames_Benchmark(void)
+{
+	const int64_t frames = 2000000;
+	alignas(8) static int32_t buffer[RF_NEEDED_BUFFER_WORDS(1024, 64)];
+	const int32_t producerCounts[] = { 1, 2, 4, 8, 16 };
+
+	for (int32_t producerCount : producerCounts)
+	{
+		const int64_t framesPerProducer = frames / producerCount;
+		const int64_t total = framesPerProducer * producerCount;
+		std::cout << "producers " << producerCount << std::endl;
+
+		// mutexで保護したRingedFrames
+		{
+			RingedFrames ring;
+			std::mutex mutex;
+			RingedFrames_Init(1024, 64, buffer, &ring);
+			double seconds = MeasureSeconds([&]()
+				{
+					std::vector<std::thread> producers;
+					for (int32_t pi = 0; pi < producerCount; pi++)
+					{
+						producers.emplace_back([&]()
+							{
+								uint8_t frame[64] = { 0 };
+								for (int64_t seq = 0; seq < framesPerProducer; )
+								{
+									std::unique_lock<std::mutex> lock(mutex);
+									if (RingedFrames_Count(&ring) < RingedFrames_Capacity(&ring))
+									{
+										RingedFrames_Push(frame, sizeof frame, seq, &ring);
+										seq += 1;
+									}
+									else
+									{
+										lock.unlock();
+										std::this_thread::yield();
+									}
+								}
+							});
+					}
+					uint8_t data[64];
+					for (int64_t seq = 0; seq < total; )
+					{
+						std::unique_lock<std::mutex> lock(mutex);
+						if (RingedFrames_Pop(data, sizeof data, nullptr, &ring) >= 0)
+						{
+							seq += 1;
+						}
+						else
+						{
+							lock.unlock();
+							std::this_thread::yield();
+						}
+					}
+					for (auto& producer : producers)
+					{
+						producer.join();
+					}
+				});
+			ShowThroughput("  RingedFrames + mutex", total, seconds);
+		}
+
+		// MPSC
+		{
+			MpscFrames ring;
+			MpscFrames_Init(1024, 64, buffer, &ring);
+			double seconds = MeasureSeconds([&]()
+				{
+					std::vector<std::thread> producers;
+					for (int32_t pi = 0; pi < producerCount; pi++)
+					{
+						producers.emplace_back([&]()
+							{
+								uint8_t frame[64] = { 0 };
+								for (int64_t seq = 0; seq < framesPerProducer; )
+								{
+									if (MpscFrames_Push(frame, sizeof frame, seq, &ring) != 0)
+									{
+										seq += 1;
+									}
+									else
+									{
+										std::this_thread::yield();
+									}
+								}
+							});
+					}
+					uint8_t data[64];
+					for (int64_t seq = 0; seq < total; )
+					{
+						if (MpscFrames_Pop(data, sizeof data, nullptr, &ring) >= 0)
+						{
+							seq += 1;
+						}
+						else
+						{
+							std::this_thread::yield();
+						}
+					}
+					for (auto& producer : producers)
+					{
+						producer.join();
+					}
+				});
+			ShowThroughput("  MpscFrames", total, seconds);
+		}
+	}
+}
+#endif
+
+// 直近の窓の合計、最小値、最大値を、Pushのたびに全走査する場合と、窓集計で差分更新する場合を比較する
+static void WindowedAggregates_Benchmark(void)
+{
+	const int32_t window = 1024;
+	const int64_t frames = 200000;
+	static int32_t ringBuffer[RF_NEEDED_BUFFER_WORDS(1024, 8)];
+	static int64_t aggregatesBuffer[WA_NEEDED_BUFFER_WORDS(1024) / 2];
+
+	// 全走査
+	{
+		RingedFrames ring;
+		RingedFrames_Init(window, sizeof(int64_t), ringBuffer, &ring);
+		int64_t check = 0;
+		double seconds = MeasureSeconds([&]()
+			{
+				for (int64_t seq = 0; seq < frames; seq++)
+				{
+					int64_t value = (seq * 7919) % 1000;
+					RingedFrames_Push(&value, sizeof value, seq, &ring);
+					int64_t sum = 0;
+					int64_t minValue = INT64_MAX;
+					int64_t maxValue = INT64_MIN;
+					int32_t count = RingedFrames_Count(&ring);
+					for (int32_t i = 0; i < count; i++)
+					{
+						int64_t v;
+						memcpy(&v, RingedFrames_ReferWithOld(i, nullptr, nullptr, &ring), sizeof v);
+						sum += v;
+						minValue = (v < minValue) ? v : minValue;
+						maxValue = (v > maxValue) ? v : maxValue;
+					}
+					check += sum + minValue + maxValue;
+				}
+			});
+		ShowThroughput("RingedFrames rescan window", frames, seconds);
+		// 最適化で消されないように結果を使う
+		if (check == 0)
+		{
+			std::cout << "(no frames)" << std::endl;
+		}
+	}
+
+	// 窓集計
+	{
+		WindowedAggregates aggregates;
+		WindowedAggregates_Init(window, 0, (int32_t*)aggregatesBuffer, &aggregates);
+		int64_t check = 0;
+		double seconds = MeasureSeconds([&]()
+			{
+				for (int64_t seq = 0; seq < frames; seq++)
+				{
+					int64_t value = (seq * 7919) % 1000;
+					WindowedAggregates_Push(value, seq, &aggregates);
+					int64_t minValue;
+					int64_t maxValue;
+					WindowedAggregates_Min(&minValue, &aggregates);
+					WindowedAggregates_Max(&maxValue, &aggregates);
+					check += WindowedAggregates_Sum(&aggregates) + minValue + maxValue;
+				}
+			});
+		ShowThroughput("WindowedAggregates", frames, seconds);
+		if (check == 0)
+		{
+			std::cout << "(no frames)" << std::endl;
+		}
+	}
+}
+
+// Mapへの挿入
+static void Map_InsertBenchmark(void)
+{
+	const int32_t count = 100000;
+	static MapElm elements[100000];
+
+	// 検索してから挿入(rootから2回辿る)
+	{
+		Map map;
+		Map_Init(count, elements, &map);
+		double seconds = MeasureSeconds([&]()
+			{
+				for (int32_t i = 0; i < count; i++)
+				{
+					MapKey_t key = (MapKey_t)(((int64_t)i * 7919) % count);
+					AvlNode* existing = AvlTree_Search(key, map.Root);
+					if (existing == nullptr)
+					{
+						MapElm* elm = &map.Elements[map.Count];
+						AvlNode_Init(key, nullptr, &elm->Node);
+						map.Root = AvlTree_Insert(&elm->Node, map.Root);
+						map.Count += 1;
+					}
+				}
+			});
+		ShowThroughput("AvlTree Search + Insert", count, seconds);
+	}
+
+	// 1回辿って挿入
+	{
+		Map map;
+		Map_Init(count, elements, &map);
+		double seconds = MeasureSeconds([&]()
+			{
+				for (int32_t i = 0; i < count; i++)
+				{
+					MapKey_t key = (MapKey_t)(((int64_t)i * 7919) % count);
+					Map_Emplace(key, &map);
+				}
+			});
+		ShowThroughput("Map_Emplace", count, seconds);
+		if (Map_Count(&map) != count)
+		{
+			std::cout << "(lost keys)" << std::endl;
+		}
+	}
+
+	// 配列から一括構築
+	{
+		static MapKey_t sortedKeys[100000];
+		static MapKey_t unsortedKeys[100000];
+		static const void* values[100000];
+		for (int32_t i = 0; i < count; i++)
+		{
+			sortedKeys[i] = i;
+			unsortedKeys[i] = (MapKey_t)(((int64_t)i * 7919) % count);
+			values[i] = nullptr;
+		}
+		Map map;
+		Map_Init(count, elements, &map);
+		double seconds = MeasureSeconds([&]()
+			{
+				Map_BuildFromSorted(sortedKeys, values, count, &map);
+			});
+		ShowThroughput("Map_BuildFromSorted", count, seconds);
+		seconds = MeasureSeconds([&]()
+			{
+				Map_BuildFromUnsorted(unsortedKeys, values, count, &map);
+			});
+		ShowThroughput("Map_BuildFromUnsorted", count, seconds);
+		if (Map_Count(&map) != count)
+		{
+			std::cout << "(lost keys)" << std::endl;
+		}
+	}
+}
+
+// Mapの検索
+static void Map_SearchBenchmark(void)
+{
+	const int32_t count = 1000000;
+	const int64_t lookups = 2000000;
+	std::vector<MapElm> elements((size_t)count);
+	std::vector<CompactMapNode> nodes((size_t)count);
+	std::vector<const void*> values((size_t)count);
+	const int32_t slotCount = 2 * 1024 * 1024;
+	std::vector<HashMapElm> slots((size_t)slotCount);
+	std::vector<uint8_t> controls((size_t)slotCount);
+	Map map;
+	CompactMap compact;
+	HashMap hash;
+	Map_Init(count, elements.data(), &map);
+	CompactMap_Init(count, nodes.data(), values.data(), &compact);
+	HashMap_Init(slotCount, slots.data(), controls.data(), &hash);
+	for (int32_t i = 0; i < count; i++)
+	{
+		MapKey_t key = (MapKey_t)(((int64_t)i * 7919) % count);
+		Map_Relate(&values[(size_t)key], key, &map);
+		CompactMap_Relate(&values[(size_t)key], key, &compact);
+		HashMap_Relate(&values[(size_t)key], key, &hash);
+	}
+	std::cout << "Map search (" << count << " keys, "
+		<< sizeof(MapElm) << " vs " << (sizeof(CompactMapNode) + sizeof(const void*)) << " bytes/entry)" << std::endl;
+
+	int64_t hits = 0;
+	double seconds = MeasureSeconds([&]()
+		{
+			for (int64_t i = 0; i < lookups; i++)
+			{
+				MapKey_t key = (MapKey_t)((i * 104729) % count);
+				hits += (Map_ValueFor(key, &map) != nullptr) ? 1 : 0;
+			}
+		});
+	ShowThroughput("  Map_ValueFor", lookups, seconds);
+	seconds = MeasureSeconds([&]()
+		{
+			for (int64_t i = 0; i < lookups; i++)
+			{
+				MapKey_t key = (MapKey_t)((i * 104729) % count);
+				hits += (CompactMap_ValueFor(key, &compact) != nullptr) ? 1 : 0;
+			}
+		});
+	ShowThroughput("  CompactMap_ValueFor", lookups, seconds);
+	seconds = MeasureSeconds([&]()
+		{
+			for (int64_t i = 0; i < lookups; i++)
+			{
+				MapKey_t key = (MapKey_t)((i * 104729) % count);
+				hits += (HashMap_ValueFor(key, &hash) != nullptr) ? 1 : 0;
+			}
+		});
+	ShowThroughput("  HashMap_ValueFor", lookups, seconds);
+	if (hits != lookups * 3)
+	{
+		std::cout << "(lost keys)" << std::endl;
+	}
+}
+
+// 凍結したMapの検索
+static void Map_FrozenBenchmark(void)
+{
+	const int32_t counts[] = { 1000, 100000, 10000000 };
+	const int64_t lookups = 2000000;
+	for (int32_t count : counts)
+	{
+		std::vector<MapElm> elements((size_t)count);
+		std::vector<MapKey_t> keys((size_t)count);
+		std::vector<const void*> values((size_t)count);
+		std::vector<MapKey_t> frozenKeys((size_t)MAP_FROZEN_SLOTS(count));
+		std::vector<const void*> frozenValues((size_t)MAP_FROZEN_SLOTS(count));
+		for (int32_t i = 0; i < count; i++)
+		{
+			keys[(size_t)i] = i * 2;
+			values[(size_t)i] = &keys[(size_t)i];
+		}
+		Map map;
+		Map_Init(count, elements.data(), &map);
+		Map_BuildFromSorted(keys.data(), values.data(), count, &map);
+		std::cout << "Map frozen search (" << count << " keys)" << std::endl;
+
+		int64_t hits = 0;
+		double seconds = MeasureSeconds([&]()
+			{
+				for (int64_t i = 0; i < lookups; i++)
+				{
+					MapKey_t key = (MapKey_t)(((i * 104729) % count) * 2);
+					hits += (AvlTree_Search(key, map.Root) != nullptr) ? 1 : 0;
+				}
+			});
+		ShowThroughput("  AvlTree_Search", lookups, seconds);
+		seconds = MeasureSeconds([&]()
+			{
+				Map_Freeze(frozenKeys.data(), frozenValues.data(), &map);
+			});
+		ShowThroughput("  Map_Freeze", count, seconds);
+		seconds = MeasureSeconds([&]()
+			{
+				for (int64_t i = 0; i < lookups; i++)
+				{
+					MapKey_t key = (MapKey_t)(((i * 104729) % count) * 2);
+					hits += (Map_ValueFor(key, &map) != nullptr) ? 1 : 0;
+				}
+			});
+		ShowThroughput("  Map_ValueFor(frozen)", lookups, seconds);
+		if (hits != lookups * 2)
+		{
+			std::cout << "(lost keys)" << std::endl;
+		}
+	}
+}
+
+// ベンチマークを実行する
+static void RunBenchmarks(void)
+{
+#ifdef HAS_STDATOMIC
+	SpscFrames_Benchmark();
+#endif
+	RingedFrames_BatchBenchmark();
+	RingedFrames_Pow2Benchmark();
+#ifdef HAS_STDATOMIC
+	MpscFrames_Benchmark();
+#endif
+	WindowedAggregates_Benchmark();
+	Map_InsertBenchmark();
+	Map_SearchBenchmark();
+	Map_FrozenBenchmark();
+}
+
 int main(int argc, char** argv)
 {
 	int result = 0;
@@ -64,7 +877,38 @@ int main(int argc, char** argv)
 	Decoders_UnitTest();
 	bits_UnitTest();
 	Timers_UnitTest();
+#ifdef HAS_STDATOMIC
+	SpscFrames_UnitTest();
+#endif
+	PackedFrames_UnitTest();
+#ifdef HAS_STDATOMIC
+	MappedFrames_UnitTest();
+#endif
+	MergedFrames_UnitTest();
+#ifdef HAS_STDATOMIC
+	MpscFrames_UnitTest();
+#endif
+	CompressedFrames_UnitTest();
+	WindowedAggregates_UnitTest();
+	CompactMap_UnitTest();
+	HashMap_UnitTest();
+
+	// 複数スレッドを使う試験
+#ifdef HAS_STDATOMIC
+	SpscFrames_StressTest();
+#endif
+#ifdef HAS_STDATOMIC
+	MpscFrames_StressTest();
+#endif
+#ifdef RF_SEQLOCK
+	RingedFrames_ReadStableStressTest();
+#endif
 
+	// 引数に--benchが指定された場合は、ベンチマークも実行する
+	if ((argc > 1) && (strcmp(argv[1], "--bench") == 0))
+	{
+		RunBenchmarks();
+	}
 
 	// 結果を表示する
 	Assertions* assertions = Assertions_Instance();
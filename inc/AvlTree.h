@@ -3,7 +3,7 @@
 /** ------------------------------------------------------------------
 *
 *	@file	AvlTree.h
-*	@brief	AVL Tree (32bits key, without deletion)
+*	@brief	AVL Tree (32bits key)
 *	@author	H.Someya
 *	@date	2021/04/26
 *
@@ -72,6 +72,8 @@ extern "C"
 	{
 		/// <summary>この部分木の高さ</summary>
 		int32_t Height;
+		/// <summary>この部分木のノード数(順位の計算に使う)</summary>
+		int32_t Size;
 		/// <summary>親ノード</summary>
 		AvlNode* Parent;
 		/// <summary>左部分木</summary>
@@ -113,6 +115,104 @@ extern "C"
 		AvlNode* node,
 		AvlNode* root);
 
+	/// <summary>
+	/// <para>ノードのKeyに該当するノードを検索し、無ければそのノードを挿入する。</para>
+	/// <para>検索で辿った位置にそのまま挿入するので、rootから辿るのは1回で済む。</para>
+	/// <para>該当するノードがある場合は、何も変更しない。</para>
+	/// </summary>
+	/// <param name="node">挿入するノード。</param>
+	/// <param name="root">treeのrootノードの格納先。挿入した場合は更新される。</param>
+	/// <returns>該当するノード(挿入した場合は、挿入したノード)。</returns>
+	AvlNode* AvlTree_SearchOrInsert(
+		AvlNode* node,
+		AvlNode** root);
+
+	/// <summary>
+	/// <para>Keyが最小のノードを取得する。</para>
+	/// </summary>
+	/// <param name="root">treeのrootノード。</param>
+	/// <returns>Keyが最小のノード。nullでtreeが空。</returns>
+	AvlNode* AvlTree_First(
+		AvlNode* root);
+
+	/// <summary>
+	/// <para>Keyが最大のノードを取得する。</para>
+	/// </summary>
+	/// <param name="root">treeのrootノード。</param>
+	/// <returns>Keyが最大のノード。nullでtreeが空。</returns>
+	AvlNode* AvlTree_Last(
+		AvlNode* root);
+
+	/// <summary>
+	/// <para>Keyの順で次のノードを取得する。</para>
+	/// <para>親へのつながりを辿るので、償却O(1)で進められる。</para>
+	/// </summary>
+	/// <param name="node">ノード。</param>
+	/// <returns>次のノード。nullで最後。</returns>
+	AvlNode* AvlTree_Next(
+		AvlNode* node);
+
+	/// <summary>
+	/// <para>Keyの順で前のノードを取得する。</para>
+	/// </summary>
+	/// <param name="node">ノード。</param>
+	/// <returns>前のノード。nullで最初。</returns>
+	AvlNode* AvlTree_Prev(
+		AvlNode* node);
+
+	/// <summary>
+	/// <para>Keyがkey以上で最小のノードを検索する。</para>
+	/// </summary>
+	/// <param name="key">検索するKey。</param>
+	/// <param name="root">検索開始rootノード。</param>
+	/// <returns>該当するノード。nullでなし。</returns>
+	AvlNode* AvlTree_LowerBound(
+		AvlKey_t key,
+		AvlNode* root);
+
+	/// <summary>
+	/// <para>Keyがkeyより大きく最小のノードを検索する。</para>
+	/// </summary>
+	/// <param name="key">検索するKey。</param>
+	/// <param name="root">検索開始rootノード。</param>
+	/// <returns>該当するノード。nullでなし。</returns>
+	AvlNode* AvlTree_UpperBound(
+		AvlKey_t key,
+		AvlNode* root);
+
+	/// <summary>
+	/// <para>keyより小さいKeyのノード数(keyの順位)を取得する。</para>
+	/// <para>部分木のノード数を使うので、O(log n)で求まる。</para>
+	/// </summary>
+	/// <param name="key">Key。</param>
+	/// <param name="root">treeのrootノード。</param>
+	/// <returns>keyより小さいKeyのノード数。</returns>
+	int32_t AvlTree_Rank(
+		AvlKey_t key,
+		AvlNode* root);
+
+	/// <summary>
+	/// <para>Keyの小さい方から数えた位置のノードを取得する。</para>
+	/// <para>部分木のノード数を使うので、O(log n)で求まる。</para>
+	/// </summary>
+	/// <param name="rank">位置(0～)。</param>
+	/// <param name="root">treeのrootノード。</param>
+	/// <returns>位置のノード。nullで範囲外。</returns>
+	AvlNode* AvlTree_Select(
+		int32_t rank,
+		AvlNode* root);
+
+	/// <summary>
+	/// <para>ノードを削除する。</para>
+	/// <para>削除したノードは、どのノードともつながっていない状態になる。</para>
+	/// </summary>
+	/// <param name="node">削除するノード。treeに挿入されていること。</param>
+	/// <param name="root">削除元treeのrootノード。</param>
+	/// <returns>更新されたtreeのrootノード。nullで空になった。</returns>
+	AvlNode* AvlTree_Remove(
+		AvlNode* node,
+		AvlNode* root);
+
 #ifdef _UNIT_TEST
 	void AvlTree_UnitTest(void);
 #endif
@@ -0,0 +1,204 @@
+﻿#ifndef CompactMap_h
+#define CompactMap_h
+/** ------------------------------------------------------------------
+*
+*	@file	CompactMap.h
+*	@brief	Compact index-based map (32bits key)
+*	@author	H.Someya
+*	@date	2026/10/17
+*
+MIT License
+
+Copyright (c) 2021 Hirobumi Someya
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*
+*/
+#include <stdint.h>
+#include "Map.h"
+
+/* -------------------------------------------------------------------
+*	Definitions
+*/
+
+/// <summary>
+/// <para>つながっていないことを表すインデックス。</para>
+/// </summary>
+#define CM_NIL (-1)
+
+/// <summary>
+/// <para>木の最大の高さ。</para>
+/// <para>AVL木の高さは要素数nに対して1.44 log2 n程度に収まるので、int32_tの要素数には十分。</para>
+/// </summary>
+#define CM_MAX_HEIGHT (48)
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+	/* -------------------------------------------------------------------
+	*	Services
+	*/
+
+	/// <summary>
+	/// <para>コンパクトMapのノード</para>
+	/// <para>子を要素配列のインデックスで持ち、親は持たない。16バイトに収まる。</para>
+	/// </summary>
+	typedef struct _CompactMapNode
+	{
+		/// <summary>Key</summary>
+		MapKey_t Key;
+		/// <summary>左部分木(CM_NILでなし)</summary>
+		int32_t Left;
+		/// <summary>右部分木(CM_NILでなし)</summary>
+		int32_t Right;
+		/// <summary>この部分木の高さ</summary>
+		uint8_t Height;
+		/// <summary>パディング</summary>
+		uint8_t Padding[3];
+	} CompactMapNode;
+
+	/// <summary>
+	/// <para>コンパクトMap</para>
+	/// <para>Mapと同じ操作を、インデックスでつないだ小さなノードで行う。</para>
+	/// <para>valueはノードと別の配列に置くので、検索で辿るのはノードだけになる。</para>
+	/// <para>親へのつながりを持たない代わりに、更新時は辿った経路を覚えておいて平衡処理を行う。</para>
+	/// </summary>
+	typedef struct _CompactMap
+	{
+		/// <summary>要素数</summary>
+		int32_t Count;
+		/// <summary>木の根(CM_NILでなし)</summary>
+		int32_t Root;
+		/// <summary>最大要素数</summary>
+		int32_t Capacity;
+		/// <summary>パディング</summary>
+		int32_t Padding;
+		/// <summary>ノードリスト</summary>
+		CompactMapNode* Nodes;
+		/// <summary>valueリスト(ノードと同じインデックス位置)</summary>
+		const void** Values;
+	} CompactMap;
+
+	/// <summary>
+	/// <para>コンパクトMapを初期化する。</para>
+	/// </summary>
+	/// <param name="capacity">最大要素数。</param>
+	/// <param name="nodes">動作に必要なノードバッファ。
+	/// 最大要素数分確保して指定すること。</param>
+	/// <param name="values">動作に必要なvalueバッファ。
+	/// 最大要素数分確保して指定すること。</param>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>なし。</returns>
+	void CompactMap_Init(
+		int32_t capacity,
+		CompactMapNode* nodes,
+		const void** values,
+		CompactMap* ctxt);
+
+	/// <summary>
+	/// <para>コンパクトMapの最大要素数を取得する。</para>
+	/// </summary>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>最大要素数。</returns>
+	int32_t CompactMap_Capacity(
+		const CompactMap* ctxt);
+
+	/// <summary>
+	/// <para>コンパクトMapの蓄積済み要素数を取得する。</para>
+	/// </summary>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>蓄積済み要素数。</returns>
+	int32_t CompactMap_Count(
+		const CompactMap* ctxt);
+
+	/// <summary>
+	/// <para>コンパクトMapをクリアする。</para>
+	/// </summary>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>なし。</returns>
+	void CompactMap_Clear(
+		CompactMap* ctxt);
+
+	/// <summary>
+	/// <para>valueをkeyに関連付ける。</para>
+	/// <para>同じkeyが既にある場合、関連付けを上書きする。</para>
+	/// <para>※　valueのスコープと定数/変数は、Map_Relateと同様にユーザーが考慮しなければならない。　※</para>
+	/// </summary>
+	/// <param name="value">値。</param>
+	/// <param name="key">キー。</param>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>蓄積済み要素数。関連付けできなかった場合は0。</returns>
+	int32_t CompactMap_Relate(
+		const void* value, MapKey_t key,
+		CompactMap* ctxt);
+
+	/// <summary>
+	/// <para>keyに対応するvalueを取得する。</para>
+	/// </summary>
+	/// <param name="key">キー。</param>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>keyに対応するvalue。</returns>
+	void* CompactMap_ValueFor(
+		MapKey_t key,
+		const CompactMap* ctxt);
+
+	/// <summary>
+	/// <para>指定したインデックス位置のvalueを取得する。</para>
+	/// </summary>
+	/// <param name="index">インデックス位置(0～)。</param>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>インデックス位置のvalue。</returns>
+	void* CompactMap_ValueAt(
+		int32_t index,
+		const CompactMap* ctxt);
+
+	/// <summary>
+	/// <para>指定したインデックス位置のkeyを取得する。</para>
+	/// </summary>
+	/// <param name="index">インデックス位置(0～)。</param>
+	/// <param name="orDefault">取得できない場合のデフォルト値。</param>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>インデックス位置のkey。</returns>
+	MapKey_t CompactMap_KeyAt(
+		int32_t index,
+		MapKey_t orDefault,
+		const CompactMap* ctxt);
+
+	/// <summary>
+	/// <para>keyの関連付けを削除する。</para>
+	/// <para>空いた要素には最後の要素を移して詰める。</para>
+	/// <para>※　要素のインデックス位置は変わることがある。　※</para>
+	/// </summary>
+	/// <param name="key">キー。</param>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>0:該当なし、非0:削除した。</returns>
+	int CompactMap_Remove(
+		MapKey_t key,
+		CompactMap* ctxt);
+
+#ifdef _UNIT_TEST
+	void CompactMap_UnitTest(void);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // top
@@ -0,0 +1,209 @@
+﻿#ifndef CompressedFrames_h
+#define CompressedFrames_h
+/** ------------------------------------------------------------------
+*
+*	@file	CompressedFrames.h
+*	@brief	Delta and run-length compressed frame ring buffer
+*	@author	H.Someya
+*	@date	2026/10/17
+*
+MIT License
+
+Copyright (c) 2021 Hirobumi Someya
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*
+*/
+#include <stdint.h>
+#include "PackedFrames.h"
+
+/* -------------------------------------------------------------------
+*	Definitions
+*/
+
+/// <summary>
+/// <para>圧縮したフレームの先頭に付ける、種別(1バイト)と元のフレーム長(4バイト)のサイズ。</para>
+/// </summary>
+#define CF_RECORD_HEADER_SIZE (5)
+
+/// <summary>
+/// <para>圧縮したフレームの最大サイズを取得する。</para>
+/// <para>ランレングス符号化は、最悪でも128バイトごとに1バイト増えるだけとなる。</para>
+/// </summary>
+/// <param name="frameSize">最大フレームサイズ。</param>
+#define CF_RECORD_SIZE(frameSize) \
+	(CF_RECORD_HEADER_SIZE + (frameSize) + (((frameSize) + 127) / 128))
+
+/// <summary>
+/// <para>圧縮の作業領域(直前のフレームと、圧縮したフレーム)のワード数を取得する。</para>
+/// </summary>
+/// <param name="frameSize">最大フレームサイズ。</param>
+#define CF_WORK_WORDS(frameSize) \
+	((((frameSize) + 3) / 4) + ((CF_RECORD_SIZE(frameSize) + 3) / 4))
+
+/// <summary>
+/// <para>バッファに必要なワード数を取得する。</para>
+/// <para>可変長フレームリングバッファの領域と、圧縮の作業領域からなる。</para>
+/// </summary>
+/// <param name="capacity">最大蓄積可能フレーム数。</param>
+/// <param name="frameSize">最大フレームサイズ。</param>
+/// <param name="dataWords">データ領域のワード数。</param>
+#define CF_NEEDED_BUFFER_WORDS(capacity, frameSize, dataWords) \
+	(PF_NEEDED_BUFFER_WORDS(capacity, dataWords) + CF_WORK_WORDS(frameSize))
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+	/* -------------------------------------------------------------------
+	*	Services
+	*/
+
+	/// <summary>
+	/// <para>圧縮フレームリングバッファ</para>
+	/// <para>フレームを直前のフレームとのXOR差分にし、ランレングス符号化して可変長で蓄積する。</para>
+	/// <para>一定の更新数ごとに、差分を取らないキーフレームを置くことで、
+	/// 任意のフレームをキーフレーム間隔以内の復号で読み出せる。</para>
+	/// <para>キーフレームが上書きされると、それに続く差分フレームは読み出せなくなる。</para>
+	/// </summary>
+	typedef struct _CompressedFrames
+	{
+		/// <summary>圧縮したフレームを蓄積する、可変長フレームリングバッファ</summary>
+		PackedFrames Packed;
+		/// <summary>最大フレームサイズ</summary>
+		int32_t FrameSize;
+		/// <summary>キーフレーム間隔(更新数)</summary>
+		int32_t KeyframeInterval;
+		/// <summary>直前にPushしたフレーム(差分の基準)</summary>
+		uint8_t* Previous;
+		/// <summary>直前にPushしたフレームの長さ</summary>
+		int32_t PreviousLength;
+		/// <summary>圧縮したフレームの作業領域</summary>
+		uint8_t* Record;
+	} CompressedFrames;
+
+	/// <summary>
+	/// <para>圧縮フレームリングバッファを初期化する。</para>
+	/// </summary>
+	/// <param name="capacity">最大蓄積可能フレーム数。</param>
+	/// <param name="frameSize">最大フレームサイズ。</param>
+	/// <param name="keyframeInterval">キーフレーム間隔(更新数)。1で全てキーフレームとする。</param>
+	/// <param name="dataWords">データ領域のワード数。
+	/// PF_RECORD_WORDS(CF_RECORD_SIZE(frameSize))以上を指定すること。</param>
+	/// <param name="buffer">動作に必要なバッファ。
+	/// CF_NEEDED_BUFFER_WORDS分の要素数を持つ領域を確保して指定すること。</param>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>なし。</returns>
+	void CompressedFrames_Init(
+		int32_t capacity, int32_t frameSize,
+		int32_t keyframeInterval,
+		int32_t dataWords,
+		int32_t* buffer,
+		CompressedFrames* ctxt);
+
+	/// <summary>
+	/// <para>クリアする。</para>
+	/// </summary>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>なし。</returns>
+	void CompressedFrames_Clear(
+		CompressedFrames* ctxt);
+
+	/// <summary>
+	/// <para>読み出せるフレーム数を取得する。</para>
+	/// <para>キーフレームが上書きされて復号できない、最古側の差分フレームは含まない。</para>
+	/// </summary>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>読み出せるフレーム数。</returns>
+	int32_t CompressedFrames_Count(
+		const CompressedFrames* ctxt);
+
+	/// <summary>
+	/// <para>現在のフレーム更新数を取得する。</para>
+	/// </summary>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>現在のフレーム更新数。</returns>
+	int64_t CompressedFrames_UpdateCount(
+		const CompressedFrames* ctxt);
+
+	/// <summary>
+	/// <para>最大フレームサイズを取得する。</para>
+	/// </summary>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>最大フレームサイズ。</returns>
+	int32_t CompressedFrames_FrameSize(
+		const CompressedFrames* ctxt);
+
+	/// <summary>
+	/// <para>フレームを圧縮してPushする。</para>
+	/// <para>最大蓄積可能フレーム数まで蓄積されているか、データ領域が足りない場合、
+	/// 必要な分だけ最古から上書きする。</para>
+	/// <para>フレームが無効(null、長さ不正)の場合は、長さ0で記録する。</para>
+	/// </summary>
+	/// <param name="frame">フレーム。</param>
+	/// <param name="length">フレームの長さ。</param>
+	/// <param name="timestamp">タイムスタンプ。</param>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>なし。</returns>
+	void CompressedFrames_Push(
+		const void* frame, int32_t length,
+		int64_t timestamp,
+		CompressedFrames* ctxt);
+
+	/// <summary>
+	/// <para>最古を0としたインデックスで、フレームを格納先に復号する。</para>
+	/// <para>直前のキーフレームから順に復号するため、格納先は最大フレームサイズ以上とすること。</para>
+	/// </summary>
+	/// <param name="index">最古を0としたインデックス。</param>
+	/// <param name="buffer">フレームの格納先バッファ。</param>
+	/// <param name="bufferSize">フレーム格納先バッファのサイズ。</param>
+	/// <param name="timestamp">タイムスタンプの格納先。</param>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>フレーム長。負でフレームなし、または格納先が足りない。</returns>
+	int32_t CompressedFrames_ReadWithOld(
+		int32_t index,
+		void* buffer, int32_t bufferSize,
+		int64_t* timestamp,
+		const CompressedFrames* ctxt);
+
+	/// <summary>
+	/// <para>最新を0としたインデックスで、フレームを格納先に復号する。</para>
+	/// <para>直前のキーフレームから順に復号するため、格納先は最大フレームサイズ以上とすること。</para>
+	/// </summary>
+	/// <param name="index">最新を0としたインデックス。</param>
+	/// <param name="buffer">フレームの格納先バッファ。</param>
+	/// <param name="bufferSize">フレーム格納先バッファのサイズ。</param>
+	/// <param name="timestamp">タイムスタンプの格納先。</param>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>フレーム長。負でフレームなし、または格納先が足りない。</returns>
+	int32_t CompressedFrames_ReadWithNew(
+		int32_t index,
+		void* buffer, int32_t bufferSize,
+		int64_t* timestamp,
+		const CompressedFrames* ctxt);
+
+#ifdef _UNIT_TEST
+	void CompressedFrames_UnitTest(void);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // top
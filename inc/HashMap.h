@@ -0,0 +1,181 @@
+﻿#ifndef HashMap_h
+#define HashMap_h
+/** ------------------------------------------------------------------
+*
+*	@file	HashMap.h
+*	@brief	Open-addressing fixed-capacity hash map (32bits key)
+*	@author	H.Someya
+*	@date	2026/10/17
+*
+MIT License
+
+Copyright (c) 2021 Hirobumi Someya
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*
+*/
+#include <stdint.h>
+#include "Map.h"
+
+/* -------------------------------------------------------------------
+*	Definitions
+*/
+
+/// <summary>
+/// <para>制御バイトのグループの幅(1回に比べるスロット数)。</para>
+/// </summary>
+#define HM_GROUP_WIDTH (16)
+
+/// <summary>
+/// <para>スロット数に対して、蓄積できる最大要素数を取得する(負荷率7/8)。</para>
+/// </summary>
+/// <param name="slotCount">スロット数。</param>
+#define HM_MAX_COUNT(slotCount) \
+	((slotCount) - ((slotCount) / 8))
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+	/* -------------------------------------------------------------------
+	*	Services
+	*/
+
+	/// <summary>
+	/// <para>ハッシュMap要素</para>
+	/// </summary>
+	typedef struct _HashMapElm
+	{
+		/// <summary>Key</summary>
+		MapKey_t Key;
+		/// <summary>パディング</summary>
+		int32_t Padding;
+		/// <summary>Value</summary>
+		const void* Value;
+	} HashMapElm;
+
+	/// <summary>
+	/// <para>ハッシュMap</para>
+	/// <para>固定スロット数のオープンアドレス法によるMapで、keyの検索は平均O(1)となる。</para>
+	/// <para>スロットごとに、空き、削除済み、またはハッシュ値の下位7ビットを表す制御バイトを持つ。</para>
+	/// <para>検索は制御バイトをHM_GROUP_WIDTHずつまとめて比べ(SSE2が使えればSIMD)、
+	/// 一致したスロットだけkeyを比べる。</para>
+	/// <para>keyの順序は持たないので、順序が必要な場合はMapを使うこと。</para>
+	/// </summary>
+	typedef struct _HashMap
+	{
+		/// <summary>要素数</summary>
+		int32_t Count;
+		/// <summary>削除済みのスロット数</summary>
+		int32_t Deleted;
+		/// <summary>スロット数</summary>
+		int32_t SlotCount;
+		/// <summary>グループ番号のマスク</summary>
+		int32_t GroupMask;
+		/// <summary>要素リスト</summary>
+		HashMapElm* Elements;
+		/// <summary>制御バイトリスト</summary>
+		uint8_t* Controls;
+	} HashMap;
+
+	/// <summary>
+	/// <para>ハッシュMapを初期化する。</para>
+	/// <para>スロット数は、HM_GROUP_WIDTH以上の2のべき乗を指定すること。
+	/// それ以外の場合は、何も蓄積できない。</para>
+	/// </summary>
+	/// <param name="slotCount">スロット数。</param>
+	/// <param name="elements">動作に必要な要素バッファ。
+	/// スロット数分確保して指定すること。</param>
+	/// <param name="controls">動作に必要な制御バイトバッファ。
+	/// スロット数分確保して指定すること。</param>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>なし。</returns>
+	void HashMap_Init(
+		int32_t slotCount,
+		HashMapElm* elements,
+		uint8_t* controls,
+		HashMap* ctxt);
+
+	/// <summary>
+	/// <para>ハッシュMapの最大要素数(HM_MAX_COUNT)を取得する。</para>
+	/// </summary>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>最大要素数。</returns>
+	int32_t HashMap_Capacity(
+		const HashMap* ctxt);
+
+	/// <summary>
+	/// <para>ハッシュMapの蓄積済み要素数を取得する。</para>
+	/// </summary>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>蓄積済み要素数。</returns>
+	int32_t HashMap_Count(
+		const HashMap* ctxt);
+
+	/// <summary>
+	/// <para>ハッシュMapをクリアする。</para>
+	/// </summary>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>なし。</returns>
+	void HashMap_Clear(
+		HashMap* ctxt);
+
+	/// <summary>
+	/// <para>valueをkeyに関連付ける。</para>
+	/// <para>同じkeyが既にある場合、関連付けを上書きする。</para>
+	/// <para>削除済みのスロットが増えて空きが無くなった場合は、その場で再配置してから追加する。</para>
+	/// <para>※　valueのスコープと定数/変数は、Map_Relateと同様にユーザーが考慮しなければならない。　※</para>
+	/// </summary>
+	/// <param name="value">値。</param>
+	/// <param name="key">キー。</param>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>蓄積済み要素数。関連付けできなかった場合は0。</returns>
+	int32_t HashMap_Relate(
+		const void* value, MapKey_t key,
+		HashMap* ctxt);
+
+	/// <summary>
+	/// <para>keyに対応するvalueを取得する。</para>
+	/// </summary>
+	/// <param name="key">キー。</param>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>keyに対応するvalue。</returns>
+	void* HashMap_ValueFor(
+		MapKey_t key,
+		const HashMap* ctxt);
+
+	/// <summary>
+	/// <para>keyの関連付けを削除する。</para>
+	/// </summary>
+	/// <param name="key">キー。</param>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>0:該当なし、非0:削除した。</returns>
+	int HashMap_Remove(
+		MapKey_t key,
+		HashMap* ctxt);
+
+#ifdef _UNIT_TEST
+	void HashMap_UnitTest(void);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // top
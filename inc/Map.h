@@ -37,6 +37,13 @@ SOFTWARE.
 *	Definitions
 */
 
+/// <summary>
+/// <para>Map_Freezeのkey配列、value配列に必要な要素数を取得する。</para>
+/// <para>添字1から使うので、要素数より1つ多い。</para>
+/// </summary>
+/// <param name="count">蓄積済み要素数。</param>
+#define MAP_FROZEN_SLOTS(count) ((count) + 1)
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -50,6 +57,17 @@ extern "C"
 	/// </summary>
 	typedef AvlKey_t MapKey_t;
 
+	/// <summary>
+	/// <para>範囲の要素の通知先。</para>
+	/// </summary>
+	/// <param name="key">キー。</param>
+	/// <param name="value">keyに対応するvalue。</param>
+	/// <param name="context">Map_ForEachInRangeで指定したコンテキスト。</param>
+	/// <returns>0:通知を終える、非0:続ける。</returns>
+	typedef int (*MapVisitor)(
+		MapKey_t key, void* value,
+		void* context);
+
 	/// <summary>
 	/// <para>Map要素</para>
 	/// </summary>
@@ -72,6 +90,10 @@ extern "C"
 		int32_t Capacity;
 		/// <summary>要素リスト</summary>
 		MapElm* Elements;
+		/// <summary>凍結したkeyの配列(Eytzinger配置、nullで凍結していない)</summary>
+		MapKey_t* FrozenKeys;
+		/// <summary>凍結したvalueの配列(FrozenKeysと同じ配置)</summary>
+		const void** FrozenValues;
 	} Map;
 
 	/// <summary>
@@ -105,6 +127,7 @@ extern "C"
 
 	/// <summary>
 	/// <para>Mapをクリアする。</para>
+	/// <para>凍結も解除する。</para>
 	/// </summary>
 	/// <param name="ctxt">コンテキスト。</param>
 	/// <returns>なし。</returns>
@@ -127,6 +150,53 @@ extern "C"
 		const void* value, MapKey_t key,
 		Map* ctxt);
 
+	/// <summary>
+	/// <para>keyに関連付けるvalueの格納先を取得する。</para>
+	/// <para>keyが無い場合は、valueをnullとして追加する。</para>
+	/// <para>rootから辿るのは1回で済む。</para>
+	/// <para>※　格納先は、Removeで要素が移されるまで有効である。　※</para>
+	/// </summary>
+	/// <param name="key">キー。</param>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>valueの格納先。nullで追加できなかった。</returns>
+	const void** Map_Emplace(
+		MapKey_t key,
+		Map* ctxt);
+
+	/// <summary>
+	/// <para>昇順に並んだkeyとvalueの配列から、Mapを作り直す。</para>
+	/// <para>回転を行わずに、完全に平衡した木をO(n)で構築する。</para>
+	/// <para>同じkeyが続く場合は、後のvalueを関連付ける。</para>
+	/// <para>要素のインデックス位置は、keyの昇順になる。</para>
+	/// <para>keyが昇順でない場合や、最大要素数を超える場合は、Mapを変更しない。</para>
+	/// </summary>
+	/// <param name="keys">キーの配列。</param>
+	/// <param name="values">値の配列。</param>
+	/// <param name="count">配列の要素数。</param>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>蓄積済み要素数。構築できなかった場合は0。</returns>
+	int32_t Map_BuildFromSorted(
+		const MapKey_t* keys, const void* const* values,
+		int32_t count,
+		Map* ctxt);
+
+	/// <summary>
+	/// <para>任意の順に並んだkeyとvalueの配列から、Mapを作り直す。</para>
+	/// <para>要素バッファ上でkeyを並べ替えてから、完全に平衡した木を構築する(追加のメモリは使わない)。</para>
+	/// <para>同じkeyが複数ある場合は、配列の後の方のvalueを関連付ける。</para>
+	/// <para>要素のインデックス位置は、keyの昇順になる。</para>
+	/// <para>最大要素数を超える場合は、Mapを変更しない。</para>
+	/// </summary>
+	/// <param name="keys">キーの配列。</param>
+	/// <param name="values">値の配列。</param>
+	/// <param name="count">配列の要素数。</param>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>蓄積済み要素数。構築できなかった場合は0。</returns>
+	int32_t Map_BuildFromUnsorted(
+		const MapKey_t* keys, const void* const* values,
+		int32_t count,
+		Map* ctxt);
+
 	/// <summary>
 	/// <para>keyに対応するvalueを取得する。</para>
 	/// <para>※　Relateで関連付けたアドレスを返すものである。
@@ -168,6 +238,105 @@ extern "C"
 		MapKey_t orDefault,
 		const Map *ctxt);
 
+	/// <summary>
+	/// <para>keyの関連付けを削除する。</para>
+	/// <para>空いた要素には最後の要素を移して詰めるので、Relateで再利用される。</para>
+	/// <para>※　最後の要素のインデックス位置は、削除した要素の位置に変わる。　※</para>
+	/// </summary>
+	/// <param name="key">キー。</param>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>0:該当なし、非0:削除した。</returns>
+	int Map_Remove(
+		MapKey_t key,
+		Map* ctxt);
+
+	/// <summary>
+	/// <para>keyがkey以上で最小の要素の木ノードを取得する。</para>
+	/// <para>AvlTree_Next/AvlTree_Prevで、keyの順に前後へ辿れる。</para>
+	/// <para>※　木ノードは、Relate/Removeで木が変わるまで有効である。　※</para>
+	/// </summary>
+	/// <param name="key">キー。</param>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>該当する木ノード。nullでなし。</returns>
+	AvlNode* Map_LowerBound(
+		MapKey_t key,
+		const Map* ctxt);
+
+	/// <summary>
+	/// <para>keyがkeyより大きく最小の要素の木ノードを取得する。</para>
+	/// <para>AvlTree_Next/AvlTree_Prevで、keyの順に前後へ辿れる。</para>
+	/// <para>※　木ノードは、Relate/Removeで木が変わるまで有効である。　※</para>
+	/// </summary>
+	/// <param name="key">キー。</param>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>該当する木ノード。nullでなし。</returns>
+	AvlNode* Map_UpperBound(
+		MapKey_t key,
+		const Map* ctxt);
+
+	/// <summary>
+	/// <para>keyがlower以上upper以下の要素を、keyの昇順に通知する。</para>
+	/// <para>範囲の先頭をO(log n)で探し、そこから順に辿るので、O(log n + 通知数)となる。</para>
+	/// <para>通知中にRelate/Removeしてはならない。</para>
+	/// </summary>
+	/// <param name="lower">範囲の下限のキー。</param>
+	/// <param name="upper">範囲の上限のキー。</param>
+	/// <param name="visitor">通知先。</param>
+	/// <param name="visitorContext">通知先に渡すコンテキスト。</param>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>通知した要素数。</returns>
+	int32_t Map_ForEachInRange(
+		MapKey_t lower, MapKey_t upper,
+		MapVisitor visitor, void* visitorContext,
+		const Map* ctxt);
+
+	/// <summary>
+	/// <para>keyより小さいkeyの要素数(keyの順位)を取得する。</para>
+	/// <para>O(log n)で求まる。</para>
+	/// </summary>
+	/// <param name="key">キー。</param>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>keyより小さいkeyの要素数。</returns>
+	int32_t Map_Rank(
+		MapKey_t key,
+		const Map* ctxt);
+
+	/// <summary>
+	/// <para>keyの小さい方から数えた位置の要素の木ノードを取得する。</para>
+	/// <para>O(log n)で求まる。AvlTree_Next/AvlTree_Prevで、keyの順に前後へ辿れる。</para>
+	/// <para>※　木ノードは、Relate/Removeで木が変わるまで有効である。　※</para>
+	/// </summary>
+	/// <param name="rank">位置(0～)。</param>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>位置の木ノード。nullで範囲外。</returns>
+	AvlNode* Map_Select(
+		int32_t rank,
+		const Map* ctxt);
+
+	/// <summary>
+	/// <para>Mapを凍結し、以後変更できないようにする。</para>
+	/// <para>keyを幅優先順(Eytzinger配置)の配列に並べ、valueを同じ配置の配列に並べる。</para>
+	/// <para>凍結後のMap_ValueForは、この配列を分岐なしで辿り、子孫を先読みして検索する。</para>
+	/// <para>凍結中はRelate/Emplace/Remove/BuildFromSorted/BuildFromUnsortedが失敗する。
+	/// Clearで凍結を解除する。</para>
+	/// <para>木はそのまま残るので、その他の参照は凍結前と同様に使用できる。</para>
+	/// </summary>
+	/// <param name="keys">keyの格納先。MAP_FROZEN_SLOTS(蓄積済み要素数)分確保して指定すること。</param>
+	/// <param name="values">valueの格納先。MAP_FROZEN_SLOTS(蓄積済み要素数)分確保して指定すること。</param>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>凍結した要素数。負で凍結できなかった。</returns>
+	int32_t Map_Freeze(
+		MapKey_t* keys, const void** values,
+		Map* ctxt);
+
+	/// <summary>
+	/// <para>Mapが凍結されているか取得する。</para>
+	/// </summary>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>0:凍結していない、非0:凍結している。</returns>
+	int Map_IsFrozen(
+		const Map* ctxt);
+
 #ifdef _UNIT_TEST
 	void Map_UnitTest(void);
 #endif
@@ -0,0 +1,224 @@
+﻿#ifndef MappedFrames_h
+#define MappedFrames_h
+/** ------------------------------------------------------------------
+*
+*	@file	MappedFrames.h
+*	@brief	Crash-persistent frame ring buffer
+*	@author	H.Someya
+*	@date	2026/10/17
+*
+MIT License
+
+Copyright (c) 2021 Hirobumi Someya
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*
+*/
+#include <stddef.h>
+#include <stdint.h>
+#include "RingedFrames.h"
+
+/* -------------------------------------------------------------------
+*	Definitions
+*/
+
+/// <summary>
+/// <para>永続化領域の識別子("RFMP")。</para>
+/// </summary>
+#define MF_MAGIC (0x504D4652u)
+
+/// <summary>
+/// <para>永続化領域のレイアウトのバージョン。</para>
+/// </summary>
+#define MF_VERSION (1u)
+
+/// <summary>
+/// <para>永続化領域の管理ヘッダのワード数。</para>
+/// </summary>
+#define MF_HEADER_WORDS (8)
+
+/// <summary>
+/// <para>バッファに必要なワード数を取得する。</para>
+/// <para>管理ヘッダと、RingedFramesと同じレイアウトのフレーム領域からなる。</para>
+/// </summary>
+/// <param name="capacity">最大蓄積可能フレーム数。</param>
+/// <param name="frameSize">最大フレームサイズ。</param>
+#define MF_NEEDED_BUFFER_WORDS(capacity, frameSize) \
+	(MF_HEADER_WORDS + RF_NEEDED_BUFFER_WORDS(capacity, frameSize))
+
+/// <summary>
+/// <para>MappedFrames_Attachの結果：失敗した。</para>
+/// </summary>
+#define MF_ATTACH_FAILED (0)
+/// <summary>
+/// <para>MappedFrames_Attachの結果：新しく初期化した。</para>
+/// </summary>
+#define MF_ATTACH_FORMATTED (1)
+/// <summary>
+/// <para>MappedFrames_Attachの結果：以前の内容を復元した。</para>
+/// </summary>
+#define MF_ATTACH_RECOVERED (2)
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+	/* -------------------------------------------------------------------
+	*	Services
+	*/
+
+	/// <summary>
+	/// <para>永続化領域の管理ヘッダ</para>
+	/// <para>バッファの先頭に置かれ、プロセスが終了しても残る。</para>
+	/// </summary>
+	typedef struct _MappedFramesHeader
+	{
+		/// <summary>識別子(MF_MAGIC)</summary>
+		uint32_t Magic;
+		/// <summary>レイアウトのバージョン(MF_VERSION)</summary>
+		uint32_t Version;
+		/// <summary>最大蓄積可能フレーム数</summary>
+		int32_t Capacity;
+		/// <summary>最大フレームサイズ</summary>
+		int32_t FrameSize;
+		/// <summary>確定したフレーム更新数</summary>
+		int64_t UpdateCount;
+		/// <summary>最古のフレームの更新番号</summary>
+		int64_t Oldest;
+	} MappedFramesHeader;
+
+	/// <summary>
+	/// <para>永続化フレームリングバッファ</para>
+	/// <para>管理情報をバッファ内に持つため、メモリマップしたファイルなどを
+	/// バッファにすると、プロセスが異常終了しても直近のフレームが残る。</para>
+	/// <para>書き込み順序だけで整合性を保つので、msyncなどの同期は行わない。</para>
+	/// <para>C11のアトミック操作(stdatomic.h)を使うので、対応した処理系でビルドすること。
+	/// stdatomic.hが無いVisual Studio(v142)のCでは、LibCEプロジェクトのビルドから除外している。</para>
+	/// </summary>
+	typedef struct _MappedFrames
+	{
+		/// <summary>永続化領域の管理ヘッダ</summary>
+		MappedFramesHeader* Header;
+		/// <summary>フレームリングバッファ(フレーム領域は永続化領域内)</summary>
+		RingedFrames Ring;
+		/// <summary>MappedFrames_Openでマップした領域(nullでなし)</summary>
+		void* Mapping;
+		/// <summary>MappedFrames_Openでマップした領域のサイズ</summary>
+		size_t MappingSize;
+	} MappedFrames;
+
+	/// <summary>
+	/// <para>永続化領域を結び付ける。</para>
+	/// <para>領域に有効な管理ヘッダがあれば、その内容を復元する。</para>
+	/// <para>Pushの途中で終了していた場合は、確定していたフレームまでに戻す。</para>
+	/// <para>識別子が無い場合は、新しく初期化する。</para>
+	/// <para>バージョン、最大蓄積可能フレーム数、最大フレームサイズが異なる場合は、
+	/// 以前の内容を壊さないように失敗する。</para>
+	/// <para>管理ヘッダの64ビット値を分断されずに書き込むため、領域が8バイト境界でない場合も失敗する。</para>
+	/// </summary>
+	/// <param name="capacity">最大蓄積可能フレーム数。</param>
+	/// <param name="frameSize">最大フレームサイズ。</param>
+	/// <param name="buffer">永続化領域。
+	/// MF_NEEDED_BUFFER_WORDS分の要素数を持つ、8バイト境界の領域を指定すること。</param>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>MF_ATTACH_FAILED、MF_ATTACH_FORMATTED、MF_ATTACH_RECOVERED。</returns>
+	int MappedFrames_Attach(
+		int32_t capacity, int32_t frameSize,
+		int32_t* buffer,
+		MappedFrames* ctxt);
+
+	/// <summary>
+	/// <para>フレームリングバッファを取得する。</para>
+	/// <para>参照、検索、読み出しカーソルに使用する。変更はMappedFramesの関数で行うこと。</para>
+	/// </summary>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>フレームリングバッファ。nullでなし。</returns>
+	const RingedFrames* MappedFrames_Ring(
+		const MappedFrames* ctxt);
+
+	/// <summary>
+	/// <para>クリアする。</para>
+	/// </summary>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>なし。</returns>
+	void MappedFrames_Clear(
+		MappedFrames* ctxt);
+
+	/// <summary>
+	/// <para>フレームをPushする。</para>
+	/// <para>最大蓄積可能フレーム数まで蓄積されていると、最古を上書きする。</para>
+	/// </summary>
+	/// <param name="frame">フレーム。</param>
+	/// <param name="length">フレームの長さ。</param>
+	/// <param name="timestamp">タイムスタンプ。</param>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>なし。</returns>
+	void MappedFrames_Push(
+		const void* frame, int32_t length,
+		int64_t timestamp,
+		MappedFrames* ctxt);
+
+	/// <summary>
+	/// <para>最古のフレームをPopする。</para>
+	/// <para>フレームが無い場合は負を返す。</para>
+	/// <para>格納先が足りない場合は、格納できる分だけ返す。</para>
+	/// </summary>
+	/// <param name="buffer">フレームの格納先バッファ。</param>
+	/// <param name="bufferSize">フレーム格納先バッファのサイズ。</param>
+	/// <param name="timestamp">タイムスタンプの格納先。</param>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>フレーム長。</returns>
+	int32_t MappedFrames_Pop(
+		void* buffer, int32_t bufferSize,
+		int64_t* timestamp,
+		MappedFrames* ctxt);
+
+#if defined(__unix__) || defined(__APPLE__)
+	/// <summary>
+	/// <para>ファイルをメモリマップして、永続化領域として結び付ける。</para>
+	/// <para>ファイルが無い場合は作成する。</para>
+	/// </summary>
+	/// <param name="path">ファイルのパス。</param>
+	/// <param name="capacity">最大蓄積可能フレーム数。</param>
+	/// <param name="frameSize">最大フレームサイズ。</param>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>MF_ATTACH_FAILED、MF_ATTACH_FORMATTED、MF_ATTACH_RECOVERED。</returns>
+	int MappedFrames_Open(
+		const char* path,
+		int32_t capacity, int32_t frameSize,
+		MappedFrames* ctxt);
+
+	/// <summary>
+	/// <para>MappedFrames_Openでマップしたファイルを閉じる。</para>
+	/// </summary>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>なし。</returns>
+	void MappedFrames_Close(
+		MappedFrames* ctxt);
+#endif
+
+#ifdef _UNIT_TEST
+	void MappedFrames_UnitTest(void);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // top
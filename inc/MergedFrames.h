@@ -0,0 +1,134 @@
+﻿#ifndef MergedFrames_h
+#define MergedFrames_h
+/** ------------------------------------------------------------------
+*
+*	@file	MergedFrames.h
+*	@brief	K-way timestamp merge of frame ring buffers
+*	@author	H.Someya
+*	@date	2026/10/17
+*
+MIT License
+
+Copyright (c) 2021 Hirobumi Someya
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*
+*/
+#include <stdint.h>
+#include "RingedFrames.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+	/* -------------------------------------------------------------------
+	*	Services
+	*/
+
+	/// <summary>
+	/// <para>マージ用ヒープの要素</para>
+	/// </summary>
+	typedef struct _MergedFramesNode
+	{
+		/// <summary>チャネルの次の未読フレームのタイムスタンプ</summary>
+		int64_t Key;
+		/// <summary>チャネル(フレームリングバッファのインデックス)</summary>
+		int32_t Channel;
+		/// <summary>パディング</summary>
+		int32_t Padding;
+	} MergedFramesNode;
+
+	/// <summary>
+	/// <para>複数のフレームリングバッファを、タイムスタンプ順に1つの流れとして読み出す。</para>
+	/// <para>各チャネルの次の未読フレームを二分ヒープで管理し、1フレームあたりO(log チャネル数)で選ぶ。</para>
+	/// <para>各チャネルのタイムスタンプは単調増加していること。</para>
+	/// <para>読み出しは読み出しカーソルで行い、フレームリングバッファは変更しない。</para>
+	/// </summary>
+	typedef struct _MergedFrames
+	{
+		/// <summary>フレームリングバッファの配列</summary>
+		const RingedFrames* const* Rings;
+		/// <summary>チャネル数</summary>
+		int32_t ChannelCount;
+		/// <summary>ヒープの要素数</summary>
+		int32_t HeapCount;
+		/// <summary>チャネルごとの読み出しカーソル</summary>
+		RingedFramesCursor* Cursors;
+		/// <summary>ヒープ</summary>
+		MergedFramesNode* Heap;
+	} MergedFrames;
+
+	/// <summary>
+	/// <para>マージを初期化する。</para>
+	/// <para>各チャネルは、蓄積されている最古のフレームから読み出す。</para>
+	/// </summary>
+	/// <param name="rings">フレームリングバッファの配列。</param>
+	/// <param name="channelCount">チャネル数(配列の要素数)。</param>
+	/// <param name="cursors">動作に必要な、チャネル数分の読み出しカーソルの配列。</param>
+	/// <param name="heap">動作に必要な、チャネル数分のヒープ要素の配列。</param>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>なし。</returns>
+	void MergedFrames_Init(
+		const RingedFrames* const* rings, int32_t channelCount,
+		RingedFramesCursor* cursors,
+		MergedFramesNode* heap,
+		MergedFrames* ctxt);
+
+	/// <summary>
+	/// <para>未読フレームがあるチャネルで、ヒープを作り直す。</para>
+	/// <para>読み切ったチャネルはヒープから外れるので、新しくPushした後に呼び出すこと。</para>
+	/// </summary>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>未読フレームがあるチャネル数。</returns>
+	int32_t MergedFrames_Refresh(
+		MergedFrames* ctxt);
+
+	/// <summary>
+	/// <para>全チャネルの中で、タイムスタンプが最も古い未読フレームを参照し、読み出し位置を進める。</para>
+	/// <para>タイムスタンプが等しい場合は、チャネルの小さい方を先にする。</para>
+	/// <para>コピーせず、内部メモリを直接参照する。</para>
+	/// </summary>
+	/// <param name="length">フレーム長の格納先。</param>
+	/// <param name="timestamp">タイムスタンプの格納先。</param>
+	/// <param name="channel">チャネルの格納先。</param>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>フレーム。nullで未読なし。</returns>
+	const void* MergedFrames_Next(
+		int32_t* length,
+		int64_t* timestamp,
+		int32_t* channel,
+		MergedFrames* ctxt);
+
+	/// <summary>
+	/// <para>全チャネルで、上書きされて読み逃したフレーム数の合計を取得する。</para>
+	/// </summary>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>読み逃したフレーム数。</returns>
+	int64_t MergedFrames_Lost(
+		const MergedFrames* ctxt);
+
+#ifdef _UNIT_TEST
+	void MergedFrames_UnitTest(void);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // top
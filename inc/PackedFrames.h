@@ -0,0 +1,216 @@
+﻿#ifndef PackedFrames_h
+#define PackedFrames_h
+/** ------------------------------------------------------------------
+*
+*	@file	PackedFrames.h
+*	@brief	Variable-length packed frame ring buffer
+*	@author	H.Someya
+*	@date	2026/10/17
+*
+MIT License
+
+Copyright (c) 2021 Hirobumi Someya
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*
+*/
+#include <stdint.h>
+#include "RingedFrames.h"
+
+/* -------------------------------------------------------------------
+*	Definitions
+*/
+
+/// <summary>
+/// <para>1フレームが占めるデータ領域のワード数を取得する。</para>
+/// <para>ヘッダ(RF_FRAME_HEADER_SIZE)と実際のフレーム長を、ワード単位に切り上げたもの。</para>
+/// </summary>
+/// <param name="length">フレーム長。</param>
+#define PF_RECORD_WORDS(length) (RF_STRIDE_WORDS(length))
+
+/// <summary>
+/// <para>バッファに必要なワード数を取得する。</para>
+/// <para>フレーム位置の管理領域(最大蓄積可能フレーム数分)とデータ領域からなる。</para>
+/// </summary>
+/// <param name="capacity">最大蓄積可能フレーム数。</param>
+/// <param name="dataWords">データ領域のワード数。</param>
+#define PF_NEEDED_BUFFER_WORDS(capacity, dataWords) \
+	((capacity) + (dataWords))
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+	/* -------------------------------------------------------------------
+	*	Services
+	*/
+
+	/// <summary>
+	/// <para>可変長フレームリングバッファ</para>
+	/// <para>フレームごとに、ヘッダと実際のフレーム長分だけデータ領域を使用する。</para>
+	/// <para>データ領域が足りなくなると、足りるまで最古から上書きする。</para>
+	/// </summary>
+	typedef struct _PackedFrames
+	{
+		/// <summary>最古のフレーム位置が記録されている、フレーム位置リスト上のインデックス</summary>
+		int32_t First;
+		/// <summary>フレーム蓄積数</summary>
+		int32_t Count;
+		/// <summary>フレーム更新数(Pushされた数)</summary>
+		int64_t UpdateCount;
+		/// <summary>最大蓄積可能フレーム数</summary>
+		int32_t Capacity;
+		/// <summary>最大フレームサイズ</summary>
+		int32_t FrameSize;
+		/// <summary>次のフレームの書き込み位置(データ領域のワード位置)</summary>
+		int32_t Head;
+		/// <summary>データ領域のワード数</summary>
+		int32_t DataWords;
+		/// <summary>フレーム位置リスト(データ領域のワード位置)</summary>
+		int32_t* Offsets;
+		/// <summary>データ領域</summary>
+		int32_t* Data;
+	} PackedFrames;
+
+	/// <summary>
+	/// <para>可変長フレームリングバッファを初期化する。</para>
+	/// </summary>
+	/// <param name="capacity">最大蓄積可能フレーム数。</param>
+	/// <param name="frameSize">最大フレームサイズ。</param>
+	/// <param name="dataWords">データ領域のワード数。
+	/// PF_RECORD_WORDS(frameSize)以上を指定すること。</param>
+	/// <param name="buffer">動作に必要なバッファ。
+	/// PF_NEEDED_BUFFER_WORDS分の要素数を持つ領域を確保して指定すること。</param>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>なし。</returns>
+	void PackedFrames_Init(
+		int32_t capacity, int32_t frameSize,
+		int32_t dataWords,
+		int32_t* buffer,
+		PackedFrames* ctxt);
+
+	/// <summary>
+	/// <para>クリアする。</para>
+	/// </summary>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>なし。</returns>
+	void PackedFrames_Clear(
+		PackedFrames* ctxt);
+
+	/// <summary>
+	/// <para>現在のフレーム蓄積数を取得する。</para>
+	/// </summary>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>現在のフレーム蓄積数。</returns>
+	int32_t PackedFrames_Count(
+		const PackedFrames* ctxt);
+
+	/// <summary>
+	/// <para>現在のフレーム更新数を取得する。</para>
+	/// </summary>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>現在のフレーム更新数。</returns>
+	int64_t PackedFrames_UpdateCount(
+		const PackedFrames* ctxt);
+
+	/// <summary>
+	/// <para>最大蓄積可能フレーム数を取得する。</para>
+	/// </summary>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>最大蓄積可能フレーム数。</returns>
+	int32_t PackedFrames_Capacity(
+		const PackedFrames* ctxt);
+
+	/// <summary>
+	/// <para>最大フレームサイズを取得する。</para>
+	/// </summary>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>最大フレームサイズ。</returns>
+	int32_t PackedFrames_FrameSize(
+		const PackedFrames* ctxt);
+
+	/// <summary>
+	/// <para>フレームをPushする。</para>
+	/// <para>最大蓄積可能フレーム数まで蓄積されているか、データ領域が足りない場合、
+	/// 必要な分だけ最古から上書きする。</para>
+	/// </summary>
+	/// <param name="frame">フレーム。</param>
+	/// <param name="length">フレームの長さ。</param>
+	/// <param name="timestamp">タイムスタンプ。</param>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>なし。</returns>
+	void PackedFrames_Push(
+		const void* frame, int32_t length,
+		int64_t timestamp,
+		PackedFrames* ctxt);
+
+	/// <summary>
+	/// <para>最古を0としたインデックスで、フレームを参照する。</para>
+	/// <para>コピーせず、内部メモリを直接参照する。</para>
+	/// </summary>
+	/// <param name="index">最古を0としたインデックス。</param>
+	/// <param name="length">フレーム長の格納先。</param>
+	/// <param name="timestamp">タイムスタンプの格納先。</param>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>フレーム。nullでなし。</returns>
+	const void* PackedFrames_ReferWithOld(
+		int32_t index,
+		int32_t* length,
+		int64_t* timestamp,
+		const PackedFrames* ctxt);
+
+	/// <summary>
+	/// <para>最新を0としたインデックスで、フレームを参照する。</para>
+	/// <para>コピーせず、内部メモリを直接参照する。</para>
+	/// </summary>
+	/// <param name="index">最新を0としたインデックス。</param>
+	/// <param name="length">フレーム長の格納先。</param>
+	/// <param name="timestamp">タイムスタンプの格納先。</param>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>フレーム。nullでなし。</returns>
+	const void* PackedFrames_ReferWithNew(
+		int32_t index,
+		int32_t* length,
+		int64_t* timestamp,
+		const PackedFrames* ctxt);
+
+	/// <summary>
+	/// <para>最古のフレームをPopする。</para>
+	/// <para>フレームが無い場合は負を返す。</para>
+	/// <para>格納先が足りない場合は、格納できる分だけ返す。</para>
+	/// </summary>
+	/// <param name="buffer">フレームの格納先バッファ。</param>
+	/// <param name="bufferSize">フレーム格納先バッファのサイズ。</param>
+	/// <param name="timestamp">タイムスタンプの格納先。</param>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>フレーム長。</returns>
+	int32_t PackedFrames_Pop(
+		void* buffer, int32_t bufferSize,
+		int64_t* timestamp,
+		PackedFrames* ctxt);
+
+#ifdef _UNIT_TEST
+	void PackedFrames_UnitTest(void);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // top
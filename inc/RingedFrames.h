@@ -56,6 +56,76 @@ SOFTWARE.
 #define RF_NEEDED_BUFFER_WORDS(capacity, frameSize) \
 	(RF_STRIDE_WORDS(frameSize) * (capacity))
 
+/// <summary>
+/// <para>ヘッダ分離レイアウトでの、1フレームあたりのフレーム領域のワード数を取得する。</para>
+/// </summary>
+/// <param name="frameSize">最大フレームサイズ。</param>
+#define RF_SOA_PAYLOAD_WORDS(frameSize) \
+	(((frameSize) + 3) / 4)
+
+/// <summary>
+/// <para>ヘッダ分離レイアウトで、バッファに必要なワード数を取得する。</para>
+/// <para>タイムスタンプ配列(2ワード)、長さ配列(1ワード)、世代番号配列(1ワード)、
+/// フレーム領域からなる。</para>
+/// </summary>
+/// <param name="capacity">最大蓄積可能フレーム数。</param>
+/// <param name="frameSize">最大フレームサイズ。</param>
+#define RF_SOA_NEEDED_BUFFER_WORDS(capacity, frameSize) \
+	((4 + RF_SOA_PAYLOAD_WORDS(frameSize)) * (capacity))
+
+/// <summary>
+/// <para>RingedFrames_DrainToで、1回に書き出す最大フレーム数。</para>
+/// </summary>
+#define RF_DRAIN_MAX_FRAMES (64)
+/// <summary>
+/// <para>RingedFrames_DrainToの結果：途中まで書き出したフレームが、続きを書き出す前に削除された。</para>
+/// <para>書き出し先のストリームは途中で切れたレコードを含むため、復元できない。</para>
+/// </summary>
+#define RF_DRAIN_BROKEN (-2)
+
+/// <summary>
+/// <para>満杯時の方針：最古のフレームを上書きする(既定)。</para>
+/// </summary>
+#define RF_POLICY_OVERWRITE_OLDEST (0)
+/// <summary>
+/// <para>満杯時の方針：新しいフレームを記録せず、Pushを失敗させる。</para>
+/// </summary>
+#define RF_POLICY_REJECT_NEWEST (1)
+
+// RF_SEQLOCKを定義してビルドすると、世代番号とフレーム更新数をC11のアトミック操作
+// (stdatomic.h)で更新し、RingedFrames_ReadStableを別スレッドから呼び出せる。
+// 定義しない場合はアトミック操作を使わないので、stdatomic.hが無い処理系でもビルドでき、
+// Pushにメモリフェンスも入らない。どちらでもバッファのレイアウトは変わらない。
+
+/// <summary>
+/// <para>RingedFrames_ReadStableの結果：フレームがまだPushされていない。</para>
+/// </summary>
+#define RF_READ_PENDING (-1)
+/// <summary>
+/// <para>RingedFrames_ReadStableの結果：フレームが上書きされた(読み出し中の上書きを含む)。</para>
+/// </summary>
+#define RF_READ_OVERWRITTEN (-2)
+
+/// <summary>
+/// <para>スナップショットの識別子("RFSS")。</para>
+/// </summary>
+#define RF_SNAPSHOT_MAGIC (0x53534652)
+/// <summary>
+/// <para>スナップショットの形式のバージョン。</para>
+/// </summary>
+#define RF_SNAPSHOT_VERSION (1)
+/// <summary>
+/// <para>スナップショットの管理ヘッダのサイズ。</para>
+/// <para>0～3バイト目が識別子、4～7バイト目がバージョン、8～11バイト目がフレーム数、
+/// 12～15バイト目が最大フレームサイズ、16～23バイト目がフレーム更新数。</para>
+/// </summary>
+#define RF_SNAPSHOT_HEADER_SIZE (24)
+/// <summary>
+/// <para>スナップショットの、フレームごとのレコードヘッダのサイズ。</para>
+/// <para>0～7バイト目がタイムスタンプ、8～11バイト目が長さ。</para>
+/// </summary>
+#define RF_SNAPSHOT_RECORD_HEADER_SIZE (12)
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -64,6 +134,20 @@ extern "C"
 	*	Services
 	*/
 
+	/// <summary>
+	/// <para>上書きされるフレームの通知先。</para>
+	/// <para>フレームは内部メモリを直接参照しており、通知から戻ると上書きされる。</para>
+	/// </summary>
+	/// <param name="frame">上書きされるフレーム。</param>
+	/// <param name="length">フレーム長。</param>
+	/// <param name="timestamp">タイムスタンプ。</param>
+	/// <param name="context">RingedFrames_SetEvictedCallbackで指定したコンテキスト。</param>
+	/// <returns>なし。</returns>
+	typedef void (*RingedFramesEvicted)(
+		const void* frame, int32_t length,
+		int64_t timestamp,
+		void* context);
+
 	/// <summary>
 	/// <para>フレームリングバッファ</para>
 	/// </summary>
@@ -75,16 +159,55 @@ extern "C"
 		int32_t Count;
 		/// <summary>フレーム更新数(Pushされた数)</summary>
 		int64_t UpdateCount;
+		/// <summary>クリアされた回数(読み出しカーソルがクリアを検出するのに使う)</summary>
+		uint32_t ClearCount;
 		/// <summary>最大蓄積可能フレーム数</summary>
 		int32_t Capacity;
 		/// <summary>最大フレームサイズ</summary>
 		int32_t FrameSize;
 		/// <summary>蓄積先バッファ</summary>
 		int32_t* Buffer;
+		/// <summary>タイムスタンプ領域の先頭</summary>
+		uint8_t* Timestamps;
+		/// <summary>タイムスタンプの間隔(バイト)</summary>
+		int32_t TimestampStride;
+		/// <summary>フレーム長領域の先頭</summary>
+		uint8_t* Lengths;
+		/// <summary>フレーム長の間隔(バイト)</summary>
+		int32_t LengthStride;
+		/// <summary>フレーム領域の先頭</summary>
+		uint8_t* Payloads;
+		/// <summary>フレームの間隔(バイト)</summary>
+		int32_t PayloadStride;
+		/// <summary>世代番号領域の先頭</summary>
+		uint8_t* Stamps;
+		/// <summary>世代番号の間隔(バイト)</summary>
+		int32_t StampStride;
+		/// <summary>インデックスのマスク(最大蓄積可能フレーム数が2のべき乗でない場合は負)</summary>
+		int32_t IndexMask;
+		/// <summary>予約中の最大フレーム長(0で予約なし)</summary>
+		int32_t Reserved;
+		/// <summary>タイムスタンプの単調増加を確認するか(0で確認しない)</summary>
+		int32_t TimeOrderCheck;
+		/// <summary>最後にPushされたタイムスタンプ</summary>
+		int64_t LastTimestamp;
+		/// <summary>直前よりタイムスタンプが増加しなかったフレームの更新番号(負でなし)</summary>
+		int64_t DisorderedAt;
+		/// <summary>満杯時の方針(RF_POLICY_OVERWRITE_OLDEST、RF_POLICY_REJECT_NEWEST)</summary>
+		int32_t Policy;
+		/// <summary>上書きされるフレームの通知先(nullで通知しない)</summary>
+		RingedFramesEvicted Evicted;
+		/// <summary>上書きされるフレームの通知先に渡すコンテキスト</summary>
+		void* EvictedContext;
+		/// <summary>RingedFrames_DrainToで途中まで書き出した、最古フレームのバイト数(0でなし)</summary>
+		int32_t DrainedBytes;
+		/// <summary>途中まで書き出したフレームの更新番号</summary>
+		int64_t DrainedAt;
 	} RingedFrames;
 
 	/// <summary>
 	/// <para>フレームリングバッファを初期化する。</para>
+	/// <para>最大蓄積可能フレーム数が2のべき乗の場合、フレーム位置を分岐なしのマスクで求める。</para>
 	/// </summary>
 	/// <param name="capacity">最大蓄積可能フレーム数。</param>
 	/// <param name="frameSize">最大フレームサイズ。</param>
@@ -97,6 +220,23 @@ extern "C"
 		int32_t* buffer,
 		RingedFrames* ctxt);
 
+	/// <summary>
+	/// <para>ヘッダ分離レイアウトで、フレームリングバッファを初期化する。</para>
+	/// <para>タイムスタンプと長さをそれぞれ連続した配列に、フレームを別の領域に配置する。</para>
+	/// <para>時刻による検索や長さの集計が、フレームを読み飛ばさずに済む。</para>
+	/// <para>それ以外の操作は、RingedFrames_Initで初期化した場合と同じ。</para>
+	/// </summary>
+	/// <param name="capacity">最大蓄積可能フレーム数。</param>
+	/// <param name="frameSize">最大フレームサイズ。</param>
+	/// <param name="buffer">動作に必要なバッファ。
+	/// RF_SOA_NEEDED_BUFFER_WORDS分の要素数を持つ、8バイト境界の領域を確保して指定すること。</param>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>なし。</returns>
+	void RingedFrames_InitSoa(
+		int32_t capacity, int32_t frameSize,
+		int32_t* buffer,
+		RingedFrames* ctxt);
+
 	/// <summary>
 	/// <para>クリアする。</para>
 	/// </summary>
@@ -117,12 +257,21 @@ extern "C"
 	/// <para>現在のフレーム更新数を取得する。</para>
 	/// <para>フレームリングバッファは最古を上書きするが、蓄積数は最大で停止する。</para>
 	/// <para>更新数は、最大蓄積数を蓄積した後でも更新される。</para>
+	/// <para>Pushするスレッドとは別のスレッドからも取得できる。</para>
 	/// </summary>
 	/// <param name="ctxt">コンテキスト。</param>
 	/// <returns>現在のフレーム更新数。</returns>
 	int64_t RingedFrames_UpdateCount(
 		const RingedFrames* ctxt);
 
+	/// <summary>
+	/// <para>蓄積されているフレームの長さの合計を取得する。</para>
+	/// </summary>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>フレームの長さの合計。</returns>
+	int64_t RingedFrames_TotalLength(
+		const RingedFrames* ctxt);
+
 	/// <summary>
 	/// <para>最大蓄積可能フレーム数を取得する。</para>
 	/// </summary>
@@ -141,18 +290,65 @@ extern "C"
 
 	/// <summary>
 	/// <para>フレームをPushする。</para>
-	/// <para>最大蓄積可能フレーム数まで蓄積されていると、最古を上書きする。</para>
+	/// <para>最大蓄積可能フレーム数まで蓄積されていると、満杯時の方針に従い、
+	/// 最古を上書きするか、記録せずに失敗する。</para>
 	/// </summary>
 	/// <param name="frame">フレーム。</param>
 	/// <param name="length">フレームの長さ。</param>
 	/// <param name="timestamp">タイムスタンプ。</param>
 	/// <param name="ctxt">コンテキスト。</param>
-	/// <returns>なし。</returns>
-	void RingedFrames_Push(
+	/// <returns>0:記録しなかった、非0:記録した。</returns>
+	int RingedFrames_Push(
 		const void* frame, int32_t length,
 		int64_t timestamp,
 		RingedFrames* ctxt);
 
+	/// <summary>
+	/// <para>複数のフレームをまとめてPushする。</para>
+	/// <para>最大蓄積可能フレーム数まで蓄積されていると、最古を上書きする。</para>
+	/// <para>最大蓄積可能フレーム数を超える分は、古い方から上書きされるため記録しない。</para>
+	/// <para>最古を上書きしない方針の場合は、満杯になるまで先頭から記録する。</para>
+	/// <para>上書きされるフレームを通知する場合は、1フレームずつPushした場合と同じ順序で通知する。</para>
+	/// </summary>
+	/// <param name="frames">フレームの配列。要素がnullのフレームは長さ0で記録する。</param>
+	/// <param name="lengths">フレームの長さの配列。</param>
+	/// <param name="timestamps">タイムスタンプの配列。</param>
+	/// <param name="count">フレーム数。</param>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>Pushしたフレーム数。</returns>
+	int32_t RingedFrames_PushBatch(
+		const void* const* frames, const int32_t* lengths,
+		const int64_t* timestamps,
+		int32_t count,
+		RingedFrames* ctxt);
+
+	/// <summary>
+	/// <para>次にPushされるフレームの格納先を予約する。</para>
+	/// <para>コピーせず、内部メモリに直接フレームを書き込むために使用する。</para>
+	/// <para>書き込んだらRingedFrames_Commitで確定すること。</para>
+	/// <para>最大蓄積可能フレーム数まで蓄積されていると、予約した時点で最古を削除する。</para>
+	/// <para>最古を上書きしない方針の場合は、満杯であれば予約できない。</para>
+	/// </summary>
+	/// <param name="maxLength">書き込む最大のフレーム長(1～最大フレームサイズ)。</param>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>フレームの格納先。nullで予約できなかった。</returns>
+	void* RingedFrames_Reserve(
+		int32_t maxLength,
+		RingedFrames* ctxt);
+
+	/// <summary>
+	/// <para>予約した格納先に書き込んだフレームを確定する。</para>
+	/// <para>長さが予約した最大フレーム長を超える場合は、長さ0で確定する。</para>
+	/// </summary>
+	/// <param name="length">書き込んだフレームの長さ。</param>
+	/// <param name="timestamp">タイムスタンプ。</param>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>0:予約されていない、非0:確定した。</returns>
+	int RingedFrames_Commit(
+		int32_t length,
+		int64_t timestamp,
+		RingedFrames* ctxt);
+
 	/// <summary>
 	/// <para>最古を0としたインデックスで、フレームを参照する。</para>
 	/// <para>コピーせず、内部メモリを直接参照する。</para>
@@ -183,6 +379,48 @@ extern "C"
 		int64_t* timestamp,
 		const RingedFrames* ctxt);
 
+	/// <summary>
+	/// <para>更新番号を指定して、フレームを別スレッドから読み出す。</para>
+	/// <para>フレームごとの世代番号で、書き込み中や上書きされたフレームを検出する(seqlock)。</para>
+	/// <para>RF_SEQLOCKを定義してビルドした場合は、Pushする1つのスレッドを止めずに、
+	/// 複数のスレッドから同時に読み出せる。定義しない場合は、Pushと同じスレッドから読み出すこと。</para>
+	/// <para>更新番号は、RingedFrames_UpdateCountで取得した値未満を指定すること。</para>
+	/// <para>格納先が足りない場合は、格納できる分だけ返す。</para>
+	/// </summary>
+	/// <param name="updateNumber">フレームの更新番号(最初にPushされたフレームを0とする)。</param>
+	/// <param name="buffer">フレームの格納先バッファ。</param>
+	/// <param name="bufferSize">フレーム格納先バッファのサイズ。</param>
+	/// <param name="timestamp">タイムスタンプの格納先。</param>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>フレーム長。RF_READ_PENDING、RF_READ_OVERWRITTENで読み出せなかった。</returns>
+	int32_t RingedFrames_ReadStable(
+		int64_t updateNumber,
+		void* buffer, int32_t bufferSize,
+		int64_t* timestamp,
+		const RingedFrames* ctxt);
+
+	/// <summary>
+	/// <para>最古のフレームを参照する。</para>
+	/// <para>コピーせず、内部メモリを直接参照する。</para>
+	/// <para>参照し終えたらRingedFrames_Releaseで削除すること。</para>
+	/// </summary>
+	/// <param name="length">フレーム長の格納先。</param>
+	/// <param name="timestamp">タイムスタンプの格納先。</param>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>フレーム。nullでなし。</returns>
+	const void* RingedFrames_PeekOldest(
+		int32_t* length,
+		int64_t* timestamp,
+		const RingedFrames* ctxt);
+
+	/// <summary>
+	/// <para>最古のフレームを削除する。</para>
+	/// </summary>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>0:フレームなし、非0:削除した。</returns>
+	int RingedFrames_Release(
+		RingedFrames* ctxt);
+
 	/// <summary>
 	/// <para>最古のフレームをPopする。</para>
 	/// <para>フレームが無い場合は負を返す。</para>
@@ -198,6 +436,231 @@ extern "C"
 		int64_t* timestamp,
 		RingedFrames* ctxt);
 
+	/// <summary>
+	/// <para>古い方から複数のフレームをまとめてPopする。</para>
+	/// <para>フレームは格納先バッファに隙間なく連結して格納する。</para>
+	/// <para>格納先バッファに収まらないフレームに達したら、そこで停止する。</para>
+	/// </summary>
+	/// <param name="buffer">フレームの格納先バッファ。</param>
+	/// <param name="bufferSize">フレーム格納先バッファのサイズ。</param>
+	/// <param name="lengths">フレーム長の格納先配列。</param>
+	/// <param name="timestamps">タイムスタンプの格納先配列。</param>
+	/// <param name="maxFrames">Popする最大フレーム数(各格納先配列の要素数)。</param>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>Popしたフレーム数。</returns>
+	int32_t RingedFrames_PopBatch(
+		void* buffer, int32_t bufferSize,
+		int32_t* lengths,
+		int64_t* timestamps,
+		int32_t maxFrames,
+		RingedFrames* ctxt);
+
+	/// <summary>
+	/// <para>満杯時の方針を設定する。</para>
+	/// </summary>
+	/// <param name="policy">RF_POLICY_OVERWRITE_OLDEST、RF_POLICY_REJECT_NEWEST。</param>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>なし。</returns>
+	void RingedFrames_SetPolicy(
+		int32_t policy,
+		RingedFrames* ctxt);
+
+	/// <summary>
+	/// <para>最古を上書きする前に、上書きされるフレームを通知する通知先を設定する。</para>
+	/// <para>二次記憶への退避などに使用する。通知先で同じフレームリングバッファを操作しないこと。</para>
+	/// <para>Pop、Release、Clearで削除されるフレームは通知しない。</para>
+	/// </summary>
+	/// <param name="callback">通知先。nullで通知しない。</param>
+	/// <param name="callbackContext">通知先に渡すコンテキスト。</param>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>なし。</returns>
+	void RingedFrames_SetEvictedCallback(
+		RingedFramesEvicted callback,
+		void* callbackContext,
+		RingedFrames* ctxt);
+
+	/// <summary>
+	/// <para>タイムスタンプの単調増加を確認するかを設定する。</para>
+	/// <para>確認する場合、Pushのたびに直前のタイムスタンプと比較し、
+	/// 増加していないフレームが蓄積されている間は時刻による検索を失敗させる。</para>
+	/// </summary>
+	/// <param name="enabled">0:確認しない、非0:確認する。</param>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>なし。</returns>
+	void RingedFrames_SetTimeOrderCheck(
+		int enabled,
+		RingedFrames* ctxt);
+
+	/// <summary>
+	/// <para>蓄積されているフレームのタイムスタンプが、単調増加しているかを取得する。</para>
+	/// <para>確認しない設定の場合は、常に単調増加とみなす。</para>
+	/// </summary>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>0:単調増加していない、非0:単調増加している。</returns>
+	int RingedFrames_IsTimeOrdered(
+		const RingedFrames* ctxt);
+
+	/// <summary>
+	/// <para>タイムスタンプが指定時刻以上となる、最古のフレームのインデックスを取得する。</para>
+	/// <para>タイムスタンプが単調増加していることを前提に、二分探索する。</para>
+	/// </summary>
+	/// <param name="timestamp">時刻。</param>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>最古を0としたインデックス。該当なしでフレーム蓄積数、失敗で負。</returns>
+	int32_t RingedFrames_LowerBoundByTime(
+		int64_t timestamp,
+		const RingedFrames* ctxt);
+
+	/// <summary>
+	/// <para>タイムスタンプが指定時刻の範囲内にあるフレームの、インデックス範囲を取得する。</para>
+	/// <para>タイムスタンプが単調増加していることを前提に、二分探索する。</para>
+	/// </summary>
+	/// <param name="from">範囲の開始時刻(この時刻を含む)。</param>
+	/// <param name="to">範囲の終了時刻(この時刻を含む)。</param>
+	/// <param name="begin">範囲の先頭インデックス(最古を0とする)の格納先。</param>
+	/// <param name="end">範囲の末尾の次のインデックスの格納先。</param>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>範囲内のフレーム数。失敗で負。</returns>
+	int32_t RingedFrames_RangeByTime(
+		int64_t from, int64_t to,
+		int32_t* begin, int32_t* end,
+		const RingedFrames* ctxt);
+
+	/// <summary>
+	/// <para>フレームリングバッファの読み出しカーソル</para>
+	/// <para>Popせずに、読み出し側ごとに独立して全フレームを順に参照するために使用する。</para>
+	/// <para>読み出し位置はフレーム更新数で管理し、上書きで読み逃したフレーム数を数える。</para>
+	/// </summary>
+	typedef struct _RingedFramesCursor
+	{
+		/// <summary>次に読み出すフレームの更新番号</summary>
+		int64_t Position;
+		/// <summary>上書きで読み逃したフレーム数</summary>
+		int64_t Lost;
+		/// <summary>読み出し位置を合わせた時点の、フレームリングバッファのクリア回数</summary>
+		uint32_t ClearCount;
+	} RingedFramesCursor;
+
+	/// <summary>
+	/// <para>読み出しカーソルを初期化する。</para>
+	/// <para>初期化した後にPushされたフレームから読み出す。</para>
+	/// </summary>
+	/// <param name="ring">フレームリングバッファ。</param>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>なし。</returns>
+	void RingedFramesCursor_Init(
+		const RingedFrames* ring,
+		RingedFramesCursor* ctxt);
+
+	/// <summary>
+	/// <para>未読のフレーム数と、最初の未読フレームのインデックスを取得する。</para>
+	/// <para>未読フレームはRingedFrames_ReferWithOldで、コピーせず参照できる。</para>
+	/// <para>読み終えたらRingedFramesCursor_Advanceで読み出し位置を進めること。</para>
+	/// </summary>
+	/// <param name="index">最初の未読フレームの、最古を0としたインデックスの格納先。</param>
+	/// <param name="ring">フレームリングバッファ。</param>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>未読のフレーム数。</returns>
+	int32_t RingedFramesCursor_Unread(
+		int32_t* index,
+		const RingedFrames* ring,
+		RingedFramesCursor* ctxt);
+
+	/// <summary>
+	/// <para>読み出し位置を進める。</para>
+	/// </summary>
+	/// <param name="count">進めるフレーム数。未読のフレーム数までに制限される。</param>
+	/// <param name="ring">フレームリングバッファ。</param>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>進めたフレーム数。</returns>
+	int32_t RingedFramesCursor_Advance(
+		int32_t count,
+		const RingedFrames* ring,
+		RingedFramesCursor* ctxt);
+
+	/// <summary>
+	/// <para>次の未読フレームを参照し、読み出し位置を1つ進める。</para>
+	/// <para>コピーせず、内部メモリを直接参照する。</para>
+	/// </summary>
+	/// <param name="length">フレーム長の格納先。</param>
+	/// <param name="timestamp">タイムスタンプの格納先。</param>
+	/// <param name="ring">フレームリングバッファ。</param>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>フレーム。nullで未読なし。</returns>
+	const void* RingedFramesCursor_Next(
+		int32_t* length,
+		int64_t* timestamp,
+		const RingedFrames* ring,
+		RingedFramesCursor* ctxt);
+
+	/// <summary>
+	/// <para>上書きまたはPopされて読み逃したフレーム数を取得する。</para>
+	/// </summary>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>読み逃したフレーム数。</returns>
+	int64_t RingedFramesCursor_Lost(
+		const RingedFramesCursor* ctxt);
+
+	/// <summary>
+	/// <para>スナップショットに必要なバイト数を取得する。</para>
+	/// <para>蓄積されているフレームの、実際の長さ分だけを数える。</para>
+	/// </summary>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>スナップショットのバイト数。INT32_MAXを超える場合は負。</returns>
+	int32_t RingedFrames_SnapshotSize(
+		const RingedFrames* ctxt);
+
+	/// <summary>
+	/// <para>蓄積されているフレームを、古い方から順にスナップショットとして書き出す。</para>
+	/// <para>管理ヘッダ(RF_SNAPSHOT_HEADER_SIZE)に続けて、フレームごとに
+	/// レコードヘッダ(RF_SNAPSHOT_RECORD_HEADER_SIZE)と実際の長さ分のフレームを書き出す。</para>
+	/// <para>数値はリトルエンディアンで書き出すので、プラットフォームに依存しない。</para>
+	/// <para>フレームリングバッファは変更しない。</para>
+	/// </summary>
+	/// <param name="dest">書き出し先バッファ。</param>
+	/// <param name="destSize">書き出し先バッファのサイズ。</param>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>書き出したバイト数。書き出し先が足りない場合、
+	/// スナップショットがINT32_MAXバイトを超える場合は負。</returns>
+	int32_t RingedFrames_Snapshot(
+		void* dest, int32_t destSize,
+		const RingedFrames* ctxt);
+
+	/// <summary>
+	/// <para>スナップショットを読み込み、フレームリングバッファの内容を置き換える。</para>
+	/// <para>最大蓄積可能フレーム数が異なっていてもよい。足りない場合は、最新の方から格納できる分だけ復元する。</para>
+	/// <para>最大フレームサイズを超えるフレームは、Pushと同様に長さ0で記録する。</para>
+	/// <para>フレーム更新数も復元するので、スナップショット前の更新番号で読み出せる。</para>
+	/// <para>スナップショットが不正な場合や、最大蓄積可能フレーム数が0の場合は、フレームリングバッファを変更しない。</para>
+	/// </summary>
+	/// <param name="src">スナップショット。</param>
+	/// <param name="srcSize">スナップショットのサイズ。</param>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>復元したフレーム数。復元できなかった場合は負。</returns>
+	int32_t RingedFrames_Restore(
+		const void* src, int32_t srcSize,
+		RingedFrames* ctxt);
+
+#if defined(__unix__) || defined(__APPLE__)
+	/// <summary>
+	/// <para>古い方から複数のフレームを、1回のwritevでファイルディスクリプタに書き出す。</para>
+	/// <para>フレームごとに、ヘッダ(RF_FRAME_HEADER_SIZE)と実際の長さ分のフレームを続けて書き出す。</para>
+	/// <para>ヘッダは、0～7バイト目がタイムスタンプ、8～11バイト目が長さ、12～15バイト目が世代番号。</para>
+	/// <para>書き出せたフレームだけを削除する。書き出しが途中で失敗した場合、
+	/// 途中まで書き出したフレームは削除せず、書き出したバイト数を記録して次回その続きから書き出す。</para>
+	/// <para>続きを書き出す前にそのフレームが削除された(Pop、上書き等)場合は、RF_DRAIN_BROKENを返す。</para>
+	/// </summary>
+	/// <param name="fd">ファイルディスクリプタ。</param>
+	/// <param name="maxFrames">書き出す最大フレーム数(RF_DRAIN_MAX_FRAMESまで)。</param>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>書き出したフレーム数。1フレームも書き出せずに失敗した場合は負。
+	/// 書き出し先のストリームが途中で切れた場合はRF_DRAIN_BROKEN。</returns>
+	int32_t RingedFrames_DrainTo(
+		int fd,
+		int32_t maxFrames,
+		RingedFrames* ctxt);
+#endif
+
 #ifdef _UNIT_TEST
 	void RingedFrames_UnitTest(void);
 #endif
@@ -0,0 +1,173 @@
+﻿#ifndef SpscFrames_h
+#define SpscFrames_h
+/** ------------------------------------------------------------------
+*
+*	@file	SpscFrames.h
+*	@brief	Single-producer/single-consumer frame ring buffer
+*	@author	H.Someya
+*	@date	2026/10/17
+*
+MIT License
+
+Copyright (c) 2021 Hirobumi Someya
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*
+*/
+#include <stdint.h>
+#include "RingedFrames.h"
+
+/* -------------------------------------------------------------------
+*	Definitions
+*/
+
+/// <summary>
+/// <para>キャッシュラインのサイズ。</para>
+/// </summary>
+#define SPSC_CACHE_LINE_SIZE (64)
+
+/// <summary>
+/// <para>バッファに必要なワード数を取得する。</para>
+/// <para>フレームのレイアウトはRingedFramesと同じ。</para>
+/// </summary>
+/// <param name="capacity">最大蓄積可能フレーム数。</param>
+/// <param name="frameSize">最大フレームサイズ。</param>
+#define SPSC_NEEDED_BUFFER_WORDS(capacity, frameSize) \
+	(RF_NEEDED_BUFFER_WORDS(capacity, frameSize))
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+	/* -------------------------------------------------------------------
+	*	Services
+	*/
+
+	/// <summary>
+	/// <para>SPSCフレームリングバッファ</para>
+	/// <para>1つの生産者(Push)と1つの消費者(Pop)が、ロックなしで別スレッドから操作できる。</para>
+	/// <para>書き込み位置と読み出し位置は、互いに異なるキャッシュラインに配置する。</para>
+	/// <para>C11のアトミック操作(stdatomic.h)を使うので、対応した処理系でビルドすること。
+	/// stdatomic.hが無いVisual Studio(v142)のCでは、LibCEプロジェクトのビルドから除外している。</para>
+	/// </summary>
+	typedef struct _SpscFrames
+	{
+		/// <summary>最大蓄積可能フレーム数</summary>
+		int32_t Capacity;
+		/// <summary>最大フレームサイズ</summary>
+		int32_t FrameSize;
+		/// <summary>蓄積先バッファ</summary>
+		int32_t* Buffer;
+		/// <summary>パディング</summary>
+		uint8_t ConfigPadding[SPSC_CACHE_LINE_SIZE - sizeof(int32_t) * 2 - sizeof(int32_t*)];
+
+		/// <summary>書き込み位置(Pushされた数、生産者のみ更新)</summary>
+		int64_t Head;
+		/// <summary>生産者が最後に観測した読み出し位置</summary>
+		int64_t CachedTail;
+		/// <summary>パディング</summary>
+		uint8_t HeadPadding[SPSC_CACHE_LINE_SIZE - sizeof(int64_t) * 2];
+
+		/// <summary>読み出し位置(Popされた数、消費者のみ更新)</summary>
+		int64_t Tail;
+		/// <summary>消費者が最後に観測した書き込み位置</summary>
+		int64_t CachedHead;
+		/// <summary>パディング</summary>
+		uint8_t TailPadding[SPSC_CACHE_LINE_SIZE - sizeof(int64_t) * 2];
+	} SpscFrames;
+
+	/// <summary>
+	/// <para>SPSCフレームリングバッファを初期化する。</para>
+	/// <para>生産者、消費者のスレッドを開始する前に呼び出すこと。</para>
+	/// </summary>
+	/// <param name="capacity">最大蓄積可能フレーム数。</param>
+	/// <param name="frameSize">最大フレームサイズ。</param>
+	/// <param name="buffer">動作に必要なバッファ。
+	/// SPSC_NEEDED_BUFFER_WORDS分の要素数を持つ領域を確保して指定すること。</param>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>なし。</returns>
+	void SpscFrames_Init(
+		int32_t capacity, int32_t frameSize,
+		int32_t* buffer,
+		SpscFrames* ctxt);
+
+	/// <summary>
+	/// <para>現在のフレーム蓄積数を取得する。</para>
+	/// <para>別スレッドから操作中の場合は、取得した時点の概算となる。</para>
+	/// </summary>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>現在のフレーム蓄積数。</returns>
+	int32_t SpscFrames_Count(
+		const SpscFrames* ctxt);
+
+	/// <summary>
+	/// <para>最大蓄積可能フレーム数を取得する。</para>
+	/// </summary>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>最大蓄積可能フレーム数。</returns>
+	int32_t SpscFrames_Capacity(
+		const SpscFrames* ctxt);
+
+	/// <summary>
+	/// <para>最大フレームサイズを取得する。</para>
+	/// </summary>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>最大フレームサイズ。</returns>
+	int32_t SpscFrames_FrameSize(
+		const SpscFrames* ctxt);
+
+	/// <summary>
+	/// <para>フレームをPushする。生産者スレッドからのみ呼び出すこと。</para>
+	/// <para>消費者が読み出し中のフレームを壊さないよう、最古を上書きせず失敗する。</para>
+	/// <para>フレームが無効(null、長さ不正)の場合は、長さ0で記録する。</para>
+	/// </summary>
+	/// <param name="frame">フレーム。</param>
+	/// <param name="length">フレームの長さ。</param>
+	/// <param name="timestamp">タイムスタンプ。</param>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>0:満杯で失敗、非0:成功。</returns>
+	int SpscFrames_Push(
+		const void* frame, int32_t length,
+		int64_t timestamp,
+		SpscFrames* ctxt);
+
+	/// <summary>
+	/// <para>最古のフレームをPopする。消費者スレッドからのみ呼び出すこと。</para>
+	/// <para>フレームが無い場合は負を返す。</para>
+	/// <para>格納先が足りない場合は、格納できる分だけ返す。</para>
+	/// </summary>
+	/// <param name="buffer">フレームの格納先バッファ。</param>
+	/// <param name="bufferSize">フレーム格納先バッファのサイズ。</param>
+	/// <param name="timestamp">タイムスタンプの格納先。</param>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>フレーム長。</returns>
+	int32_t SpscFrames_Pop(
+		void* buffer, int32_t bufferSize,
+		int64_t* timestamp,
+		SpscFrames* ctxt);
+
+#ifdef _UNIT_TEST
+	void SpscFrames_UnitTest(void);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // top
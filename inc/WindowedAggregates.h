@@ -0,0 +1,188 @@
+﻿#ifndef WindowedAggregates_h
+#define WindowedAggregates_h
+/** ------------------------------------------------------------------
+*
+*	@file	WindowedAggregates.h
+*	@brief	Incremental sum, count, min and max over a sliding window
+*	@author	H.Someya
+*	@date	2026/10/17
+*
+MIT License
+
+Copyright (c) 2021 Hirobumi Someya
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*
+*/
+#include <stdint.h>
+
+/* -------------------------------------------------------------------
+*	Definitions
+*/
+
+/// <summary>
+/// <para>バッファに必要なワード数を取得する。</para>
+/// <para>値の履歴(タイムスタンプと値)、最小値候補列、最大値候補列からなる。</para>
+/// </summary>
+/// <param name="capacity">窓に含められる最大の値の数。</param>
+#define WA_NEEDED_BUFFER_WORDS(capacity) \
+	(8 * (capacity))
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+	/* -------------------------------------------------------------------
+	*	Services
+	*/
+
+	/// <summary>
+	/// <para>窓集計</para>
+	/// <para>直近の値の合計、数、最小値、最大値を、Pushのたびに差分で更新する。</para>
+	/// <para>窓は直近のcapacity個、または直近の一定時間で、窓から外れた値は古い方から取り除く。</para>
+	/// <para>最小値、最大値は単調な候補列(monotonic deque)で管理し、
+	/// 更新、取得とも償却O(1)となる。</para>
+	/// <para>フレームリングバッファとは独立しており、フレームから取り出した値をPushして使う。</para>
+	/// </summary>
+	typedef struct _WindowedAggregates
+	{
+		/// <summary>窓に含められる最大の値の数</summary>
+		int32_t Capacity;
+		/// <summary>パディング</summary>
+		int32_t Padding;
+		/// <summary>窓の時間幅(0以下で時間では取り除かない)</summary>
+		int64_t TimeSpan;
+		/// <summary>次にPushされる値の番号</summary>
+		int64_t Head;
+		/// <summary>窓の最古の値の番号</summary>
+		int64_t Tail;
+		/// <summary>窓の値の合計</summary>
+		int64_t Sum;
+		/// <summary>値のタイムスタンプの履歴(番号 % Capacityの位置)</summary>
+		int64_t* Timestamps;
+		/// <summary>値の履歴(番号 % Capacityの位置)</summary>
+		int64_t* Values;
+		/// <summary>最小値候補列(値の番号、値は先頭から単調増加)</summary>
+		int64_t* MinQueue;
+		/// <summary>最小値候補列の先頭位置</summary>
+		int64_t MinFront;
+		/// <summary>最小値候補列の末尾位置</summary>
+		int64_t MinBack;
+		/// <summary>最大値候補列(値の番号、値は先頭から単調減少)</summary>
+		int64_t* MaxQueue;
+		/// <summary>最大値候補列の先頭位置</summary>
+		int64_t MaxFront;
+		/// <summary>最大値候補列の末尾位置</summary>
+		int64_t MaxBack;
+	} WindowedAggregates;
+
+	/// <summary>
+	/// <para>窓集計を初期化する。</para>
+	/// </summary>
+	/// <param name="capacity">窓に含められる最大の値の数。</param>
+	/// <param name="timeSpan">窓の時間幅。最新のタイムスタンプからtimeSpan未満の値を窓に含める。
+	/// 0以下の場合は、直近のcapacity個を窓とする。</param>
+	/// <param name="buffer">動作に必要なバッファ。
+	/// WA_NEEDED_BUFFER_WORDS分の要素数を持つ、8バイト境界の領域を確保して指定すること。</param>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>なし。</returns>
+	void WindowedAggregates_Init(
+		int32_t capacity,
+		int64_t timeSpan,
+		int32_t* buffer,
+		WindowedAggregates* ctxt);
+
+	/// <summary>
+	/// <para>クリアする。</para>
+	/// </summary>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>なし。</returns>
+	void WindowedAggregates_Clear(
+		WindowedAggregates* ctxt);
+
+	/// <summary>
+	/// <para>値をPushする。</para>
+	/// <para>窓から外れた値は、古い方から取り除く。</para>
+	/// <para>時間幅を指定した場合、タイムスタンプは単調増加していること。</para>
+	/// </summary>
+	/// <param name="value">値。</param>
+	/// <param name="timestamp">タイムスタンプ。</param>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>なし。</returns>
+	void WindowedAggregates_Push(
+		int64_t value,
+		int64_t timestamp,
+		WindowedAggregates* ctxt);
+
+	/// <summary>
+	/// <para>指定時刻で、時間幅から外れた値を取り除く。</para>
+	/// <para>Pushが無い間も窓を進めるために使用する。時間幅を指定していない場合は何もしない。</para>
+	/// </summary>
+	/// <param name="now">現在時刻(タイムスタンプと同じ単位)。</param>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>なし。</returns>
+	void WindowedAggregates_Expire(
+		int64_t now,
+		WindowedAggregates* ctxt);
+
+	/// <summary>
+	/// <para>窓の値の数を取得する。</para>
+	/// </summary>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>窓の値の数。</returns>
+	int32_t WindowedAggregates_Count(
+		const WindowedAggregates* ctxt);
+
+	/// <summary>
+	/// <para>窓の値の合計を取得する。</para>
+	/// </summary>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>窓の値の合計。値が無い場合は0。</returns>
+	int64_t WindowedAggregates_Sum(
+		const WindowedAggregates* ctxt);
+
+	/// <summary>
+	/// <para>窓の値の最小値を取得する。</para>
+	/// </summary>
+	/// <param name="value">最小値の格納先。</param>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>0:値なし、非0:取得した。</returns>
+	int WindowedAggregates_Min(
+		int64_t* value,
+		const WindowedAggregates* ctxt);
+
+	/// <summary>
+	/// <para>窓の値の最大値を取得する。</para>
+	/// </summary>
+	/// <param name="value">最大値の格納先。</param>
+	/// <param name="ctxt">コンテキスト。</param>
+	/// <returns>0:値なし、非0:取得した。</returns>
+	int WindowedAggregates_Max(
+		int64_t* value,
+		const WindowedAggregates* ctxt);
+
+#ifdef _UNIT_TEST
+	void WindowedAggregates_UnitTest(void);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // top
@@ -78,6 +78,8 @@ void Assertions_Init(
 		RingedFrames_Init(
 			capacity, sizeof(Assertions_Item), buffer,
 			&ctxt->Items);
+		// Assertionは、最古を上書きしない、最初のn個を記録するものとする
+		RingedFrames_SetPolicy(RF_POLICY_REJECT_NEWEST, &ctxt->Items);
 	}
 }
 
@@ -97,26 +99,21 @@ void Assertions_AssertWith(
 	if ((ctxt != nullptr) &&
 		(condition == 0))
 	{
-		// Assertionは、最古を上書きしない、最初のn個を記録するものとする
-		if (RingedFrames_Count(&ctxt->Items) <
-			RingedFrames_Capacity(&ctxt->Items))
+		// アイテムを作成
+		Assertions_Item item;
+		item.Line = line;
+		// ターミネータを含めたサイズをコピー
+		size_t fnl = strlen(fileName) + 1;
+		if (fnl > sizeof item.FileName)
 		{
-			// アイテムを作成
-			Assertions_Item item;
-			item.Line = line;
-			// ターミネータを含めたサイズをコピー
-			size_t fnl = strlen(fileName) + 1;
-			if (fnl > sizeof item.FileName)
-			{
-				fnl = sizeof item.FileName;
-			}
-			memcpy(item.FileName, fileName, fnl);
-			// バッファ末尾のターミネータは常時つけてしまう
-			item.FileName[CAPACITY_OF(item.FileName) - 1] = '\0';
-
-			// リングバッファに追加
-			RingedFrames_Push(&item, sizeof item, 0, &ctxt->Items);
+			fnl = sizeof item.FileName;
 		}
+		memcpy(item.FileName, fileName, fnl);
+		// バッファ末尾のターミネータは常時つけてしまう
+		item.FileName[CAPACITY_OF(item.FileName) - 1] = '\0';
+
+		// リングバッファに追加(満杯の場合は記録されない)
+		RingedFrames_Push(&item, sizeof item, 0, &ctxt->Items);
 	}
 }
 
@@ -241,6 +238,20 @@ void Assertions_UnitTest(void)
 	assItem = Assertions_Refer(3, &assertions);
 	assert(assItem == nullptr);
 
+	// -----------------------------------------
+	// 2-7 Capacity 0 records nothing, and does not destroy memories
+	{
+		Assertions zero;
+		int32_t guard[2];
+		memset(guard, 0x5a, sizeof guard);
+		Assertions_Init(0, guard, &zero);
+		Assertions_Assert(0, &zero);
+		assert(Assertions_Count(&zero) == 0);
+		assert(Assertions_Refer(0, &zero) == nullptr);
+		assert(guard[0] == 0x5a5a5a5a);
+		assert(guard[1] == 0x5a5a5a5a);
+	}
+
 	// -----------------------------------------
 	// 3-1 Count(self==nullptr)
 	assert(Assertions_Count(nullptr) == 0);
@@ -1,7 +1,7 @@
 ﻿/** ------------------------------------------------------------------
 *
 *	@file	AvlTree.c
-*	@brief	AVL Tree (subset, without deletion)
+*	@brief	AVL Tree (subset)
 *	@author	H.Someya
 *	@date	2021/04/26
 *
@@ -84,6 +84,18 @@ static int32_t HeightOf(const AvlNode* node)
 	return result;
 }
 /// <summary>
+/// <para>部分木のノード数を取得する。</para>
+/// </summary>
+static int32_t SizeOf(const AvlNode* node)
+{
+	int32_t result = 0;
+	if (node != nullptr)
+	{
+		result = node->Size;
+	}
+	return result;
+}
+/// <summary>
 /// <para>子の最大の高さを取得する。</para>
 /// </summary>
 static int32_t ChildrenMaxHeightOf(const AvlNode* node)
@@ -119,13 +131,25 @@ static int32_t ChildrenBalanceOf(const AvlNode* node)
 	return result;
 }
 /// <summary>
+/// <para>部分木のノード数を更新する。</para>
+/// </summary>
+static void UpdateSize(AvlNode* node)
+{
+	if (node != nullptr)
+	{
+		node->Size = SizeOf(node->Left) + SizeOf(node->Right) + 1;
+	}
+}
+/// <summary>
 /// <para>高さを更新する。</para>
+/// <para>子が変わったときに呼ぶので、部分木のノード数も合わせて更新する。</para>
 /// </summary>
 static void UpdateHeight(AvlNode* node)
 {
 	if (node != nullptr)
 	{
 		node->Height = ChildrenMaxHeightOf(node) + 1;
+		UpdateSize(node);
 	}
 }
 
@@ -203,10 +227,11 @@ static void Replace(const AvlNode* from, AvlNode* to)
 	AvlNode* right = RightOf(from);
 	AdoptAsRight(right, to);
 
-	// Heightを引き継ぐ
+	// Height、Sizeを引き継ぐ
 	if (to != nullptr)
 	{
 		to->Height = HeightOf(from);
+		to->Size = SizeOf(from);
 	}
 }
 
@@ -321,6 +346,7 @@ static void Insert(
 					// 左がない -> 見つかった。ここに挿入
 					AdoptAsLeft(node, parent);
 					node->Height = 1;
+					node->Size = 1;
 					node->Left = nullptr;
 					node->Right = nullptr;
 
@@ -340,6 +366,7 @@ static void Insert(
 					// 右がない -> 見つかった。ここに挿入
 					AdoptAsRight(node, parent);
 					node->Height = 1;
+					node->Size = 1;
 					node->Left = nullptr;
 					node->Right = nullptr;
 
@@ -426,11 +453,12 @@ static AvlNode* Balance(AvlNode* node)
 		parent = ParentOf(target);
 	}
 
-	// 新しいrootを探す
+	// 新しいrootを探す(高さが変わらなくても、ノード数は変わるので更新する)
 	AvlNode* root = target;
 	AvlNode* rootParent = ParentOf(root);
 	while (rootParent != nullptr)
 	{
+		UpdateSize(rootParent);
 		root = rootParent;
 		rootParent = ParentOf(root);
 	}
@@ -438,6 +466,54 @@ static AvlNode* Balance(AvlNode* node)
 	return root;
 }
 
+/// <summary>
+/// <para>削除で部分木が低くなった位置から、rootまでのバランスをとる。</para>
+/// <para>削除では回転後も高さが変わりうるので、rootまで辿る。</para>
+/// <para>更新されたrootを返す。</para>
+/// </summary>
+static AvlNode* Rebalance(AvlNode* node)
+{
+	AvlNode* root = node;
+	AvlNode* target = node;
+	while (target != nullptr)
+	{
+		int32_t balance = ChildrenBalanceOf(target);
+		if (balance >= 2)
+		{
+			// 左が高い
+			if (ChildrenBalanceOf(LeftOf(target)) >= 0)
+			{
+				target = RotateRight(target);
+			}
+			else
+			{
+				target = RotateLeftRight(target);
+			}
+		}
+		else if (balance <= -2)
+		{
+			// 右が高い
+			if (ChildrenBalanceOf(RightOf(target)) <= 0)
+			{
+				target = RotateLeft(target);
+			}
+			else
+			{
+				target = RotateRightLeft(target);
+			}
+		}
+		else
+		{
+			UpdateHeight(target);
+		}
+
+		// 次へ
+		root = target;
+		target = ParentOf(target);
+	}
+	return root;
+}
+
 /* -------------------------------------------------------------------
 *	Services
 */
@@ -458,6 +534,7 @@ void AvlNode_Init(
 		memset(node, 0, sizeof(AvlNode));
 
 		node->Height = 1;
+		node->Size = 1;
 		node->Content.Key = key;
 		node->Content.Value = value;
 	}
@@ -514,6 +591,353 @@ AvlNode* AvlTree_Insert(
 	return newRoot;
 }
 
+/// <summary>
+/// <para>ノードのKeyに該当するノードを検索し、無ければそのノードを挿入する。</para>
+/// <para>検索で辿った位置にそのまま挿入するので、rootから辿るのは1回で済む。</para>
+/// <para>該当するノードがある場合は、何も変更しない。</para>
+/// </summary>
+/// <param name="node">挿入するノード。</param>
+/// <param name="root">treeのrootノードの格納先。挿入した場合は更新される。</param>
+/// <returns>該当するノード(挿入した場合は、挿入したノード)。</returns>
+AvlNode* AvlTree_SearchOrInsert(
+	AvlNode* node,
+	AvlNode** root)
+{
+	AvlNode* result = nullptr;
+	if ((node != nullptr) && (root != nullptr))
+	{
+		AvlNode* parent = nullptr;
+		AvlNode** link = root;
+		while (*link != nullptr)
+		{
+			parent = *link;
+			if (node->Content.Key < parent->Content.Key)
+			{
+				link = &parent->Left;
+			}
+			else if (node->Content.Key > parent->Content.Key)
+			{
+				link = &parent->Right;
+			}
+			else
+			{
+				// HIT!
+				result = parent;
+				break;
+			}
+		}
+
+		if (result == nullptr)
+		{
+			// 辿り着いた空き位置に挿入
+			node->Height = 1;
+			node->Size = 1;
+			node->Left = nullptr;
+			node->Right = nullptr;
+			node->Parent = parent;
+			*link = node;
+
+			// バランスをとる
+			*root = Balance(node);
+
+			result = node;
+		}
+	}
+	return result;
+}
+
+/// <summary>
+/// <para>Keyが最小のノードを取得する。</para>
+/// </summary>
+/// <param name="root">treeのrootノード。</param>
+/// <returns>Keyが最小のノード。nullでtreeが空。</returns>
+AvlNode* AvlTree_First(
+	AvlNode* root)
+{
+	AvlNode* node = root;
+	if (node != nullptr)
+	{
+		while (node->Left != nullptr)
+		{
+			node = node->Left;
+		}
+	}
+	return node;
+}
+
+/// <summary>
+/// <para>Keyが最大のノードを取得する。</para>
+/// </summary>
+/// <param name="root">treeのrootノード。</param>
+/// <returns>Keyが最大のノード。nullでtreeが空。</returns>
+AvlNode* AvlTree_Last(
+	AvlNode* root)
+{
+	AvlNode* node = root;
+	if (node != nullptr)
+	{
+		while (node->Right != nullptr)
+		{
+			node = node->Right;
+		}
+	}
+	return node;
+}
+
+/// <summary>
+/// <para>Keyの順で次のノードを取得する。</para>
+/// <para>親へのつながりを辿るので、償却O(1)で進められる。</para>
+/// </summary>
+/// <param name="node">ノード。</param>
+/// <returns>次のノード。nullで最後。</returns>
+AvlNode* AvlTree_Next(
+	AvlNode* node)
+{
+	AvlNode* result = nullptr;
+	if (node != nullptr)
+	{
+		if (node->Right != nullptr)
+		{
+			// 右部分木がある -> 右部分木の最小
+			result = AvlTree_First(node->Right);
+		}
+		else
+		{
+			// 右部分木がない -> 左の子として辿り着く親まで上る
+			const AvlNode* child = node;
+			result = node->Parent;
+			while ((result != nullptr) && (result->Right == child))
+			{
+				child = result;
+				result = result->Parent;
+			}
+		}
+	}
+	return result;
+}
+
+/// <summary>
+/// <para>Keyの順で前のノードを取得する。</para>
+/// </summary>
+/// <param name="node">ノード。</param>
+/// <returns>前のノード。nullで最初。</returns>
+AvlNode* AvlTree_Prev(
+	AvlNode* node)
+{
+	AvlNode* result = nullptr;
+	if (node != nullptr)
+	{
+		if (node->Left != nullptr)
+		{
+			// 左部分木がある -> 左部分木の最大
+			result = AvlTree_Last(node->Left);
+		}
+		else
+		{
+			// 左部分木がない -> 右の子として辿り着く親まで上る
+			const AvlNode* child = node;
+			result = node->Parent;
+			while ((result != nullptr) && (result->Left == child))
+			{
+				child = result;
+				result = result->Parent;
+			}
+		}
+	}
+	return result;
+}
+
+/// <summary>
+/// <para>Keyがkey以上で最小のノードを検索する。</para>
+/// </summary>
+/// <param name="key">検索するKey。</param>
+/// <param name="root">検索開始rootノード。</param>
+/// <returns>該当するノード。nullでなし。</returns>
+AvlNode* AvlTree_LowerBound(
+	AvlKey_t key,
+	AvlNode* root)
+{
+	AvlNode* result = nullptr;
+	AvlNode* node = root;
+	while (node != nullptr)
+	{
+		if (key <= node->Content.Key)
+		{
+			// 候補にして、より小さいものを左に探す
+			result = node;
+			node = node->Left;
+		}
+		else
+		{
+			node = node->Right;
+		}
+	}
+	return result;
+}
+
+/// <summary>
+/// <para>Keyがkeyより大きく最小のノードを検索する。</para>
+/// </summary>
+/// <param name="key">検索するKey。</param>
+/// <param name="root">検索開始rootノード。</param>
+/// <returns>該当するノード。nullでなし。</returns>
+AvlNode* AvlTree_UpperBound(
+	AvlKey_t key,
+	AvlNode* root)
+{
+	AvlNode* result = nullptr;
+	AvlNode* node = root;
+	while (node != nullptr)
+	{
+		if (key < node->Content.Key)
+		{
+			// 候補にして、より小さいものを左に探す
+			result = node;
+			node = node->Left;
+		}
+		else
+		{
+			node = node->Right;
+		}
+	}
+	return result;
+}
+
+/// <summary>
+/// <para>keyより小さいKeyのノード数(keyの順位)を取得する。</para>
+/// <para>部分木のノード数を使うので、O(log n)で求まる。</para>
+/// </summary>
+/// <param name="key">Key。</param>
+/// <param name="root">treeのrootノード。</param>
+/// <returns>keyより小さいKeyのノード数。</returns>
+int32_t AvlTree_Rank(
+	AvlKey_t key,
+	AvlNode* root)
+{
+	int32_t rank = 0;
+	AvlNode* node = root;
+	while (node != nullptr)
+	{
+		if (key <= node->Content.Key)
+		{
+			node = node->Left;
+		}
+		else
+		{
+			// このノードと左部分木はkeyより小さい
+			rank += SizeOf(node->Left) + 1;
+			node = node->Right;
+		}
+	}
+	return rank;
+}
+
+/// <summary>
+/// <para>Keyの小さい方から数えた位置のノードを取得する。</para>
+/// <para>部分木のノード数を使うので、O(log n)で求まる。</para>
+/// </summary>
+/// <param name="rank">位置(0～)。</param>
+/// <param name="root">treeのrootノード。</param>
+/// <returns>位置のノード。nullで範囲外。</returns>
+AvlNode* AvlTree_Select(
+	int32_t rank,
+	AvlNode* root)
+{
+	AvlNode* result = nullptr;
+	AvlNode* node = root;
+	int32_t remaining = rank;
+	while ((node != nullptr) && (remaining >= 0))
+	{
+		int32_t leftSize = SizeOf(node->Left);
+		if (remaining < leftSize)
+		{
+			node = node->Left;
+		}
+		else if (remaining > leftSize)
+		{
+			remaining -= leftSize + 1;
+			node = node->Right;
+		}
+		else
+		{
+			// HIT!
+			result = node;
+			break;
+		}
+	}
+	return result;
+}
+
+/// <summary>
+/// <para>ノードを削除する。</para>
+/// <para>削除したノードは、どのノードともつながっていない状態になる。</para>
+/// </summary>
+/// <param name="node">削除するノード。treeに挿入されていること。</param>
+/// <param name="root">削除元treeのrootノード。</param>
+/// <returns>更新されたtreeのrootノード。nullで空になった。</returns>
+AvlNode* AvlTree_Remove(
+	AvlNode* node,
+	AvlNode* root)
+{
+	AvlNode* newRoot = root;
+	if (node != nullptr)
+	{
+		// バランスをとり始める位置
+		AvlNode* start;
+		// 削除したノードの位置に入るノード
+		AvlNode* heir;
+
+		if ((node->Left != nullptr) && (node->Right != nullptr))
+		{
+			// 子が2つ -> 右部分木の最小のノードを、削除するノードの位置に移す
+			heir = node->Right;
+			while (heir->Left != nullptr)
+			{
+				heir = heir->Left;
+			}
+			if (heir == node->Right)
+			{
+				// 右の子がそのまま成り代わる(右部分木はそのまま)
+				ReplaceChild(node, heir);
+				AdoptAsLeft(node->Left, heir);
+				start = heir;
+			}
+			else
+			{
+				// 移すノードの右部分木を、その親の左につなぎ直してから成り代わる
+				start = heir->Parent;
+				AdoptAsLeft(heir->Right, start);
+				Replace(node, heir);
+			}
+		}
+		else
+		{
+			// 子が1つ以下 -> 子が成り代わる
+			heir = (node->Left != nullptr) ? node->Left : node->Right;
+			ReplaceChild(node, heir);
+			start = node->Parent;
+		}
+
+		if (start != nullptr)
+		{
+			newRoot = Rebalance(start);
+		}
+		else
+		{
+			// rootを削除した
+			newRoot = heir;
+		}
+
+		// 削除したノードの縁を切る
+		node->Parent = nullptr;
+		node->Left = nullptr;
+		node->Right = nullptr;
+		node->Height = 1;
+		node->Size = 1;
+	}
+	return newRoot;
+}
+
 /* -------------------------------------------------------------------
 *	Unit Test
 */
@@ -558,6 +982,13 @@ static void AvlTree_Check(const AvlNode* root, Assertions* assertions)
 		Assertions_Assert(tlh == slh, assertions);
 		Assertions_Assert(trh == srh, assertions);
 
+		// 部分木のノード数が合っていること
+		Assertions_Assert(root->Size == SizeOf(root->Left) + SizeOf(root->Right) + 1, assertions);
+
+		// 子から親へつながっていること
+		Assertions_Assert((root->Left == nullptr) || (root->Left->Parent == root), assertions);
+		Assertions_Assert((root->Right == nullptr) || (root->Right->Parent == root), assertions);
+
 		// 部分木を再帰チェック
 		AvlTree_Check(root->Left, assertions);
 		AvlTree_Check(root->Right, assertions);
@@ -781,5 +1212,201 @@ void AvlTree_UnitTest(void)
 	Assertions_Assert(foundValue != nullptr, assertions);
 	Assertions_Assert(foundValue->Member1 == (10 * 2) + 1 + 1, assertions);
 
+	// -----------------------------------------
+	// 6-1 Remove(node==nullptr)
+	root = nullptr;
+	for (int32_t i = 0; i < 30; i++)
+	{
+		// 挿入順をばらけさせる
+		AvlKey_t key = (i * 7) % 30;
+		AvlNode_Init(key, &values[key], &nodes[key]);
+		root = AvlTree_Insert(&nodes[key], root);
+	}
+	Assertions_Assert(AvlTree_Remove(nullptr, root) == root, assertions);
+	AvlTree_Check(root, assertions);
+
+	// -----------------------------------------
+	// 6-2 Remove leaves and inner nodes
+	for (int32_t i = 0; i < 30; i += 2)
+	{
+		root = AvlTree_Remove(&nodes[i], root);
+		// 削除したノードは縁が切れている
+		Assertions_Assert(nodes[i].Parent == nullptr, assertions);
+		Assertions_Assert(nodes[i].Left == nullptr, assertions);
+		Assertions_Assert(nodes[i].Right == nullptr, assertions);
+		// Check structure
+		Assertions_Assert(root != nullptr, assertions);
+		Assertions_Assert(root->Parent == nullptr, assertions);
+		AvlTree_Check(root, assertions);
+	}
+	// Check searches
+	for (int32_t i = 0; i < 30; i++)
+	{
+		searched = AvlTree_Search(i, root);
+		Assertions_Assert(searched == (((i % 2) == 0) ? nullptr : &nodes[i]), assertions);
+	}
+
+	// -----------------------------------------
+	// 6-3 Re-Insert removed nodes
+	for (int32_t i = 0; i < 30; i += 2)
+	{
+		AvlNode_Init(i, &values[i], &nodes[i]);
+		root = AvlTree_Insert(&nodes[i], root);
+	}
+	AvlTree_Check(root, assertions);
+	for (int32_t i = 0; i < 30; i++)
+	{
+		searched = AvlTree_Search(i, root);
+		Assertions_Assert(searched == &nodes[i], assertions);
+	}
+
+	// -----------------------------------------
+	// 6-4 Remove root until empty
+	for (int32_t i = 0; i < 30; i++)
+	{
+		AvlNode* removing = root;
+		root = AvlTree_Remove(removing, root);
+		AvlTree_Check(root, assertions);
+		searched = AvlTree_Search(removing->Content.Key, root);
+		Assertions_Assert(searched == nullptr, assertions);
+		Assertions_Assert((root == nullptr) == (i == 29), assertions);
+	}
+
+	// -----------------------------------------
+	// 6-5 Remove in descent order
+	root = nullptr;
+	for (int32_t i = 0; i < 30; i++)
+	{
+		AvlNode_Init(i, &values[i], &nodes[i]);
+		root = AvlTree_Insert(&nodes[i], root);
+	}
+	for (int32_t i = 29; i >= 0; i--)
+	{
+		root = AvlTree_Remove(&nodes[i], root);
+		AvlTree_Check(root, assertions);
+		searched = AvlTree_Search(i - 1, root);
+		Assertions_Assert(searched == ((i > 0) ? &nodes[i - 1] : nullptr), assertions);
+	}
+	Assertions_Assert(root == nullptr, assertions);
+
+	// -----------------------------------------
+	// 7-1 SearchOrInsert(node==nullptr, root==nullptr)
+	AvlNode_Init(0, &values[0], &nodes[0]);
+	Assertions_Assert(AvlTree_SearchOrInsert(nullptr, &root) == nullptr, assertions);
+	Assertions_Assert(AvlTree_SearchOrInsert(&nodes[0], nullptr) == nullptr, assertions);
+	Assertions_Assert(root == nullptr, assertions);
+	// -----------------------------------------
+	// 7-2 SearchOrInsert 1st node, become a root
+	Assertions_Assert(AvlTree_SearchOrInsert(&nodes[0], &root) == &nodes[0], assertions);
+	Assertions_Assert(root == &nodes[0], assertions);
+	// -----------------------------------------
+	// 7-3 SearchOrInsert new keys
+	for (int32_t i = 1; i < 20; i++)
+	{
+		AvlKey_t key = (i * 7) % 20;
+		AvlNode_Init(key, &values[key], &nodes[key]);
+		Assertions_Assert(AvlTree_SearchOrInsert(&nodes[key], &root) == &nodes[key], assertions);
+		AvlTree_Check(root, assertions);
+		Assertions_Assert(root->Parent == nullptr, assertions);
+	}
+	for (int32_t i = 0; i < 20; i++)
+	{
+		searched = AvlTree_Search(i, root);
+		Assertions_Assert(searched == &nodes[i], assertions);
+	}
+	// -----------------------------------------
+	// 7-4 SearchOrInsert existing keys does not change the tree
+	for (int32_t i = 0; i < 20; i++)
+	{
+		AvlNode* before = root;
+		AvlNode_Init(i, &values[20 + (i % 10)], &nodes[20 + (i % 10)]);
+		Assertions_Assert(AvlTree_SearchOrInsert(&nodes[20 + (i % 10)], &root) == &nodes[i], assertions);
+		Assertions_Assert(root == before, assertions);
+		Assertions_Assert(nodes[i].Content.Value == &values[i], assertions);
+	}
+	AvlTree_Check(root, assertions);
+
+	// -----------------------------------------
+	// 8-1 First, Last, Next, Prev(nullptr)
+	Assertions_Assert(AvlTree_First(nullptr) == nullptr, assertions);
+	Assertions_Assert(AvlTree_Last(nullptr) == nullptr, assertions);
+	Assertions_Assert(AvlTree_Next(nullptr) == nullptr, assertions);
+	Assertions_Assert(AvlTree_Prev(nullptr) == nullptr, assertions);
+	// -----------------------------------------
+	// 8-2 Next visits in key order
+	root = nullptr;
+	for (int32_t i = 0; i < 30; i++)
+	{
+		int32_t n = (i * 11) % 30;
+		AvlNode_Init(n * 2, &values[n], &nodes[n]);
+		root = AvlTree_Insert(&nodes[n], root);
+	}
+	searched = AvlTree_First(root);
+	for (int32_t i = 0; i < 30; i++)
+	{
+		Assertions_Assert(searched == &nodes[i], assertions);
+		searched = AvlTree_Next(searched);
+	}
+	Assertions_Assert(searched == nullptr, assertions);
+	// -----------------------------------------
+	// 8-3 Prev visits in reverse key order
+	searched = AvlTree_Last(root);
+	for (int32_t i = 29; i >= 0; i--)
+	{
+		Assertions_Assert(searched == &nodes[i], assertions);
+		searched = AvlTree_Prev(searched);
+	}
+	Assertions_Assert(searched == nullptr, assertions);
+	// -----------------------------------------
+	// 8-4 LowerBound, UpperBound
+	for (AvlKey_t key = -2; key <= 60; key++)
+	{
+		int32_t lower = (key < 0) ? 0 : ((key + 1) / 2);
+		int32_t upper = (key < 0) ? 0 : ((key / 2) + 1);
+		searched = AvlTree_LowerBound(key, root);
+		Assertions_Assert(searched == ((lower < 30) ? &nodes[lower] : nullptr), assertions);
+		searched = AvlTree_UpperBound(key, root);
+		Assertions_Assert(searched == ((upper < 30) ? &nodes[upper] : nullptr), assertions);
+	}
+	Assertions_Assert(AvlTree_LowerBound(0, nullptr) == nullptr, assertions);
+	Assertions_Assert(AvlTree_UpperBound(0, nullptr) == nullptr, assertions);
+
+	// -----------------------------------------
+	// 9-1 Rank, Select(root==nullptr)
+	Assertions_Assert(AvlTree_Rank(0, nullptr) == 0, assertions);
+	Assertions_Assert(AvlTree_Select(0, nullptr) == nullptr, assertions);
+	// -----------------------------------------
+	// 9-2 Rank, Select (keys 0, 2, ..., 58)
+	Assertions_Assert(root->Size == 30, assertions);
+	for (AvlKey_t key = -1; key <= 60; key++)
+	{
+		int32_t rank = (key <= 0) ? 0 : ((key + 1) / 2);
+		Assertions_Assert(AvlTree_Rank(key, root) == ((rank < 30) ? rank : 30), assertions);
+	}
+	for (int32_t i = 0; i < 30; i++)
+	{
+		Assertions_Assert(AvlTree_Select(i, root) == &nodes[i], assertions);
+	}
+	Assertions_Assert(AvlTree_Select(-1, root) == nullptr, assertions);
+	Assertions_Assert(AvlTree_Select(30, root) == nullptr, assertions);
+	// -----------------------------------------
+	// 9-3 Rank, Select follow Remove and duplicated Insert
+	for (int32_t i = 0; i < 30; i += 3)
+	{
+		root = AvlTree_Remove(&nodes[i], root);
+	}
+	AvlNode_Init(10, &values[0], &nodes[0]);
+	root = AvlTree_Insert(&nodes[0], root);
+	AvlTree_Check(root, assertions);
+	Assertions_Assert(root->Size == 20, assertions);
+	for (int32_t i = 0, r = 0; i < 30; i++)
+	{
+		if ((i % 3) != 0)
+		{
+			Assertions_Assert(AvlTree_Rank(i * 2, root) == r, assertions);
+			Assertions_Assert(AvlTree_Select(r, root)->Content.Key == i * 2, assertions);
+			r += 1;
+		}
+	}
 }
 #endif
@@ -0,0 +1,670 @@
+﻿/** ------------------------------------------------------------------
+*
+*	@file	CompactMap.c
+*	@brief	Compact index-based map (32bits key)
+*	@author	H.Someya
+*	@date	2026/10/17
+*
+MIT License
+
+Copyright (c) 2021 Hirobumi Someya
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*
+*/
+#include "CompactMap.h"
+#include <string.h>
+#include "nullptr.h"
+
+/* -------------------------------------------------------------------
+*	Privates
+*/
+/// <summary>
+/// <para>高さを取得する。</para>
+/// </summary>
+static int32_t HeightOf(int32_t index, const CompactMap* ctxt)
+{
+	int32_t result = 0;
+	if (index != CM_NIL)
+	{
+		result = ctxt->Nodes[index].Height;
+	}
+	return result;
+}
+/// <summary>
+/// <para>平衡値(左の高さ - 右の高さ)を取得する。</para>
+/// </summary>
+static int32_t BalanceOf(int32_t index, const CompactMap* ctxt)
+{
+	int32_t result = 0;
+	if (index != CM_NIL)
+	{
+		const CompactMapNode* node = &ctxt->Nodes[index];
+		result = HeightOf(node->Left, ctxt) - HeightOf(node->Right, ctxt);
+	}
+	return result;
+}
+/// <summary>
+/// <para>高さを更新する。</para>
+/// </summary>
+static void UpdateHeight(int32_t index, CompactMap* ctxt)
+{
+	CompactMapNode* node = &ctxt->Nodes[index];
+	int32_t lh = HeightOf(node->Left, ctxt);
+	int32_t rh = HeightOf(node->Right, ctxt);
+	node->Height = (uint8_t)(((lh > rh) ? lh : rh) + 1);
+}
+
+/// <summary>
+/// <para>親からのつながりを付け替える。親がCM_NILの場合はrootを付け替える。</para>
+/// </summary>
+static void Relink(int32_t parent, int32_t from, int32_t to, CompactMap* ctxt)
+{
+	if (parent == CM_NIL)
+	{
+		ctxt->Root = to;
+	}
+	else if (ctxt->Nodes[parent].Left == from)
+	{
+		ctxt->Nodes[parent].Left = to;
+	}
+	else
+	{
+		ctxt->Nodes[parent].Right = to;
+	}
+}
+
+/// <summary>
+/// <para>右回転を行う。</para>
+/// <para>部分木の新たなrootを返す。</para>
+/// </summary>
+static int32_t RotateRight(int32_t index, CompactMap* ctxt)
+{
+	int32_t pivot = ctxt->Nodes[index].Left;
+	ctxt->Nodes[index].Left = ctxt->Nodes[pivot].Right;
+	ctxt->Nodes[pivot].Right = index;
+	UpdateHeight(index, ctxt);
+	UpdateHeight(pivot, ctxt);
+	return pivot;
+}
+/// <summary>
+/// <para>左回転を行う。</para>
+/// <para>部分木の新たなrootを返す。</para>
+/// </summary>
+static int32_t RotateLeft(int32_t index, CompactMap* ctxt)
+{
+	int32_t pivot = ctxt->Nodes[index].Right;
+	ctxt->Nodes[index].Right = ctxt->Nodes[pivot].Left;
+	ctxt->Nodes[pivot].Left = index;
+	UpdateHeight(index, ctxt);
+	UpdateHeight(pivot, ctxt);
+	return pivot;
+}
+
+/// <summary>
+/// <para>部分木のバランスをとる。</para>
+/// <para>部分木の新たなrootを返す。</para>
+/// </summary>
+static int32_t BalanceAt(int32_t index, CompactMap* ctxt)
+{
+	int32_t root = index;
+	int32_t balance = BalanceOf(index, ctxt);
+	if (balance >= 2)
+	{
+		// 左が高い
+		CompactMapNode* node = &ctxt->Nodes[index];
+		if (BalanceOf(node->Left, ctxt) < 0)
+		{
+			node->Left = RotateLeft(node->Left, ctxt);
+		}
+		root = RotateRight(index, ctxt);
+	}
+	else if (balance <= -2)
+	{
+		// 右が高い
+		CompactMapNode* node = &ctxt->Nodes[index];
+		if (BalanceOf(node->Right, ctxt) > 0)
+		{
+			node->Right = RotateRight(node->Right, ctxt);
+		}
+		root = RotateLeft(index, ctxt);
+	}
+	else
+	{
+		UpdateHeight(index, ctxt);
+	}
+	return root;
+}
+
+/// <summary>
+/// <para>辿った経路を、下からrootまでバランスをとる。</para>
+/// </summary>
+static void Retrace(const int32_t* path, int32_t depth, CompactMap* ctxt)
+{
+	for (int32_t d = depth - 1; d >= 0; d--)
+	{
+		int32_t index = path[d];
+		int32_t root = BalanceAt(index, ctxt);
+		if (root != index)
+		{
+			Relink((d > 0) ? path[d - 1] : CM_NIL, index, root, ctxt);
+		}
+	}
+}
+
+/// <summary>
+/// <para>要素を別の位置に移し、親からのつながりを付け替える。</para>
+/// </summary>
+static void Move(int32_t from, int32_t to, CompactMap* ctxt)
+{
+	// 親を探す(親へのつながりが無いので、keyで辿る)
+	MapKey_t key = ctxt->Nodes[from].Key;
+	int32_t parent = CM_NIL;
+	int32_t index = ctxt->Root;
+	while (index != from)
+	{
+		parent = index;
+		index = (key < ctxt->Nodes[index].Key) ? ctxt->Nodes[index].Left : ctxt->Nodes[index].Right;
+	}
+
+	ctxt->Nodes[to] = ctxt->Nodes[from];
+	ctxt->Values[to] = ctxt->Values[from];
+	Relink(parent, from, to, ctxt);
+}
+
+/* -------------------------------------------------------------------
+*	Services
+*/
+
+/// <summary>
+/// <para>コンパクトMapを初期化する。</para>
+/// </summary>
+/// <param name="capacity">最大要素数。</param>
+/// <param name="nodes">動作に必要なノードバッファ。
+/// 最大要素数分確保して指定すること。</param>
+/// <param name="values">動作に必要なvalueバッファ。
+/// 最大要素数分確保して指定すること。</param>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>なし。</returns>
+void CompactMap_Init(
+	int32_t capacity,
+	CompactMapNode* nodes,
+	const void** values,
+	CompactMap* ctxt)
+{
+	if (ctxt != nullptr)
+	{
+		memset(ctxt, 0, sizeof(CompactMap));
+		ctxt->Root = CM_NIL;
+		ctxt->Capacity = capacity;
+		ctxt->Nodes = nodes;
+		ctxt->Values = values;
+	}
+}
+
+/// <summary>
+/// <para>コンパクトMapの最大要素数を取得する。</para>
+/// </summary>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>最大要素数。</returns>
+int32_t CompactMap_Capacity(
+	const CompactMap* ctxt)
+{
+	int32_t result = 0;
+	if (ctxt != nullptr)
+	{
+		result = ctxt->Capacity;
+	}
+	return result;
+}
+
+/// <summary>
+/// <para>コンパクトMapの蓄積済み要素数を取得する。</para>
+/// </summary>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>蓄積済み要素数。</returns>
+int32_t CompactMap_Count(
+	const CompactMap* ctxt)
+{
+	int32_t result = 0;
+	if (ctxt != nullptr)
+	{
+		result = ctxt->Count;
+	}
+	return result;
+}
+
+/// <summary>
+/// <para>コンパクトMapをクリアする。</para>
+/// </summary>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>なし。</returns>
+void CompactMap_Clear(
+	CompactMap* ctxt)
+{
+	if (ctxt != nullptr)
+	{
+		ctxt->Count = 0;
+		ctxt->Root = CM_NIL;
+	}
+}
+
+/// <summary>
+/// <para>valueをkeyに関連付ける。</para>
+/// <para>同じkeyが既にある場合、関連付けを上書きする。</para>
+/// <para>※　valueのスコープと定数/変数は、Map_Relateと同様にユーザーが考慮しなければならない。　※</para>
+/// </summary>
+/// <param name="value">値。</param>
+/// <param name="key">キー。</param>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>蓄積済み要素数。関連付けできなかった場合は0。</returns>
+int32_t CompactMap_Relate(
+	const void* value, MapKey_t key,
+	CompactMap* ctxt)
+{
+	int32_t result = 0;
+	if (ctxt != nullptr)
+	{
+		// 辿った経路を覚えながら探す
+		int32_t path[CM_MAX_HEIGHT];
+		int32_t depth = 0;
+		int32_t index = ctxt->Root;
+		while (index != CM_NIL)
+		{
+			const CompactMapNode* node = &ctxt->Nodes[index];
+			if (key == node->Key)
+			{
+				break;
+			}
+			path[depth] = index;
+			depth += 1;
+			index = (key < node->Key) ? node->Left : node->Right;
+		}
+
+		if (index != CM_NIL)
+		{
+			// 同じkey -> 上書き
+			ctxt->Values[index] = value;
+
+			result = ctxt->Count;
+		}
+		else if (ctxt->Count < ctxt->Capacity)
+		{
+			// 辿り着いた空き位置に挿入
+			int32_t added = ctxt->Count;
+			CompactMapNode* node = &ctxt->Nodes[added];
+			memset(node, 0, sizeof(CompactMapNode));
+			node->Key = key;
+			node->Left = CM_NIL;
+			node->Right = CM_NIL;
+			node->Height = 1;
+			ctxt->Values[added] = value;
+			if (depth == 0)
+			{
+				ctxt->Root = added;
+			}
+			else if (key < ctxt->Nodes[path[depth - 1]].Key)
+			{
+				ctxt->Nodes[path[depth - 1]].Left = added;
+			}
+			else
+			{
+				ctxt->Nodes[path[depth - 1]].Right = added;
+			}
+			ctxt->Count += 1;
+
+			// バランスをとる
+			Retrace(path, depth, ctxt);
+
+			result = ctxt->Count;
+		}
+	}
+	return result;
+}
+
+/// <summary>
+/// <para>keyに対応するvalueを取得する。</para>
+/// </summary>
+/// <param name="key">キー。</param>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>keyに対応するvalue。</returns>
+void* CompactMap_ValueFor(
+	MapKey_t key,
+	const CompactMap* ctxt)
+{
+	void* result = nullptr;
+	if (ctxt != nullptr)
+	{
+		int32_t index = ctxt->Root;
+		while (index != CM_NIL)
+		{
+			const CompactMapNode* node = &ctxt->Nodes[index];
+			if (key < node->Key)
+			{
+				index = node->Left;
+			}
+			else if (key > node->Key)
+			{
+				index = node->Right;
+			}
+			else
+			{
+				// HIT!
+				result = (void*)ctxt->Values[index];
+				break;
+			}
+		}
+	}
+	return result;
+}
+
+/// <summary>
+/// <para>指定したインデックス位置のvalueを取得する。</para>
+/// </summary>
+/// <param name="index">インデックス位置(0～)。</param>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>インデックス位置のvalue。</returns>
+void* CompactMap_ValueAt(
+	int32_t index,
+	const CompactMap* ctxt)
+{
+	void* result = nullptr;
+	if ((ctxt != nullptr) &&
+		(0 <= index) && (index < ctxt->Count))
+	{
+		result = (void*)ctxt->Values[index];
+	}
+	return result;
+}
+
+/// <summary>
+/// <para>指定したインデックス位置のkeyを取得する。</para>
+/// </summary>
+/// <param name="index">インデックス位置(0～)。</param>
+/// <param name="orDefault">取得できない場合のデフォルト値。</param>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>インデックス位置のkey。</returns>
+MapKey_t CompactMap_KeyAt(
+	int32_t index,
+	MapKey_t orDefault,
+	const CompactMap* ctxt)
+{
+	MapKey_t result = orDefault;
+	if ((ctxt != nullptr) &&
+		(0 <= index) && (index < ctxt->Count))
+	{
+		result = ctxt->Nodes[index].Key;
+	}
+	return result;
+}
+
+/// <summary>
+/// <para>keyの関連付けを削除する。</para>
+/// <para>空いた要素には最後の要素を移して詰める。</para>
+/// <para>※　要素のインデックス位置は変わることがある。　※</para>
+/// </summary>
+/// <param name="key">キー。</param>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>0:該当なし、非0:削除した。</returns>
+int CompactMap_Remove(
+	MapKey_t key,
+	CompactMap* ctxt)
+{
+	int result = 0;
+	if (ctxt != nullptr)
+	{
+		// 辿った経路を覚えながら探す(見つかったノードも経路に含める)
+		int32_t path[CM_MAX_HEIGHT];
+		int32_t depth = 0;
+		int32_t index = ctxt->Root;
+		while (index != CM_NIL)
+		{
+			const CompactMapNode* node = &ctxt->Nodes[index];
+			path[depth] = index;
+			depth += 1;
+			if (key == node->Key)
+			{
+				break;
+			}
+			index = (key < node->Key) ? node->Left : node->Right;
+		}
+
+		if (index != CM_NIL)
+		{
+			// 木から外すノード
+			int32_t removing = index;
+			CompactMapNode* node = &ctxt->Nodes[index];
+			if ((node->Left != CM_NIL) && (node->Right != CM_NIL))
+			{
+				// 子が2つ -> 右部分木の最小のノードの内容を移し、そのノードを外す
+				removing = node->Right;
+				path[depth] = removing;
+				depth += 1;
+				while (ctxt->Nodes[removing].Left != CM_NIL)
+				{
+					removing = ctxt->Nodes[removing].Left;
+					path[depth] = removing;
+					depth += 1;
+				}
+				node->Key = ctxt->Nodes[removing].Key;
+				ctxt->Values[index] = ctxt->Values[removing];
+			}
+
+			// 外すノードの子は1つ以下なので、子が成り代わる
+			const CompactMapNode* removed = &ctxt->Nodes[removing];
+			int32_t heir = (removed->Left != CM_NIL) ? removed->Left : removed->Right;
+			depth -= 1;
+			Relink((depth > 0) ? path[depth - 1] : CM_NIL, removing, heir, ctxt);
+
+			// バランスをとる
+			Retrace(path, depth, ctxt);
+
+			// 最後の要素を空いた位置に詰める
+			int32_t last = ctxt->Count - 1;
+			if (removing != last)
+			{
+				Move(last, removing, ctxt);
+			}
+			ctxt->Count -= 1;
+
+			result = 1;
+		}
+	}
+	return result;
+}
+
+/* -------------------------------------------------------------------
+*	Unit Test
+*/
+#ifdef _UNIT_TEST
+#include "Assertions.h"
+
+/// <summary>
+/// <para>部分木の構造を確認し、辿った高さを返す。</para>
+/// <para>keyの範囲外のノード、記憶された高さの違い、平衡の崩れがあれば負を返す。</para>
+/// </summary>
+static int32_t CompactMap_CheckedHeightOf(
+	int32_t index,
+	int64_t lower, int64_t upper,
+	int32_t* reached,
+	const CompactMap* ctxt)
+{
+	int32_t height = 0;
+	if (index != CM_NIL)
+	{
+		const CompactMapNode* node = &ctxt->Nodes[index];
+		*reached += 1;
+		int32_t lh = CompactMap_CheckedHeightOf(node->Left, lower, node->Key, reached, ctxt);
+		int32_t rh = CompactMap_CheckedHeightOf(node->Right, node->Key, upper, reached, ctxt);
+		height = ((lh > rh) ? lh : rh) + 1;
+		if ((lh < 0) || (rh < 0) ||
+			(node->Key <= lower) || (upper <= node->Key) ||
+			(lh - rh > 1) || (rh - lh > 1) ||
+			(node->Height != height))
+		{
+			height = -1;
+		}
+	}
+	return height;
+}
+
+/// <summary>
+/// <para>木の構造が正しく、全ての要素がつながっているか確認する。</para>
+/// </summary>
+static int CompactMap_IsValid(const CompactMap* ctxt)
+{
+	int32_t reached = 0;
+	int32_t height = CompactMap_CheckedHeightOf(ctxt->Root, INT64_MIN, INT64_MAX, &reached, ctxt);
+	return (height >= 0) && (reached == ctxt->Count);
+}
+
+void CompactMap_UnitTest(void)
+{
+	Assertions* assertions = Assertions_Instance();
+	CompactMapNode nodes[128];
+	const void* values[128];
+	int32_t expected[256];
+	int32_t present[256];
+	CompactMap map;
+
+	// -----------------------------------------
+	// 1-1 Init(ctxt==nullptr)
+	CompactMap_Init(128, nodes, values, nullptr);
+	// -----------------------------------------
+	// 1-2 Init
+	CompactMap_Init(128, nodes, values, &map);
+	Assertions_Assert(CompactMap_Capacity(&map) == 128, assertions);
+	Assertions_Assert(CompactMap_Count(&map) == 0, assertions);
+	Assertions_Assert(CompactMap_ValueFor(0, &map) == nullptr, assertions);
+	// -----------------------------------------
+	// 1-3 Node is compact
+	Assertions_Assert(sizeof(CompactMapNode) == 16, assertions);
+
+	// -----------------------------------------
+	// 2-1 Capacity, Count(ctxt==nullptr)
+	Assertions_Assert(CompactMap_Capacity(nullptr) == 0, assertions);
+	Assertions_Assert(CompactMap_Count(nullptr) == 0, assertions);
+
+	// -----------------------------------------
+	// 3-1 Relate(ctxt==nullptr)
+	Assertions_Assert(CompactMap_Relate(&expected[0], 1, nullptr) == 0, assertions);
+	// -----------------------------------------
+	// 3-2 Relate sequential keys
+	for (int32_t i = 0; i < 128; i++)
+	{
+		Assertions_Assert(CompactMap_Relate(&expected[i], i, &map) == i + 1, assertions);
+		Assertions_Assert(CompactMap_IsValid(&map), assertions);
+	}
+	for (int32_t i = 0; i < 128; i++)
+	{
+		Assertions_Assert(CompactMap_ValueFor(i, &map) == &expected[i], assertions);
+		Assertions_Assert(CompactMap_ValueAt(i, &map) == &expected[i], assertions);
+		Assertions_Assert(CompactMap_KeyAt(i, -1, &map) == i, assertions);
+	}
+	Assertions_Assert(CompactMap_ValueFor(128, &map) == nullptr, assertions);
+	// -----------------------------------------
+	// 3-3 Relate いっぱいの場合には新たなキーは挿入できない
+	Assertions_Assert(CompactMap_Relate(&expected[0], 128, &map) == 0, assertions);
+	// -----------------------------------------
+	// 3-4 Relate 同じキーは上書き
+	Assertions_Assert(CompactMap_Relate(&expected[200], 5, &map) == 128, assertions);
+	Assertions_Assert(CompactMap_ValueFor(5, &map) == &expected[200], assertions);
+
+	// -----------------------------------------
+	// 4-1 ValueAt, KeyAt(ctxt==nullptr, out of range)
+	Assertions_Assert(CompactMap_ValueAt(0, nullptr) == nullptr, assertions);
+	Assertions_Assert(CompactMap_ValueAt(-1, &map) == nullptr, assertions);
+	Assertions_Assert(CompactMap_ValueAt(128, &map) == nullptr, assertions);
+	Assertions_Assert(CompactMap_KeyAt(0, -1, nullptr) == -1, assertions);
+	Assertions_Assert(CompactMap_KeyAt(128, -1, &map) == -1, assertions);
+
+	// -----------------------------------------
+	// 5-1 Remove(ctxt==nullptr, key not found)
+	Assertions_Assert(CompactMap_Remove(5, nullptr) == 0, assertions);
+	Assertions_Assert(CompactMap_Remove(128, &map) == 0, assertions);
+	Assertions_Assert(CompactMap_Count(&map) == 128, assertions);
+	// -----------------------------------------
+	// 5-2 Remove in descent order
+	for (int32_t i = 127; i >= 0; i--)
+	{
+		Assertions_Assert(CompactMap_Remove(i, &map) != 0, assertions);
+		Assertions_Assert(CompactMap_IsValid(&map), assertions);
+		Assertions_Assert(CompactMap_ValueFor(i, &map) == nullptr, assertions);
+		if (i > 0)
+		{
+			Assertions_Assert(CompactMap_ValueFor(i - 1, &map) != nullptr, assertions);
+		}
+	}
+	Assertions_Assert(map.Root == CM_NIL, assertions);
+
+	// -----------------------------------------
+	// 6-1 Random Relate and Remove, compared with a plain table
+	memset(present, 0, sizeof present);
+	uint32_t seed = 12345u;
+	int32_t count = 0;
+	for (int32_t step = 0; step < 4000; step++)
+	{
+		seed = (seed * 1103515245u) + 12345u;
+		MapKey_t key = (MapKey_t)((seed >> 16) % 256u) - 128;
+		int32_t slot = key + 128;
+		if (((seed >> 8) & 1u) != 0)
+		{
+			int32_t related = CompactMap_Relate(&expected[slot], key, &map);
+			if ((present[slot] != 0) || (count < 128))
+			{
+				count += (present[slot] == 0) ? 1 : 0;
+				present[slot] = 1;
+				Assertions_Assert(related == count, assertions);
+			}
+			else
+			{
+				Assertions_Assert(related == 0, assertions);
+			}
+		}
+		else
+		{
+			int removed = CompactMap_Remove(key, &map);
+			Assertions_Assert((removed != 0) == (present[slot] != 0), assertions);
+			count -= (present[slot] != 0) ? 1 : 0;
+			present[slot] = 0;
+		}
+		Assertions_Assert(CompactMap_Count(&map) == count, assertions);
+		if ((step % 64) == 0)
+		{
+			Assertions_Assert(CompactMap_IsValid(&map), assertions);
+			for (int32_t k = 0; k < 256; k++)
+			{
+				const void* found = CompactMap_ValueFor(k - 128, &map);
+				Assertions_Assert(found == ((present[k] != 0) ? &expected[k] : nullptr), assertions);
+			}
+		}
+	}
+	Assertions_Assert(CompactMap_IsValid(&map), assertions);
+
+	// -----------------------------------------
+	// 7-1 Clear(ctxt==nullptr)
+	CompactMap_Clear(nullptr);
+	Assertions_Assert(CompactMap_Count(&map) == count, assertions);
+	// -----------------------------------------
+	// 7-2 Clear
+	CompactMap_Clear(&map);
+	Assertions_Assert(CompactMap_Count(&map) == 0, assertions);
+	Assertions_Assert(CompactMap_ValueFor(0, &map) == nullptr, assertions);
+}
+#endif
@@ -0,0 +1,663 @@
+﻿/** ------------------------------------------------------------------
+*
+*	@file	CompressedFrames.c
+*	@brief	Delta and run-length compressed frame ring buffer
+*	@author	H.Someya
+*	@date	2026/10/17
+*
+MIT License
+
+Copyright (c) 2021 Hirobumi Someya
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*
+*/
+#include "CompressedFrames.h"
+#include <string.h>
+#include "nullptr.h"
+
+/* -------------------------------------------------------------------
+*	Privates
+*/
+/// <summary>
+/// <para>圧縮したフレームの種別：キーフレーム。</para>
+/// </summary>
+#define CF_KIND_KEYFRAME (0)
+/// <summary>
+/// <para>圧縮したフレームの種別：直前のフレームとの差分。</para>
+/// </summary>
+#define CF_KIND_DELTA (1)
+
+/// <summary>
+/// <para>符号化するバイト(基準フレームとのXOR差分)を取得する。</para>
+/// </summary>
+static uint8_t DeltaAt(
+	int32_t i,
+	const uint8_t* frame,
+	const uint8_t* base, int32_t baseLength)
+{
+	return (uint8_t)(frame[i] ^ ((i < baseLength) ? base[i] : 0));
+}
+
+/// <summary>
+/// <para>ランレングス符号化する(PackBits)。</para>
+/// <para>基準フレームがある場合は、基準フレームとのXOR差分を符号化する(基準より長い部分はそのまま)。</para>
+/// <para>制御バイトが0～127の場合は続く(制御バイト+1)バイトをそのまま、
+/// 129～255の場合は続く1バイトを(257-制御バイト)回繰り返す。</para>
+/// <para>繰り返しは3バイト以上の連続から始め、2バイトの連続はそのままの方に含める。
+/// そのままの方の制御バイトは後に続く繰り返しで取り返すので、
+/// 最悪でも128バイトごとに1バイト増えるだけとなる。</para>
+/// </summary>
+static int32_t Encode(
+	const uint8_t* frame, int32_t length,
+	const uint8_t* base, int32_t baseLength,
+	uint8_t* dest)
+{
+	int32_t di = 0;
+	int32_t i = 0;
+	while (i < length)
+	{
+		// 同じ値の連続を数える
+		uint8_t v = DeltaAt(i, frame, base, baseLength);
+		int32_t run = 1;
+		while ((i + run < length) && (run < 128) &&
+			(DeltaAt(i + run, frame, base, baseLength) == v))
+		{
+			run += 1;
+		}
+
+		if (run >= 3)
+		{
+			dest[di++] = (uint8_t)(257 - run);
+			dest[di++] = v;
+			i += run;
+		}
+		else
+		{
+			// 次に3バイト以上の連続が始まるまで、そのまま書き出す
+			int32_t ci = di++;
+			int32_t n = 0;
+			while ((i < length) && (n < 128))
+			{
+				uint8_t cur = DeltaAt(i, frame, base, baseLength);
+				if ((n > 0) && (i + 2 < length) &&
+					(DeltaAt(i + 1, frame, base, baseLength) == cur) &&
+					(DeltaAt(i + 2, frame, base, baseLength) == cur))
+				{
+					break;
+				}
+				dest[di++] = cur;
+				i += 1;
+				n += 1;
+			}
+			dest[ci] = (uint8_t)(n - 1);
+		}
+	}
+	return di;
+}
+
+/// <summary>
+/// <para>ランレングス符号を復号する。</para>
+/// <para>格納先の先頭baseLengthバイトに基準フレームがあるものとして、XOR差分を戻す。</para>
+/// </summary>
+static int Decode(
+	const uint8_t* src, int32_t srcLength,
+	uint8_t* frame, int32_t length,
+	int32_t baseLength)
+{
+	int32_t si = 0;
+	int32_t oi = 0;
+	while ((si < srcLength) && (oi < length))
+	{
+		int32_t control = src[si++];
+		if (control < 128)
+		{
+			// そのまま
+			for (int32_t n = 0; (n <= control) && (si < srcLength) && (oi < length); n++)
+			{
+				uint8_t v = src[si++];
+				frame[oi] = (oi < baseLength) ? (uint8_t)(frame[oi] ^ v) : v;
+				oi += 1;
+			}
+		}
+		else if ((control > 128) && (si < srcLength))
+		{
+			// 繰り返し
+			uint8_t v = src[si++];
+			for (int32_t n = 0; (n < 257 - control) && (oi < length); n++)
+			{
+				frame[oi] = (oi < baseLength) ? (uint8_t)(frame[oi] ^ v) : v;
+				oi += 1;
+			}
+		}
+	}
+	return (oi == length);
+}
+
+/// <summary>
+/// <para>可変長フレームリングバッファ上のインデックスで、圧縮したフレームを参照する。</para>
+/// </summary>
+static const uint8_t* RecordAt(
+	int32_t index,
+	int32_t* recordLength,
+	int64_t* timestamp,
+	const CompressedFrames* ctxt)
+{
+	return (const uint8_t*)PackedFrames_ReferWithOld(index, recordLength, timestamp, &ctxt->Packed);
+}
+
+/// <summary>
+/// <para>最古のキーフレームの、可変長フレームリングバッファ上のインデックスを取得する。</para>
+/// <para>それより古い差分フレームは、基準が上書きされているので復号できない。</para>
+/// </summary>
+static int32_t FirstKeyframe(const CompressedFrames* ctxt)
+{
+	int32_t count = PackedFrames_Count(&ctxt->Packed);
+	int32_t pi = 0;
+	while (pi < count)
+	{
+		const uint8_t* record = RecordAt(pi, nullptr, nullptr, ctxt);
+		if (record[0] == CF_KIND_KEYFRAME)
+		{
+			break;
+		}
+		pi += 1;
+	}
+	return pi;
+}
+
+/* -------------------------------------------------------------------
+*	Services
+*/
+
+/// <summary>
+/// <para>圧縮フレームリングバッファを初期化する。</para>
+/// </summary>
+/// <param name="capacity">最大蓄積可能フレーム数。</param>
+/// <param name="frameSize">最大フレームサイズ。</param>
+/// <param name="keyframeInterval">キーフレーム間隔(更新数)。1で全てキーフレームとする。</param>
+/// <param name="dataWords">データ領域のワード数。
+/// PF_RECORD_WORDS(CF_RECORD_SIZE(frameSize))以上を指定すること。</param>
+/// <param name="buffer">動作に必要なバッファ。
+/// CF_NEEDED_BUFFER_WORDS分の要素数を持つ領域を確保して指定すること。</param>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>なし。</returns>
+void CompressedFrames_Init(
+	int32_t capacity, int32_t frameSize,
+	int32_t keyframeInterval,
+	int32_t dataWords,
+	int32_t* buffer,
+	CompressedFrames* ctxt)
+{
+	if (ctxt != nullptr)
+	{
+		memset(ctxt, 0, sizeof(CompressedFrames));
+		PackedFrames_Init(
+			capacity, CF_RECORD_SIZE(frameSize), dataWords,
+			buffer,
+			&ctxt->Packed);
+		ctxt->FrameSize = frameSize;
+		ctxt->KeyframeInterval = (keyframeInterval > 0) ? keyframeInterval : 1;
+		// 作業領域は、可変長フレームリングバッファの後ろに配置する
+		if (buffer != nullptr)
+		{
+			int32_t* work = &buffer[PF_NEEDED_BUFFER_WORDS(capacity, dataWords)];
+			ctxt->Previous = (uint8_t*)&work[0];
+			ctxt->Record = (uint8_t*)&work[(frameSize + 3) / 4];
+		}
+	}
+}
+
+/// <summary>
+/// <para>クリアする。</para>
+/// </summary>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>なし。</returns>
+void CompressedFrames_Clear(
+	CompressedFrames* ctxt)
+{
+	if (ctxt != nullptr)
+	{
+		PackedFrames_Clear(&ctxt->Packed);
+		ctxt->PreviousLength = 0;
+	}
+}
+
+/// <summary>
+/// <para>読み出せるフレーム数を取得する。</para>
+/// <para>キーフレームが上書きされて復号できない、最古側の差分フレームは含まない。</para>
+/// </summary>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>読み出せるフレーム数。</returns>
+int32_t CompressedFrames_Count(
+	const CompressedFrames* ctxt)
+{
+	int32_t result = 0;
+	if (ctxt != nullptr)
+	{
+		result = PackedFrames_Count(&ctxt->Packed) - FirstKeyframe(ctxt);
+	}
+	return result;
+}
+
+/// <summary>
+/// <para>現在のフレーム更新数を取得する。</para>
+/// </summary>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>現在のフレーム更新数。</returns>
+int64_t CompressedFrames_UpdateCount(
+	const CompressedFrames* ctxt)
+{
+	int64_t result = 0;
+	if (ctxt != nullptr)
+	{
+		result = PackedFrames_UpdateCount(&ctxt->Packed);
+	}
+	return result;
+}
+
+/// <summary>
+/// <para>最大フレームサイズを取得する。</para>
+/// </summary>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>最大フレームサイズ。</returns>
+int32_t CompressedFrames_FrameSize(
+	const CompressedFrames* ctxt)
+{
+	int32_t result = 0;
+	if (ctxt != nullptr)
+	{
+		result = ctxt->FrameSize;
+	}
+	return result;
+}
+
+/// <summary>
+/// <para>フレームを圧縮してPushする。</para>
+/// <para>最大蓄積可能フレーム数まで蓄積されているか、データ領域が足りない場合、
+/// 必要な分だけ最古から上書きする。</para>
+/// <para>フレームが無効(null、長さ不正)の場合は、長さ0で記録する。</para>
+/// </summary>
+/// <param name="frame">フレーム。</param>
+/// <param name="length">フレームの長さ。</param>
+/// <param name="timestamp">タイムスタンプ。</param>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>なし。</returns>
+void CompressedFrames_Push(
+	const void* frame, int32_t length,
+	int64_t timestamp,
+	CompressedFrames* ctxt)
+{
+	if ((ctxt != nullptr) &&
+		(ctxt->Record != nullptr))
+	{
+		// フレームが記録されない場合は長さを0にする
+		if ((frame == nullptr) ||
+			(length <= 0) || (ctxt->FrameSize < length))
+		{
+			length = 0;
+		}
+
+		// キーフレームは差分を取らない
+		int keyframe = ((PackedFrames_UpdateCount(&ctxt->Packed) % ctxt->KeyframeInterval) == 0);
+
+		// 0バイト目に種別、1～4バイト目に元のフレーム長を記録する
+		uint8_t* record = ctxt->Record;
+		record[0] = keyframe ? CF_KIND_KEYFRAME : CF_KIND_DELTA;
+		memcpy(&record[1], &length, sizeof(int32_t));
+		int32_t encoded = Encode(
+			(const uint8_t*)frame, length,
+			ctxt->Previous, keyframe ? 0 : ctxt->PreviousLength,
+			&record[CF_RECORD_HEADER_SIZE]);
+		PackedFrames_Push(record, CF_RECORD_HEADER_SIZE + encoded, timestamp, &ctxt->Packed);
+
+		// 次の差分の基準にする
+		if (length > 0)
+		{
+			memcpy(ctxt->Previous, frame, (size_t)length);
+		}
+		ctxt->PreviousLength = length;
+	}
+}
+
+/// <summary>
+/// <para>最古を0としたインデックスで、フレームを格納先に復号する。</para>
+/// <para>直前のキーフレームから順に復号するため、格納先は最大フレームサイズ以上とすること。</para>
+/// </summary>
+/// <param name="index">最古を0としたインデックス。</param>
+/// <param name="buffer">フレームの格納先バッファ。</param>
+/// <param name="bufferSize">フレーム格納先バッファのサイズ。</param>
+/// <param name="timestamp">タイムスタンプの格納先。</param>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>フレーム長。負でフレームなし、または格納先が足りない。</returns>
+int32_t CompressedFrames_ReadWithOld(
+	int32_t index,
+	void* buffer, int32_t bufferSize,
+	int64_t* timestamp,
+	const CompressedFrames* ctxt)
+{
+	// 結果を初期化
+	int32_t length = -1;
+	if (timestamp != nullptr)
+	{
+		*timestamp = 0LL;
+	}
+
+	if ((ctxt != nullptr) &&
+		(buffer != nullptr) &&
+		(bufferSize >= ctxt->FrameSize))
+	{
+		int32_t packedCount = PackedFrames_Count(&ctxt->Packed);
+		int32_t first = FirstKeyframe(ctxt);
+		if ((0 <= index) && (index < packedCount - first))
+		{
+			int32_t target = first + index;
+			int64_t ts;
+			int32_t recordLength;
+			const uint8_t* record = RecordAt(target, &recordLength, &ts, ctxt);
+			if (target == packedCount - 1)
+			{
+				// 最新のフレームは、差分の基準として保持している
+				length = ctxt->PreviousLength;
+				memcpy(buffer, ctxt->Previous, (size_t)length);
+			}
+			else
+			{
+				// 直前のキーフレームまで戻る(キーフレーム間隔以内)
+				int32_t pi = target;
+				while (record[0] != CF_KIND_KEYFRAME)
+				{
+					pi -= 1;
+					record = RecordAt(pi, &recordLength, nullptr, ctxt);
+				}
+
+				// キーフレームから順に、差分を戻していく
+				int32_t baseLength = 0;
+				int ok = 1;
+				for (; (pi <= target) && (ok != 0); pi++)
+				{
+					record = RecordAt(pi, &recordLength, nullptr, ctxt);
+					int32_t frameLength;
+					memcpy(&frameLength, &record[1], sizeof(int32_t));
+					ok = Decode(
+						&record[CF_RECORD_HEADER_SIZE], recordLength - CF_RECORD_HEADER_SIZE,
+						(uint8_t*)buffer, frameLength,
+						(record[0] == CF_KIND_KEYFRAME) ? 0 : baseLength);
+					baseLength = frameLength;
+				}
+				if (ok != 0)
+				{
+					length = baseLength;
+				}
+			}
+
+			if ((length >= 0) &&
+				(timestamp != nullptr))
+			{
+				*timestamp = ts;
+			}
+		}
+	}
+
+	return length;
+}
+
+/// <summary>
+/// <para>最新を0としたインデックスで、フレームを格納先に復号する。</para>
+/// <para>直前のキーフレームから順に復号するため、格納先は最大フレームサイズ以上とすること。</para>
+/// </summary>
+/// <param name="index">最新を0としたインデックス。</param>
+/// <param name="buffer">フレームの格納先バッファ。</param>
+/// <param name="bufferSize">フレーム格納先バッファのサイズ。</param>
+/// <param name="timestamp">タイムスタンプの格納先。</param>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>フレーム長。負でフレームなし、または格納先が足りない。</returns>
+int32_t CompressedFrames_ReadWithNew(
+	int32_t index,
+	void* buffer, int32_t bufferSize,
+	int64_t* timestamp,
+	const CompressedFrames* ctxt)
+{
+	return CompressedFrames_ReadWithOld(
+		CompressedFrames_Count(ctxt) - 1 - index,
+		buffer, bufferSize,
+		timestamp,
+		ctxt);
+}
+
+/* -------------------------------------------------------------------
+*	Unit Test
+*/
+#ifdef _UNIT_TEST
+#include "Assertions.h"
+
+/// <summary>
+/// <para>冗長なテレメトリを模したフレームを作る。</para>
+/// </summary>
+static void MakeTelemetry(int32_t seq, uint8_t* frame, int32_t length)
+{
+	memset(frame, 0, (size_t)length);
+	for (int32_t i = 0; i < length; i += 8)
+	{
+		frame[i] = 0xA5;
+	}
+	frame[4] = (uint8_t)seq;
+	frame[5] = (uint8_t)(seq >> 8);
+	frame[length - 1] = (uint8_t)(seq * 3);
+}
+
+/// <summary>
+/// <para>フレームが期待どおりに復号されたかを確認する。</para>
+/// </summary>
+static int IsTelemetry(int32_t seq, const uint8_t* frame, int32_t length)
+{
+	uint8_t expected[64];
+	MakeTelemetry(seq, expected, length);
+	return (memcmp(expected, frame, (size_t)length) == 0);
+}
+
+void CompressedFrames_UnitTest(void)
+{
+	Assertions* assertions = Assertions_Instance();
+	CompressedFrames ring;
+	static int32_t buffer[1 + CF_NEEDED_BUFFER_WORDS(64, 64, 128) + 1];
+	uint8_t frame[64];
+	uint8_t dataBuffer[64];
+	int32_t length;
+	int64_t timestamp;
+
+	// -----------------------------------------
+	// 1-1 Init(ctxt==nullptr)
+	CompressedFrames_Init(64, 64, 4, 128, &buffer[1], nullptr);
+	// -----------------------------------------
+	// 1-2 Init
+	memset(buffer, -1, sizeof buffer);
+	CompressedFrames_Init(64, 64, 4, 128, &buffer[1], &ring);
+	Assertions_Assert(CompressedFrames_Count(&ring) == 0, assertions);
+	Assertions_Assert(CompressedFrames_UpdateCount(&ring) == 0, assertions);
+	Assertions_Assert(CompressedFrames_FrameSize(&ring) == 64, assertions);
+	// -----------------------------------------
+	// 1-3 Count, UpdateCount, FrameSize(ctxt==nullptr)
+	Assertions_Assert(CompressedFrames_Count(nullptr) == 0, assertions);
+	Assertions_Assert(CompressedFrames_UpdateCount(nullptr) == 0, assertions);
+	Assertions_Assert(CompressedFrames_FrameSize(nullptr) == 0, assertions);
+
+	// -----------------------------------------
+	// 2-1 Read empty
+	length = CompressedFrames_ReadWithOld(0, dataBuffer, sizeof dataBuffer, &timestamp, &ring);
+	Assertions_Assert(length < 0, assertions);
+	Assertions_Assert(timestamp == 0LL, assertions);
+	// -----------------------------------------
+	// 2-2 Push(ctxt==nullptr)
+	CompressedFrames_Push(frame, 64, 22LL, nullptr);
+	// -----------------------------------------
+	// 2-3 Push and read every frame, keyframes every 4 frames
+	for (int32_t seq = 0; seq < 10; seq++)
+	{
+		MakeTelemetry(seq, frame, 64);
+		CompressedFrames_Push(frame, 64, 230LL + seq, &ring);
+	}
+	Assertions_Assert(CompressedFrames_Count(&ring) == 10, assertions);
+	Assertions_Assert(CompressedFrames_UpdateCount(&ring) == 10, assertions);
+	for (int32_t seq = 0; seq < 10; seq++)
+	{
+		length = CompressedFrames_ReadWithOld(seq, dataBuffer, sizeof dataBuffer, &timestamp, &ring);
+		Assertions_Assert(length == 64, assertions);
+		Assertions_Assert(timestamp == 230LL + seq, assertions);
+		Assertions_Assert(IsTelemetry(seq, dataBuffer, 64), assertions);
+	}
+	// -----------------------------------------
+	// 2-4 ReadWithNew
+	length = CompressedFrames_ReadWithNew(0, dataBuffer, sizeof dataBuffer, &timestamp, &ring);
+	Assertions_Assert(length == 64, assertions);
+	Assertions_Assert(timestamp == 239LL, assertions);
+	Assertions_Assert(IsTelemetry(9, dataBuffer, 64), assertions);
+	length = CompressedFrames_ReadWithNew(3, dataBuffer, sizeof dataBuffer, &timestamp, &ring);
+	Assertions_Assert(length == 64, assertions);
+	Assertions_Assert(IsTelemetry(6, dataBuffer, 64), assertions);
+	// -----------------------------------------
+	// 2-5 Out of range, not enough buffer
+	Assertions_Assert(CompressedFrames_ReadWithOld(10, dataBuffer, sizeof dataBuffer, &timestamp, &ring) < 0, assertions);
+	Assertions_Assert(CompressedFrames_ReadWithOld(-1, dataBuffer, sizeof dataBuffer, &timestamp, &ring) < 0, assertions);
+	Assertions_Assert(CompressedFrames_ReadWithOld(0, dataBuffer, 63, &timestamp, &ring) < 0, assertions);
+	Assertions_Assert(CompressedFrames_ReadWithOld(0, nullptr, 64, &timestamp, &ring) < 0, assertions);
+	Assertions_Assert(CompressedFrames_ReadWithOld(0, dataBuffer, sizeof dataBuffer, &timestamp, nullptr) < 0, assertions);
+
+	// -----------------------------------------
+	// 3-1 Different lengths and invalid frames
+	CompressedFrames_Clear(&ring);
+	Assertions_Assert(CompressedFrames_Count(&ring) == 0, assertions);
+	MakeTelemetry(31, frame, 16);
+	CompressedFrames_Push(frame, 16, 310LL, &ring);
+	MakeTelemetry(32, frame, 40);
+	CompressedFrames_Push(frame, 40, 320LL, &ring);
+	CompressedFrames_Push(nullptr, 40, 330LL, &ring);
+	CompressedFrames_Push(frame, 65, 340LL, &ring);
+	MakeTelemetry(35, frame, 8);
+	CompressedFrames_Push(frame, 8, 350LL, &ring);
+	MakeTelemetry(36, frame, 24);
+	CompressedFrames_Push(frame, 24, 360LL, &ring);
+	Assertions_Assert(CompressedFrames_Count(&ring) == 6, assertions);
+	length = CompressedFrames_ReadWithOld(0, dataBuffer, sizeof dataBuffer, &timestamp, &ring);
+	Assertions_Assert(length == 16, assertions);
+	Assertions_Assert(IsTelemetry(31, dataBuffer, 16), assertions);
+	length = CompressedFrames_ReadWithOld(1, dataBuffer, sizeof dataBuffer, &timestamp, &ring);
+	Assertions_Assert(length == 40, assertions);
+	Assertions_Assert(IsTelemetry(32, dataBuffer, 40), assertions);
+	length = CompressedFrames_ReadWithOld(2, dataBuffer, sizeof dataBuffer, &timestamp, &ring);
+	Assertions_Assert(length == 0, assertions);
+	Assertions_Assert(timestamp == 330LL, assertions);
+	length = CompressedFrames_ReadWithOld(3, dataBuffer, sizeof dataBuffer, &timestamp, &ring);
+	Assertions_Assert(length == 0, assertions);
+	length = CompressedFrames_ReadWithOld(4, dataBuffer, sizeof dataBuffer, &timestamp, &ring);
+	Assertions_Assert(length == 8, assertions);
+	Assertions_Assert(IsTelemetry(35, dataBuffer, 8), assertions);
+	length = CompressedFrames_ReadWithOld(5, dataBuffer, sizeof dataBuffer, &timestamp, &ring);
+	Assertions_Assert(length == 24, assertions);
+	Assertions_Assert(IsTelemetry(36, dataBuffer, 24), assertions);
+
+	// -----------------------------------------
+	// 4-1 Incompressible frames still fit
+	CompressedFrames_Clear(&ring);
+	for (int32_t seq = 0; seq < 3; seq++)
+	{
+		for (int32_t i = 0; i < 64; i++)
+		{
+			frame[i] = (uint8_t)((i * 37 + seq * 101) ^ (i >> 1));
+		}
+		CompressedFrames_Push(frame, 64, 410LL + seq, &ring);
+	}
+	length = CompressedFrames_ReadWithOld(CompressedFrames_Count(&ring) - 2, dataBuffer, sizeof dataBuffer, &timestamp, &ring);
+	Assertions_Assert(length == 64, assertions);
+	Assertions_Assert(timestamp == 411LL, assertions);
+	for (int32_t i = 0; i < 64; i++)
+	{
+		frame[i] = (uint8_t)((i * 37 + 101) ^ (i >> 1));
+	}
+	Assertions_Assert(memcmp(frame, dataBuffer, 64) == 0, assertions);
+
+	// -----------------------------------------
+	// 5-1 Redundant frames are stored at least twice as many as uncompressed frames
+	// (128 data words hold only 6 uncompressed 64 bytes frames)
+	CompressedFrames_Clear(&ring);
+	for (int32_t seq = 0; seq < 100; seq++)
+	{
+		MakeTelemetry(seq, frame, 64);
+		CompressedFrames_Push(frame, 64, 510LL + seq, &ring);
+	}
+	Assertions_Assert(128 / PF_RECORD_WORDS(64) == 6, assertions);
+	Assertions_Assert(CompressedFrames_Count(&ring) >= 12, assertions);
+	// -----------------------------------------
+	// 5-2 Oldest readable frame is a keyframe, and every frame is restored
+	{
+		int32_t count = CompressedFrames_Count(&ring);
+		for (int32_t i = 0; i < count; i++)
+		{
+			int32_t seq = 100 - count + i;
+			length = CompressedFrames_ReadWithOld(i, dataBuffer, sizeof dataBuffer, &timestamp, &ring);
+			Assertions_Assert(length == 64, assertions);
+			Assertions_Assert(timestamp == 510LL + seq, assertions);
+			Assertions_Assert(IsTelemetry(seq, dataBuffer, 64), assertions);
+		}
+		Assertions_Assert(((100 - count) % 4) == 0, assertions);
+	}
+
+	// Do not destroy memories
+	Assertions_Assert(buffer[0] == -1, assertions);
+	Assertions_Assert(
+		buffer[((sizeof buffer) / sizeof buffer[0]) - 1] == -1, assertions);
+
+	// -----------------------------------------
+	// 6-1 Literal bytes between pairs ("a bb c dd ...") fit in the record
+	{
+		static int32_t pairBuffer[1 + CF_NEEDED_BUFFER_WORDS(4, 120, 256) + 1];
+		uint8_t pairs[120];
+		uint8_t restored[120];
+		memset(pairBuffer, -1, sizeof pairBuffer);
+		CompressedFrames_Init(4, 120, 2, 256, &pairBuffer[1], &ring);
+		for (int32_t i = 0; i < 120; i++)
+		{
+			// 3バイトごとに、1バイトのそのままと2バイトの連続
+			pairs[i] = (uint8_t)(((i / 3) * 2) + (((i % 3) == 0) ? 0 : 1));
+		}
+		CompressedFrames_Push(pairs, 120, 610LL, &ring);
+		// 差分も同じ形になるフレーム
+		for (int32_t i = 0; i < 120; i++)
+		{
+			restored[i] = (uint8_t)(pairs[i] ^ pairs[119 - i]);
+		}
+		CompressedFrames_Push(restored, 120, 611LL, &ring);
+		Assertions_Assert(CompressedFrames_Count(&ring) == 2, assertions);
+		memset(restored, 0, sizeof restored);
+		length = CompressedFrames_ReadWithOld(0, restored, sizeof restored, &timestamp, &ring);
+		Assertions_Assert(length == 120, assertions);
+		Assertions_Assert(memcmp(pairs, restored, 120) == 0, assertions);
+		length = CompressedFrames_ReadWithOld(1, restored, sizeof restored, &timestamp, &ring);
+		Assertions_Assert(length == 120, assertions);
+		for (int32_t i = 0; i < 120; i++)
+		{
+			Assertions_Assert(restored[i] == (uint8_t)(pairs[i] ^ pairs[119 - i]), assertions);
+		}
+		// Do not destroy memories
+		Assertions_Assert(pairBuffer[0] == -1, assertions);
+		Assertions_Assert(
+			pairBuffer[((sizeof pairBuffer) / sizeof pairBuffer[0]) - 1] == -1, assertions);
+	}
+}
+#endif
@@ -0,0 +1,677 @@
+﻿/** ------------------------------------------------------------------
+*
+*	@file	HashMap.c
+*	@brief	Open-addressing fixed-capacity hash map (32bits key)
+*	@author	H.Someya
+*	@date	2026/10/17
+*
+MIT License
+
+Copyright (c) 2021 Hirobumi Someya
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*
+*/
+#include "HashMap.h"
+#include <string.h>
+#include "nullptr.h"
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define HM_USE_SSE2 (1)
+#include <emmintrin.h>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+/* -------------------------------------------------------------------
+*	Privates
+*/
+/// <summary>
+/// <para>制御バイト：空き(上位ビットが1)。</para>
+/// </summary>
+#define HM_EMPTY ((uint8_t)0x80)
+/// <summary>
+/// <para>制御バイト：削除済み(上位ビットが1)。</para>
+/// </summary>
+#define HM_DELETED ((uint8_t)0xFE)
+
+/// <summary>
+/// <para>keyのハッシュ値を取得する。</para>
+/// <para>連続したkeyでも散らばるように、全ビットを混ぜる。</para>
+/// </summary>
+static uint32_t HashOf(MapKey_t key)
+{
+	uint32_t hash = (uint32_t)key;
+	hash ^= hash >> 16;
+	hash *= 0x85EBCA6Bu;
+	hash ^= hash >> 13;
+	hash *= 0xC2B2AE35u;
+	hash ^= hash >> 16;
+	return hash;
+}
+/// <summary>
+/// <para>ハッシュ値から、制御バイトに記録する値(下位7ビット)を取得する。</para>
+/// </summary>
+static uint8_t TagOf(uint32_t hash)
+{
+	return (uint8_t)(hash & 0x7Fu);
+}
+/// <summary>
+/// <para>ハッシュ値から、最初に調べるグループ番号を取得する。</para>
+/// </summary>
+static int32_t FirstGroupOf(uint32_t hash, const HashMap* ctxt)
+{
+	return (int32_t)(hash >> 7) & ctxt->GroupMask;
+}
+
+/// <summary>
+/// <para>最下位の1のビット位置を取得する。0は指定しないこと。</para>
+/// </summary>
+static int32_t LowestBitOf(uint32_t mask)
+{
+#if defined(__GNUC__)
+	return __builtin_ctz(mask);
+#elif defined(_MSC_VER)
+	unsigned long bit;
+	_BitScanForward(&bit, mask);
+	return (int32_t)bit;
+#else
+	int32_t bit = 0;
+	while ((mask & 1u) == 0)
+	{
+		mask >>= 1;
+		bit += 1;
+	}
+	return bit;
+#endif
+}
+
+#if !defined(HM_USE_SSE2) || defined(_UNIT_TEST)
+/// <summary>
+/// <para>グループの制御バイトのうち、値が一致するものをビットマスクで取得する(スカラー版)。</para>
+/// </summary>
+static uint32_t MatchScalar(const uint8_t* group, uint8_t control)
+{
+	uint32_t mask = 0;
+	for (int32_t i = 0; i < HM_GROUP_WIDTH; i++)
+	{
+		if (group[i] == control)
+		{
+			mask |= 1u << i;
+		}
+	}
+	return mask;
+}
+/// <summary>
+/// <para>グループの制御バイトのうち、空きまたは削除済みのものをビットマスクで取得する(スカラー版)。</para>
+/// </summary>
+static uint32_t MatchAvailableScalar(const uint8_t* group)
+{
+	uint32_t mask = 0;
+	for (int32_t i = 0; i < HM_GROUP_WIDTH; i++)
+	{
+		if ((group[i] & 0x80u) != 0)
+		{
+			mask |= 1u << i;
+		}
+	}
+	return mask;
+}
+#endif
+
+/// <summary>
+/// <para>グループの制御バイトのうち、値が一致するものをビットマスクで取得する。</para>
+/// </summary>
+static uint32_t Match(const uint8_t* group, uint8_t control)
+{
+#ifdef HM_USE_SSE2
+	__m128i controls = _mm_loadu_si128((const __m128i*)group);
+	__m128i equals = _mm_cmpeq_epi8(controls, _mm_set1_epi8((char)control));
+	return (uint32_t)_mm_movemask_epi8(equals);
+#else
+	return MatchScalar(group, control);
+#endif
+}
+/// <summary>
+/// <para>グループの制御バイトのうち、空きまたは削除済みのものをビットマスクで取得する。</para>
+/// </summary>
+static uint32_t MatchAvailable(const uint8_t* group)
+{
+#ifdef HM_USE_SSE2
+	// 空き、削除済みは上位ビットが1なので、上位ビットを集めればよい
+	return (uint32_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)group));
+#else
+	return MatchAvailableScalar(group);
+#endif
+}
+
+/// <summary>
+/// <para>keyのスロットを検索する。</para>
+/// <para>グループを三角数の間隔で調べるので、グループ数が2のべき乗なら全グループを巡る。</para>
+/// <para>空きを含むグループまで来たら、その先には無い。</para>
+/// </summary>
+static int32_t Find(MapKey_t key, uint32_t hash, const HashMap* ctxt)
+{
+	int32_t result = -1;
+	uint8_t tag = TagOf(hash);
+	int32_t group = FirstGroupOf(hash, ctxt);
+	for (int32_t step = 0; step <= ctxt->GroupMask; step++)
+	{
+		const uint8_t* controls = &ctxt->Controls[group * HM_GROUP_WIDTH];
+		uint32_t match = Match(controls, tag);
+		while (match != 0)
+		{
+			int32_t slot = (group * HM_GROUP_WIDTH) + LowestBitOf(match);
+			if (ctxt->Elements[slot].Key == key)
+			{
+				// HIT!
+				result = slot;
+				break;
+			}
+			match &= match - 1;
+		}
+		if ((result >= 0) ||
+			(Match(controls, HM_EMPTY) != 0))
+		{
+			break;
+		}
+		group = (group + step + 1) & ctxt->GroupMask;
+	}
+	return result;
+}
+
+/// <summary>
+/// <para>ハッシュ値の検索順で、最初の空きまたは削除済みのスロットを探す。</para>
+/// </summary>
+static int32_t FindAvailable(uint32_t hash, const HashMap* ctxt)
+{
+	int32_t result = -1;
+	int32_t group = FirstGroupOf(hash, ctxt);
+	for (int32_t step = 0; step <= ctxt->GroupMask; step++)
+	{
+		uint32_t match = MatchAvailable(&ctxt->Controls[group * HM_GROUP_WIDTH]);
+		if (match != 0)
+		{
+			result = (group * HM_GROUP_WIDTH) + LowestBitOf(match);
+			break;
+		}
+		group = (group + step + 1) & ctxt->GroupMask;
+	}
+	return result;
+}
+
+/// <summary>
+/// <para>削除済みのスロットを無くすように、その場で要素を再配置する。</para>
+/// <para>全要素を「未配置」(削除済みの制御バイト)にしてから、検索順で最初の空きに置き直す。</para>
+/// <para>置き直し先が未配置の要素なら入れ替えて、入れ替えた要素を続けて置き直す。</para>
+/// </summary>
+static void DropDeleted(HashMap* ctxt)
+{
+	for (int32_t i = 0; i < ctxt->SlotCount; i++)
+	{
+		uint8_t control = ctxt->Controls[i];
+		ctxt->Controls[i] = ((control & 0x80u) != 0) ? HM_EMPTY : HM_DELETED;
+	}
+	for (int32_t i = 0; i < ctxt->SlotCount; i++)
+	{
+		while (ctxt->Controls[i] == HM_DELETED)
+		{
+			uint32_t hash = HashOf(ctxt->Elements[i].Key);
+			int32_t target = FindAvailable(hash, ctxt);
+			if ((target / HM_GROUP_WIDTH) == (i / HM_GROUP_WIDTH))
+			{
+				// 同じグループなら、そのままの位置でよい
+				ctxt->Controls[i] = TagOf(hash);
+			}
+			else if (ctxt->Controls[target] == HM_EMPTY)
+			{
+				// 空きに移す
+				ctxt->Elements[target] = ctxt->Elements[i];
+				ctxt->Controls[target] = TagOf(hash);
+				ctxt->Controls[i] = HM_EMPTY;
+			}
+			else
+			{
+				// 未配置の要素と入れ替え、入れ替えた要素を続けて置き直す
+				HashMapElm moving = ctxt->Elements[target];
+				ctxt->Elements[target] = ctxt->Elements[i];
+				ctxt->Elements[i] = moving;
+				ctxt->Controls[target] = TagOf(hash);
+			}
+		}
+	}
+	ctxt->Deleted = 0;
+}
+
+/* -------------------------------------------------------------------
+*	Services
+*/
+
+/// <summary>
+/// <para>ハッシュMapを初期化する。</para>
+/// <para>スロット数は、HM_GROUP_WIDTH以上の2のべき乗を指定すること。
+/// それ以外の場合は、何も蓄積できない。</para>
+/// </summary>
+/// <param name="slotCount">スロット数。</param>
+/// <param name="elements">動作に必要な要素バッファ。
+/// スロット数分確保して指定すること。</param>
+/// <param name="controls">動作に必要な制御バイトバッファ。
+/// スロット数分確保して指定すること。</param>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>なし。</returns>
+void HashMap_Init(
+	int32_t slotCount,
+	HashMapElm* elements,
+	uint8_t* controls,
+	HashMap* ctxt)
+{
+	if (ctxt != nullptr)
+	{
+		memset(ctxt, 0, sizeof(HashMap));
+		if ((elements != nullptr) && (controls != nullptr) &&
+			(slotCount >= HM_GROUP_WIDTH) && ((slotCount & (slotCount - 1)) == 0))
+		{
+			ctxt->SlotCount = slotCount;
+			ctxt->GroupMask = (slotCount / HM_GROUP_WIDTH) - 1;
+			ctxt->Elements = elements;
+			ctxt->Controls = controls;
+			HashMap_Clear(ctxt);
+		}
+	}
+}
+
+/// <summary>
+/// <para>ハッシュMapの最大要素数(HM_MAX_COUNT)を取得する。</para>
+/// </summary>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>最大要素数。</returns>
+int32_t HashMap_Capacity(
+	const HashMap* ctxt)
+{
+	int32_t result = 0;
+	if (ctxt != nullptr)
+	{
+		result = HM_MAX_COUNT(ctxt->SlotCount);
+	}
+	return result;
+}
+
+/// <summary>
+/// <para>ハッシュMapの蓄積済み要素数を取得する。</para>
+/// </summary>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>蓄積済み要素数。</returns>
+int32_t HashMap_Count(
+	const HashMap* ctxt)
+{
+	int32_t result = 0;
+	if (ctxt != nullptr)
+	{
+		result = ctxt->Count;
+	}
+	return result;
+}
+
+/// <summary>
+/// <para>ハッシュMapをクリアする。</para>
+/// </summary>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>なし。</returns>
+void HashMap_Clear(
+	HashMap* ctxt)
+{
+	if (ctxt != nullptr)
+	{
+		ctxt->Count = 0;
+		ctxt->Deleted = 0;
+		if (ctxt->Controls != nullptr)
+		{
+			memset(ctxt->Controls, HM_EMPTY, (size_t)ctxt->SlotCount);
+		}
+	}
+}
+
+/// <summary>
+/// <para>valueをkeyに関連付ける。</para>
+/// <para>同じkeyが既にある場合、関連付けを上書きする。</para>
+/// <para>削除済みのスロットが増えて空きが無くなった場合は、その場で再配置してから追加する。</para>
+/// <para>※　valueのスコープと定数/変数は、Map_Relateと同様にユーザーが考慮しなければならない。　※</para>
+/// </summary>
+/// <param name="value">値。</param>
+/// <param name="key">キー。</param>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>蓄積済み要素数。関連付けできなかった場合は0。</returns>
+int32_t HashMap_Relate(
+	const void* value, MapKey_t key,
+	HashMap* ctxt)
+{
+	int32_t result = 0;
+	if ((ctxt != nullptr) &&
+		(ctxt->SlotCount > 0))
+	{
+		uint32_t hash = HashOf(key);
+		int32_t slot = Find(key, hash, ctxt);
+		if (slot >= 0)
+		{
+			// 同じkey -> 上書き
+			ctxt->Elements[slot].Value = value;
+
+			result = ctxt->Count;
+		}
+		else if (ctxt->Count < HM_MAX_COUNT(ctxt->SlotCount))
+		{
+			// 削除済みを含めて負荷率を超える場合は、検索が空きで止まるように再配置する
+			if (ctxt->Count + ctxt->Deleted >= HM_MAX_COUNT(ctxt->SlotCount))
+			{
+				DropDeleted(ctxt);
+			}
+
+			slot = FindAvailable(hash, ctxt);
+			if (ctxt->Controls[slot] == HM_DELETED)
+			{
+				ctxt->Deleted -= 1;
+			}
+			ctxt->Controls[slot] = TagOf(hash);
+			ctxt->Elements[slot].Key = key;
+			ctxt->Elements[slot].Padding = 0;
+			ctxt->Elements[slot].Value = value;
+			ctxt->Count += 1;
+
+			result = ctxt->Count;
+		}
+	}
+	return result;
+}
+
+/// <summary>
+/// <para>keyに対応するvalueを取得する。</para>
+/// </summary>
+/// <param name="key">キー。</param>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>keyに対応するvalue。</returns>
+void* HashMap_ValueFor(
+	MapKey_t key,
+	const HashMap* ctxt)
+{
+	void* result = nullptr;
+	if ((ctxt != nullptr) &&
+		(ctxt->SlotCount > 0))
+	{
+		int32_t slot = Find(key, HashOf(key), ctxt);
+		if (slot >= 0)
+		{
+			result = (void*)ctxt->Elements[slot].Value;
+		}
+	}
+	return result;
+}
+
+/// <summary>
+/// <para>keyの関連付けを削除する。</para>
+/// </summary>
+/// <param name="key">キー。</param>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>0:該当なし、非0:削除した。</returns>
+int HashMap_Remove(
+	MapKey_t key,
+	HashMap* ctxt)
+{
+	int result = 0;
+	if ((ctxt != nullptr) &&
+		(ctxt->SlotCount > 0))
+	{
+		int32_t slot = Find(key, HashOf(key), ctxt);
+		if (slot >= 0)
+		{
+			// 空きを含むグループは検索がそこで止まっていたので、空きに戻せる
+			const uint8_t* group = &ctxt->Controls[slot - (slot % HM_GROUP_WIDTH)];
+			if (Match(group, HM_EMPTY) != 0)
+			{
+				ctxt->Controls[slot] = HM_EMPTY;
+			}
+			else
+			{
+				ctxt->Controls[slot] = HM_DELETED;
+				ctxt->Deleted += 1;
+			}
+			ctxt->Count -= 1;
+
+			result = 1;
+		}
+	}
+	return result;
+}
+
+/* -------------------------------------------------------------------
+*	Unit Test
+*/
+#ifdef _UNIT_TEST
+#include "Assertions.h"
+
+void HashMap_UnitTest(void)
+{
+	Assertions* assertions = Assertions_Instance();
+	HashMapElm elements[256];
+	uint8_t controls[256];
+	int32_t expected[1024];
+	int32_t present[1024];
+	HashMap map;
+
+	// -----------------------------------------
+	// 1-1 Init(ctxt==nullptr)
+	HashMap_Init(256, elements, controls, nullptr);
+	// -----------------------------------------
+	// 1-2 Init(slotCount is not a power of two, too small, buffer==nullptr)
+	HashMap_Init(48, elements, controls, &map);
+	Assertions_Assert(HashMap_Capacity(&map) == 0, assertions);
+	Assertions_Assert(HashMap_Relate(&expected[0], 1, &map) == 0, assertions);
+	Assertions_Assert(HashMap_ValueFor(1, &map) == nullptr, assertions);
+	Assertions_Assert(HashMap_Remove(1, &map) == 0, assertions);
+	HashMap_Init(8, elements, controls, &map);
+	Assertions_Assert(HashMap_Capacity(&map) == 0, assertions);
+	HashMap_Init(256, nullptr, controls, &map);
+	Assertions_Assert(HashMap_Capacity(&map) == 0, assertions);
+	// -----------------------------------------
+	// 1-3 Init
+	HashMap_Init(256, elements, controls, &map);
+	Assertions_Assert(HashMap_Capacity(&map) == 224, assertions);
+	Assertions_Assert(HashMap_Count(&map) == 0, assertions);
+
+	// -----------------------------------------
+	// 2-1 Capacity, Count(ctxt==nullptr)
+	Assertions_Assert(HashMap_Capacity(nullptr) == 0, assertions);
+	Assertions_Assert(HashMap_Count(nullptr) == 0, assertions);
+
+	// -----------------------------------------
+	// 3-1 Match equals the scalar version
+	{
+		uint8_t group[HM_GROUP_WIDTH];
+		uint32_t seed = 7u;
+		for (int32_t round = 0; round < 200; round++)
+		{
+			for (int32_t i = 0; i < HM_GROUP_WIDTH; i++)
+			{
+				seed = (seed * 1103515245u) + 12345u;
+				uint32_t r = (seed >> 16) % 6u;
+				group[i] = (r == 0) ? HM_EMPTY : ((r == 1) ? HM_DELETED : (uint8_t)((seed >> 20) & 0x3u));
+			}
+			for (uint8_t tag = 0; tag < 4; tag++)
+			{
+				Assertions_Assert(Match(group, tag) == MatchScalar(group, tag), assertions);
+			}
+			Assertions_Assert(Match(group, HM_EMPTY) == MatchScalar(group, HM_EMPTY), assertions);
+			Assertions_Assert(MatchAvailable(group) == MatchAvailableScalar(group), assertions);
+		}
+	}
+
+	// -----------------------------------------
+	// 4-1 Relate(ctxt==nullptr)
+	Assertions_Assert(HashMap_Relate(&expected[0], 1, nullptr) == 0, assertions);
+	// -----------------------------------------
+	// 4-2 Relate until full
+	for (int32_t i = 0; i < 224; i++)
+	{
+		Assertions_Assert(HashMap_Relate(&expected[i], i * 16, &map) == i + 1, assertions);
+	}
+	Assertions_Assert(HashMap_Relate(&expected[224], 224 * 16, &map) == 0, assertions);
+	for (int32_t i = 0; i < 225; i++)
+	{
+		Assertions_Assert(HashMap_ValueFor(i * 16, &map) == ((i < 224) ? &expected[i] : nullptr), assertions);
+		Assertions_Assert(HashMap_ValueFor((i * 16) + 1, &map) == nullptr, assertions);
+	}
+	// -----------------------------------------
+	// 4-3 Relate 同じキーは上書き
+	Assertions_Assert(HashMap_Relate(&expected[500], 16, &map) == 224, assertions);
+	Assertions_Assert(HashMap_ValueFor(16, &map) == &expected[500], assertions);
+	Assertions_Assert(HashMap_Relate(&expected[1], 16, &map) == 224, assertions);
+
+	// -----------------------------------------
+	// 5-1 Remove(ctxt==nullptr, key not found)
+	Assertions_Assert(HashMap_Remove(16, nullptr) == 0, assertions);
+	Assertions_Assert(HashMap_Remove(17, &map) == 0, assertions);
+	// -----------------------------------------
+	// 5-2 Remove
+	for (int32_t i = 0; i < 224; i += 2)
+	{
+		Assertions_Assert(HashMap_Remove(i * 16, &map) != 0, assertions);
+		Assertions_Assert(HashMap_Remove(i * 16, &map) == 0, assertions);
+	}
+	Assertions_Assert(HashMap_Count(&map) == 112, assertions);
+	for (int32_t i = 1; i < 224; i += 2)
+	{
+		Assertions_Assert(HashMap_ValueFor(i * 16, &map) == &expected[i], assertions);
+	}
+	// -----------------------------------------
+	// 5-3 Removed slots are reused, even after the deleted slots fill the table
+	for (int32_t round = 0; round < 8; round++)
+	{
+		for (int32_t i = 0; i < 224; i += 2)
+		{
+			MapKey_t key = (i * 16) + 1 + round;
+			Assertions_Assert(HashMap_Relate(&expected[i], key, &map) != 0, assertions);
+		}
+		Assertions_Assert(HashMap_Count(&map) == 224, assertions);
+		for (int32_t i = 0; i < 224; i += 2)
+		{
+			Assertions_Assert(HashMap_Remove((i * 16) + 1 + round, &map) != 0, assertions);
+		}
+		Assertions_Assert(HashMap_Count(&map) + map.Deleted <= 224, assertions);
+	}
+	for (int32_t i = 1; i < 224; i += 2)
+	{
+		Assertions_Assert(HashMap_ValueFor(i * 16, &map) == &expected[i], assertions);
+	}
+
+	// -----------------------------------------
+	// 6-1 Random Relate and Remove on a single group, compared with a plain table
+	HashMap_Init(16, elements, controls, &map);
+	memset(present, 0, sizeof present);
+	{
+		uint32_t seed = 99u;
+		int32_t count = 0;
+		for (int32_t step = 0; step < 3000; step++)
+		{
+			seed = (seed * 1103515245u) + 12345u;
+			int32_t k = (int32_t)((seed >> 16) % 40u);
+			if (((seed >> 8) & 1u) != 0)
+			{
+				int32_t related = HashMap_Relate(&expected[k], k - 20, &map);
+				if ((present[k] != 0) || (count < 14))
+				{
+					count += (present[k] == 0) ? 1 : 0;
+					present[k] = 1;
+					Assertions_Assert(related == count, assertions);
+				}
+				else
+				{
+					Assertions_Assert(related == 0, assertions);
+				}
+			}
+			else
+			{
+				int removed = HashMap_Remove(k - 20, &map);
+				Assertions_Assert((removed != 0) == (present[k] != 0), assertions);
+				count -= (present[k] != 0) ? 1 : 0;
+				present[k] = 0;
+			}
+			Assertions_Assert(HashMap_Count(&map) == count, assertions);
+			for (int32_t j = 0; j < 40; j++)
+			{
+				Assertions_Assert(HashMap_ValueFor(j - 20, &map) == ((present[j] != 0) ? &expected[j] : nullptr), assertions);
+			}
+		}
+	}
+	// -----------------------------------------
+	// 6-2 Random Relate and Remove on many groups, compared with a plain table
+	HashMap_Init(256, elements, controls, &map);
+	memset(present, 0, sizeof present);
+	{
+		uint32_t seed = 12345u;
+		int32_t count = 0;
+		for (int32_t step = 0; step < 20000; step++)
+		{
+			seed = (seed * 1103515245u) + 12345u;
+			int32_t k = (int32_t)((seed >> 16) % 1024u);
+			if (((seed >> 8) % 3u) != 0)
+			{
+				int32_t related = HashMap_Relate(&expected[k], k * 65536, &map);
+				if ((present[k] != 0) || (count < 224))
+				{
+					count += (present[k] == 0) ? 1 : 0;
+					present[k] = 1;
+					Assertions_Assert(related == count, assertions);
+				}
+				else
+				{
+					Assertions_Assert(related == 0, assertions);
+				}
+			}
+			else
+			{
+				int removed = HashMap_Remove(k * 65536, &map);
+				Assertions_Assert((removed != 0) == (present[k] != 0), assertions);
+				count -= (present[k] != 0) ? 1 : 0;
+				present[k] = 0;
+			}
+			Assertions_Assert(HashMap_Count(&map) == count, assertions);
+			if ((step % 256) == 0)
+			{
+				for (int32_t j = 0; j < 1024; j++)
+				{
+					Assertions_Assert(HashMap_ValueFor(j * 65536, &map) == ((present[j] != 0) ? &expected[j] : nullptr), assertions);
+				}
+			}
+		}
+	}
+
+	// -----------------------------------------
+	// 7-1 Clear(ctxt==nullptr)
+	int32_t before = HashMap_Count(&map);
+	HashMap_Clear(nullptr);
+	Assertions_Assert(HashMap_Count(&map) == before, assertions);
+	// -----------------------------------------
+	// 7-2 Clear
+	HashMap_Clear(&map);
+	Assertions_Assert(HashMap_Count(&map) == 0, assertions);
+	for (int32_t j = 0; j < 1024; j++)
+	{
+		Assertions_Assert(HashMap_ValueFor(j * 65536, &map) == nullptr, assertions);
+	}
+}
+#endif
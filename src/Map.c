@@ -31,10 +31,354 @@ SOFTWARE.
 #include "Map.h"
 #include <string.h>
 #include "nullptr.h"
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 
 /* -------------------------------------------------------------------
 *	Privates
 */
+/// <summary>
+/// <para>要素を別の位置に移し、木のつながりを付け替える。</para>
+/// </summary>
+static void Move(MapElm* from, MapElm* to, Map* ctxt)
+{
+	AvlNode* node = &to->Node;
+	*node = from->Node;
+
+	// 親->子
+	AvlNode* parent = node->Parent;
+	if (parent == nullptr)
+	{
+		ctxt->Root = node;
+	}
+	else if (parent->Left == &from->Node)
+	{
+		parent->Left = node;
+	}
+	else
+	{
+		parent->Right = node;
+	}
+
+	// 子->親
+	if (node->Left != nullptr)
+	{
+		node->Left->Parent = node;
+	}
+	if (node->Right != nullptr)
+	{
+		node->Right->Parent = node;
+	}
+}
+
+/// <summary>
+/// <para>並べ替え用の要素</para>
+/// <para>MapElmより小さいので、要素バッファの先頭に詰めて並べ替える。</para>
+/// </summary>
+typedef struct _MapSortEntry
+{
+	/// <summary>Key</summary>
+	MapKey_t Key;
+	/// <summary>元の配列の位置</summary>
+	int32_t Order;
+	/// <summary>Value</summary>
+	const void* Value;
+} MapSortEntry;
+
+/// <summary>
+/// <para>並べ替えの順序で、aがbより前か判定する。</para>
+/// <para>keyが同じ場合は、元の配列の位置の順にする。</para>
+/// </summary>
+static int Precedes(const MapSortEntry* a, const MapSortEntry* b)
+{
+	return (a->Key < b->Key) ||
+		((a->Key == b->Key) && (a->Order < b->Order));
+}
+
+/// <summary>
+/// <para>ヒープの要素を、子の方へ沈める。</para>
+/// </summary>
+static void SiftDown(int32_t index, int32_t count, MapSortEntry* entries)
+{
+	MapSortEntry moving = entries[index];
+	int32_t hole = index;
+	int32_t child = (hole * 2) + 1;
+	while (child < count)
+	{
+		// 大きい方の子を選ぶ
+		if ((child + 1 < count) &&
+			(Precedes(&entries[child], &entries[child + 1]) != 0))
+		{
+			child += 1;
+		}
+		if (Precedes(&moving, &entries[child]) == 0)
+		{
+			break;
+		}
+		entries[hole] = entries[child];
+		hole = child;
+		child = (hole * 2) + 1;
+	}
+	entries[hole] = moving;
+}
+
+/// <summary>
+/// <para>要素を昇順に並べ替える(ヒープソート)。</para>
+/// </summary>
+static void HeapSort(int32_t count, MapSortEntry* entries)
+{
+	for (int32_t i = (count / 2) - 1; i >= 0; i--)
+	{
+		SiftDown(i, count, entries);
+	}
+	for (int32_t last = count - 1; last > 0; last--)
+	{
+		MapSortEntry largest = entries[0];
+		entries[0] = entries[last];
+		entries[last] = largest;
+		SiftDown(0, last, entries);
+	}
+}
+
+/// <summary>
+/// <para>要素を入れ替える。</para>
+/// </summary>
+static void Swap(MapSortEntry* a, MapSortEntry* b)
+{
+	MapSortEntry temp = *a;
+	*a = *b;
+	*b = temp;
+}
+
+/// <summary>
+/// <para>少ない要素を昇順に並べ替える(挿入ソート)。</para>
+/// </summary>
+static void InsertionSort(int32_t count, MapSortEntry* entries)
+{
+	for (int32_t i = 1; i < count; i++)
+	{
+		MapSortEntry moving = entries[i];
+		int32_t hole = i;
+		while ((hole > 0) && (Precedes(&moving, &entries[hole - 1]) != 0))
+		{
+			entries[hole] = entries[hole - 1];
+			hole -= 1;
+		}
+		entries[hole] = moving;
+	}
+}
+
+/// <summary>
+/// <para>要素を昇順に並べ替える(イントロソート、追加のメモリを使わない)。</para>
+/// <para>分割が偏って深くなった場合は、ヒープソートに切り替えてO(n log n)を保つ。</para>
+/// </summary>
+static void Sort(int32_t count, int32_t depth, MapSortEntry* entries)
+{
+	while (count > 16)
+	{
+		if (depth <= 0)
+		{
+			HeapSort(count, entries);
+			return;
+		}
+		depth -= 1;
+
+		// 先頭、中央、末尾の中央値を基準にする(基準は最大にならないので、分割は空にならない)
+		MapSortEntry* first = &entries[0];
+		MapSortEntry* middle = &entries[count / 2];
+		MapSortEntry* last = &entries[count - 1];
+		if (Precedes(middle, first) != 0)
+		{
+			Swap(middle, first);
+		}
+		if (Precedes(last, middle) != 0)
+		{
+			Swap(last, middle);
+			if (Precedes(middle, first) != 0)
+			{
+				Swap(middle, first);
+			}
+		}
+		MapSortEntry pivot = *middle;
+
+		// 分割
+		int32_t i = -1;
+		int32_t j = count;
+		for (;;)
+		{
+			do
+			{
+				i += 1;
+			} while (Precedes(&entries[i], &pivot) != 0);
+			do
+			{
+				j -= 1;
+			} while (Precedes(&pivot, &entries[j]) != 0);
+			if (i >= j)
+			{
+				break;
+			}
+			Swap(&entries[i], &entries[j]);
+		}
+
+		// 小さい方を再帰し、大きい方は繰り返す(再帰の深さをlog nに抑える)
+		int32_t leftCount = j + 1;
+		int32_t rightCount = count - leftCount;
+		if (leftCount < rightCount)
+		{
+			Sort(leftCount, depth, entries);
+			entries += leftCount;
+			count = rightCount;
+		}
+		else
+		{
+			Sort(rightCount, depth, &entries[leftCount]);
+			count = leftCount;
+		}
+	}
+	InsertionSort(count, entries);
+}
+
+/// <summary>
+/// <para>昇順に並んだ要素のうち、同じkeyが続くものを後の方にまとめる。</para>
+/// <para>まとめた後の要素数を返す。</para>
+/// </summary>
+static int32_t Unique(int32_t count, MapElm* elements)
+{
+	int32_t unique = 0;
+	for (int32_t i = 0; i < count; i++)
+	{
+		if ((unique > 0) &&
+			(elements[unique - 1].Node.Content.Key == elements[i].Node.Content.Key))
+		{
+			elements[unique - 1].Node.Content = elements[i].Node.Content;
+		}
+		else
+		{
+			elements[unique] = elements[i];
+			unique += 1;
+		}
+	}
+	return unique;
+}
+
+/// <summary>
+/// <para>昇順に並んだ要素の範囲から、完全に平衡した部分木を構築する。</para>
+/// <para>部分木のrootを返す。</para>
+/// </summary>
+static AvlNode* BuildBalanced(int32_t first, int32_t last, AvlNode* parent, MapElm* elements)
+{
+	AvlNode* node = nullptr;
+	if (first <= last)
+	{
+		int32_t middle = first + ((last - first) / 2);
+		node = &elements[middle].Node;
+		node->Parent = parent;
+		node->Left = BuildBalanced(first, middle - 1, node, elements);
+		node->Right = BuildBalanced(middle + 1, last, node, elements);
+
+		// 子の高さは確定しているので、回転せずに高さが決まる
+		int32_t lh = (node->Left != nullptr) ? node->Left->Height : 0;
+		int32_t rh = (node->Right != nullptr) ? node->Right->Height : 0;
+		node->Height = ((lh > rh) ? lh : rh) + 1;
+		node->Size = (last - first) + 1;
+	}
+	return node;
+}
+
+/// <summary>
+/// <para>要素バッファに並べた要素から、木を構築する。</para>
+/// </summary>
+static int32_t Build(int32_t count, Map* ctxt)
+{
+	ctxt->Count = Unique(count, ctxt->Elements);
+	ctxt->Root = BuildBalanced(0, ctxt->Count - 1, nullptr, ctxt->Elements);
+	return ctxt->Count;
+}
+
+/// <summary>
+/// <para>凍結した配列で先読みする子孫の間隔。</para>
+/// <para>4段下の子孫16個のkeyが、1つのキャッシュライン(64バイト)に並ぶ。</para>
+/// </summary>
+#define FROZEN_PREFETCH_STRIDE (16)
+
+/// <summary>
+/// <para>木をkeyの昇順に辿りながら、Eytzinger配置(添字indexの子は2index、2index+1)の配列に並べる。</para>
+/// </summary>
+static void Freeze(uint32_t index, AvlNode** cursor, Map* ctxt)
+{
+	if (index <= (uint32_t)ctxt->Count)
+	{
+		Freeze(2 * index, cursor, ctxt);
+		ctxt->FrozenKeys[index] = (*cursor)->Content.Key;
+		ctxt->FrozenValues[index] = (*cursor)->Content.Value;
+		*cursor = AvlTree_Next(*cursor);
+		Freeze((2 * index) + 1, cursor, ctxt);
+	}
+}
+
+/// <summary>
+/// <para>凍結した配列で、indexの4段下の子孫を先読みする。</para>
+/// <para>配列外を指しても、先読みは例外にならない。</para>
+/// </summary>
+static void PrefetchDescendants(uint32_t index, const MapKey_t* keys)
+{
+	uintptr_t address = (uintptr_t)keys + ((uintptr_t)index * (FROZEN_PREFETCH_STRIDE * sizeof(MapKey_t)));
+#if defined(__GNUC__)
+	__builtin_prefetch((const void*)address);
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+	_mm_prefetch((const char*)address, _MM_HINT_T0);
+#else
+	(void)address;
+#endif
+}
+
+/// <summary>
+/// <para>下位から続く1のビット数を取得する。全ビットが1の値は指定しないこと。</para>
+/// </summary>
+static int32_t TrailingOnesOf(uint32_t value)
+{
+#if defined(__GNUC__)
+	return __builtin_ctz(~value);
+#elif defined(_MSC_VER)
+	unsigned long bit;
+	_BitScanForward(&bit, ~value);
+	return (int32_t)bit;
+#else
+	int32_t bits = 0;
+	while ((value & 1u) != 0)
+	{
+		value >>= 1;
+		bits += 1;
+	}
+	return bits;
+#endif
+}
+
+/// <summary>
+/// <para>凍結した配列から、keyに対応するvalueを検索する。</para>
+/// <para>比較結果で左右の子を選ぶだけなので、分岐予測を外さない。</para>
+/// <para>葉を越えるまで降りてから、最後に右へ進んだ位置(key以上で最小)に戻る。</para>
+/// </summary>
+static void* FrozenValueFor(MapKey_t key, const Map* ctxt)
+{
+	void* result = nullptr;
+	const MapKey_t* keys = ctxt->FrozenKeys;
+	uint32_t count = (uint32_t)ctxt->Count;
+	uint32_t index = 1;
+	while (index <= count)
+	{
+		PrefetchDescendants(index, keys);
+		index = (2 * index) + (uint32_t)(keys[index] < key);
+	}
+	index >>= TrailingOnesOf(index) + 1;
+	if ((index != 0) && (keys[index] == key))
+	{
+		result = (void*)ctxt->FrozenValues[index];
+	}
+	return result;
+}
 
 /* -------------------------------------------------------------------
 *	Services
@@ -95,6 +439,7 @@ int32_t Map_Count(
 
 /// <summary>
 /// <para>Mapをクリアする。</para>
+/// <para>凍結も解除する。</para>
 /// </summary>
 /// <param name="ctxt">コンテキスト。</param>
 /// <returns>なし。</returns>
@@ -105,6 +450,8 @@ void Map_Clear(
 	{
 		ctxt->Count = 0;
 		ctxt->Root = nullptr;
+		ctxt->FrozenKeys = nullptr;
+		ctxt->FrozenValues = nullptr;
 	}
 }
 
@@ -125,30 +472,153 @@ int32_t Map_Relate(
 	Map* ctxt)
 {
 	int32_t result = 0;
-	if (ctxt != nullptr)
+	const void** slot = Map_Emplace(key, ctxt);
+	if (slot != nullptr)
 	{
-		AvlNode* existing = AvlTree_Search(key, ctxt->Root);
-		if (existing != nullptr)
+		*slot = value;
+
+		result = ctxt->Count;
+	}
+	return result;
+}
+
+/// <summary>
+/// <para>keyに関連付けるvalueの格納先を取得する。</para>
+/// <para>keyが無い場合は、valueをnullとして追加する。</para>
+/// <para>rootから辿るのは1回で済む。</para>
+/// <para>※　格納先は、Removeで要素が移されるまで有効である。　※</para>
+/// </summary>
+/// <param name="key">キー。</param>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>valueの格納先。nullで追加できなかった。</returns>
+const void** Map_Emplace(
+	MapKey_t key,
+	Map* ctxt)
+{
+	const void** result = nullptr;
+	if ((ctxt != nullptr) &&
+		(ctxt->FrozenKeys == nullptr))
+	{
+		AvlNode* node;
+		if (ctxt->Count < ctxt->Capacity)
 		{
-			existing->Content.Value = value;
+			// 次の空き要素を挿入候補にする(該当するkeyがあれば使われない)
+			MapElm* elm = &ctxt->Elements[ctxt->Count];
+			AvlNode_Init(key, nullptr, &elm->Node);
+			node = AvlTree_SearchOrInsert(&elm->Node, &ctxt->Root);
+			if (node == &elm->Node)
+			{
+				ctxt->Count += 1;
+			}
+		}
+		else
+		{
+			// いっぱいの場合は、既存のkeyのみ
+			node = AvlTree_Search(key, ctxt->Root);
+		}
 
-			result = ctxt->Count;
+		if (node != nullptr)
+		{
+			result = &node->Content.Value;
 		}
-		else if (ctxt->Count < ctxt->Capacity)
+	}
+	return result;
+}
+
+/// <summary>
+/// <para>昇順に並んだkeyとvalueの配列から、Mapを作り直す。</para>
+/// <para>回転を行わずに、完全に平衡した木をO(n)で構築する。</para>
+/// <para>同じkeyが続く場合は、後のvalueを関連付ける。</para>
+/// <para>要素のインデックス位置は、keyの昇順になる。</para>
+/// <para>keyが昇順でない場合や、最大要素数を超える場合は、Mapを変更しない。</para>
+/// </summary>
+/// <param name="keys">キーの配列。</param>
+/// <param name="values">値の配列。</param>
+/// <param name="count">配列の要素数。</param>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>蓄積済み要素数。構築できなかった場合は0。</returns>
+int32_t Map_BuildFromSorted(
+	const MapKey_t* keys, const void* const* values,
+	int32_t count,
+	Map* ctxt)
+{
+	int32_t result = 0;
+	if ((ctxt != nullptr) &&
+		(ctxt->FrozenKeys == nullptr) &&
+		(keys != nullptr) && (values != nullptr) &&
+		(0 <= count) && (count <= ctxt->Capacity))
+	{
+		// 変更する前に昇順か確認する
+		int32_t sorted = 1;
+		while ((sorted < count) && (keys[sorted - 1] <= keys[sorted]))
 		{
-			MapElm* elm = &ctxt->Elements[ctxt->Count];
-			AvlNode_Init(key, value, &elm->Node);
-			ctxt->Root = AvlTree_Insert(&elm->Node, ctxt->Root);
-			ctxt->Count += 1;
+			sorted += 1;
+		}
 
-			result = ctxt->Count;
+		if (sorted >= count)
+		{
+			for (int32_t i = 0; i < count; i++)
+			{
+				AvlNode_Init(keys[i], values[i], &ctxt->Elements[i].Node);
+			}
+			result = Build(count, ctxt);
 		}
 	}
 	return result;
 }
 
+/// <summary>
+/// <para>任意の順に並んだkeyとvalueの配列から、Mapを作り直す。</para>
+/// <para>要素バッファ上でkeyを並べ替えてから、完全に平衡した木を構築する(追加のメモリは使わない)。</para>
+/// <para>同じkeyが複数ある場合は、配列の後の方のvalueを関連付ける。</para>
+/// <para>要素のインデックス位置は、keyの昇順になる。</para>
+/// <para>最大要素数を超える場合は、Mapを変更しない。</para>
+/// </summary>
+/// <param name="keys">キーの配列。</param>
+/// <param name="values">値の配列。</param>
+/// <param name="count">配列の要素数。</param>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>蓄積済み要素数。構築できなかった場合は0。</returns>
+int32_t Map_BuildFromUnsorted(
+	const MapKey_t* keys, const void* const* values,
+	int32_t count,
+	Map* ctxt)
+{
+	int32_t result = 0;
+	if ((ctxt != nullptr) &&
+		(ctxt->FrozenKeys == nullptr) &&
+		(keys != nullptr) && (values != nullptr) &&
+		(0 <= count) && (count <= ctxt->Capacity))
+	{
+		// 小さい並べ替え用の要素を、要素バッファの先頭に詰めて並べ替える
+		MapSortEntry* entries = (MapSortEntry*)(void*)ctxt->Elements;
+		for (int32_t i = 0; i < count; i++)
+		{
+			entries[i].Key = keys[i];
+			entries[i].Order = i;
+			entries[i].Value = values[i];
+		}
+		int32_t depth = 0;
+		for (int32_t n = count; n > 0; n /= 2)
+		{
+			depth += 2;
+		}
+		Sort(count, depth, entries);
+
+		// 後ろから要素に展開する(要素iが重なる並べ替え用の要素は、i以降なので読み終えている)
+		for (int32_t i = count - 1; i >= 0; i--)
+		{
+			MapSortEntry entry = entries[i];
+			AvlNode_Init(entry.Key, entry.Value, &ctxt->Elements[i].Node);
+		}
+		result = Build(count, ctxt);
+	}
+	return result;
+}
+
 /// <summary>
 /// <para>keyに対応するvalueを取得する。</para>
+/// <para>凍結している場合は、凍結した配列から検索する。</para>
 /// <para>※　Relateで関連付けたアドレスを返すものである。
 /// 従って、valueのスコープと定数/変数は、
 /// Relateと合わせ、ユーザーが考慮しなければならない。　※</para>
@@ -163,10 +633,17 @@ void* Map_ValueFor(
 	void* result = nullptr;
 	if (ctxt != nullptr)
 	{
-		AvlNode* node = AvlTree_Search(key, ctxt->Root);
-		if (node != nullptr)
+		if (ctxt->FrozenKeys != nullptr)
+		{
+			result = FrozenValueFor(key, ctxt);
+		}
+		else
 		{
-			result = (void*)node->Content.Value;
+			AvlNode* node = AvlTree_Search(key, ctxt->Root);
+			if (node != nullptr)
+			{
+				result = (void*)node->Content.Value;
+			}
 		}
 	}
 	return result;
@@ -220,6 +697,206 @@ MapKey_t Map_KeyAt(
 	return result;
 }
 
+/// <summary>
+/// <para>keyの関連付けを削除する。</para>
+/// <para>空いた要素には最後の要素を移して詰めるので、Relateで再利用される。</para>
+/// <para>※　最後の要素のインデックス位置は、削除した要素の位置に変わる。　※</para>
+/// </summary>
+/// <param name="key">キー。</param>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>0:該当なし、非0:削除した。</returns>
+int Map_Remove(
+	MapKey_t key,
+	Map* ctxt)
+{
+	int result = 0;
+	if ((ctxt != nullptr) &&
+		(ctxt->FrozenKeys == nullptr))
+	{
+		AvlNode* node = AvlTree_Search(key, ctxt->Root);
+		if (node != nullptr)
+		{
+			ctxt->Root = AvlTree_Remove(node, ctxt->Root);
+
+			// 最後の要素を空いた位置に詰める
+			MapElm* elm = (MapElm*)node;
+			MapElm* last = &ctxt->Elements[ctxt->Count - 1];
+			if (elm != last)
+			{
+				Move(last, elm, ctxt);
+			}
+			ctxt->Count -= 1;
+
+			result = 1;
+		}
+	}
+	return result;
+}
+
+/// <summary>
+/// <para>keyがkey以上で最小の要素の木ノードを取得する。</para>
+/// <para>AvlTree_Next/AvlTree_Prevで、keyの順に前後へ辿れる。</para>
+/// <para>※　木ノードは、Relate/Removeで木が変わるまで有効である。　※</para>
+/// </summary>
+/// <param name="key">キー。</param>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>該当する木ノード。nullでなし。</returns>
+AvlNode* Map_LowerBound(
+	MapKey_t key,
+	const Map* ctxt)
+{
+	AvlNode* result = nullptr;
+	if (ctxt != nullptr)
+	{
+		result = AvlTree_LowerBound(key, ctxt->Root);
+	}
+	return result;
+}
+
+/// <summary>
+/// <para>keyがkeyより大きく最小の要素の木ノードを取得する。</para>
+/// <para>AvlTree_Next/AvlTree_Prevで、keyの順に前後へ辿れる。</para>
+/// <para>※　木ノードは、Relate/Removeで木が変わるまで有効である。　※</para>
+/// </summary>
+/// <param name="key">キー。</param>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>該当する木ノード。nullでなし。</returns>
+AvlNode* Map_UpperBound(
+	MapKey_t key,
+	const Map* ctxt)
+{
+	AvlNode* result = nullptr;
+	if (ctxt != nullptr)
+	{
+		result = AvlTree_UpperBound(key, ctxt->Root);
+	}
+	return result;
+}
+
+/// <summary>
+/// <para>keyがlower以上upper以下の要素を、keyの昇順に通知する。</para>
+/// <para>範囲の先頭をO(log n)で探し、そこから順に辿るので、O(log n + 通知数)となる。</para>
+/// <para>通知中にRelate/Removeしてはならない。</para>
+/// </summary>
+/// <param name="lower">範囲の下限のキー。</param>
+/// <param name="upper">範囲の上限のキー。</param>
+/// <param name="visitor">通知先。</param>
+/// <param name="visitorContext">通知先に渡すコンテキスト。</param>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>通知した要素数。</returns>
+int32_t Map_ForEachInRange(
+	MapKey_t lower, MapKey_t upper,
+	MapVisitor visitor, void* visitorContext,
+	const Map* ctxt)
+{
+	int32_t visited = 0;
+	if ((ctxt != nullptr) &&
+		(visitor != nullptr))
+	{
+		AvlNode* node = AvlTree_LowerBound(lower, ctxt->Root);
+		while ((node != nullptr) &&
+			(node->Content.Key <= upper))
+		{
+			visited += 1;
+			if (visitor(node->Content.Key, (void*)node->Content.Value, visitorContext) == 0)
+			{
+				break;
+			}
+			node = AvlTree_Next(node);
+		}
+	}
+	return visited;
+}
+
+/// <summary>
+/// <para>keyより小さいkeyの要素数(keyの順位)を取得する。</para>
+/// <para>O(log n)で求まる。</para>
+/// </summary>
+/// <param name="key">キー。</param>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>keyより小さいkeyの要素数。</returns>
+int32_t Map_Rank(
+	MapKey_t key,
+	const Map* ctxt)
+{
+	int32_t result = 0;
+	if (ctxt != nullptr)
+	{
+		result = AvlTree_Rank(key, ctxt->Root);
+	}
+	return result;
+}
+
+/// <summary>
+/// <para>keyの小さい方から数えた位置の要素の木ノードを取得する。</para>
+/// <para>O(log n)で求まる。AvlTree_Next/AvlTree_Prevで、keyの順に前後へ辿れる。</para>
+/// <para>※　木ノードは、Relate/Removeで木が変わるまで有効である。　※</para>
+/// </summary>
+/// <param name="rank">位置(0～)。</param>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>位置の木ノード。nullで範囲外。</returns>
+AvlNode* Map_Select(
+	int32_t rank,
+	const Map* ctxt)
+{
+	AvlNode* result = nullptr;
+	if (ctxt != nullptr)
+	{
+		result = AvlTree_Select(rank, ctxt->Root);
+	}
+	return result;
+}
+
+/// <summary>
+/// <para>Mapを凍結し、以後変更できないようにする。</para>
+/// <para>keyを幅優先順(Eytzinger配置)の配列に並べ、valueを同じ配置の配列に並べる。</para>
+/// <para>凍結後のMap_ValueForは、この配列を分岐なしで辿り、子孫を先読みして検索する。</para>
+/// <para>凍結中はRelate/Emplace/Remove/BuildFromSorted/BuildFromUnsortedが失敗する。
+/// Clearで凍結を解除する。</para>
+/// <para>木はそのまま残るので、その他の参照は凍結前と同様に使用できる。</para>
+/// </summary>
+/// <param name="keys">keyの格納先。MAP_FROZEN_SLOTS(蓄積済み要素数)分確保して指定すること。</param>
+/// <param name="values">valueの格納先。MAP_FROZEN_SLOTS(蓄積済み要素数)分確保して指定すること。</param>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>凍結した要素数。負で凍結できなかった。</returns>
+int32_t Map_Freeze(
+	MapKey_t* keys, const void** values,
+	Map* ctxt)
+{
+	int32_t result = -1;
+	if ((ctxt != nullptr) &&
+		(ctxt->FrozenKeys == nullptr) &&
+		(keys != nullptr) && (values != nullptr))
+	{
+		ctxt->FrozenKeys = keys;
+		ctxt->FrozenValues = values;
+		// 添字0は使わない
+		keys[0] = 0;
+		values[0] = nullptr;
+		AvlNode* cursor = AvlTree_First(ctxt->Root);
+		Freeze(1, &cursor, ctxt);
+
+		result = ctxt->Count;
+	}
+	return result;
+}
+
+/// <summary>
+/// <para>Mapが凍結されているか取得する。</para>
+/// </summary>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>0:凍結していない、非0:凍結している。</returns>
+int Map_IsFrozen(
+	const Map* ctxt)
+{
+	int result = 0;
+	if (ctxt != nullptr)
+	{
+		result = (ctxt->FrozenKeys != nullptr);
+	}
+	return result;
+}
+
 /* -------------------------------------------------------------------
  *	Unit Test
  */
@@ -232,6 +909,26 @@ typedef struct _Map_UnitTest_Value {
 	short Member3[4];
 } Map_UnitTest_Value;
 
+/// <summary>
+/// <para>範囲の要素の通知を記録する。</para>
+/// </summary>
+typedef struct _Map_UnitTest_Visited
+{
+	int32_t Count;
+	int32_t Limit;
+	MapKey_t Keys[64];
+	void* Values[64];
+} Map_UnitTest_Visited;
+
+static int Map_UnitTest_Visit(MapKey_t key, void* value, void* context)
+{
+	Map_UnitTest_Visited* visited = (Map_UnitTest_Visited*)context;
+	visited->Keys[visited->Count] = key;
+	visited->Values[visited->Count] = value;
+	visited->Count += 1;
+	return visited->Count < visited->Limit;
+}
+
 void Map_UnitTest(void)
 {
 	Assertions* assertions = Assertions_Instance();
@@ -429,5 +1126,342 @@ void Map_UnitTest(void)
 	// 7-5 KeyAt
 	key = Map_KeyAt(1, 0, &map);
 	Assertions_Assert(key == 87654321, assertions);
+
+	// -----------------------------------------
+	// 8-x Remove
+	{
+		MapElm bigElms[64];
+		Map_UnitTest_Value bigValues[64];
+		Map big;
+		Map_Init(64, bigElms, &big);
+		for (int32_t i = 0; i < 64; i++)
+		{
+			bigValues[i].Member1 = i;
+			Map_Relate(&bigValues[i], (i * 37) % 64, &big);
+		}
+		// -----------------------------------------
+		// 8-1 Remove(ctxt==nullptr)
+		Assertions_Assert(Map_Remove(0, nullptr) == 0, assertions);
+		// -----------------------------------------
+		// 8-2 Remove(key not found)
+		Assertions_Assert(Map_Remove(64, &big) == 0, assertions);
+		Assertions_Assert(Map_Count(&big) == 64, assertions);
+		// -----------------------------------------
+		// 8-3 Remove odd keys
+		for (int32_t k = 1; k < 64; k += 2)
+		{
+			Assertions_Assert(Map_Remove(k, &big) != 0, assertions);
+			Assertions_Assert(Map_Remove(k, &big) == 0, assertions);
+		}
+		Assertions_Assert(Map_Count(&big) == 32, assertions);
+		for (int32_t i = 0; i < 64; i++)
+		{
+			value = Map_ValueFor((i * 37) % 64, &big);
+			if ((((i * 37) % 64) % 2) == 0)
+			{
+				Assertions_Assert(value == &bigValues[i], assertions);
+			}
+			else
+			{
+				Assertions_Assert(value == nullptr, assertions);
+			}
+		}
+		// -----------------------------------------
+		// 8-4 ValueAt, KeyAt are packed
+		for (int32_t i = 0; i < 32; i++)
+		{
+			key = Map_KeyAt(i, -1, &big);
+			Assertions_Assert((key >= 0) && ((key % 2) == 0), assertions);
+			value = Map_ValueAt(i, &big);
+			Assertions_Assert(value == Map_ValueFor(key, &big), assertions);
+		}
+		Assertions_Assert(Map_KeyAt(32, -1, &big) == -1, assertions);
+		// -----------------------------------------
+		// 8-5 Relate reuses removed elements
+		for (int32_t k = 1; k < 64; k += 2)
+		{
+			Map_Relate(&bigValues[k], k, &big);
+		}
+		Assertions_Assert(Map_Count(&big) == 64, assertions);
+		Assertions_Assert(Map_Relate(&bigValues[0], 64, &big) == 0, assertions);
+		for (int32_t k = 1; k < 64; k += 2)
+		{
+			value = Map_ValueFor(k, &big);
+			Assertions_Assert(value == &bigValues[k], assertions);
+		}
+		// -----------------------------------------
+		// 8-6 Remove all
+		for (int32_t k = 0; k < 64; k++)
+		{
+			Assertions_Assert(Map_Remove(k, &big) != 0, assertions);
+			Assertions_Assert(Map_ValueFor(k, &big) == nullptr, assertions);
+			if (k < 63)
+			{
+				Assertions_Assert(Map_ValueFor(k + 1, &big) != nullptr, assertions);
+			}
+		}
+		Assertions_Assert(Map_Count(&big) == 0, assertions);
+		Assertions_Assert(big.Root == nullptr, assertions);
+
+		// -----------------------------------------
+		// 9-1 Emplace(ctxt==nullptr)
+		Assertions_Assert(Map_Emplace(0, nullptr) == nullptr, assertions);
+		// -----------------------------------------
+		// 9-2 Emplace new key, value is null
+		const void** slot = Map_Emplace(100, &big);
+		Assertions_Assert(slot != nullptr, assertions);
+		Assertions_Assert(*slot == nullptr, assertions);
+		Assertions_Assert(Map_Count(&big) == 1, assertions);
+		*slot = &bigValues[5];
+		Assertions_Assert(Map_ValueFor(100, &big) == &bigValues[5], assertions);
+		// -----------------------------------------
+		// 9-3 Emplace existing key returns the same slot
+		Assertions_Assert(Map_Emplace(100, &big) == slot, assertions);
+		Assertions_Assert(*slot == &bigValues[5], assertions);
+		Assertions_Assert(Map_Count(&big) == 1, assertions);
+		// -----------------------------------------
+		// 9-4 Emplace until full
+		for (int32_t k = 0; k < 63; k++)
+		{
+			slot = Map_Emplace(k, &big);
+			Assertions_Assert(slot != nullptr, assertions);
+			*slot = &bigValues[k];
+		}
+		Assertions_Assert(Map_Count(&big) == 64, assertions);
+		Assertions_Assert(Map_Emplace(63, &big) == nullptr, assertions);
+		slot = Map_Emplace(62, &big);
+		Assertions_Assert((slot != nullptr) && (*slot == &bigValues[62]), assertions);
+		Assertions_Assert(Map_Count(&big) == 64, assertions);
+		for (int32_t k = 0; k < 63; k++)
+		{
+			Assertions_Assert(Map_ValueFor(k, &big) == &bigValues[k], assertions);
+		}
+
+		// -----------------------------------------
+		// 10-x BuildFromSorted, BuildFromUnsorted
+		MapKey_t keys[65];
+		const void* ptrs[65];
+		for (int32_t i = 0; i < 65; i++)
+		{
+			keys[i] = (i * 3) - 90;
+			ptrs[i] = &bigValues[i % 64];
+		}
+		// -----------------------------------------
+		// 10-1 BuildFromSorted(ctxt==nullptr, keys==nullptr, values==nullptr)
+		Assertions_Assert(Map_BuildFromSorted(keys, ptrs, 63, nullptr) == 0, assertions);
+		Assertions_Assert(Map_BuildFromSorted(nullptr, ptrs, 63, &big) == 0, assertions);
+		Assertions_Assert(Map_BuildFromSorted(keys, nullptr, 63, &big) == 0, assertions);
+		// -----------------------------------------
+		// 10-2 BuildFromSorted(count > Capacity) does not change the map
+		Assertions_Assert(Map_BuildFromSorted(keys, ptrs, 65, &big) == 0, assertions);
+		Assertions_Assert(Map_Count(&big) == 64, assertions);
+		// -----------------------------------------
+		// 10-3 BuildFromSorted(not sorted) does not change the map
+		keys[10] = keys[11] + 1;
+		Assertions_Assert(Map_BuildFromSorted(keys, ptrs, 63, &big) == 0, assertions);
+		Assertions_Assert(Map_ValueFor(62, &big) == &bigValues[62], assertions);
+		keys[10] = keys[11] - 3;
+		// -----------------------------------------
+		// 10-4 BuildFromSorted makes a perfectly balanced tree
+		Assertions_Assert(Map_BuildFromSorted(keys, ptrs, 63, &big) == 63, assertions);
+		Assertions_Assert(big.Root->Height == 6, assertions);
+		Assertions_Assert(big.Root->Parent == nullptr, assertions);
+		for (int32_t i = 0; i < 63; i++)
+		{
+			Assertions_Assert(Map_ValueFor(keys[i], &big) == ptrs[i], assertions);
+			Assertions_Assert(Map_ValueFor(keys[i] + 1, &big) == nullptr, assertions);
+			Assertions_Assert(Map_KeyAt(i, 0, &big) == keys[i], assertions);
+		}
+		// -----------------------------------------
+		// 10-5 Built map accepts Relate and Remove
+		Assertions_Assert(Map_Relate(&bigValues[0], 1000, &big) == 64, assertions);
+		Assertions_Assert(Map_Remove(keys[31], &big) != 0, assertions);
+		Assertions_Assert(Map_ValueFor(1000, &big) == &bigValues[0], assertions);
+		Assertions_Assert(Map_ValueFor(keys[31], &big) == nullptr, assertions);
+		Assertions_Assert(Map_ValueFor(keys[30], &big) == ptrs[30], assertions);
+		// -----------------------------------------
+		// 10-6 BuildFromSorted keeps the last of duplicated keys
+		keys[1] = keys[0];
+		keys[2] = keys[0];
+		Assertions_Assert(Map_BuildFromSorted(keys, ptrs, 5, &big) == 3, assertions);
+		Assertions_Assert(Map_ValueFor(keys[0], &big) == ptrs[2], assertions);
+		Assertions_Assert(Map_ValueFor(keys[4], &big) == ptrs[4], assertions);
+		// -----------------------------------------
+		// 10-7 BuildFromUnsorted(ctxt==nullptr, count > Capacity)
+		for (int32_t i = 0; i < 65; i++)
+		{
+			keys[i] = ((i * 37) % 64) - 32;
+		}
+		Assertions_Assert(Map_BuildFromUnsorted(keys, ptrs, 64, nullptr) == 0, assertions);
+		Assertions_Assert(Map_BuildFromUnsorted(keys, ptrs, 65, &big) == 0, assertions);
+		Assertions_Assert(Map_Count(&big) == 3, assertions);
+		// -----------------------------------------
+		// 10-8 BuildFromUnsorted sorts the elements
+		Assertions_Assert(Map_BuildFromUnsorted(keys, ptrs, 64, &big) == 64, assertions);
+		Assertions_Assert(big.Root->Height == 7, assertions);
+		for (int32_t i = 0; i < 64; i++)
+		{
+			Assertions_Assert(Map_ValueFor(keys[i], &big) == ptrs[i], assertions);
+			Assertions_Assert(Map_KeyAt(i, 0, &big) == i - 32, assertions);
+		}
+		// -----------------------------------------
+		// 10-9 BuildFromUnsorted keeps the last of duplicated keys
+		keys[0] = 5;
+		keys[1] = 7;
+		keys[2] = 5;
+		keys[3] = 7;
+		keys[4] = 5;
+		Assertions_Assert(Map_BuildFromUnsorted(keys, ptrs, 5, &big) == 2, assertions);
+		Assertions_Assert(Map_ValueFor(5, &big) == ptrs[4], assertions);
+		Assertions_Assert(Map_ValueFor(7, &big) == ptrs[3], assertions);
+		Assertions_Assert(keys[4] == 5, assertions);
+
+		// -----------------------------------------
+		// 11-x LowerBound, UpperBound, ForEachInRange
+		for (int32_t i = 0; i < 64; i++)
+		{
+			keys[i] = ((i * 37) % 64) * 3;
+		}
+		Map_BuildFromUnsorted(keys, ptrs, 32, &big);
+		for (int32_t i = 32; i < 64; i++)
+		{
+			Map_Relate(ptrs[i], keys[i], &big);
+		}
+		// -----------------------------------------
+		// 11-1 LowerBound, UpperBound(ctxt==nullptr)
+		Assertions_Assert(Map_LowerBound(0, nullptr) == nullptr, assertions);
+		Assertions_Assert(Map_UpperBound(0, nullptr) == nullptr, assertions);
+		// -----------------------------------------
+		// 11-2 LowerBound, UpperBound
+		Assertions_Assert(Map_LowerBound(-5, &big)->Content.Key == 0, assertions);
+		Assertions_Assert(Map_LowerBound(30, &big)->Content.Key == 30, assertions);
+		Assertions_Assert(Map_LowerBound(31, &big)->Content.Key == 33, assertions);
+		Assertions_Assert(Map_LowerBound(190, &big) == nullptr, assertions);
+		Assertions_Assert(Map_UpperBound(30, &big)->Content.Key == 33, assertions);
+		Assertions_Assert(Map_UpperBound(189, &big) == nullptr, assertions);
+		// -----------------------------------------
+		// 11-3 Cursor visits in key order
+		AvlNode* cursor = Map_LowerBound(100, &big);
+		for (MapKey_t k = 102; k <= 189; k += 3)
+		{
+			Assertions_Assert((cursor != nullptr) && (cursor->Content.Key == k), assertions);
+			cursor = AvlTree_Next(cursor);
+		}
+		Assertions_Assert(cursor == nullptr, assertions);
+		// -----------------------------------------
+		// 11-4 ForEachInRange(ctxt==nullptr, visitor==nullptr)
+		Map_UnitTest_Visited visited;
+		memset(&visited, 0, sizeof visited);
+		visited.Limit = 64;
+		Assertions_Assert(Map_ForEachInRange(0, 200, Map_UnitTest_Visit, &visited, nullptr) == 0, assertions);
+		Assertions_Assert(Map_ForEachInRange(0, 200, nullptr, &visited, &big) == 0, assertions);
+		// -----------------------------------------
+		// 11-5 ForEachInRange visits [lower, upper] in key order
+		Assertions_Assert(Map_ForEachInRange(10, 30, Map_UnitTest_Visit, &visited, &big) == 7, assertions);
+		Assertions_Assert(visited.Count == 7, assertions);
+		for (int32_t i = 0; i < 7; i++)
+		{
+			Assertions_Assert(visited.Keys[i] == 12 + (i * 3), assertions);
+			Assertions_Assert(visited.Values[i] == Map_ValueFor(visited.Keys[i], &big), assertions);
+		}
+		// -----------------------------------------
+		// 11-6 ForEachInRange(empty range)
+		Assertions_Assert(Map_ForEachInRange(31, 32, Map_UnitTest_Visit, &visited, &big) == 0, assertions);
+		Assertions_Assert(Map_ForEachInRange(30, 10, Map_UnitTest_Visit, &visited, &big) == 0, assertions);
+		// -----------------------------------------
+		// 11-7 ForEachInRange stops when the visitor returns 0
+		memset(&visited, 0, sizeof visited);
+		visited.Limit = 3;
+		Assertions_Assert(Map_ForEachInRange(-100, 1000, Map_UnitTest_Visit, &visited, &big) == 3, assertions);
+		Assertions_Assert(visited.Keys[2] == 6, assertions);
+
+		// -----------------------------------------
+		// 12-1 Rank, Select(ctxt==nullptr)
+		Assertions_Assert(Map_Rank(0, nullptr) == 0, assertions);
+		Assertions_Assert(Map_Select(0, nullptr) == nullptr, assertions);
+		// -----------------------------------------
+		// 12-2 Rank, Select on a built and updated map (keys 0, 3, ..., 189)
+		for (MapKey_t k = -1; k <= 190; k++)
+		{
+			Assertions_Assert(Map_Rank(k, &big) == ((k <= 0) ? 0 : (((k - 1) / 3) + 1)), assertions);
+		}
+		for (int32_t r = 0; r < 64; r++)
+		{
+			cursor = Map_Select(r, &big);
+			Assertions_Assert((cursor != nullptr) && (cursor->Content.Key == r * 3), assertions);
+		}
+		Assertions_Assert(Map_Select(-1, &big) == nullptr, assertions);
+		Assertions_Assert(Map_Select(64, &big) == nullptr, assertions);
+		// -----------------------------------------
+		// 12-3 Rank, Select follow Remove
+		for (MapKey_t k = 0; k < 192; k += 6)
+		{
+			Map_Remove(k, &big);
+		}
+		for (int32_t r = 0; r < 32; r++)
+		{
+			cursor = Map_Select(r, &big);
+			Assertions_Assert((cursor != nullptr) && (cursor->Content.Key == (r * 6) + 3), assertions);
+			Assertions_Assert(Map_Rank((r * 6) + 3, &big) == r, assertions);
+		}
+		Assertions_Assert(Map_Select(32, &big) == nullptr, assertions);
+		Assertions_Assert(big.Root->Size == 32, assertions);
+
+		// -----------------------------------------
+		// 13-1 Freeze, IsFrozen(ctxt==nullptr, keys==nullptr, values==nullptr)
+		MapKey_t frozenKeys[MAP_FROZEN_SLOTS(64)];
+		const void* frozenValues[MAP_FROZEN_SLOTS(64)];
+		Assertions_Assert(Map_Freeze(frozenKeys, frozenValues, nullptr) < 0, assertions);
+		Assertions_Assert(Map_Freeze(nullptr, frozenValues, &big) < 0, assertions);
+		Assertions_Assert(Map_Freeze(frozenKeys, nullptr, &big) < 0, assertions);
+		Assertions_Assert(Map_IsFrozen(nullptr) == 0, assertions);
+		Assertions_Assert(Map_IsFrozen(&big) == 0, assertions);
+		// -----------------------------------------
+		// 13-2 Freeze an updated map (keys 3, 9, ..., 189)
+		Assertions_Assert(Map_Freeze(frozenKeys, frozenValues, &big) == 32, assertions);
+		Assertions_Assert(Map_IsFrozen(&big) != 0, assertions);
+		Assertions_Assert(Map_Freeze(frozenKeys, frozenValues, &big) < 0, assertions);
+		for (MapKey_t k = -1; k <= 200; k++)
+		{
+			cursor = AvlTree_Search(k, big.Root);
+			Assertions_Assert(Map_ValueFor(k, &big) == ((cursor != nullptr) ? cursor->Content.Value : nullptr), assertions);
+		}
+		// -----------------------------------------
+		// 13-3 A frozen map refuses updates, and keeps other queries
+		Assertions_Assert(Map_Relate(&bigValues[0], 3, &big) == 0, assertions);
+		Assertions_Assert(Map_Relate(&bigValues[0], 4, &big) == 0, assertions);
+		Assertions_Assert(Map_Emplace(4, &big) == nullptr, assertions);
+		Assertions_Assert(Map_Remove(3, &big) == 0, assertions);
+		Assertions_Assert(Map_BuildFromSorted(keys, ptrs, 3, &big) == 0, assertions);
+		Assertions_Assert(Map_BuildFromUnsorted(keys, ptrs, 3, &big) == 0, assertions);
+		Assertions_Assert(Map_Count(&big) == 32, assertions);
+		Assertions_Assert(Map_Rank(9, &big) == 1, assertions);
+		Assertions_Assert(Map_LowerBound(4, &big)->Content.Key == 9, assertions);
+		// -----------------------------------------
+		// 13-4 Freeze every size of tree, including incomplete last levels
+		for (int32_t count = 0; count <= 64; count++)
+		{
+			Map_Clear(&big);
+			Assertions_Assert(Map_IsFrozen(&big) == 0, assertions);
+			for (int32_t i = 0; i < count; i++)
+			{
+				keys[i] = (i * 2) - 40;
+				ptrs[i] = &bigValues[i];
+			}
+			Assertions_Assert(Map_BuildFromSorted(keys, ptrs, count, &big) == count, assertions);
+			Assertions_Assert(Map_Freeze(frozenKeys, frozenValues, &big) == count, assertions);
+			for (MapKey_t k = -42; k <= 90; k++)
+			{
+				int32_t i = (k + 40) / 2;
+				const void* expected = ((k % 2 == 0) && (0 <= i) && (i < count)) ? ptrs[i] : nullptr;
+				Assertions_Assert(Map_ValueFor(k, &big) == expected, assertions);
+			}
+		}
+		// -----------------------------------------
+		// 13-5 Clear thaws the map
+		Map_Clear(&big);
+		Assertions_Assert(Map_Relate(&bigValues[0], 3, &big) == 1, assertions);
+		Assertions_Assert(Map_ValueFor(3, &big) == &bigValues[0], assertions);
+	}
 }
 #endif
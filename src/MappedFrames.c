@@ -0,0 +1,508 @@
+﻿/** ------------------------------------------------------------------
+*
+*	@file	MappedFrames.c
+*	@brief	Crash-persistent frame ring buffer
+*	@author	H.Someya
+*	@date	2026/10/17
+*
+MIT License
+
+Copyright (c) 2021 Hirobumi Someya
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*
+*/
+// ftruncate等のPOSIXの宣言を、-std=c11のような厳密なモードでも有効にする
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+#include "MappedFrames.h"
+#include <string.h>
+#include <stdatomic.h>
+#include "nullptr.h"
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/* -------------------------------------------------------------------
+*	Privates
+*/
+/// <summary>
+/// <para>管理ヘッダの更新数、最古位置をreleaseで書き込む。</para>
+/// <para>それ以前のフレームの書き込みが、必ず先に永続化領域に反映される。</para>
+/// </summary>
+static void StoreRelease(int64_t value, int64_t* position)
+{
+	atomic_store_explicit(
+		(_Atomic int64_t*)position, value, memory_order_release);
+}
+
+/// <summary>
+/// <para>管理ヘッダの内容から、フレームリングバッファの状態を復元する。</para>
+/// </summary>
+static void Recover(MappedFrames* ctxt)
+{
+	MappedFramesHeader* header = ctxt->Header;
+	RingedFrames* ring = &ctxt->Ring;
+
+	// 確定していない位置は無効とする
+	if (header->UpdateCount < 0)
+	{
+		header->UpdateCount = 0;
+	}
+	if ((header->Oldest < 0) ||
+		(header->Oldest > header->UpdateCount))
+	{
+		// Clearの途中などで矛盾している場合は空とする
+		header->Oldest = header->UpdateCount;
+	}
+
+	// 書き込み位置は更新数から決まる
+	int64_t count = header->UpdateCount - header->Oldest;
+	if (count > ring->Capacity)
+	{
+		count = ring->Capacity;
+	}
+	ring->Index = (int32_t)(header->UpdateCount % ring->Capacity);
+	ring->Count = (int32_t)count;
+	ring->UpdateCount = header->UpdateCount;
+
+	// 壊れた長さのフレームは、長さ0とする
+	for (int32_t fi = 0; fi < ring->Count; fi++)
+	{
+		uint8_t* fp = (uint8_t*)RingedFrames_ReferWithOld(fi, nullptr, nullptr, ring);
+		// 8～11バイト目に長さが記録されている
+		int32_t* lenp = (int32_t*)&fp[sizeof(int64_t) - RF_FRAME_HEADER_SIZE];
+		if ((*lenp < 0) || (ring->FrameSize < *lenp))
+		{
+			*lenp = 0;
+		}
+	}
+}
+
+/* -------------------------------------------------------------------
+*	Services
+*/
+
+/// <summary>
+/// <para>永続化領域を結び付ける。</para>
+/// <para>領域に有効な管理ヘッダがあれば、その内容を復元する。</para>
+/// <para>Pushの途中で終了していた場合は、確定していたフレームまでに戻す。</para>
+/// <para>識別子が無い場合は、新しく初期化する。</para>
+/// <para>バージョン、最大蓄積可能フレーム数、最大フレームサイズが異なる場合は、
+/// 以前の内容を壊さないように失敗する。</para>
+/// <para>管理ヘッダの64ビット値を分断されずに書き込むため、領域が8バイト境界でない場合も失敗する。</para>
+/// </summary>
+/// <param name="capacity">最大蓄積可能フレーム数。</param>
+/// <param name="frameSize">最大フレームサイズ。</param>
+/// <param name="buffer">永続化領域。
+/// MF_NEEDED_BUFFER_WORDS分の要素数を持つ、8バイト境界の領域を指定すること。</param>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>MF_ATTACH_FAILED、MF_ATTACH_FORMATTED、MF_ATTACH_RECOVERED。</returns>
+int MappedFrames_Attach(
+	int32_t capacity, int32_t frameSize,
+	int32_t* buffer,
+	MappedFrames* ctxt)
+{
+	int result = MF_ATTACH_FAILED;
+	if (ctxt != nullptr)
+	{
+		memset(ctxt, 0, sizeof(MappedFrames));
+	}
+
+	if ((ctxt != nullptr) &&
+		(buffer != nullptr) &&
+		(((uintptr_t)buffer % sizeof(int64_t)) == 0) &&
+		(capacity > 0) && (frameSize >= 0))
+	{
+		MappedFramesHeader* header = (MappedFramesHeader*)buffer;
+		RingedFrames_Init(capacity, frameSize, &buffer[MF_HEADER_WORDS], &ctxt->Ring);
+
+		if (header->Magic != MF_MAGIC)
+		{
+			// 新しい領域なので初期化する
+			// 識別子は最後に書き、途中で終了した場合は次回も初期化させる
+			header->Version = MF_VERSION;
+			header->Capacity = capacity;
+			header->FrameSize = frameSize;
+			header->UpdateCount = 0;
+			header->Oldest = 0;
+			atomic_thread_fence(memory_order_release);
+			header->Magic = MF_MAGIC;
+			ctxt->Header = header;
+			result = MF_ATTACH_FORMATTED;
+		}
+		else if ((header->Version == MF_VERSION) &&
+			(header->Capacity == capacity) &&
+			(header->FrameSize == frameSize))
+		{
+			// 以前の内容を復元する
+			ctxt->Header = header;
+			Recover(ctxt);
+			result = MF_ATTACH_RECOVERED;
+		}
+	}
+	return result;
+}
+
+/// <summary>
+/// <para>フレームリングバッファを取得する。</para>
+/// <para>参照、検索、読み出しカーソルに使用する。変更はMappedFramesの関数で行うこと。</para>
+/// </summary>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>フレームリングバッファ。nullでなし。</returns>
+const RingedFrames* MappedFrames_Ring(
+	const MappedFrames* ctxt)
+{
+	const RingedFrames* result = nullptr;
+	if ((ctxt != nullptr) &&
+		(ctxt->Header != nullptr))
+	{
+		result = &ctxt->Ring;
+	}
+	return result;
+}
+
+/// <summary>
+/// <para>クリアする。</para>
+/// </summary>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>なし。</returns>
+void MappedFrames_Clear(
+	MappedFrames* ctxt)
+{
+	if ((ctxt != nullptr) &&
+		(ctxt->Header != nullptr))
+	{
+		RingedFrames_Clear(&ctxt->Ring);
+		// 更新数を先に戻す(途中で終了しても、最古が更新数を超えるので空に復元される)
+		StoreRelease(0, &ctxt->Header->UpdateCount);
+		StoreRelease(0, &ctxt->Header->Oldest);
+	}
+}
+
+/// <summary>
+/// <para>フレームをPushする。</para>
+/// <para>最大蓄積可能フレーム数まで蓄積されていると、最古を上書きする。</para>
+/// </summary>
+/// <param name="frame">フレーム。</param>
+/// <param name="length">フレームの長さ。</param>
+/// <param name="timestamp">タイムスタンプ。</param>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>なし。</returns>
+void MappedFrames_Push(
+	const void* frame, int32_t length,
+	int64_t timestamp,
+	MappedFrames* ctxt)
+{
+	if ((ctxt != nullptr) &&
+		(ctxt->Header != nullptr))
+	{
+		RingedFrames* ring = &ctxt->Ring;
+
+		// 満杯の場合、書き込み位置は最古のフレームと重なるので、書き込む前に最古を外す
+		if (ring->Count >= ring->Capacity)
+		{
+			StoreRelease(ring->UpdateCount - ring->Count + 1, &ctxt->Header->Oldest);
+		}
+
+		// フレームを書き込んでから、更新数で確定する
+		RingedFrames_Push(frame, length, timestamp, ring);
+		StoreRelease(ring->UpdateCount, &ctxt->Header->UpdateCount);
+	}
+}
+
+/// <summary>
+/// <para>最古のフレームをPopする。</para>
+/// <para>フレームが無い場合は負を返す。</para>
+/// <para>格納先が足りない場合は、格納できる分だけ返す。</para>
+/// </summary>
+/// <param name="buffer">フレームの格納先バッファ。</param>
+/// <param name="bufferSize">フレーム格納先バッファのサイズ。</param>
+/// <param name="timestamp">タイムスタンプの格納先。</param>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>フレーム長。</returns>
+int32_t MappedFrames_Pop(
+	void* buffer, int32_t bufferSize,
+	int64_t* timestamp,
+	MappedFrames* ctxt)
+{
+	int32_t length = -1;
+	if ((ctxt != nullptr) &&
+		(ctxt->Header != nullptr))
+	{
+		RingedFrames* ring = &ctxt->Ring;
+		length = RingedFrames_Pop(buffer, bufferSize, timestamp, ring);
+		if (length >= 0)
+		{
+			StoreRelease(ring->UpdateCount - ring->Count, &ctxt->Header->Oldest);
+		}
+	}
+	else if (timestamp != nullptr)
+	{
+		*timestamp = 0LL;
+	}
+	return length;
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+/// <summary>
+/// <para>ファイルをメモリマップして、永続化領域として結び付ける。</para>
+/// <para>ファイルが無い場合は作成する。</para>
+/// </summary>
+/// <param name="path">ファイルのパス。</param>
+/// <param name="capacity">最大蓄積可能フレーム数。</param>
+/// <param name="frameSize">最大フレームサイズ。</param>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>MF_ATTACH_FAILED、MF_ATTACH_FORMATTED、MF_ATTACH_RECOVERED。</returns>
+int MappedFrames_Open(
+	const char* path,
+	int32_t capacity, int32_t frameSize,
+	MappedFrames* ctxt)
+{
+	int result = MF_ATTACH_FAILED;
+	if ((path != nullptr) &&
+		(ctxt != nullptr) &&
+		(capacity > 0) && (frameSize >= 0))
+	{
+		size_t size = sizeof(int32_t) * (size_t)MF_NEEDED_BUFFER_WORDS(capacity, frameSize);
+		void* mapping = MAP_FAILED;
+
+		// 新しいファイルは必要なサイズにして(0で埋められる)、マップする
+		// 既存のファイルのサイズが異なる場合は、内容を壊さないように失敗する
+		int fd = open(path, O_RDWR | O_CREAT, 0644);
+		if (fd >= 0)
+		{
+			struct stat st;
+			if ((fstat(fd, &st) == 0) &&
+				(((st.st_size == 0) && (ftruncate(fd, (off_t)size) == 0)) ||
+				 ((size_t)st.st_size == size)))
+			{
+				mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+			}
+			// マップした後はファイルを閉じてよい
+			close(fd);
+		}
+
+		if (mapping != MAP_FAILED)
+		{
+			result = MappedFrames_Attach(capacity, frameSize, (int32_t*)mapping, ctxt);
+			if (result != MF_ATTACH_FAILED)
+			{
+				ctxt->Mapping = mapping;
+				ctxt->MappingSize = size;
+			}
+			else
+			{
+				munmap(mapping, size);
+			}
+		}
+	}
+	return result;
+}
+
+/// <summary>
+/// <para>MappedFrames_Openでマップしたファイルを閉じる。</para>
+/// </summary>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>なし。</returns>
+void MappedFrames_Close(
+	MappedFrames* ctxt)
+{
+	if ((ctxt != nullptr) &&
+		(ctxt->Mapping != nullptr))
+	{
+		munmap(ctxt->Mapping, ctxt->MappingSize);
+		memset(ctxt, 0, sizeof(MappedFrames));
+	}
+}
+#endif
+
+/* -------------------------------------------------------------------
+*	Unit Test
+*/
+#ifdef _UNIT_TEST
+#include <stdio.h>
+#include <stdlib.h>
+#include "Assertions.h"
+
+void MappedFrames_UnitTest(void)
+{
+	Assertions* assertions = Assertions_Instance();
+	MappedFrames mapped;
+	MappedFrames recovered;
+	int64_t buffer[(2 + MF_NEEDED_BUFFER_WORDS(3, 8) + 1) / 2 + 1];
+	int32_t* words = (int32_t*)buffer;
+	int32_t wordCount = (int32_t)(sizeof buffer) / (int32_t)sizeof(int32_t);
+	int64_t crashedBuffer[(MF_NEEDED_BUFFER_WORDS(3, 8) + 1) / 2];
+	int32_t* crashed = (int32_t*)crashedBuffer;
+	const size_t regionSize = MF_NEEDED_BUFFER_WORDS(3, 8) * sizeof(int32_t);
+	uint8_t frame[8];
+	uint8_t dataBuffer[8];
+	const uint8_t* referer;
+	int32_t length;
+	int64_t timestamp;
+
+	// -----------------------------------------
+	// 1-1 Attach(ctxt==nullptr, buffer==nullptr)
+	memset(buffer, 0, sizeof buffer);
+	words[0] = -1;
+	words[1] = -1;
+	words[wordCount - 1] = -1;
+	Assertions_Assert(MappedFrames_Attach(3, 8, &words[2], nullptr) == MF_ATTACH_FAILED, assertions);
+	Assertions_Assert(MappedFrames_Attach(3, 8, nullptr, &mapped) == MF_ATTACH_FAILED, assertions);
+	Assertions_Assert(MappedFrames_Ring(&mapped) == nullptr, assertions);
+	// 8バイト境界でない領域は、変更せずに失敗する
+	Assertions_Assert(MappedFrames_Attach(3, 8, &words[1], &mapped) == MF_ATTACH_FAILED, assertions);
+	Assertions_Assert(MappedFrames_Ring(&mapped) == nullptr, assertions);
+	Assertions_Assert(words[2] == 0, assertions);
+	MappedFrames_Push(frame, 8, 11LL, &mapped);
+	Assertions_Assert(MappedFrames_Pop(dataBuffer, sizeof dataBuffer, &timestamp, &mapped) < 0, assertions);
+	// -----------------------------------------
+	// 1-2 Attach new region
+	Assertions_Assert(MappedFrames_Attach(3, 8, &words[2], &mapped) == MF_ATTACH_FORMATTED, assertions);
+	Assertions_Assert(RingedFrames_Count(MappedFrames_Ring(&mapped)) == 0, assertions);
+	Assertions_Assert(mapped.Header->Magic == MF_MAGIC, assertions);
+	// -----------------------------------------
+	// 1-3 Attach again, recovered
+	Assertions_Assert(MappedFrames_Attach(3, 8, &words[2], &mapped) == MF_ATTACH_RECOVERED, assertions);
+	// -----------------------------------------
+	// 1-4 Attach with different layout
+	Assertions_Assert(MappedFrames_Attach(4, 8, &words[2], &recovered) == MF_ATTACH_FAILED, assertions);
+	Assertions_Assert(MappedFrames_Attach(3, 7, &words[2], &recovered) == MF_ATTACH_FAILED, assertions);
+
+	// -----------------------------------------
+	// 2-1 Push, recovered after crash
+	for (int32_t i = 0; i < 5; i++)
+	{
+		memset(frame, 0, sizeof frame);
+		frame[0] = 2;
+		frame[7] = (uint8_t)i;
+		MappedFrames_Push(frame, 8, 20LL + i, &mapped);
+	}
+	memcpy(crashed, &words[2], regionSize);
+	Assertions_Assert(MappedFrames_Attach(3, 8, crashed, &recovered) == MF_ATTACH_RECOVERED, assertions);
+	Assertions_Assert(RingedFrames_Count(MappedFrames_Ring(&recovered)) == 3, assertions);
+	Assertions_Assert(RingedFrames_UpdateCount(MappedFrames_Ring(&recovered)) == 5, assertions);
+	referer = RingedFrames_ReferWithOld(0, &length, &timestamp, MappedFrames_Ring(&recovered));
+	Assertions_Assert(referer[7] == 2, assertions);
+	Assertions_Assert(length == 8, assertions);
+	Assertions_Assert(timestamp == 22LL, assertions);
+	referer = RingedFrames_ReferWithNew(0, &length, &timestamp, MappedFrames_Ring(&recovered));
+	Assertions_Assert(referer[7] == 4, assertions);
+	Assertions_Assert(timestamp == 24LL, assertions);
+	// Continue pushing after recovery
+	MappedFrames_Push(frame, 8, 25LL, &recovered);
+	referer = RingedFrames_ReferWithOld(0, &length, &timestamp, MappedFrames_Ring(&recovered));
+	Assertions_Assert(timestamp == 23LL, assertions);
+
+	// -----------------------------------------
+	// 2-2 Crashed in the middle of Push to a full ring
+	memcpy(crashed, &words[2], regionSize);
+	{
+		// The oldest is released, then the frame is being written
+		MappedFramesHeader* header = (MappedFramesHeader*)crashed;
+		header->Oldest = header->UpdateCount - 3 + 1;
+		uint8_t* slot = (uint8_t*)&crashed[MF_HEADER_WORDS + RF_STRIDE_WORDS(8) * (int32_t)(header->UpdateCount % 3)];
+		memset(slot, 0x5a, RF_FRAME_HEADER_SIZE);
+	}
+	Assertions_Assert(MappedFrames_Attach(3, 8, crashed, &recovered) == MF_ATTACH_RECOVERED, assertions);
+	Assertions_Assert(RingedFrames_Count(MappedFrames_Ring(&recovered)) == 2, assertions);
+	referer = RingedFrames_ReferWithOld(0, &length, &timestamp, MappedFrames_Ring(&recovered));
+	Assertions_Assert(timestamp == 23LL, assertions);
+	referer = RingedFrames_ReferWithNew(0, &length, &timestamp, MappedFrames_Ring(&recovered));
+	Assertions_Assert(timestamp == 24LL, assertions);
+
+	// -----------------------------------------
+	// 2-3 Broken length is recovered as zero length
+	memcpy(crashed, &words[2], regionSize);
+	{
+		MappedFramesHeader* header = (MappedFramesHeader*)crashed;
+		int32_t* slot = &crashed[MF_HEADER_WORDS + RF_STRIDE_WORDS(8) * (int32_t)((header->UpdateCount - 1) % 3)];
+		slot[2] = 9;
+	}
+	Assertions_Assert(MappedFrames_Attach(3, 8, crashed, &recovered) == MF_ATTACH_RECOVERED, assertions);
+	referer = RingedFrames_ReferWithNew(0, &length, &timestamp, MappedFrames_Ring(&recovered));
+	Assertions_Assert(length == 0, assertions);
+	Assertions_Assert(timestamp == 24LL, assertions);
+
+	// -----------------------------------------
+	// 3-1 Pop is persisted
+	length = MappedFrames_Pop(dataBuffer, sizeof dataBuffer, &timestamp, &mapped);
+	Assertions_Assert(length == 8, assertions);
+	Assertions_Assert(timestamp == 22LL, assertions);
+	memcpy(crashed, &words[2], regionSize);
+	Assertions_Assert(MappedFrames_Attach(3, 8, crashed, &recovered) == MF_ATTACH_RECOVERED, assertions);
+	Assertions_Assert(RingedFrames_Count(MappedFrames_Ring(&recovered)) == 2, assertions);
+	referer = RingedFrames_ReferWithOld(0, &length, &timestamp, MappedFrames_Ring(&recovered));
+	Assertions_Assert(timestamp == 23LL, assertions);
+
+	// -----------------------------------------
+	// 3-2 Clear is persisted, even if crashed in the middle
+	memcpy(crashed, &words[2], regionSize);
+	((MappedFramesHeader*)crashed)->UpdateCount = 0;
+	Assertions_Assert(MappedFrames_Attach(3, 8, crashed, &recovered) == MF_ATTACH_RECOVERED, assertions);
+	Assertions_Assert(RingedFrames_Count(MappedFrames_Ring(&recovered)) == 0, assertions);
+	MappedFrames_Clear(&mapped);
+	memcpy(crashed, &words[2], regionSize);
+	Assertions_Assert(MappedFrames_Attach(3, 8, crashed, &recovered) == MF_ATTACH_RECOVERED, assertions);
+	Assertions_Assert(RingedFrames_Count(MappedFrames_Ring(&recovered)) == 0, assertions);
+	Assertions_Assert(RingedFrames_UpdateCount(MappedFrames_Ring(&recovered)) == 0, assertions);
+
+	// Do not destroy memories
+	Assertions_Assert(words[0] == -1, assertions);
+	Assertions_Assert(words[1] == -1, assertions);
+	Assertions_Assert(words[wordCount - 1] == -1, assertions);
+
+#if defined(__unix__) || defined(__APPLE__)
+	// -----------------------------------------
+	// 4-1 Open file, reopen and recover
+	char path[] = "/tmp/MappedFrames_XXXXXX";
+	int fd = mkstemp(path);
+	Assertions_Assert(fd >= 0, assertions);
+	if (fd >= 0)
+	{
+		close(fd);
+		Assertions_Assert(MappedFrames_Open(path, 3, 8, &mapped) == MF_ATTACH_FORMATTED, assertions);
+		memset(frame, 0, sizeof frame);
+		frame[0] = 4;
+		frame[7] = 1;
+		MappedFrames_Push(frame, 8, 41LL, &mapped);
+		MappedFrames_Close(&mapped);
+		Assertions_Assert(MappedFrames_Ring(&mapped) == nullptr, assertions);
+
+		Assertions_Assert(MappedFrames_Open(path, 3, 8, &mapped) == MF_ATTACH_RECOVERED, assertions);
+		referer = RingedFrames_ReferWithOld(0, &length, &timestamp, MappedFrames_Ring(&mapped));
+		Assertions_Assert(referer != nullptr, assertions);
+		Assertions_Assert(referer[7] == 1, assertions);
+		Assertions_Assert(timestamp == 41LL, assertions);
+		MappedFrames_Close(&mapped);
+
+		// -----------------------------------------
+		// 4-2 Open with different layout
+		Assertions_Assert(MappedFrames_Open(path, 4, 8, &mapped) == MF_ATTACH_FAILED, assertions);
+		Assertions_Assert(MappedFrames_Open(nullptr, 3, 8, &mapped) == MF_ATTACH_FAILED, assertions);
+		remove(path);
+	}
+#endif
+}
+#endif
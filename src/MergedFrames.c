@@ -0,0 +1,422 @@
+﻿/** ------------------------------------------------------------------
+*
+*	@file	MergedFrames.c
+*	@brief	K-way timestamp merge of frame ring buffers
+*	@author	H.Someya
+*	@date	2026/10/17
+*
+MIT License
+
+Copyright (c) 2021 Hirobumi Someya
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*
+*/
+#include "MergedFrames.h"
+#include <string.h>
+#include "nullptr.h"
+
+/* -------------------------------------------------------------------
+*	Privates
+*/
+/// <summary>
+/// <para>ヒープ要素aがbより先に読み出すべきかを判定する。</para>
+/// </summary>
+static int Precedes(const MergedFramesNode* a, const MergedFramesNode* b)
+{
+	return (a->Key < b->Key) ||
+		((a->Key == b->Key) && (a->Channel < b->Channel));
+}
+
+/// <summary>
+/// <para>ヒープの指定位置の要素を、子と比較しながら下げる。</para>
+/// </summary>
+static void SiftDown(int32_t hi, MergedFrames* ctxt)
+{
+	MergedFramesNode* heap = ctxt->Heap;
+	MergedFramesNode node = heap[hi];
+	for (;;)
+	{
+		int32_t child = (hi * 2) + 1;
+		if (child >= ctxt->HeapCount)
+		{
+			break;
+		}
+		// 先に読み出すべき方の子と比較する
+		if ((child + 1 < ctxt->HeapCount) &&
+			Precedes(&heap[child + 1], &heap[child]))
+		{
+			child += 1;
+		}
+		if (!Precedes(&heap[child], &node))
+		{
+			break;
+		}
+		heap[hi] = heap[child];
+		hi = child;
+	}
+	heap[hi] = node;
+}
+
+/// <summary>
+/// <para>チャネルの次の未読フレームを参照する。</para>
+/// </summary>
+static const void* PeekChannel(
+	int32_t channel,
+	int32_t* length, int64_t* timestamp,
+	MergedFrames* ctxt)
+{
+	const RingedFrames* ring = ctxt->Rings[channel];
+	int32_t index = 0;
+	if (RingedFramesCursor_Unread(&index, ring, &ctxt->Cursors[channel]) <= 0)
+	{
+		// 未読がない場合は、範囲外を参照させて結果を初期化する
+		index = -1;
+	}
+	return RingedFrames_ReferWithOld(index, length, timestamp, ring);
+}
+
+/// <summary>
+/// <para>ヒープの先頭の要素を削除する。</para>
+/// </summary>
+static void RemoveTop(MergedFrames* ctxt)
+{
+	ctxt->HeapCount -= 1;
+	if (ctxt->HeapCount > 0)
+	{
+		ctxt->Heap[0] = ctxt->Heap[ctxt->HeapCount];
+		SiftDown(0, ctxt);
+	}
+}
+
+/* -------------------------------------------------------------------
+*	Services
+*/
+
+/// <summary>
+/// <para>マージを初期化する。</para>
+/// <para>各チャネルは、蓄積されている最古のフレームから読み出す。</para>
+/// </summary>
+/// <param name="rings">フレームリングバッファの配列。</param>
+/// <param name="channelCount">チャネル数(配列の要素数)。</param>
+/// <param name="cursors">動作に必要な、チャネル数分の読み出しカーソルの配列。</param>
+/// <param name="heap">動作に必要な、チャネル数分のヒープ要素の配列。</param>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>なし。</returns>
+void MergedFrames_Init(
+	const RingedFrames* const* rings, int32_t channelCount,
+	RingedFramesCursor* cursors,
+	MergedFramesNode* heap,
+	MergedFrames* ctxt)
+{
+	if (ctxt != nullptr)
+	{
+		memset(ctxt, 0, sizeof(MergedFrames));
+		if ((rings != nullptr) &&
+			(cursors != nullptr) &&
+			(heap != nullptr) &&
+			(channelCount > 0))
+		{
+			ctxt->Rings = rings;
+			ctxt->ChannelCount = channelCount;
+			ctxt->Cursors = cursors;
+			ctxt->Heap = heap;
+
+			// 最古のフレームから読み出す
+			for (int32_t ci = 0; ci < channelCount; ci++)
+			{
+				RingedFramesCursor_Init(rings[ci], &cursors[ci]);
+				cursors[ci].Position -= RingedFrames_Count(rings[ci]);
+			}
+
+			MergedFrames_Refresh(ctxt);
+		}
+	}
+}
+
+/// <summary>
+/// <para>未読フレームがあるチャネルで、ヒープを作り直す。</para>
+/// <para>読み切ったチャネルはヒープから外れるので、新しくPushした後に呼び出すこと。</para>
+/// </summary>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>未読フレームがあるチャネル数。</returns>
+int32_t MergedFrames_Refresh(
+	MergedFrames* ctxt)
+{
+	int32_t result = 0;
+	if (ctxt != nullptr)
+	{
+		// 未読フレームがあるチャネルを集める
+		ctxt->HeapCount = 0;
+		for (int32_t ci = 0; ci < ctxt->ChannelCount; ci++)
+		{
+			int64_t timestamp;
+			if (PeekChannel(ci, nullptr, &timestamp, ctxt) != nullptr)
+			{
+				MergedFramesNode* node = &ctxt->Heap[ctxt->HeapCount];
+				node->Key = timestamp;
+				node->Channel = ci;
+				node->Padding = 0;
+				ctxt->HeapCount += 1;
+			}
+		}
+
+		// 下から順にヒープにする
+		for (int32_t hi = (ctxt->HeapCount / 2) - 1; hi >= 0; hi--)
+		{
+			SiftDown(hi, ctxt);
+		}
+
+		result = ctxt->HeapCount;
+	}
+	return result;
+}
+
+/// <summary>
+/// <para>全チャネルの中で、タイムスタンプが最も古い未読フレームを参照し、読み出し位置を進める。</para>
+/// <para>タイムスタンプが等しい場合は、チャネルの小さい方を先にする。</para>
+/// <para>コピーせず、内部メモリを直接参照する。</para>
+/// </summary>
+/// <param name="length">フレーム長の格納先。</param>
+/// <param name="timestamp">タイムスタンプの格納先。</param>
+/// <param name="channel">チャネルの格納先。</param>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>フレーム。nullで未読なし。</returns>
+const void* MergedFrames_Next(
+	int32_t* length,
+	int64_t* timestamp,
+	int32_t* channel,
+	MergedFrames* ctxt)
+{
+	// 結果を初期化
+	const void* frame = nullptr;
+	int32_t len = 0;
+	int64_t ts = 0LL;
+	int32_t ch = -1;
+
+	while ((frame == nullptr) &&
+		(ctxt != nullptr) &&
+		(ctxt->HeapCount > 0))
+	{
+		MergedFramesNode* top = &ctxt->Heap[0];
+		const void* fp = PeekChannel(top->Channel, &len, &ts, ctxt);
+		if (fp == nullptr)
+		{
+			// Popされるなどして未読がなくなった
+			RemoveTop(ctxt);
+		}
+		else if (ts != top->Key)
+		{
+			// ヒープに入れた後に上書きされたので、新しいタイムスタンプで並べ直す
+			top->Key = ts;
+			SiftDown(0, ctxt);
+		}
+		else
+		{
+			// 最も古いフレームなので読み出す
+			frame = fp;
+			ch = top->Channel;
+			RingedFramesCursor_Advance(1, ctxt->Rings[ch], &ctxt->Cursors[ch]);
+
+			// チャネルの次の未読フレームで並べ直す
+			int64_t next;
+			if (PeekChannel(ch, nullptr, &next, ctxt) != nullptr)
+			{
+				top->Key = next;
+				SiftDown(0, ctxt);
+			}
+			else
+			{
+				RemoveTop(ctxt);
+			}
+		}
+	}
+
+	if (frame == nullptr)
+	{
+		len = 0;
+		ts = 0LL;
+	}
+	if (length != nullptr)
+	{
+		*length = len;
+	}
+	if (timestamp != nullptr)
+	{
+		*timestamp = ts;
+	}
+	if (channel != nullptr)
+	{
+		*channel = ch;
+	}
+	return frame;
+}
+
+/// <summary>
+/// <para>全チャネルで、上書きされて読み逃したフレーム数の合計を取得する。</para>
+/// </summary>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>読み逃したフレーム数。</returns>
+int64_t MergedFrames_Lost(
+	const MergedFrames* ctxt)
+{
+	int64_t result = 0;
+	if (ctxt != nullptr)
+	{
+		for (int32_t ci = 0; ci < ctxt->ChannelCount; ci++)
+		{
+			result += RingedFramesCursor_Lost(&ctxt->Cursors[ci]);
+		}
+	}
+	return result;
+}
+
+/* -------------------------------------------------------------------
+*	Unit Test
+*/
+#ifdef _UNIT_TEST
+#include "Assertions.h"
+
+void MergedFrames_UnitTest(void)
+{
+	Assertions* assertions = Assertions_Instance();
+	RingedFrames rings[3];
+	int32_t buffers[3][RF_NEEDED_BUFFER_WORDS(4, 8)];
+	const RingedFrames* ringPointers[3] = { &rings[0], &rings[1], &rings[2] };
+	RingedFramesCursor cursors[3];
+	MergedFramesNode heap[3];
+	MergedFrames merged;
+	const uint8_t* referer;
+	uint8_t frame[8];
+	int32_t length;
+	int64_t timestamp;
+	int32_t channel;
+
+	for (int32_t ri = 0; ri < 3; ri++)
+	{
+		RingedFrames_Init(4, 8, buffers[ri], &rings[ri]);
+	}
+
+	// -----------------------------------------
+	// 1-1 Init(ctxt==nullptr), invalid arguments
+	MergedFrames_Init(ringPointers, 3, cursors, heap, nullptr);
+	MergedFrames_Init(nullptr, 3, cursors, heap, &merged);
+	Assertions_Assert(MergedFrames_Refresh(&merged) == 0, assertions);
+	Assertions_Assert(MergedFrames_Refresh(nullptr) == 0, assertions);
+	referer = MergedFrames_Next(&length, &timestamp, &channel, nullptr);
+	Assertions_Assert(referer == nullptr, assertions);
+	Assertions_Assert(length == 0, assertions);
+	Assertions_Assert(timestamp == 0LL, assertions);
+	Assertions_Assert(channel == -1, assertions);
+	Assertions_Assert(MergedFrames_Lost(nullptr) == 0, assertions);
+	// -----------------------------------------
+	// 1-2 Init with empty rings
+	MergedFrames_Init(ringPointers, 3, cursors, heap, &merged);
+	Assertions_Assert(MergedFrames_Next(&length, &timestamp, &channel, &merged) == nullptr, assertions);
+
+	// -----------------------------------------
+	// 2-1 Merge in timestamp order
+	// ch0: 10, 40, 70
+	// ch1: 20, 30, 80
+	// ch2: 40, 50
+	const int64_t ch0[] = { 10, 40, 70 };
+	const int64_t ch1[] = { 20, 30, 80 };
+	const int64_t ch2[] = { 40, 50 };
+	for (int32_t i = 0; i < 3; i++)
+	{
+		memset(frame, 0, sizeof frame);
+		frame[0] = 0;
+		frame[7] = (uint8_t)i;
+		RingedFrames_Push(frame, 8, ch0[i], &rings[0]);
+		frame[0] = 1;
+		RingedFrames_Push(frame, 8, ch1[i], &rings[1]);
+		if (i < 2)
+		{
+			frame[0] = 2;
+			RingedFrames_Push(frame, 8, ch2[i], &rings[2]);
+		}
+	}
+	MergedFrames_Init(ringPointers, 3, cursors, heap, &merged);
+	{
+		const int64_t expectedTimes[] = { 10, 20, 30, 40, 40, 50, 70, 80 };
+		const int32_t expectedChannels[] = { 0, 1, 1, 0, 2, 2, 0, 1 };
+		for (int32_t i = 0; i < 8; i++)
+		{
+			referer = MergedFrames_Next(&length, &timestamp, &channel, &merged);
+			Assertions_Assert(referer != nullptr, assertions);
+			Assertions_Assert(timestamp == expectedTimes[i], assertions);
+			Assertions_Assert(channel == expectedChannels[i], assertions);
+			Assertions_Assert(referer[0] == (uint8_t)channel, assertions);
+			Assertions_Assert(length == 8, assertions);
+		}
+	}
+	referer = MergedFrames_Next(&length, &timestamp, &channel, &merged);
+	Assertions_Assert(referer == nullptr, assertions);
+	Assertions_Assert(channel == -1, assertions);
+	// Rings are not changed
+	Assertions_Assert(RingedFrames_Count(&rings[0]) == 3, assertions);
+
+	// -----------------------------------------
+	// 2-2 Refresh after new frames are pushed
+	RingedFrames_Push(nullptr, 0, 90LL, &rings[2]);
+	RingedFrames_Push(nullptr, 0, 85LL, &rings[1]);
+	Assertions_Assert(MergedFrames_Next(&length, &timestamp, &channel, &merged) == nullptr, assertions);
+	Assertions_Assert(MergedFrames_Refresh(&merged) == 2, assertions);
+	MergedFrames_Next(&length, &timestamp, &channel, &merged);
+	Assertions_Assert(timestamp == 85LL, assertions);
+	Assertions_Assert(channel == 1, assertions);
+	MergedFrames_Next(&length, &timestamp, &channel, &merged);
+	Assertions_Assert(timestamp == 90LL, assertions);
+	Assertions_Assert(channel == 2, assertions);
+
+	// -----------------------------------------
+	// 3-1 Frames overwritten while waiting in the heap
+	for (int32_t ri = 0; ri < 3; ri++)
+	{
+		RingedFrames_Clear(&rings[ri]);
+	}
+	RingedFrames_Push(nullptr, 0, 100LL, &rings[0]);
+	RingedFrames_Push(nullptr, 0, 110LL, &rings[1]);
+	MergedFrames_Init(ringPointers, 3, cursors, heap, &merged);
+	// ch0 is overwritten: 100 is lost, 120..150 remain
+	for (int32_t i = 0; i < 4; i++)
+	{
+		RingedFrames_Push(nullptr, 0, 120LL + (10 * i), &rings[0]);
+	}
+	MergedFrames_Next(&length, &timestamp, &channel, &merged);
+	Assertions_Assert(timestamp == 110LL, assertions);
+	Assertions_Assert(channel == 1, assertions);
+	MergedFrames_Next(&length, &timestamp, &channel, &merged);
+	Assertions_Assert(timestamp == 120LL, assertions);
+	Assertions_Assert(channel == 0, assertions);
+	Assertions_Assert(MergedFrames_Lost(&merged) == 1, assertions);
+
+	// -----------------------------------------
+	// 3-2 Frames popped while waiting in the heap
+	RingedFrames_Push(nullptr, 0, 200LL, &rings[2]);
+	MergedFrames_Refresh(&merged);
+	while (RingedFrames_Pop(nullptr, 0, nullptr, &rings[0]) >= 0)
+	{
+	}
+	MergedFrames_Next(&length, &timestamp, &channel, &merged);
+	Assertions_Assert(timestamp == 200LL, assertions);
+	Assertions_Assert(channel == 2, assertions);
+	Assertions_Assert(MergedFrames_Next(&length, &timestamp, &channel, &merged) == nullptr, assertions);
+}
+#endif
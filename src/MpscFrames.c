@@ -0,0 +1,521 @@
+﻿/** ------------------------------------------------------------------
+*
+*	@file	MpscFrames.c
+*	@brief	Multi-producer/single-consumer frame ring buffer
+*	@author	H.Someya
+*	@date	2026/10/17
+*
+MIT License
+
+Copyright (c) 2021 Hirobumi Someya
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*
+*/
+#include "MpscFrames.h"
+#include <string.h>
+#include <stdatomic.h>
+#include "nullptr.h"
+
+/* -------------------------------------------------------------------
+*	Privates
+*/
+/// <summary>
+/// <para>位置をacquireで読み出す。</para>
+/// </summary>
+static int64_t LoadAcquire(const int64_t* position)
+{
+	return atomic_load_explicit(
+		(const _Atomic int64_t*)position, memory_order_acquire);
+}
+/// <summary>
+/// <para>位置を読み出す。順序の保証はスロットのシーケンス番号で行う。</para>
+/// </summary>
+static int64_t LoadRelaxed(const int64_t* position)
+{
+	return atomic_load_explicit(
+		(const _Atomic int64_t*)position, memory_order_relaxed);
+}
+/// <summary>
+/// <para>位置をreleaseで書き込む。</para>
+/// </summary>
+static void StoreRelease(int64_t value, int64_t* position)
+{
+	atomic_store_explicit(
+		(_Atomic int64_t*)position, value, memory_order_release);
+}
+
+/// <summary>
+/// <para>位置に対応するフレームヘッダを取得する。</para>
+/// </summary>
+static uint8_t* HeaderAt(int64_t position, const MpscFrames* ctxt)
+{
+	int32_t fi = (int32_t)(position % ctxt->Capacity);
+	int32_t bi = RF_STRIDE_WORDS(ctxt->FrameSize) * fi;
+	return (uint8_t*)&ctxt->Buffer[bi];
+}
+
+/// <summary>
+/// <para>ヘッダの12～15バイト目にある、スロットのシーケンス番号を取得する。</para>
+/// <para>位置の下位32ビットで、空き(位置)と公開済み(位置+1)を表す。</para>
+/// </summary>
+static _Atomic uint32_t* StampOf(uint8_t* header)
+{
+	return (_Atomic uint32_t*)&header[sizeof(int64_t) + sizeof(int32_t)];
+}
+
+/// <summary>
+/// <para>シーケンス番号と位置の差を取得する。</para>
+/// <para>32ビットで周回しても、差が小さい間は正しく比較できる。</para>
+/// </summary>
+static int32_t StampDiff(uint32_t stamp, int64_t position)
+{
+	return (int32_t)(stamp - (uint32_t)position);
+}
+
+/* -------------------------------------------------------------------
+*	Services
+*/
+
+/// <summary>
+/// <para>MPSCフレームリングバッファを初期化する。</para>
+/// <para>生産者、消費者のスレッドを開始する前に呼び出すこと。</para>
+/// <para>最大蓄積可能フレーム数がMPSC_MIN_CAPACITY未満の場合は、何も蓄積できない。</para>
+/// </summary>
+/// <param name="capacity">最大蓄積可能フレーム数(MPSC_MIN_CAPACITY以上)。</param>
+/// <param name="frameSize">最大フレームサイズ。</param>
+/// <param name="buffer">動作に必要なバッファ。
+/// MPSC_NEEDED_BUFFER_WORDS分の要素数を持つ、8バイト境界の領域を確保して指定すること。</param>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>なし。</returns>
+void MpscFrames_Init(
+	int32_t capacity, int32_t frameSize,
+	int32_t* buffer,
+	MpscFrames* ctxt)
+{
+	if (ctxt != nullptr)
+	{
+		memset(ctxt, 0, sizeof(MpscFrames));
+		// 公開済みと空きを見分けられない場合は、蓄積しない
+		ctxt->Capacity = (capacity >= MPSC_MIN_CAPACITY) ? capacity : 0;
+		ctxt->FrameSize = frameSize;
+		ctxt->Buffer = buffer;
+
+		// 各スロットを、最初の周回の位置で空きにする
+		if (buffer != nullptr)
+		{
+			for (int32_t fi = 0; fi < ctxt->Capacity; fi++)
+			{
+				atomic_init(StampOf(HeaderAt(fi, ctxt)), (uint32_t)fi);
+			}
+		}
+	}
+}
+
+/// <summary>
+/// <para>現在のフレーム蓄積数を取得する。</para>
+/// <para>書き込み途中のフレームも含む。</para>
+/// <para>別スレッドから操作中の場合は、取得した時点の概算となる。</para>
+/// </summary>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>現在のフレーム蓄積数。</returns>
+int32_t MpscFrames_Count(
+	const MpscFrames* ctxt)
+{
+	int32_t result = 0;
+	if (ctxt != nullptr)
+	{
+		// Tailを先に読むことで、UpdateCount - Tailが負にならないようにする
+		int64_t tail = LoadAcquire(&ctxt->Tail);
+		int64_t updateCount = LoadAcquire(&ctxt->UpdateCount);
+		result = (int32_t)(updateCount - tail);
+	}
+	return result;
+}
+
+/// <summary>
+/// <para>最大蓄積可能フレーム数を取得する。</para>
+/// </summary>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>最大蓄積可能フレーム数。</returns>
+int32_t MpscFrames_Capacity(
+	const MpscFrames* ctxt)
+{
+	int32_t result = 0;
+	if (ctxt != nullptr)
+	{
+		result = ctxt->Capacity;
+	}
+	return result;
+}
+
+/// <summary>
+/// <para>最大フレームサイズを取得する。</para>
+/// </summary>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>最大フレームサイズ。</returns>
+int32_t MpscFrames_FrameSize(
+	const MpscFrames* ctxt)
+{
+	int32_t result = 0;
+	if (ctxt != nullptr)
+	{
+		result = ctxt->FrameSize;
+	}
+	return result;
+}
+
+/// <summary>
+/// <para>フレームをPushする。複数の生産者スレッドから同時に呼び出せる。</para>
+/// <para>消費者が読み出し中のフレームを壊さないよう、最古を上書きせず失敗する。</para>
+/// <para>フレームが無効(null、長さ不正)の場合は、長さ0で記録する。</para>
+/// </summary>
+/// <param name="frame">フレーム。</param>
+/// <param name="length">フレームの長さ。</param>
+/// <param name="timestamp">タイムスタンプ。</param>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>0:満杯で失敗、非0:成功。</returns>
+int MpscFrames_Push(
+	const void* frame, int32_t length,
+	int64_t timestamp,
+	MpscFrames* ctxt)
+{
+	int result = 0;
+	if ((ctxt != nullptr) &&
+		(ctxt->Capacity >= MPSC_MIN_CAPACITY))
+	{
+		// スロットを確保する
+		int64_t position = LoadRelaxed(&ctxt->UpdateCount);
+		uint8_t* header = nullptr;
+		for (;;)
+		{
+			header = HeaderAt(position, ctxt);
+			uint32_t stamp = atomic_load_explicit(StampOf(header), memory_order_acquire);
+			int32_t diff = StampDiff(stamp, position);
+			if (diff == 0)
+			{
+				// 空きスロット。他の生産者と競合した場合は、最新の位置でやり直す
+				if (atomic_compare_exchange_weak_explicit(
+					(_Atomic int64_t*)&ctxt->UpdateCount, &position, position + 1,
+					memory_order_relaxed, memory_order_relaxed))
+				{
+					result = 1;
+					break;
+				}
+			}
+			else if (diff < 0)
+			{
+				// 前の周回のフレームがまだPopされていない
+				break;
+			}
+			else
+			{
+				// 他の生産者が先に確保した
+				position = LoadRelaxed(&ctxt->UpdateCount);
+			}
+		}
+
+		if (result != 0)
+		{
+			// 0～7バイト目にタイムスタンプを記録
+			int64_t* tsp = (int64_t*)&header[0];
+			*tsp = timestamp;
+			// 8～11バイト目に長さを記録
+			int32_t* lenp = (int32_t*)&header[sizeof(int64_t)];
+			*lenp = length;
+
+			// フレームを記録
+			uint8_t* fp = &header[RF_FRAME_HEADER_SIZE];
+			if ((frame != nullptr) &&
+				(0 < length) && (length <= ctxt->FrameSize))
+			{
+				memcpy(fp, frame, (size_t)length);
+			}
+			else
+			{
+				// フレームが記録されない場合は長さを0にする
+				*lenp = 0;
+			}
+
+			// 書き込んだフレームを消費者に公開
+			atomic_store_explicit(StampOf(header), (uint32_t)(position + 1), memory_order_release);
+		}
+	}
+	return result;
+}
+
+/// <summary>
+/// <para>最古のフレームをPopする。消費者スレッドからのみ呼び出すこと。</para>
+/// <para>フレームが無い場合、または最古のフレームが書き込み途中の場合は負を返す。</para>
+/// <para>格納先が足りない場合は、格納できる分だけ返す。</para>
+/// </summary>
+/// <param name="buffer">フレームの格納先バッファ。</param>
+/// <param name="bufferSize">フレーム格納先バッファのサイズ。</param>
+/// <param name="timestamp">タイムスタンプの格納先。</param>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>フレーム長。</returns>
+int32_t MpscFrames_Pop(
+	void* buffer, int32_t bufferSize,
+	int64_t* timestamp,
+	MpscFrames* ctxt)
+{
+	// 結果を初期化
+	int32_t length = -1;
+	if (timestamp != nullptr)
+	{
+		*timestamp = 0LL;
+	}
+
+	if ((ctxt != nullptr) &&
+		(ctxt->Capacity >= MPSC_MIN_CAPACITY))
+	{
+		// 読み出し位置は自分しか更新しない
+		int64_t tail = LoadRelaxed(&ctxt->Tail);
+		uint8_t* header = HeaderAt(tail, ctxt);
+
+		// 公開済みの場合だけ読み出す(未確保、書き込み途中は待つ)
+		uint32_t stamp = atomic_load_explicit(StampOf(header), memory_order_acquire);
+		if (StampDiff(stamp, tail + 1) == 0)
+		{
+			// 0～7バイト目にタイムスタンプが記録されている
+			if (timestamp != nullptr)
+			{
+				const int64_t* tsp = (const int64_t*)&header[0];
+				*timestamp = *tsp;
+			}
+			// 8～11バイト目に長さが記録されている
+			const int32_t* lenp = (const int32_t*)&header[sizeof(int64_t)];
+			length = *lenp;
+			if (length > bufferSize)
+			{
+				length = bufferSize;
+			}
+
+			// フレームを報告
+			if ((buffer != nullptr) &&
+				(length > 0))
+			{
+				memcpy(buffer, &header[RF_FRAME_HEADER_SIZE], (size_t)length);
+			}
+
+			// 読み終えたスロットを、次の周回の位置で空きにする
+			atomic_store_explicit(StampOf(header), (uint32_t)(tail + ctxt->Capacity), memory_order_release);
+			StoreRelease(tail + 1, &ctxt->Tail);
+		}
+	}
+
+	return length;
+}
+
+/* -------------------------------------------------------------------
+*	Unit Test
+*/
+#ifdef _UNIT_TEST
+#include "Assertions.h"
+
+void MpscFrames_UnitTest(void)
+{
+	Assertions* assertions = Assertions_Instance();
+	MpscFrames ring;
+	int64_t buffer[(2 + MPSC_NEEDED_BUFFER_WORDS(3, 8) + 1) / 2 + 1];
+	int32_t* words = (int32_t*)buffer;
+	int32_t wordCount = (int32_t)(sizeof buffer) / (int32_t)sizeof(int32_t);
+	const int32_t stride = RF_STRIDE_WORDS(8);
+	uint8_t frame[8];
+	uint8_t dataBuffer[8];
+	int32_t length;
+	int64_t timestamp;
+	int pushed;
+
+	// -----------------------------------------
+	// 1-1 Init(ctxt==nullptr)
+	MpscFrames_Init(3, 8, &words[2], nullptr);
+	// -----------------------------------------
+	// 1-2 Init
+	memset(buffer, -1, sizeof buffer);
+	MpscFrames_Init(3, 8, &words[2], &ring);
+	Assertions_Assert(MpscFrames_Count(&ring) == 0, assertions);
+	Assertions_Assert(MpscFrames_Capacity(&ring) == 3, assertions);
+	Assertions_Assert(MpscFrames_FrameSize(&ring) == 8, assertions);
+	// -----------------------------------------
+	// 1-3 Slots are free at the first round
+	Assertions_Assert(words[2 + 3] == 0, assertions);
+	Assertions_Assert(words[2 + stride + 3] == 1, assertions);
+	Assertions_Assert(words[2 + stride * 2 + 3] == 2, assertions);
+	// -----------------------------------------
+	// 1-4 UpdateCount and Tail are on different cache lines
+	Assertions_Assert(
+		(uintptr_t)&ring.Tail - (uintptr_t)&ring.UpdateCount >= MPSC_CACHE_LINE_SIZE,
+		assertions);
+
+	// -----------------------------------------
+	// 2-1 Count, Capacity, FrameSize(ctxt==nullptr)
+	Assertions_Assert(MpscFrames_Count(nullptr) == 0, assertions);
+	Assertions_Assert(MpscFrames_Capacity(nullptr) == 0, assertions);
+	Assertions_Assert(MpscFrames_FrameSize(nullptr) == 0, assertions);
+
+	// -----------------------------------------
+	// 3-1 Pop empty
+	length = MpscFrames_Pop(dataBuffer, sizeof dataBuffer, &timestamp, &ring);
+	Assertions_Assert(length < 0, assertions);
+	Assertions_Assert(timestamp == 0LL, assertions);
+	// -----------------------------------------
+	// 3-2 Push(ctxt==nullptr)
+	pushed = MpscFrames_Push(frame, 8, 32LL, nullptr);
+	Assertions_Assert(pushed == 0, assertions);
+	// -----------------------------------------
+	// 3-3 Push until full
+	for (int32_t i = 0; i < 3; i++)
+	{
+		memset(frame, 0, sizeof frame);
+		frame[0] = 3;
+		frame[7] = (uint8_t)i;
+		pushed = MpscFrames_Push(frame, 8, 330LL + i, &ring);
+		Assertions_Assert(pushed != 0, assertions);
+	}
+	Assertions_Assert(MpscFrames_Count(&ring) == 3, assertions);
+	// published stamp is position + 1
+	Assertions_Assert(words[2 + 3] == 1, assertions);
+	Assertions_Assert(words[2 + stride * 2 + 3] == 3, assertions);
+	// -----------------------------------------
+	// 3-4 Push full, oldest is not overwritten
+	pushed = MpscFrames_Push(frame, 8, 34LL, &ring);
+	Assertions_Assert(pushed == 0, assertions);
+	Assertions_Assert(MpscFrames_Count(&ring) == 3, assertions);
+	// -----------------------------------------
+	// 3-5 Pop oldest
+	length = MpscFrames_Pop(dataBuffer, sizeof dataBuffer, &timestamp, &ring);
+	Assertions_Assert(length == 8, assertions);
+	Assertions_Assert(timestamp == 330LL, assertions);
+	Assertions_Assert(dataBuffer[0] == 3, assertions);
+	Assertions_Assert(dataBuffer[7] == 0, assertions);
+	Assertions_Assert(MpscFrames_Count(&ring) == 2, assertions);
+	// freed stamp is the position of the next round
+	Assertions_Assert(words[2 + 3] == 3, assertions);
+	// -----------------------------------------
+	// 3-6 Push after Pop, wraps around
+	memset(frame, 0, sizeof frame);
+	frame[0] = 3;
+	frame[5] = 6;
+	pushed = MpscFrames_Push(frame, 6, 36LL, &ring);
+	Assertions_Assert(pushed != 0, assertions);
+	Assertions_Assert(MpscFrames_Count(&ring) == 3, assertions);
+	// -----------------------------------------
+	// 3-7 Pop but not enough buffer
+	length = MpscFrames_Pop(dataBuffer, 4, &timestamp, &ring);
+	Assertions_Assert(length == 4, assertions);
+	Assertions_Assert(timestamp == 331LL, assertions);
+	// -----------------------------------------
+	// 3-8 Pop without buffer and timestamp
+	length = MpscFrames_Pop(nullptr, 0, nullptr, &ring);
+	Assertions_Assert(length == 0, assertions);
+	// -----------------------------------------
+	// 3-9 Pop wrapped frame
+	length = MpscFrames_Pop(dataBuffer, sizeof dataBuffer, &timestamp, &ring);
+	Assertions_Assert(length == 6, assertions);
+	Assertions_Assert(timestamp == 36LL, assertions);
+	Assertions_Assert(dataBuffer[0] == 3, assertions);
+	Assertions_Assert(dataBuffer[5] == 6, assertions);
+	Assertions_Assert(MpscFrames_Count(&ring) == 0, assertions);
+
+	// -----------------------------------------
+	// 4-1 Push oversized frame is recorded as zero length
+	pushed = MpscFrames_Push(frame, 9, 41LL, &ring);
+	Assertions_Assert(pushed != 0, assertions);
+	length = MpscFrames_Pop(dataBuffer, sizeof dataBuffer, &timestamp, &ring);
+	Assertions_Assert(length == 0, assertions);
+	Assertions_Assert(timestamp == 41LL, assertions);
+	// -----------------------------------------
+	// 4-2 Push null frame is recorded as zero length
+	pushed = MpscFrames_Push(nullptr, 8, 42LL, &ring);
+	Assertions_Assert(pushed != 0, assertions);
+	length = MpscFrames_Pop(dataBuffer, sizeof dataBuffer, &timestamp, &ring);
+	Assertions_Assert(length == 0, assertions);
+	Assertions_Assert(timestamp == 42LL, assertions);
+
+	// -----------------------------------------
+	// 5-1 A claimed but unpublished slot blocks Pop
+	// (position 6 is claimed by a producer that has not finished writing)
+	Assertions_Assert(ring.UpdateCount == 6, assertions);
+	ring.UpdateCount = 7;
+	Assertions_Assert(MpscFrames_Count(&ring) == 1, assertions);
+	length = MpscFrames_Pop(dataBuffer, sizeof dataBuffer, &timestamp, &ring);
+	Assertions_Assert(length < 0, assertions);
+	// -----------------------------------------
+	// 5-2 Another producer publishes the next slot, Pop still keeps order
+	pushed = MpscFrames_Push(frame, 6, 52LL, &ring);
+	Assertions_Assert(pushed != 0, assertions);
+	Assertions_Assert(MpscFrames_Count(&ring) == 2, assertions);
+	length = MpscFrames_Pop(dataBuffer, sizeof dataBuffer, &timestamp, &ring);
+	Assertions_Assert(length < 0, assertions);
+	// -----------------------------------------
+	// 5-3 The first producer finishes writing
+	{
+		int64_t* tsp = (int64_t*)&words[2];
+		*tsp = 51LL;
+		words[2 + 2] = 1;
+		words[2 + 3] = 7;
+	}
+	length = MpscFrames_Pop(dataBuffer, sizeof dataBuffer, &timestamp, &ring);
+	Assertions_Assert(length == 1, assertions);
+	Assertions_Assert(timestamp == 51LL, assertions);
+	length = MpscFrames_Pop(dataBuffer, sizeof dataBuffer, &timestamp, &ring);
+	Assertions_Assert(length == 6, assertions);
+	Assertions_Assert(timestamp == 52LL, assertions);
+	Assertions_Assert(MpscFrames_Count(&ring) == 0, assertions);
+
+	// -----------------------------------------
+	// 6-1 Capacity 1 cannot tell published slots from free ones, so it stores nothing
+	memset(buffer, -1, sizeof buffer);
+	MpscFrames_Init(1, 8, &words[2], &ring);
+	Assertions_Assert(MpscFrames_Capacity(&ring) == 0, assertions);
+	Assertions_Assert(MpscFrames_Push(frame, 1, 61LL, &ring) == 0, assertions);
+	Assertions_Assert(MpscFrames_Pop(dataBuffer, sizeof dataBuffer, &timestamp, &ring) < 0, assertions);
+	Assertions_Assert(MpscFrames_Count(&ring) == 0, assertions);
+	Assertions_Assert(words[2] == -1, assertions);
+	// -----------------------------------------
+	// 6-2 Capacity 2 keeps every frame across many laps
+	MpscFrames_Init(2, 8, &words[2], &ring);
+	Assertions_Assert(MpscFrames_Capacity(&ring) == 2, assertions);
+	for (int32_t lap = 0; lap < 5; lap++)
+	{
+		frame[0] = (uint8_t)(lap * 2);
+		Assertions_Assert(MpscFrames_Push(frame, 1, 620LL + (lap * 2), &ring) != 0, assertions);
+		frame[0] = (uint8_t)((lap * 2) + 1);
+		Assertions_Assert(MpscFrames_Push(frame, 1, 621LL + (lap * 2), &ring) != 0, assertions);
+		Assertions_Assert(MpscFrames_Push(frame, 1, 0LL, &ring) == 0, assertions);
+		Assertions_Assert(MpscFrames_Count(&ring) == 2, assertions);
+		for (int32_t i = 0; i < 2; i++)
+		{
+			length = MpscFrames_Pop(dataBuffer, sizeof dataBuffer, &timestamp, &ring);
+			Assertions_Assert(length == 1, assertions);
+			Assertions_Assert(dataBuffer[0] == (uint8_t)((lap * 2) + i), assertions);
+			Assertions_Assert(timestamp == 620LL + (lap * 2) + i, assertions);
+		}
+		Assertions_Assert(MpscFrames_Pop(dataBuffer, sizeof dataBuffer, &timestamp, &ring) < 0, assertions);
+	}
+	Assertions_Assert(MpscFrames_Count(&ring) == 0, assertions);
+
+	// Do not destroy memories
+	Assertions_Assert(words[0] == -1, assertions);
+	Assertions_Assert(words[1] == -1, assertions);
+	Assertions_Assert(
+		words[wordCount - 1] == -1, assertions);
+}
+#endif
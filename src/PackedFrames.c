@@ -0,0 +1,591 @@
+﻿/** ------------------------------------------------------------------
+*
+*	@file	PackedFrames.c
+*	@brief	Variable-length packed frame ring buffer
+*	@author	H.Someya
+*	@date	2026/10/17
+*
+MIT License
+
+Copyright (c) 2021 Hirobumi Someya
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*
+*/
+#include "PackedFrames.h"
+#include <string.h>
+#include "nullptr.h"
+#include "Indices.h"
+
+/* -------------------------------------------------------------------
+*	Privates
+*/
+/// <summary>
+/// <para>フレーム位置リスト上のインデックスを取得する。</para>
+/// </summary>
+static int32_t SlotOf(int32_t index, const PackedFrames* ctxt)
+{
+	return RoundIndex(ctxt->First + index, ctxt->Capacity, 0);
+}
+
+/// <summary>
+/// <para>最古のフレームを削除する。</para>
+/// </summary>
+static void RemoveOldest(PackedFrames* ctxt)
+{
+	if (ctxt->Count > 0)
+	{
+		ctxt->First = NextIndex(ctxt->First, ctxt->Capacity, 0);
+		ctxt->Count = Dec2Min(ctxt->Count, 0);
+	}
+}
+
+/// <summary>
+/// <para>データ領域から、指定ワード数の連続した領域を確保する。</para>
+/// <para>空きが足りない場合は、足りるまで最古を削除する。</para>
+/// <para>確保した領域のワード位置を返す。</para>
+/// </summary>
+static int32_t Allocate(int32_t words, PackedFrames* ctxt)
+{
+	int32_t position = 0;
+	for (;;)
+	{
+		if (ctxt->Count <= 0)
+		{
+			// 空の場合は先頭から使う
+			ctxt->Head = 0;
+			position = 0;
+			break;
+		}
+
+		int32_t tail = ctxt->Offsets[ctxt->First];
+		if (ctxt->Head > tail)
+		{
+			// 最古～書き込み位置が折り返していない場合、空きは末尾側と先頭側
+			if (ctxt->Head + words <= ctxt->DataWords)
+			{
+				position = ctxt->Head;
+				break;
+			}
+			if (words <= tail)
+			{
+				// 末尾側の余りは使わず、先頭に折り返す
+				position = 0;
+				break;
+			}
+		}
+		else
+		{
+			// 折り返している場合、空きは書き込み位置～最古の間だけ
+			if (ctxt->Head + words <= tail)
+			{
+				position = ctxt->Head;
+				break;
+			}
+		}
+
+		// 空きが足りないので、最古を削除して再確認
+		RemoveOldest(ctxt);
+	}
+	return position;
+}
+
+/* -------------------------------------------------------------------
+*	Services
+*/
+
+/// <summary>
+/// <para>可変長フレームリングバッファを初期化する。</para>
+/// </summary>
+/// <param name="capacity">最大蓄積可能フレーム数。</param>
+/// <param name="frameSize">最大フレームサイズ。</param>
+/// <param name="dataWords">データ領域のワード数。
+/// PF_RECORD_WORDS(frameSize)以上を指定すること。</param>
+/// <param name="buffer">動作に必要なバッファ。
+/// PF_NEEDED_BUFFER_WORDS分の要素数を持つ領域を確保して指定すること。</param>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>なし。</returns>
+void PackedFrames_Init(
+	int32_t capacity, int32_t frameSize,
+	int32_t dataWords,
+	int32_t* buffer,
+	PackedFrames* ctxt)
+{
+	if (ctxt != nullptr)
+	{
+		memset(ctxt, 0, sizeof(PackedFrames));
+		ctxt->Capacity = capacity;
+		ctxt->FrameSize = frameSize;
+		ctxt->DataWords = dataWords;
+		if (buffer != nullptr)
+		{
+			ctxt->Offsets = &buffer[0];
+			ctxt->Data = &buffer[capacity];
+		}
+	}
+}
+
+/// <summary>
+/// <para>クリアする。</para>
+/// </summary>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>なし。</returns>
+void PackedFrames_Clear(
+	PackedFrames* ctxt)
+{
+	if (ctxt != nullptr)
+	{
+		ctxt->First = 0;
+		ctxt->Count = 0;
+		ctxt->UpdateCount = 0;
+		ctxt->Head = 0;
+	}
+}
+
+/// <summary>
+/// <para>現在のフレーム蓄積数を取得する。</para>
+/// </summary>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>現在のフレーム蓄積数。</returns>
+int32_t PackedFrames_Count(
+	const PackedFrames* ctxt)
+{
+	int32_t result = 0;
+	if (ctxt != nullptr)
+	{
+		result = ctxt->Count;
+	}
+	return result;
+}
+
+/// <summary>
+/// <para>現在のフレーム更新数を取得する。</para>
+/// </summary>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>現在のフレーム更新数。</returns>
+int64_t PackedFrames_UpdateCount(
+	const PackedFrames* ctxt)
+{
+	int64_t result = 0;
+	if (ctxt != nullptr)
+	{
+		result = ctxt->UpdateCount;
+	}
+	return result;
+}
+
+/// <summary>
+/// <para>最大蓄積可能フレーム数を取得する。</para>
+/// </summary>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>最大蓄積可能フレーム数。</returns>
+int32_t PackedFrames_Capacity(
+	const PackedFrames* ctxt)
+{
+	int32_t result = 0;
+	if (ctxt != nullptr)
+	{
+		result = ctxt->Capacity;
+	}
+	return result;
+}
+
+/// <summary>
+/// <para>最大フレームサイズを取得する。</para>
+/// </summary>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>最大フレームサイズ。</returns>
+int32_t PackedFrames_FrameSize(
+	const PackedFrames* ctxt)
+{
+	int32_t result = 0;
+	if (ctxt != nullptr)
+	{
+		result = ctxt->FrameSize;
+	}
+	return result;
+}
+
+/// <summary>
+/// <para>フレームをPushする。</para>
+/// <para>最大蓄積可能フレーム数まで蓄積されているか、データ領域が足りない場合、
+/// 必要な分だけ最古から上書きする。</para>
+/// </summary>
+/// <param name="frame">フレーム。</param>
+/// <param name="length">フレームの長さ。</param>
+/// <param name="timestamp">タイムスタンプ。</param>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>なし。</returns>
+void PackedFrames_Push(
+	const void* frame, int32_t length,
+	int64_t timestamp,
+	PackedFrames* ctxt)
+{
+	if ((ctxt != nullptr) &&
+		(ctxt->Capacity > 0) &&
+		(ctxt->DataWords >= PF_RECORD_WORDS(0)))
+	{
+		// フレームが記録されない場合は長さを0にする
+		if ((frame == nullptr) ||
+			(length <= 0) || (ctxt->FrameSize < length) ||
+			(ctxt->DataWords < PF_RECORD_WORDS(length)))
+		{
+			length = 0;
+		}
+
+		// フレーム数が最大の場合は、最古を削除
+		if (ctxt->Count >= ctxt->Capacity)
+		{
+			RemoveOldest(ctxt);
+		}
+
+		// 保存先を確保
+		int32_t words = PF_RECORD_WORDS(length);
+		int32_t position = Allocate(words, ctxt);
+
+		// ヘッダを記録
+		uint8_t* header = (uint8_t*)&ctxt->Data[position];
+		memset(header, 0, RF_FRAME_HEADER_SIZE);
+		// 0～7バイト目にタイムスタンプを記録
+		int64_t* tsp = (int64_t*)&header[0];
+		*tsp = timestamp;
+		// 8～11バイト目に長さを記録
+		int32_t* lenp = (int32_t*)&header[sizeof(int64_t)];
+		*lenp = length;
+
+		// フレームを記録
+		if (length > 0)
+		{
+			memcpy(&header[RF_FRAME_HEADER_SIZE], frame, (size_t)length);
+		}
+
+		// 位置、カウンタを更新
+		ctxt->Offsets[SlotOf(ctxt->Count, ctxt)] = position;
+		ctxt->Count += 1;
+		ctxt->Head = position + words;
+		ctxt->UpdateCount += 1;
+	}
+}
+
+/// <summary>
+/// <para>最古を0としたインデックスで、フレームを参照する。</para>
+/// <para>コピーせず、内部メモリを直接参照する。</para>
+/// </summary>
+/// <param name="index">最古を0としたインデックス。</param>
+/// <param name="length">フレーム長の格納先。</param>
+/// <param name="timestamp">タイムスタンプの格納先。</param>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>フレーム。nullでなし。</returns>
+const void* PackedFrames_ReferWithOld(
+	int32_t index,
+	int32_t* length,
+	int64_t* timestamp,
+	const PackedFrames* ctxt)
+{
+	// 結果を初期化
+	const void* frame = nullptr;
+	if (length != nullptr)
+	{
+		*length = 0;
+	}
+	if (timestamp != nullptr)
+	{
+		*timestamp = 0LL;
+	}
+
+	if ((ctxt != nullptr) &&
+		((0 <= index) && (index < ctxt->Count)))
+	{
+		// ヘッダを取得
+		int32_t position = ctxt->Offsets[SlotOf(index, ctxt)];
+		const uint8_t* header = (const uint8_t*)&ctxt->Data[position];
+		// 0～7バイト目にタイムスタンプが記録されている
+		if (timestamp != nullptr)
+		{
+			const int64_t* tsp = (const int64_t*)&header[0];
+			*timestamp = *tsp;
+		}
+		// 8～11バイト目に長さが記録されている
+		if (length != nullptr)
+		{
+			const int32_t* lenp = (const int32_t*)&header[sizeof(int64_t)];
+			*length = *lenp;
+		}
+
+		// フレームを取得
+		frame = &header[RF_FRAME_HEADER_SIZE];
+	}
+
+	return frame;
+}
+
+/// <summary>
+/// <para>最新を0としたインデックスで、フレームを参照する。</para>
+/// <para>コピーせず、内部メモリを直接参照する。</para>
+/// </summary>
+/// <param name="index">最新を0としたインデックス。</param>
+/// <param name="length">フレーム長の格納先。</param>
+/// <param name="timestamp">タイムスタンプの格納先。</param>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>フレーム。nullでなし。</returns>
+const void* PackedFrames_ReferWithNew(
+	int32_t index,
+	int32_t* length,
+	int64_t* timestamp,
+	const PackedFrames* ctxt)
+{
+	return PackedFrames_ReferWithOld(
+		PackedFrames_Count(ctxt) - 1 - index,
+		length, timestamp,
+		ctxt);
+}
+
+/// <summary>
+/// <para>最古のフレームをPopする。</para>
+/// <para>フレームが無い場合は負を返す。</para>
+/// <para>格納先が足りない場合は、格納できる分だけ返す。</para>
+/// </summary>
+/// <param name="buffer">フレームの格納先バッファ。</param>
+/// <param name="bufferSize">フレーム格納先バッファのサイズ。</param>
+/// <param name="timestamp">タイムスタンプの格納先。</param>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>フレーム長。</returns>
+int32_t PackedFrames_Pop(
+	void* buffer, int32_t bufferSize,
+	int64_t* timestamp,
+	PackedFrames* ctxt)
+{
+	// 結果を初期化
+	int32_t length = -1;
+	if (timestamp != nullptr)
+	{
+		*timestamp = 0LL;
+	}
+
+	// 最古のフレームを取得
+	int32_t len;
+	int64_t ts;
+	const void* frame = PackedFrames_ReferWithOld(0, &len, &ts, ctxt);
+	if (frame != nullptr)
+	{
+		// データ長を補正して報告
+		length = len;
+		if (length > bufferSize)
+		{
+			length = bufferSize;
+		}
+
+		// フレームを報告
+		if ((buffer != nullptr) &&
+			(length > 0))
+		{
+			memcpy(buffer, frame, (size_t)length);
+		}
+
+		// タイムスタンプを報告
+		if (timestamp != nullptr)
+		{
+			*timestamp = ts;
+		}
+
+		// 最古を削除
+		RemoveOldest(ctxt);
+	}
+
+	return length;
+}
+
+/* -------------------------------------------------------------------
+*	Unit Test
+*/
+#ifdef _UNIT_TEST
+#include "Assertions.h"
+
+void PackedFrames_UnitTest(void)
+{
+	Assertions* assertions = Assertions_Instance();
+	PackedFrames ring;
+	int32_t buffer[1 + PF_NEEDED_BUFFER_WORDS(8, 16) + 1];
+	uint8_t frame[16];
+	uint8_t dataBuffer[16];
+	const uint8_t* referer;
+	int32_t length;
+	int64_t timestamp;
+
+	// -----------------------------------------
+	// 1-1 Init(ctxt==nullptr)
+	PackedFrames_Init(8, 16, 16, &buffer[1], nullptr);
+	// -----------------------------------------
+	// 1-2 Init
+	memset(buffer, -1, sizeof buffer);
+	PackedFrames_Init(8, 16, 16, &buffer[1], &ring);
+	Assertions_Assert(PackedFrames_Count(&ring) == 0, assertions);
+	Assertions_Assert(PackedFrames_UpdateCount(&ring) == 0, assertions);
+	Assertions_Assert(PackedFrames_Capacity(&ring) == 8, assertions);
+	Assertions_Assert(PackedFrames_FrameSize(&ring) == 16, assertions);
+
+	// -----------------------------------------
+	// 2-1 Getters(ctxt==nullptr)
+	Assertions_Assert(PackedFrames_Count(nullptr) == 0, assertions);
+	Assertions_Assert(PackedFrames_UpdateCount(nullptr) == 0, assertions);
+	Assertions_Assert(PackedFrames_Capacity(nullptr) == 0, assertions);
+	Assertions_Assert(PackedFrames_FrameSize(nullptr) == 0, assertions);
+
+	// -----------------------------------------
+	// 3-1 Empty
+	referer = PackedFrames_ReferWithOld(0, &length, &timestamp, &ring);
+	Assertions_Assert(referer == nullptr, assertions);
+	Assertions_Assert(length == 0, assertions);
+	Assertions_Assert(timestamp == 0LL, assertions);
+	length = PackedFrames_Pop(dataBuffer, sizeof dataBuffer, &timestamp, &ring);
+	Assertions_Assert(length < 0, assertions);
+
+	// -----------------------------------------
+	// 3-2 Push 2 frames, 6 words each
+	memset(frame, 0, sizeof frame);
+	frame[0] = 3;
+	frame[7] = 21;
+	PackedFrames_Push(frame, 8, 321LL, &ring);
+	frame[7] = 22;
+	PackedFrames_Push(frame, 8, 322LL, &ring);
+	Assertions_Assert(PackedFrames_Count(&ring) == 2, assertions);
+	Assertions_Assert(PackedFrames_UpdateCount(&ring) == 2, assertions);
+	referer = PackedFrames_ReferWithOld(0, &length, &timestamp, &ring);
+	Assertions_Assert(referer[7] == 21, assertions);
+	Assertions_Assert(length == 8, assertions);
+	Assertions_Assert(timestamp == 321LL, assertions);
+	referer = PackedFrames_ReferWithNew(0, &length, &timestamp, &ring);
+	Assertions_Assert(referer[7] == 22, assertions);
+	Assertions_Assert(length == 8, assertions);
+	Assertions_Assert(timestamp == 322LL, assertions);
+
+	// -----------------------------------------
+	// 3-3 Push short frame, wraps around and removes the oldest
+	memset(frame, 0, sizeof frame);
+	frame[0] = 33;
+	PackedFrames_Push(frame, 1, 33LL, &ring);
+	Assertions_Assert(PackedFrames_Count(&ring) == 2, assertions);
+	referer = PackedFrames_ReferWithOld(0, &length, &timestamp, &ring);
+	Assertions_Assert(referer[7] == 22, assertions);
+	Assertions_Assert(timestamp == 322LL, assertions);
+	referer = PackedFrames_ReferWithOld(1, &length, &timestamp, &ring);
+	Assertions_Assert(referer[0] == 33, assertions);
+	Assertions_Assert(length == 1, assertions);
+	Assertions_Assert(timestamp == 33LL, assertions);
+	Assertions_Assert(referer == (const uint8_t*)&ring.Data[0] + RF_FRAME_HEADER_SIZE, assertions);
+
+	// -----------------------------------------
+	// 3-4 Push long frame, removes as many as needed
+	memset(frame, 0, sizeof frame);
+	frame[0] = 34;
+	frame[15] = 34;
+	PackedFrames_Push(frame, 16, 34LL, &ring);
+	Assertions_Assert(PackedFrames_Count(&ring) == 2, assertions);
+	referer = PackedFrames_ReferWithOld(0, &length, &timestamp, &ring);
+	Assertions_Assert(referer[0] == 33, assertions);
+	Assertions_Assert(timestamp == 33LL, assertions);
+	referer = PackedFrames_ReferWithNew(0, &length, &timestamp, &ring);
+	Assertions_Assert(referer[0] == 34, assertions);
+	Assertions_Assert(referer[15] == 34, assertions);
+	Assertions_Assert(length == 16, assertions);
+	Assertions_Assert(timestamp == 34LL, assertions);
+
+	// -----------------------------------------
+	// 3-5 Push oversized and null frame, recorded as zero length
+	PackedFrames_Push(frame, 17, 351LL, &ring);
+	referer = PackedFrames_ReferWithNew(0, &length, &timestamp, &ring);
+	Assertions_Assert(referer != nullptr, assertions);
+	Assertions_Assert(length == 0, assertions);
+	Assertions_Assert(timestamp == 351LL, assertions);
+	PackedFrames_Push(nullptr, 4, 352LL, &ring);
+	referer = PackedFrames_ReferWithNew(0, &length, &timestamp, &ring);
+	Assertions_Assert(referer != nullptr, assertions);
+	Assertions_Assert(length == 0, assertions);
+	Assertions_Assert(timestamp == 352LL, assertions);
+	Assertions_Assert(PackedFrames_Count(&ring) == 2, assertions);
+
+	// -----------------------------------------
+	// 4-1 Pop
+	length = PackedFrames_Pop(dataBuffer, sizeof dataBuffer, &timestamp, &ring);
+	Assertions_Assert(length == 0, assertions);
+	Assertions_Assert(timestamp == 351LL, assertions);
+	Assertions_Assert(PackedFrames_Count(&ring) == 1, assertions);
+	// -----------------------------------------
+	// 4-2 Pop until empty, then restart from the top
+	length = PackedFrames_Pop(nullptr, 0, nullptr, &ring);
+	Assertions_Assert(length == 0, assertions);
+	Assertions_Assert(PackedFrames_Count(&ring) == 0, assertions);
+	PackedFrames_Push(frame, 16, 42LL, &ring);
+	referer = PackedFrames_ReferWithOld(0, &length, &timestamp, &ring);
+	Assertions_Assert(referer == (const uint8_t*)&ring.Data[0] + RF_FRAME_HEADER_SIZE, assertions);
+	// -----------------------------------------
+	// 4-3 Pop long frame
+	length = PackedFrames_Pop(dataBuffer, sizeof dataBuffer, &timestamp, &ring);
+	Assertions_Assert(length == 16, assertions);
+	Assertions_Assert(timestamp == 42LL, assertions);
+	Assertions_Assert(dataBuffer[0] == 34, assertions);
+	Assertions_Assert(dataBuffer[15] == 34, assertions);
+	// -----------------------------------------
+	// 4-4 Pop but not enough buffer
+	PackedFrames_Push(frame, 16, 44LL, &ring);
+	length = PackedFrames_Pop(dataBuffer, 4, &timestamp, &ring);
+	Assertions_Assert(length == 4, assertions);
+	Assertions_Assert(timestamp == 44LL, assertions);
+
+	// -----------------------------------------
+	// 5-1 Many short frames are limited by Capacity
+	PackedFrames_Clear(&ring);
+	for (int32_t i = 0; i < 10; i++)
+	{
+		PackedFrames_Push(nullptr, 0, 510LL + i, &ring);
+	}
+	Assertions_Assert(PackedFrames_Count(&ring) == 4, assertions);
+	Assertions_Assert(PackedFrames_UpdateCount(&ring) == 10, assertions);
+	PackedFrames_ReferWithOld(0, &length, &timestamp, &ring);
+	Assertions_Assert(timestamp == 516LL, assertions);
+	PackedFrames_ReferWithNew(0, &length, &timestamp, &ring);
+	Assertions_Assert(timestamp == 519LL, assertions);
+	// -----------------------------------------
+	// 5-2 Limited by Capacity when data area is enough
+	memset(buffer, -1, sizeof buffer);
+	PackedFrames_Init(3, 16, 21, &buffer[1], &ring);
+	for (int32_t i = 0; i < 5; i++)
+	{
+		PackedFrames_Push(nullptr, 0, 520LL + i, &ring);
+	}
+	Assertions_Assert(PackedFrames_Count(&ring) == 3, assertions);
+	PackedFrames_ReferWithOld(0, &length, &timestamp, &ring);
+	Assertions_Assert(timestamp == 522LL, assertions);
+
+	// Do not destroy memories
+	Assertions_Assert(buffer[0] == -1, assertions);
+	Assertions_Assert(
+		buffer[((sizeof buffer) / sizeof buffer[0]) - 1] == -1, assertions);
+
+	// -----------------------------------------
+	// 6-1 Clear(ctxt==nullptr)
+	PackedFrames_Clear(nullptr);
+	Assertions_Assert(PackedFrames_Count(&ring) == 3, assertions);
+	// -----------------------------------------
+	// 6-2 Clear
+	PackedFrames_Clear(&ring);
+	Assertions_Assert(PackedFrames_Count(&ring) == 0, assertions);
+	Assertions_Assert(PackedFrames_UpdateCount(&ring) == 0, assertions);
+}
+#endif
@@ -31,11 +31,281 @@ SOFTWARE.
 #include "RingedFrames.h"
 #include <string.h>
 #include "nullptr.h"
+#ifdef RF_SEQLOCK
+#include <stdatomic.h>
+#endif
 #include "Indices.h"
+#include "Encoders.h"
+#include "Decoders.h"
+#if defined(__unix__) || defined(__APPLE__)
+#include <errno.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
 
 /* -------------------------------------------------------------------
 *	Privates
 */
+/// <summary>
+/// <para>インデックスを、バッファ上のフレーム位置に巡回させる。</para>
+/// <para>最大蓄積可能フレーム数が2のべき乗の場合は、分岐せずマスクで求める。</para>
+/// <para>それ以外の場合は、-最大蓄積可能フレーム数～最大蓄積可能フレーム数*2の範囲で指定すること。</para>
+/// </summary>
+static int32_t SlotOf(int32_t index, const RingedFrames* ctxt)
+{
+	int32_t fi;
+	if (ctxt->IndexMask >= 0)
+	{
+		fi = index & ctxt->IndexMask;
+	}
+	else
+	{
+		fi = RoundIndex(index, ctxt->Capacity, 0);
+	}
+	return fi;
+}
+
+/// <summary>
+/// <para>バッファ位置に対応するタイムスタンプの格納先を取得する。</para>
+/// </summary>
+static int64_t* TimestampSlot(int32_t fi, const RingedFrames* ctxt)
+{
+	return (int64_t*)&ctxt->Timestamps[(size_t)ctxt->TimestampStride * (size_t)fi];
+}
+
+/// <summary>
+/// <para>バッファ位置に対応するフレーム長の格納先を取得する。</para>
+/// </summary>
+static int32_t* LengthSlot(int32_t fi, const RingedFrames* ctxt)
+{
+	return (int32_t*)&ctxt->Lengths[(size_t)ctxt->LengthStride * (size_t)fi];
+}
+
+/// <summary>
+/// <para>バッファ位置に対応するフレームの格納先を取得する。</para>
+/// </summary>
+static uint8_t* PayloadSlot(int32_t fi, const RingedFrames* ctxt)
+{
+	return &ctxt->Payloads[(size_t)ctxt->PayloadStride * (size_t)fi];
+}
+
+/// <summary>
+/// <para>バッファ位置に対応する世代番号の格納先を取得する。</para>
+/// </summary>
+static uint32_t* StampSlot(int32_t fi, const RingedFrames* ctxt)
+{
+	return (uint32_t*)&ctxt->Stamps[(size_t)ctxt->StampStride * (size_t)fi];
+}
+
+/// <summary>
+/// <para>更新番号のフレームを書き込み中にする(世代番号を奇数にする)。</para>
+/// <para>RF_SEQLOCKの場合は、以降のフレームの書き込みより先に、別スレッドから観測されるようにする。</para>
+/// </summary>
+static void BeginWrite(int32_t fi, int64_t updateNumber, const RingedFrames* ctxt)
+{
+	uint32_t stamp = (uint32_t)(updateNumber * 2 + 1);
+#ifdef RF_SEQLOCK
+	atomic_store_explicit((_Atomic uint32_t*)StampSlot(fi, ctxt), stamp, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+#else
+	*StampSlot(fi, ctxt) = stamp;
+#endif
+}
+
+/// <summary>
+/// <para>更新番号のフレームの書き込みを完了する(世代番号を偶数にする)。</para>
+/// </summary>
+static void EndWrite(int32_t fi, int64_t updateNumber, const RingedFrames* ctxt)
+{
+	uint32_t stamp = (uint32_t)(updateNumber * 2 + 2);
+#ifdef RF_SEQLOCK
+	atomic_store_explicit((_Atomic uint32_t*)StampSlot(fi, ctxt), stamp, memory_order_release);
+#else
+	*StampSlot(fi, ctxt) = stamp;
+#endif
+}
+
+/// <summary>
+/// <para>読み出し前の世代番号を取得する。</para>
+/// </summary>
+static uint32_t LoadStamp(int32_t fi, const RingedFrames* ctxt)
+{
+#ifdef RF_SEQLOCK
+	return atomic_load_explicit((_Atomic uint32_t*)StampSlot(fi, ctxt), memory_order_acquire);
+#else
+	return *StampSlot(fi, ctxt);
+#endif
+}
+
+/// <summary>
+/// <para>読み出し後の世代番号を取得する。</para>
+/// <para>RF_SEQLOCKの場合は、読み出した内容より後に観測する。</para>
+/// </summary>
+static uint32_t ReloadStamp(int32_t fi, const RingedFrames* ctxt)
+{
+#ifdef RF_SEQLOCK
+	atomic_thread_fence(memory_order_acquire);
+	return atomic_load_explicit((_Atomic uint32_t*)StampSlot(fi, ctxt), memory_order_relaxed);
+#else
+	return *StampSlot(fi, ctxt);
+#endif
+}
+
+/// <summary>
+/// <para>フレーム更新数を更新する。</para>
+/// <para>RF_SEQLOCKの場合は、別スレッドから観測できるように更新する。</para>
+/// </summary>
+static void StoreUpdateCount(int64_t updateCount, RingedFrames* ctxt)
+{
+#ifdef RF_SEQLOCK
+	atomic_store_explicit(
+		(_Atomic int64_t*)&ctxt->UpdateCount, updateCount, memory_order_release);
+#else
+	ctxt->UpdateCount = updateCount;
+#endif
+}
+
+/// <summary>
+/// <para>バッファ位置のフレームの、タイムスタンプと長さを記録する。</para>
+/// </summary>
+static void WriteHeader(int32_t fi, int32_t length, int64_t timestamp, RingedFrames* ctxt)
+{
+	*TimestampSlot(fi, ctxt) = timestamp;
+	*LengthSlot(fi, ctxt) = length;
+}
+
+/// <summary>
+/// <para>最古を0としたインデックスのフレームの、タイムスタンプを取得する。</para>
+/// </summary>
+static int64_t TimestampAt(int32_t index, const RingedFrames* ctxt)
+{
+	int32_t fi = SlotOf(ctxt->Index - ctxt->Count + index, ctxt);
+	return *TimestampSlot(fi, ctxt);
+}
+
+/// <summary>
+/// <para>タイムスタンプが指定時刻以上(orEqualが0の場合は超過)となる、
+/// 最古のフレームのインデックスを二分探索する。</para>
+/// </summary>
+static int32_t SearchByTime(int64_t timestamp, int orEqual, const RingedFrames* ctxt)
+{
+	int32_t low = 0;
+	int32_t high = ctxt->Count;
+	while (low < high)
+	{
+		int32_t mid = low + ((high - low) / 2);
+		int64_t ts = TimestampAt(mid, ctxt);
+		if ((ts < timestamp) ||
+			((orEqual == 0) && (ts == timestamp)))
+		{
+			low = mid + 1;
+		}
+		else
+		{
+			high = mid;
+		}
+	}
+	return low;
+}
+
+/// <summary>
+/// <para>Pushされるタイムスタンプが、直前より増加しているかを確認する。</para>
+/// </summary>
+static void CheckTimeOrder(int64_t timestamp, int64_t updateNumber, RingedFrames* ctxt)
+{
+	if ((updateNumber > 0) &&
+		(timestamp <= ctxt->LastTimestamp))
+	{
+		ctxt->DisorderedAt = updateNumber;
+	}
+	ctxt->LastTimestamp = timestamp;
+}
+
+/// <summary>
+/// <para>書き込み位置にフレームを書き込めるかを、満杯時の方針で判断する。</para>
+/// <para>満杯で最古を上書きする場合は、上書きされる最古のフレームを通知する。</para>
+/// <para>最大蓄積可能フレーム数が0の場合は、方針に関わらず書き込めない。</para>
+/// </summary>
+static int MakeRoom(RingedFrames* ctxt)
+{
+	int result = 1;
+	if (ctxt->Capacity <= 0)
+	{
+		// 書き込み位置が無い
+		result = 0;
+	}
+	else if (ctxt->Count >= ctxt->Capacity)
+	{
+		if (ctxt->Policy == RF_POLICY_REJECT_NEWEST)
+		{
+			result = 0;
+		}
+		else if (ctxt->Evicted != nullptr)
+		{
+			// 満杯の場合、書き込み位置は最古のフレームと重なる
+			int32_t fi = ctxt->Index;
+			ctxt->Evicted(
+				PayloadSlot(fi, ctxt), *LengthSlot(fi, ctxt),
+				*TimestampSlot(fi, ctxt),
+				ctxt->EvictedContext);
+		}
+	}
+	return result;
+}
+
+/// <summary>
+/// <para>書き込み位置のフレームのヘッダを記録し、フレームを確定する。</para>
+/// </summary>
+static void Publish(int32_t length, int64_t timestamp, RingedFrames* ctxt)
+{
+	// タイムスタンプの順序を確認
+	if (ctxt->TimeOrderCheck != 0)
+	{
+		CheckTimeOrder(timestamp, ctxt->UpdateCount, ctxt);
+	}
+
+	// ヘッダを記録
+	WriteHeader(ctxt->Index, length, timestamp, ctxt);
+	EndWrite(ctxt->Index, ctxt->UpdateCount, ctxt);
+
+	// インデックス、カウンタを更新
+	if (ctxt->IndexMask >= 0)
+	{
+		// 2のべき乗の場合は、分岐せずに更新する
+		ctxt->Index = (ctxt->Index + 1) & ctxt->IndexMask;
+		ctxt->Count += (ctxt->Count < ctxt->Capacity) ? 1 : 0;
+	}
+	else
+	{
+		ctxt->Index = NextIndex(ctxt->Index, ctxt->Capacity, 0);
+		ctxt->Count = Inc2Max(ctxt->Count, ctxt->Capacity);
+	}
+	StoreUpdateCount(ctxt->UpdateCount + 1, ctxt);
+
+	// 書き込み位置が進んだので、予約は無効になる
+	ctxt->Reserved = 0;
+}
+
+/// <summary>
+/// <para>読み出しカーソルの読み出し位置を、蓄積されているフレームの範囲に合わせる。</para>
+/// </summary>
+static void CatchUp(const RingedFrames* ring, RingedFramesCursor* ctxt)
+{
+	int64_t oldest = ring->UpdateCount - ring->Count;
+	if ((ctxt->ClearCount != ring->ClearCount) ||
+		(ctxt->Position > ring->UpdateCount))
+	{
+		// クリアされた場合は、最新から読み直す(更新番号が振り直されるので、位置では判定できない)
+		ctxt->ClearCount = ring->ClearCount;
+		ctxt->Position = ring->UpdateCount;
+	}
+	else if (ctxt->Position < oldest)
+	{
+		// 上書きされた分は読み逃したものとする
+		ctxt->Lost += oldest - ctxt->Position;
+		ctxt->Position = oldest;
+	}
+}
 
 /* -------------------------------------------------------------------
 *	Services
@@ -43,6 +313,7 @@ SOFTWARE.
 
 /// <summary>
 /// <para>フレームリングバッファを初期化する。</para>
+/// <para>最大蓄積可能フレーム数が2のべき乗の場合、フレーム位置を分岐なしのマスクで求める。</para>
 /// </summary>
 /// <param name="capacity">最大蓄積可能フレーム数。</param>
 /// <param name="frameSize">最大フレームサイズ。</param>
@@ -61,6 +332,63 @@ void RingedFrames_Init(
 		ctxt->Capacity = capacity;
 		ctxt->FrameSize = frameSize;
 		ctxt->Buffer = buffer;
+		ctxt->DisorderedAt = -1;
+		// フレームごとに、ヘッダとフレームを続けて配置する
+		if (buffer != nullptr)
+		{
+			int32_t stride = RF_STRIDE_WORDS(frameSize) * (int32_t)sizeof(int32_t);
+			// 0～7バイト目にタイムスタンプ、8～11バイト目に長さを記録する
+			ctxt->Timestamps = (uint8_t*)&buffer[0];
+			ctxt->TimestampStride = stride;
+			ctxt->Lengths = &ctxt->Timestamps[sizeof(int64_t)];
+			ctxt->LengthStride = stride;
+			ctxt->Payloads = &ctxt->Timestamps[RF_FRAME_HEADER_SIZE];
+			ctxt->PayloadStride = stride;
+			// 12～15バイト目に世代番号を記録する
+			ctxt->Stamps = &ctxt->Timestamps[sizeof(int64_t) + sizeof(int32_t)];
+			ctxt->StampStride = stride;
+		}
+		// 2のべき乗の場合は、インデックスをマスクで巡回させる
+		ctxt->IndexMask = -1;
+		if ((capacity > 0) &&
+			((capacity & (capacity - 1)) == 0))
+		{
+			ctxt->IndexMask = capacity - 1;
+		}
+	}
+}
+
+/// <summary>
+/// <para>ヘッダ分離レイアウトで、フレームリングバッファを初期化する。</para>
+/// <para>タイムスタンプと長さをそれぞれ連続した配列に、フレームを別の領域に配置する。</para>
+/// <para>時刻による検索や長さの集計が、フレームを読み飛ばさずに済む。</para>
+/// <para>それ以外の操作は、RingedFrames_Initで初期化した場合と同じ。</para>
+/// </summary>
+/// <param name="capacity">最大蓄積可能フレーム数。</param>
+/// <param name="frameSize">最大フレームサイズ。</param>
+/// <param name="buffer">動作に必要なバッファ。
+/// RF_SOA_NEEDED_BUFFER_WORDS分の要素数を持つ、8バイト境界の領域を確保して指定すること。</param>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>なし。</returns>
+void RingedFrames_InitSoa(
+	int32_t capacity, int32_t frameSize,
+	int32_t* buffer,
+	RingedFrames* ctxt)
+{
+	RingedFrames_Init(capacity, frameSize, buffer, ctxt);
+	if ((ctxt != nullptr) &&
+		(buffer != nullptr) &&
+		(capacity > 0))
+	{
+		// タイムスタンプ配列、長さ配列、世代番号配列、フレーム領域の順に配置する
+		ctxt->Timestamps = (uint8_t*)&buffer[0];
+		ctxt->TimestampStride = (int32_t)sizeof(int64_t);
+		ctxt->Lengths = (uint8_t*)&buffer[2 * capacity];
+		ctxt->LengthStride = (int32_t)sizeof(int32_t);
+		ctxt->Stamps = (uint8_t*)&buffer[3 * capacity];
+		ctxt->StampStride = (int32_t)sizeof(uint32_t);
+		ctxt->Payloads = (uint8_t*)&buffer[4 * capacity];
+		ctxt->PayloadStride = RF_SOA_PAYLOAD_WORDS(frameSize) * (int32_t)sizeof(int32_t);
 	}
 }
 
@@ -77,6 +405,11 @@ void RingedFrames_Clear(
 		ctxt->Index = 0;
 		ctxt->Count = 0;
 		ctxt->UpdateCount = 0;
+		ctxt->Reserved = 0;
+		ctxt->LastTimestamp = 0LL;
+		ctxt->DisorderedAt = -1;
+		ctxt->DrainedBytes = 0;
+		ctxt->ClearCount += 1;
 	}
 }
 
@@ -109,7 +442,61 @@ int64_t RingedFrames_UpdateCount(
 	int64_t result = 0;
 	if (ctxt != nullptr)
 	{
+#ifdef RF_SEQLOCK
+		result = atomic_load_explicit(
+			(const _Atomic int64_t*)&ctxt->UpdateCount, memory_order_acquire);
+#else
 		result = ctxt->UpdateCount;
+#endif
+	}
+	return result;
+}
+
+/// <summary>
+/// <para>蓄積されているフレームの長さの合計を取得する。</para>
+/// </summary>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>フレームの長さの合計。</returns>
+int64_t RingedFrames_TotalLength(
+	const RingedFrames* ctxt)
+{
+	int64_t result = 0;
+	if ((ctxt != nullptr) &&
+		(ctxt->Count > 0))
+	{
+		// 折り返し位置で分けた、最大2つの連続区間を集計する
+		int32_t fi = SlotOf(ctxt->Index - ctxt->Count, ctxt);
+		int32_t remain = ctxt->Count;
+		while (remain > 0)
+		{
+			int32_t run = ctxt->Capacity - fi;
+			if (run > remain)
+			{
+				run = remain;
+			}
+
+			if (ctxt->LengthStride == (int32_t)sizeof(int32_t))
+			{
+				// 長さが連続している場合は、配列として集計する(ベクトル化できる)
+				const int32_t* lengths = LengthSlot(fi, ctxt);
+				for (int32_t ri = 0; ri < run; ri++)
+				{
+					result += lengths[ri];
+				}
+			}
+			else
+			{
+				const uint8_t* lenp = (const uint8_t*)LengthSlot(fi, ctxt);
+				for (int32_t ri = 0; ri < run; ri++)
+				{
+					result += *(const int32_t*)lenp;
+					lenp += ctxt->LengthStride;
+				}
+			}
+
+			remain -= run;
+			fi = 0;
+		}
 	}
 	return result;
 }
@@ -148,37 +535,26 @@ int32_t RingedFrames_FrameSize(
 
 /// <summary>
 /// <para>フレームをPushする。</para>
-/// <para>最大蓄積可能フレーム数まで蓄積されていると、最古を上書きする。</para>
+/// <para>最大蓄積可能フレーム数まで蓄積されていると、満杯時の方針に従い、
+/// 最古を上書きするか、記録せずに失敗する。</para>
 /// </summary>
 /// <param name="frame">フレーム。</param>
 /// <param name="length">フレームの長さ。</param>
 /// <param name="timestamp">タイムスタンプ。</param>
 /// <param name="ctxt">コンテキスト。</param>
-/// <returns>なし。</returns>
-void RingedFrames_Push(
+/// <returns>0:記録しなかった、非0:記録した。</returns>
+int RingedFrames_Push(
 	const void* frame, int32_t length,
 	int64_t timestamp,
 	RingedFrames* ctxt)
 {
-	if (ctxt != nullptr)
+	int result = 0;
+	if ((ctxt != nullptr) &&
+		(MakeRoom(ctxt) != 0))
 	{
-		// 保存先バッファ位置を計算
-		int32_t fi = ctxt->Index;
-		int32_t bi = RF_STRIDE_WORDS(ctxt->FrameSize) * fi;
-		int32_t* bp = &ctxt->Buffer[bi];
-
-		// ヘッダを記録
-		uint8_t* header = (uint8_t*)bp;
-		memset(header, 0, RF_FRAME_HEADER_SIZE);
-		// 0～7バイト目にタイムスタンプを記録
-		int64_t* tsp = (int64_t*)&header[0];
-		*tsp = timestamp;
-		// 8～11バイト目に長さを記録
-		int32_t* lenp = (int32_t*)&header[sizeof(int64_t)];
-		*lenp = length;
-
 		// フレームを記録
-		uint8_t* fp = &header[RF_FRAME_HEADER_SIZE];
+		BeginWrite(ctxt->Index, ctxt->UpdateCount, ctxt);
+		uint8_t* fp = PayloadSlot(ctxt->Index, ctxt);
 		if ((frame != nullptr) &&
 			(0 < length) && (length <= ctxt->FrameSize))
 		{
@@ -187,14 +563,197 @@ void RingedFrames_Push(
 		else
 		{
 			// フレームが記録されない場合は長さを0にする
-			*lenp = 0;
+			length = 0;
+		}
+
+		// ヘッダを記録して確定
+		Publish(length, timestamp, ctxt);
+
+		result = 1;
+	}
+	return result;
+}
+
+/// <summary>
+/// <para>複数のフレームをまとめてPushする。</para>
+/// <para>最大蓄積可能フレーム数まで蓄積されていると、最古を上書きする。</para>
+/// <para>最大蓄積可能フレーム数を超える分は、古い方から上書きされるため記録しない。</para>
+/// <para>最古を上書きしない方針の場合は、満杯になるまで先頭から記録する。</para>
+/// <para>上書きされるフレームを通知する場合は、1フレームずつPushした場合と同じ順序で通知する。</para>
+/// </summary>
+/// <param name="frames">フレームの配列。要素がnullのフレームは長さ0で記録する。</param>
+/// <param name="lengths">フレームの長さの配列。</param>
+/// <param name="timestamps">タイムスタンプの配列。</param>
+/// <param name="count">フレーム数。</param>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>Pushしたフレーム数。</returns>
+int32_t RingedFrames_PushBatch(
+	const void* const* frames, const int32_t* lengths,
+	const int64_t* timestamps,
+	int32_t count,
+	RingedFrames* ctxt)
+{
+	int32_t pushed = 0;
+	if ((ctxt != nullptr) &&
+		(frames != nullptr) && (lengths != nullptr) && (timestamps != nullptr) &&
+		((ctxt->Policy != RF_POLICY_OVERWRITE_OLDEST) || (ctxt->Evicted != nullptr)))
+	{
+		// 拒否や通知はフレームごとに判断する必要があるので、1フレームずつ記録する
+		while ((pushed < count) &&
+			(RingedFrames_Push(frames[pushed], lengths[pushed], timestamps[pushed], ctxt) != 0))
+		{
+			pushed += 1;
+		}
+	}
+	else if ((ctxt != nullptr) &&
+		(ctxt->Capacity > 0) &&
+		(frames != nullptr) && (lengths != nullptr) && (timestamps != nullptr) &&
+		(count > 0))
+	{
+		// 最大蓄積可能フレーム数を超える分は上書きされるので、新しい方だけ記録する
+		int32_t first = 0;
+		if (count > ctxt->Capacity)
+		{
+			first = count - ctxt->Capacity;
+		}
+		int32_t fi = SlotOf(ctxt->Index + (first % ctxt->Capacity), ctxt);
+
+		// タイムスタンプの順序を確認(上書きされる分も前後関係に含める)
+		if (ctxt->TimeOrderCheck != 0)
+		{
+			for (int32_t ci = 0; ci < count; ci++)
+			{
+				CheckTimeOrder(timestamps[ci], ctxt->UpdateCount + ci, ctxt);
+			}
+		}
+
+		// 折り返し位置で分けた、最大2つの連続区間に記録する
+		int32_t si = first;
+		while (si < count)
+		{
+			int32_t run = ctxt->Capacity - fi;
+			if (run > count - si)
+			{
+				run = count - si;
+			}
+
+			uint8_t* tsp = (uint8_t*)TimestampSlot(fi, ctxt);
+			uint8_t* lenp = (uint8_t*)LengthSlot(fi, ctxt);
+			uint8_t* fp = PayloadSlot(fi, ctxt);
+			for (int32_t ri = 0; ri < run; ri++)
+			{
+				// フレームを記録
+				int64_t updateNumber = ctxt->UpdateCount + si;
+				BeginWrite(fi + ri, updateNumber, ctxt);
+				int32_t length = lengths[si];
+				if ((frames[si] != nullptr) &&
+					(0 < length) && (length <= ctxt->FrameSize))
+				{
+					memcpy(fp, frames[si], (size_t)length);
+				}
+				else
+				{
+					// フレームが記録されない場合は長さを0にする
+					length = 0;
+				}
+
+				// ヘッダを記録
+				*(int64_t*)tsp = timestamps[si];
+				*(int32_t*)lenp = length;
+				EndWrite(fi + ri, updateNumber, ctxt);
+
+				tsp += ctxt->TimestampStride;
+				lenp += ctxt->LengthStride;
+				fp += ctxt->PayloadStride;
+				si += 1;
+			}
+
+			fi = SlotOf(fi + run, ctxt);
 		}
 
 		// インデックス、カウンタを更新
-		ctxt->Index = NextIndex(ctxt->Index, ctxt->Capacity, 0);
-		ctxt->Count = Inc2Max(ctxt->Count, ctxt->Capacity);
-		ctxt->UpdateCount += 1;
+		ctxt->Index = fi;
+		if (count >= ctxt->Capacity - ctxt->Count)
+		{
+			ctxt->Count = ctxt->Capacity;
+		}
+		else
+		{
+			ctxt->Count += count;
+		}
+		StoreUpdateCount(ctxt->UpdateCount + count, ctxt);
+
+		// 書き込み位置が進んだので、予約は無効になる
+		ctxt->Reserved = 0;
+
+		pushed = count;
+	}
+	return pushed;
+}
+
+/// <summary>
+/// <para>次にPushされるフレームの格納先を予約する。</para>
+/// <para>コピーせず、内部メモリに直接フレームを書き込むために使用する。</para>
+/// <para>書き込んだらRingedFrames_Commitで確定すること。</para>
+/// <para>最大蓄積可能フレーム数まで蓄積されていると、予約した時点で最古を削除する。</para>
+/// <para>最古を上書きしない方針の場合は、満杯であれば予約できない。</para>
+/// </summary>
+/// <param name="maxLength">書き込む最大のフレーム長(1～最大フレームサイズ)。</param>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>フレームの格納先。nullで予約できなかった。</returns>
+void* RingedFrames_Reserve(
+	int32_t maxLength,
+	RingedFrames* ctxt)
+{
+	void* payload = nullptr;
+	if ((ctxt != nullptr) &&
+		(ctxt->Capacity > 0) &&
+		(0 < maxLength) && (maxLength <= ctxt->FrameSize) &&
+		(MakeRoom(ctxt) != 0))
+	{
+		// 満杯の場合、書き込み位置は最古のフレームと重なるので先に削除する
+		if (ctxt->Count >= ctxt->Capacity)
+		{
+			ctxt->Count = Dec2Min(ctxt->Count, 0);
+		}
+
+		// 書き込み位置のフレーム格納先を渡す
+		BeginWrite(ctxt->Index, ctxt->UpdateCount, ctxt);
+		ctxt->Reserved = maxLength;
+		payload = PayloadSlot(ctxt->Index, ctxt);
+	}
+	return payload;
+}
+
+/// <summary>
+/// <para>予約した格納先に書き込んだフレームを確定する。</para>
+/// <para>長さが予約した最大フレーム長を超える場合は、長さ0で確定する。</para>
+/// </summary>
+/// <param name="length">書き込んだフレームの長さ。</param>
+/// <param name="timestamp">タイムスタンプ。</param>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>0:予約されていない、非0:確定した。</returns>
+int RingedFrames_Commit(
+	int32_t length,
+	int64_t timestamp,
+	RingedFrames* ctxt)
+{
+	int result = 0;
+	if ((ctxt != nullptr) &&
+		(ctxt->Reserved > 0))
+	{
+		// 予約範囲外の長さは記録しない
+		if ((length < 0) || (ctxt->Reserved < length))
+		{
+			length = 0;
+		}
+
+		// ヘッダを記録して確定
+		Publish(length, timestamp, ctxt);
+
+		result = 1;
 	}
+	return result;
 }
 
 /// <summary>
@@ -228,29 +787,20 @@ const void* RingedFrames_ReferWithOld(
 		((0 <= index) && (index < ctxt->Count)))
 	{
 		// 保存先バッファ位置を計算
-		int32_t fi = RoundIndex(
-			ctxt->Index - ctxt->Count + index, ctxt->Capacity, 0);
-		int32_t bi = RF_STRIDE_WORDS(ctxt->FrameSize) * fi;
-		int32_t* bp = &ctxt->Buffer[bi];
+		int32_t fi = SlotOf(ctxt->Index - ctxt->Count + index, ctxt);
 
 		// ヘッダを取得
-		uint8_t* header = (uint8_t*)bp;
-		// 0～7バイト目にタイムスタンプが記録されている
 		if (timestamp != nullptr)
 		{
-			int64_t* tsp = (int64_t*)&header[0];
-			*timestamp = *tsp;
+			*timestamp = *TimestampSlot(fi, ctxt);
 		}
-		// 8～11バイト目に長さが記録されている
 		if (length != nullptr)
 		{
-			int32_t* lenp = (int32_t*)&header[sizeof(int64_t)];
-			*length = *lenp;
+			*length = *LengthSlot(fi, ctxt);
 		}
 
 		// フレームを取得
-		uint8_t* fp = &header[RF_FRAME_HEADER_SIZE];
-		frame = fp;
+		frame = PayloadSlot(fi, ctxt);
 	}
 
 	return frame;
@@ -278,45 +828,161 @@ const void* RingedFrames_ReferWithNew(
 }
 
 /// <summary>
-/// <para>最古のフレームをPopする。</para>
-/// <para>フレームが無い場合は負を返す。</para>
+/// <para>更新番号を指定して、フレームを別スレッドから読み出す。</para>
+/// <para>フレームごとの世代番号で、書き込み中や上書きされたフレームを検出する(seqlock)。</para>
+/// <para>RF_SEQLOCKを定義してビルドした場合は、Pushする1つのスレッドを止めずに、
+/// 複数のスレッドから同時に読み出せる。定義しない場合は、Pushと同じスレッドから読み出すこと。</para>
+/// <para>更新番号は、RingedFrames_UpdateCountで取得した値未満を指定すること。</para>
 /// <para>格納先が足りない場合は、格納できる分だけ返す。</para>
 /// </summary>
+/// <param name="updateNumber">フレームの更新番号(最初にPushされたフレームを0とする)。</param>
 /// <param name="buffer">フレームの格納先バッファ。</param>
 /// <param name="bufferSize">フレーム格納先バッファのサイズ。</param>
 /// <param name="timestamp">タイムスタンプの格納先。</param>
 /// <param name="ctxt">コンテキスト。</param>
-/// <returns>フレーム長。</returns>
-int32_t RingedFrames_Pop(
+/// <returns>フレーム長。RF_READ_PENDING、RF_READ_OVERWRITTENで読み出せなかった。</returns>
+int32_t RingedFrames_ReadStable(
+	int64_t updateNumber,
 	void* buffer, int32_t bufferSize,
 	int64_t* timestamp,
-	RingedFrames* ctxt)
+	const RingedFrames* ctxt)
 {
 	// 結果を初期化
-	int32_t length = -1;
+	int32_t length = RF_READ_PENDING;
 	if (timestamp != nullptr)
 	{
 		*timestamp = 0LL;
 	}
 
-	// 最古のフレームを取得
-	int32_t len;
-	int64_t ts;
-	const void* frame = RingedFrames_ReferWithOld(0, &len, &ts, ctxt);
-	if (frame != nullptr)
+	if ((ctxt != nullptr) &&
+		(ctxt->Capacity > 0) &&
+		(updateNumber >= 0))
 	{
-		// データ長を補正して報告
-		length = len;
-		if (length > bufferSize)
+		int64_t updateCount = RingedFrames_UpdateCount(ctxt);
+		if (updateNumber < updateCount - ctxt->Capacity)
 		{
-			length = bufferSize;
+			// 既に上書きされている
+			length = RF_READ_OVERWRITTEN;
 		}
-
-		// フレームを報告
-		if ((buffer != nullptr) &&
-			(length > 0))
+		else if (updateNumber < updateCount)
 		{
-			memcpy(buffer, frame, (size_t)length);
+			// 更新番号と位置は、クリアされるまで1対1に対応する
+			int32_t fi = (int32_t)(updateNumber % ctxt->Capacity);
+			uint32_t expected = (uint32_t)(updateNumber * 2 + 2);
+			uint32_t before = LoadStamp(fi, ctxt);
+			length = RF_READ_OVERWRITTEN;
+			if (before == expected)
+			{
+				// 書き換えられている可能性があるので、壊れた長さでも範囲外を読まない
+				int64_t ts = *TimestampSlot(fi, ctxt);
+				int32_t copied = *LengthSlot(fi, ctxt);
+				if ((copied < 0) || (ctxt->FrameSize < copied))
+				{
+					copied = 0;
+				}
+				if (copied > bufferSize)
+				{
+					copied = bufferSize;
+				}
+				if ((buffer != nullptr) &&
+					(copied > 0))
+				{
+					memcpy(buffer, PayloadSlot(fi, ctxt), (size_t)copied);
+				}
+
+				// 読み出し中に書き換えられていなければ、読み出した内容は正しい
+				uint32_t after = ReloadStamp(fi, ctxt);
+				if (after == before)
+				{
+					length = copied;
+					if (timestamp != nullptr)
+					{
+						*timestamp = ts;
+					}
+				}
+			}
+		}
+	}
+
+	return length;
+}
+
+/// <summary>
+/// <para>最古のフレームを参照する。</para>
+/// <para>コピーせず、内部メモリを直接参照する。</para>
+/// <para>参照し終えたらRingedFrames_Releaseで削除すること。</para>
+/// </summary>
+/// <param name="length">フレーム長の格納先。</param>
+/// <param name="timestamp">タイムスタンプの格納先。</param>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>フレーム。nullでなし。</returns>
+const void* RingedFrames_PeekOldest(
+	int32_t* length,
+	int64_t* timestamp,
+	const RingedFrames* ctxt)
+{
+	return RingedFrames_ReferWithOld(0, length, timestamp, ctxt);
+}
+
+/// <summary>
+/// <para>最古のフレームを削除する。</para>
+/// </summary>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>0:フレームなし、非0:削除した。</returns>
+int RingedFrames_Release(
+	RingedFrames* ctxt)
+{
+	int result = 0;
+	if ((ctxt != nullptr) &&
+		(ctxt->Count > 0))
+	{
+		ctxt->Count = Dec2Min(ctxt->Count, 0);
+
+		result = 1;
+	}
+	return result;
+}
+
+/// <summary>
+/// <para>最古のフレームをPopする。</para>
+/// <para>フレームが無い場合は負を返す。</para>
+/// <para>格納先が足りない場合は、格納できる分だけ返す。</para>
+/// </summary>
+/// <param name="buffer">フレームの格納先バッファ。</param>
+/// <param name="bufferSize">フレーム格納先バッファのサイズ。</param>
+/// <param name="timestamp">タイムスタンプの格納先。</param>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>フレーム長。</returns>
+int32_t RingedFrames_Pop(
+	void* buffer, int32_t bufferSize,
+	int64_t* timestamp,
+	RingedFrames* ctxt)
+{
+	// 結果を初期化
+	int32_t length = -1;
+	if (timestamp != nullptr)
+	{
+		*timestamp = 0LL;
+	}
+
+	// 最古のフレームを取得
+	int32_t len;
+	int64_t ts;
+	const void* frame = RingedFrames_PeekOldest(&len, &ts, ctxt);
+	if (frame != nullptr)
+	{
+		// データ長を補正して報告
+		length = len;
+		if (length > bufferSize)
+		{
+			length = bufferSize;
+		}
+
+		// フレームを報告
+		if ((buffer != nullptr) &&
+			(length > 0))
+		{
+			memcpy(buffer, frame, (size_t)length);
 		}
 
 		// タイムスタンプを報告
@@ -326,446 +992,2192 @@ int32_t RingedFrames_Pop(
 		}
 
 		// 最古を削除
-		ctxt->Count = Dec2Min(ctxt->Count, 0);
+		RingedFrames_Release(ctxt);
 	}
 
 	return length;
 }
 
-/* -------------------------------------------------------------------
-*	Unit Test
-*/
-#ifdef _UNIT_TEST
-#include <assert.h>
-void RingedFrames_UnitTest(void)
+/// <summary>
+/// <para>古い方から複数のフレームをまとめてPopする。</para>
+/// <para>フレームは格納先バッファに隙間なく連結して格納する。</para>
+/// <para>格納先バッファに収まらないフレームに達したら、そこで停止する。</para>
+/// </summary>
+/// <param name="buffer">フレームの格納先バッファ。</param>
+/// <param name="bufferSize">フレーム格納先バッファのサイズ。</param>
+/// <param name="lengths">フレーム長の格納先配列。</param>
+/// <param name="timestamps">タイムスタンプの格納先配列。</param>
+/// <param name="maxFrames">Popする最大フレーム数(各格納先配列の要素数)。</param>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>Popしたフレーム数。</returns>
+int32_t RingedFrames_PopBatch(
+	void* buffer, int32_t bufferSize,
+	int32_t* lengths,
+	int64_t* timestamps,
+	int32_t maxFrames,
+	RingedFrames* ctxt)
 {
-	// -----------------------------------------
-	// 1-1
-	RingedFrames ring;
-	int32_t buffer[1 + RF_NEEDED_BUFFER_WORDS(3, 8) + 1];
-	uint8_t frame[8];
-	int32_t length;
-	int64_t timestamp;
-	const uint8_t* referer;
-	uint8_t dataBuffer[8];
-	int64_t updateCount;
+	int32_t popped = 0;
+	if ((ctxt != nullptr) &&
+		(ctxt->Count > 0) &&
+		(maxFrames > 0))
+	{
+		// 格納先がない場合は、長さ0のフレームだけPopできる
+		uint8_t* dp = (uint8_t*)buffer;
+		if (dp == nullptr)
+		{
+			bufferSize = 0;
+		}
 
-	// -----------------------------------------
-	// 1-1 Init
-	memset(buffer, -1, sizeof buffer);
-	RingedFrames_Init(3, 8, &buffer[1], &ring);
-	assert(RingedFrames_Count(&ring) == 0);
-	assert(RingedFrames_UpdateCount(&ring) == 0);
-	// -----------------------------------------
-	// 1-2 Init(self==nullptr)
-	RingedFrames_Init(5, 8, &buffer[1], nullptr);
-	assert(RingedFrames_Capacity(&ring) == 3);
+		int32_t count = ctxt->Count;
+		if (count > maxFrames)
+		{
+			count = maxFrames;
+		}
+		int32_t fi = SlotOf(ctxt->Index - ctxt->Count, ctxt);
 
-	// -----------------------------------------
-	// 2-1 Capacity(self==nullptr)
-	assert(RingedFrames_Capacity(nullptr) == 0);
-	// -----------------------------------------
-	// 2-2 Capacity
-	assert(RingedFrames_Capacity(&ring) == 3);
+		// 折り返し位置で分けた、最大2つの連続区間から取り出す
+		int32_t used = 0;
+		int stopped = 0;
+		while ((popped < count) && (stopped == 0))
+		{
+			int32_t run = ctxt->Capacity - fi;
+			if (run > count - popped)
+			{
+				run = count - popped;
+			}
+
+			const uint8_t* tsp = (const uint8_t*)TimestampSlot(fi, ctxt);
+			const uint8_t* lenp = (const uint8_t*)LengthSlot(fi, ctxt);
+			const uint8_t* fp = PayloadSlot(fi, ctxt);
+			for (int32_t ri = 0; ri < run; ri++)
+			{
+				int32_t length = *(const int32_t*)lenp;
+				if (length > bufferSize - used)
+				{
+					// 収まらないので停止
+					stopped = 1;
+					break;
+				}
+
+				// フレームを報告
+				if (length > 0)
+				{
+					memcpy(&dp[used], fp, (size_t)length);
+				}
+				used += length;
+				if (lengths != nullptr)
+				{
+					lengths[popped] = length;
+				}
+				if (timestamps != nullptr)
+				{
+					timestamps[popped] = *(const int64_t*)tsp;
+				}
+
+				tsp += ctxt->TimestampStride;
+				lenp += ctxt->LengthStride;
+				fp += ctxt->PayloadStride;
+				popped += 1;
+			}
+
+			fi = 0;
+		}
 
-	// -----------------------------------------
-	// 3-1 FrameSize(self==nullptr)
-	assert(RingedFrames_FrameSize(nullptr) == 0);
-	// -----------------------------------------
-	// 3-2 FrameSize
-	assert(RingedFrames_FrameSize(&ring) == 8);
+		// 取り出した分を削除
+		ctxt->Count -= popped;
+	}
+	return popped;
+}
+
+/// <summary>
+/// <para>満杯時の方針を設定する。</para>
+/// </summary>
+/// <param name="policy">RF_POLICY_OVERWRITE_OLDEST、RF_POLICY_REJECT_NEWEST。</param>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>なし。</returns>
+void RingedFrames_SetPolicy(
+	int32_t policy,
+	RingedFrames* ctxt)
+{
+	if ((ctxt != nullptr) &&
+		((policy == RF_POLICY_OVERWRITE_OLDEST) || (policy == RF_POLICY_REJECT_NEWEST)))
+	{
+		ctxt->Policy = policy;
+	}
+}
+
+/// <summary>
+/// <para>最古を上書きする前に、上書きされるフレームを通知する通知先を設定する。</para>
+/// <para>二次記憶への退避などに使用する。通知先で同じフレームリングバッファを操作しないこと。</para>
+/// <para>Pop、Release、Clearで削除されるフレームは通知しない。</para>
+/// </summary>
+/// <param name="callback">通知先。nullで通知しない。</param>
+/// <param name="callbackContext">通知先に渡すコンテキスト。</param>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>なし。</returns>
+void RingedFrames_SetEvictedCallback(
+	RingedFramesEvicted callback,
+	void* callbackContext,
+	RingedFrames* ctxt)
+{
+	if (ctxt != nullptr)
+	{
+		ctxt->Evicted = callback;
+		ctxt->EvictedContext = callbackContext;
+	}
+}
+
+/// <summary>
+/// <para>タイムスタンプの単調増加を確認するかを設定する。</para>
+/// <para>確認する場合、Pushのたびに直前のタイムスタンプと比較し、
+/// 増加していないフレームが蓄積されている間は時刻による検索を失敗させる。</para>
+/// </summary>
+/// <param name="enabled">0:確認しない、非0:確認する。</param>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>なし。</returns>
+void RingedFrames_SetTimeOrderCheck(
+	int enabled,
+	RingedFrames* ctxt)
+{
+	if (ctxt != nullptr)
+	{
+		ctxt->TimeOrderCheck = (enabled != 0) ? 1 : 0;
+		// 確認を始める前のフレームは、順序が不明なので確認済みとみなす
+		ctxt->DisorderedAt = -1;
+		ctxt->LastTimestamp = (ctxt->Count > 0) ?
+			TimestampAt(ctxt->Count - 1, ctxt) : 0LL;
+	}
+}
+
+/// <summary>
+/// <para>蓄積されているフレームのタイムスタンプが、単調増加しているかを取得する。</para>
+/// <para>確認しない設定の場合は、常に単調増加とみなす。</para>
+/// </summary>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>0:単調増加していない、非0:単調増加している。</returns>
+int RingedFrames_IsTimeOrdered(
+	const RingedFrames* ctxt)
+{
+	int result = 0;
+	if (ctxt != nullptr)
+	{
+		result = 1;
+		// 増加しなかったフレームと、その直前のフレームが両方残っている場合は順序が崩れている
+		if ((ctxt->TimeOrderCheck != 0) &&
+			(ctxt->DisorderedAt - 1 >= ctxt->UpdateCount - ctxt->Count))
+		{
+			result = 0;
+		}
+	}
+	return result;
+}
+
+/// <summary>
+/// <para>タイムスタンプが指定時刻以上となる、最古のフレームのインデックスを取得する。</para>
+/// <para>タイムスタンプが単調増加していることを前提に、二分探索する。</para>
+/// </summary>
+/// <param name="timestamp">時刻。</param>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>最古を0としたインデックス。該当なしでフレーム蓄積数、失敗で負。</returns>
+int32_t RingedFrames_LowerBoundByTime(
+	int64_t timestamp,
+	const RingedFrames* ctxt)
+{
+	int32_t result = -1;
+	if (RingedFrames_IsTimeOrdered(ctxt) != 0)
+	{
+		result = SearchByTime(timestamp, 1, ctxt);
+	}
+	return result;
+}
+
+/// <summary>
+/// <para>タイムスタンプが指定時刻の範囲内にあるフレームの、インデックス範囲を取得する。</para>
+/// <para>タイムスタンプが単調増加していることを前提に、二分探索する。</para>
+/// </summary>
+/// <param name="from">範囲の開始時刻(この時刻を含む)。</param>
+/// <param name="to">範囲の終了時刻(この時刻を含む)。</param>
+/// <param name="begin">範囲の先頭インデックス(最古を0とする)の格納先。</param>
+/// <param name="end">範囲の末尾の次のインデックスの格納先。</param>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>範囲内のフレーム数。失敗で負。</returns>
+int32_t RingedFrames_RangeByTime(
+	int64_t from, int64_t to,
+	int32_t* begin, int32_t* end,
+	const RingedFrames* ctxt)
+{
+	// 結果を初期化
+	int32_t result = -1;
+	int32_t first = 0;
+	int32_t last = 0;
+
+	if (RingedFrames_IsTimeOrdered(ctxt) != 0)
+	{
+		// 開始時刻以上の最古と、終了時刻超過の最古を探す
+		first = SearchByTime(from, 1, ctxt);
+		last = first;
+		if (from <= to)
+		{
+			last = SearchByTime(to, 0, ctxt);
+		}
+		result = last - first;
+	}
+
+	if (begin != nullptr)
+	{
+		*begin = first;
+	}
+	if (end != nullptr)
+	{
+		*end = last;
+	}
+	return result;
+}
+
+/// <summary>
+/// <para>読み出しカーソルを初期化する。</para>
+/// <para>初期化した後にPushされたフレームから読み出す。</para>
+/// </summary>
+/// <param name="ring">フレームリングバッファ。</param>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>なし。</returns>
+void RingedFramesCursor_Init(
+	const RingedFrames* ring,
+	RingedFramesCursor* ctxt)
+{
+	if (ctxt != nullptr)
+	{
+		memset(ctxt, 0, sizeof(RingedFramesCursor));
+		ctxt->Position = RingedFrames_UpdateCount(ring);
+		if (ring != nullptr)
+		{
+			ctxt->ClearCount = ring->ClearCount;
+		}
+	}
+}
+
+/// <summary>
+/// <para>未読のフレーム数と、最初の未読フレームのインデックスを取得する。</para>
+/// <para>未読フレームはRingedFrames_ReferWithOldで、コピーせず参照できる。</para>
+/// <para>読み終えたらRingedFramesCursor_Advanceで読み出し位置を進めること。</para>
+/// </summary>
+/// <param name="index">最初の未読フレームの、最古を0としたインデックスの格納先。</param>
+/// <param name="ring">フレームリングバッファ。</param>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>未読のフレーム数。</returns>
+int32_t RingedFramesCursor_Unread(
+	int32_t* index,
+	const RingedFrames* ring,
+	RingedFramesCursor* ctxt)
+{
+	int32_t count = 0;
+	int32_t first = 0;
+	if ((ring != nullptr) &&
+		(ctxt != nullptr))
+	{
+		CatchUp(ring, ctxt);
+		count = (int32_t)(ring->UpdateCount - ctxt->Position);
+		first = ring->Count - count;
+	}
+
+	if (index != nullptr)
+	{
+		*index = first;
+	}
+	return count;
+}
+
+/// <summary>
+/// <para>読み出し位置を進める。</para>
+/// </summary>
+/// <param name="count">進めるフレーム数。未読のフレーム数までに制限される。</param>
+/// <param name="ring">フレームリングバッファ。</param>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>進めたフレーム数。</returns>
+int32_t RingedFramesCursor_Advance(
+	int32_t count,
+	const RingedFrames* ring,
+	RingedFramesCursor* ctxt)
+{
+	int32_t advanced = 0;
+	if (count > 0)
+	{
+		int32_t unread = RingedFramesCursor_Unread(nullptr, ring, ctxt);
+		advanced = (count < unread) ? count : unread;
+		if (advanced > 0)
+		{
+			ctxt->Position += advanced;
+		}
+	}
+	return advanced;
+}
+
+/// <summary>
+/// <para>次の未読フレームを参照し、読み出し位置を1つ進める。</para>
+/// <para>コピーせず、内部メモリを直接参照する。</para>
+/// </summary>
+/// <param name="length">フレーム長の格納先。</param>
+/// <param name="timestamp">タイムスタンプの格納先。</param>
+/// <param name="ring">フレームリングバッファ。</param>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>フレーム。nullで未読なし。</returns>
+const void* RingedFramesCursor_Next(
+	int32_t* length,
+	int64_t* timestamp,
+	const RingedFrames* ring,
+	RingedFramesCursor* ctxt)
+{
+	// 最初の未読フレームを参照
+	int32_t index = 0;
+	if (RingedFramesCursor_Unread(&index, ring, ctxt) <= 0)
+	{
+		// 未読がない場合は、範囲外を参照させて結果を初期化する
+		index = -1;
+	}
+	const void* frame = RingedFrames_ReferWithOld(index, length, timestamp, ring);
+
+	// 読み出し位置を進める
+	if (frame != nullptr)
+	{
+		ctxt->Position += 1;
+	}
+	return frame;
+}
+
+/// <summary>
+/// <para>上書きまたはPopされて読み逃したフレーム数を取得する。</para>
+/// </summary>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>読み逃したフレーム数。</returns>
+int64_t RingedFramesCursor_Lost(
+	const RingedFramesCursor* ctxt)
+{
+	int64_t result = 0;
+	if (ctxt != nullptr)
+	{
+		result = ctxt->Lost;
+	}
+	return result;
+}
+
+/// <summary>
+/// <para>スナップショットに必要なバイト数を取得する。</para>
+/// <para>蓄積されているフレームの、実際の長さ分だけを数える。</para>
+/// </summary>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>スナップショットのバイト数。INT32_MAXを超える場合は負。</returns>
+int32_t RingedFrames_SnapshotSize(
+	const RingedFrames* ctxt)
+{
+	int32_t result = 0;
+	if (ctxt != nullptr)
+	{
+		// フレーム数と最大フレームサイズが大きいと32ビットを超えるので、64ビットで数える
+		int64_t total = RF_SNAPSHOT_HEADER_SIZE;
+		int32_t fi = SlotOf(ctxt->Index - ctxt->Count, ctxt);
+		for (int32_t i = 0; i < ctxt->Count; i++)
+		{
+			total += RF_SNAPSHOT_RECORD_HEADER_SIZE + (int64_t)*LengthSlot(fi, ctxt);
+			fi = SlotOf(fi + 1, ctxt);
+		}
+		result = (total <= INT32_MAX) ? (int32_t)total : -1;
+	}
+	return result;
+}
+
+/// <summary>
+/// <para>蓄積されているフレームを、古い方から順にスナップショットとして書き出す。</para>
+/// <para>管理ヘッダ(RF_SNAPSHOT_HEADER_SIZE)に続けて、フレームごとに
+/// レコードヘッダ(RF_SNAPSHOT_RECORD_HEADER_SIZE)と実際の長さ分のフレームを書き出す。</para>
+/// <para>数値はリトルエンディアンで書き出すので、プラットフォームに依存しない。</para>
+/// <para>フレームリングバッファは変更しない。</para>
+/// </summary>
+/// <param name="dest">書き出し先バッファ。</param>
+/// <param name="destSize">書き出し先バッファのサイズ。</param>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>書き出したバイト数。書き出し先が足りない場合、
+/// スナップショットがINT32_MAXバイトを超える場合は負。</returns>
+int32_t RingedFrames_Snapshot(
+	void* dest, int32_t destSize,
+	const RingedFrames* ctxt)
+{
+	int32_t result = -1;
+	int32_t size = RingedFrames_SnapshotSize(ctxt);
+	if ((ctxt != nullptr) &&
+		(size >= 0) &&
+		(Encoders_CanEncode(size, dest, destSize) != 0))
+	{
+		uint8_t* dp = (uint8_t*)dest;
+		Encoders_Encode32At(0, RF_SNAPSHOT_MAGIC, 0, dp);
+		Encoders_Encode32At(4, RF_SNAPSHOT_VERSION, 0, dp);
+		Encoders_Encode32At(8, ctxt->Count, 0, dp);
+		Encoders_Encode32At(12, ctxt->FrameSize, 0, dp);
+		Encoders_Encode64At(16, ctxt->UpdateCount, 0, dp);
+		int32_t di = RF_SNAPSHOT_HEADER_SIZE;
+
+		// 古い方から、実際の長さ分だけ並べる
+		int32_t fi = SlotOf(ctxt->Index - ctxt->Count, ctxt);
+		for (int32_t i = 0; i < ctxt->Count; i++)
+		{
+			int32_t length = *LengthSlot(fi, ctxt);
+			Encoders_Encode64At(di, *TimestampSlot(fi, ctxt), 0, dp);
+			Encoders_Encode32At(di + 8, length, 0, dp);
+			di += RF_SNAPSHOT_RECORD_HEADER_SIZE;
+			if (length > 0)
+			{
+				memcpy(&dp[di], PayloadSlot(fi, ctxt), (size_t)length);
+				di += length;
+			}
+			fi = SlotOf(fi + 1, ctxt);
+		}
+		result = di;
+	}
+	return result;
+}
+
+/// <summary>
+/// <para>スナップショットを読み込み、フレームリングバッファの内容を置き換える。</para>
+/// <para>最大蓄積可能フレーム数が異なっていてもよい。足りない場合は、最新の方から格納できる分だけ復元する。</para>
+/// <para>最大フレームサイズを超えるフレームは、Pushと同様に長さ0で記録する。</para>
+/// <para>フレーム更新数も復元するので、スナップショット前の更新番号で読み出せる。</para>
+/// <para>スナップショットが不正な場合や、最大蓄積可能フレーム数が0の場合は、フレームリングバッファを変更しない。</para>
+/// </summary>
+/// <param name="src">スナップショット。</param>
+/// <param name="srcSize">スナップショットのサイズ。</param>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>復元したフレーム数。復元できなかった場合は負。</returns>
+int32_t RingedFrames_Restore(
+	const void* src, int32_t srcSize,
+	RingedFrames* ctxt)
+{
+	int32_t result = -1;
+	const uint8_t* sp = (const uint8_t*)src;
+	if ((ctxt != nullptr) &&
+		(ctxt->Capacity > 0) &&
+		(Decoders_CanDecode(RF_SNAPSHOT_HEADER_SIZE, src, srcSize) != 0) &&
+		(Decoders_32At(0, sp, 0) == RF_SNAPSHOT_MAGIC) &&
+		(Decoders_32At(4, sp, 0) == RF_SNAPSHOT_VERSION))
+	{
+		int32_t count = Decoders_32At(8, sp, 0);
+		int64_t updateCount = Decoders_64At(16, sp, 0);
+
+		// 変更する前に、全てのレコードがスナップショット内に収まっているか確認する
+		int valid = (0 <= count) && (count <= updateCount);
+		int32_t si = RF_SNAPSHOT_HEADER_SIZE;
+		for (int32_t i = 0; (valid != 0) && (i < count); i++)
+		{
+			valid = 0;
+			if (Decoders_CanDecode(si + RF_SNAPSHOT_RECORD_HEADER_SIZE, src, srcSize) != 0)
+			{
+				int32_t length = Decoders_32At(si + 8, sp, 0);
+				si += RF_SNAPSHOT_RECORD_HEADER_SIZE;
+				if ((0 <= length) && (length <= srcSize - si))
+				{
+					si += length;
+					valid = 1;
+				}
+			}
+		}
+
+		if (valid != 0)
+		{
+			// 格納できない古い方のフレームは読み飛ばす
+			int32_t skip = 0;
+			if (count > ctxt->Capacity)
+			{
+				skip = count - ctxt->Capacity;
+			}
+
+			// 最新のフレームの更新番号が一致するように、書き込み位置を合わせる
+			RingedFrames_Clear(ctxt);
+			int64_t first = updateCount - (count - skip);
+			ctxt->Index = (int32_t)(first % ctxt->Capacity);
+			StoreUpdateCount(first, ctxt);
+
+			si = RF_SNAPSHOT_HEADER_SIZE;
+			for (int32_t i = 0; i < count; i++)
+			{
+				int64_t timestamp = Decoders_64At(si, sp, 0);
+				int32_t length = Decoders_32At(si + 8, sp, 0);
+				si += RF_SNAPSHOT_RECORD_HEADER_SIZE;
+				if (i >= skip)
+				{
+					RingedFrames_Push(&sp[si], length, timestamp, ctxt);
+				}
+				si += length;
+			}
+			result = count - skip;
+		}
+	}
+	return result;
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+/// <summary>
+/// <para>書き出せたバイト数だけ、書き出す領域を進める。</para>
+/// </summary>
+static void SkipWritten(size_t skip, struct iovec** iop, int* iovCount)
+{
+	while ((*iovCount > 0) && (skip >= (*iop)->iov_len))
+	{
+		skip -= (*iop)->iov_len;
+		*iop += 1;
+		*iovCount -= 1;
+	}
+	if (*iovCount > 0)
+	{
+		(*iop)->iov_base = (uint8_t*)(*iop)->iov_base + skip;
+		(*iop)->iov_len -= skip;
+	}
+}
+
+/// <summary>
+/// <para>古い方から複数のフレームを、1回のwritevでファイルディスクリプタに書き出す。</para>
+/// <para>フレームごとに、ヘッダ(RF_FRAME_HEADER_SIZE)と実際の長さ分のフレームを続けて書き出す。</para>
+/// <para>ヘッダは、0～7バイト目がタイムスタンプ、8～11バイト目が長さ、12～15バイト目が世代番号。</para>
+/// <para>書き出せたフレームだけを削除する。書き出しが途中で失敗した場合、
+/// 途中まで書き出したフレームは削除せず、書き出したバイト数を記録して次回その続きから書き出す。</para>
+/// <para>続きを書き出す前にそのフレームが削除された(Pop、上書き等)場合は、RF_DRAIN_BROKENを返す。</para>
+/// </summary>
+/// <param name="fd">ファイルディスクリプタ。</param>
+/// <param name="maxFrames">書き出す最大フレーム数(RF_DRAIN_MAX_FRAMESまで)。</param>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>書き出したフレーム数。1フレームも書き出せずに失敗した場合は負。
+/// 書き出し先のストリームが途中で切れた場合はRF_DRAIN_BROKEN。</returns>
+int32_t RingedFrames_DrainTo(
+	int fd,
+	int32_t maxFrames,
+	RingedFrames* ctxt)
+{
+	int32_t drained = -1;
+	if ((ctxt != nullptr) &&
+		(fd >= 0))
+	{
+		drained = 0;
+		int32_t count = ctxt->Count;
+		// 前回途中まで書き出したフレームが残っていれば、その続きから書き出す
+		size_t resume = 0;
+		if (ctxt->DrainedBytes > 0)
+		{
+			if ((count > 0) &&
+				(ctxt->UpdateCount - count == ctxt->DrainedAt))
+			{
+				resume = (size_t)ctxt->DrainedBytes;
+			}
+			else
+			{
+				ctxt->DrainedBytes = 0;
+				count = 0;
+				drained = RF_DRAIN_BROKEN;
+			}
+		}
+		if (count > maxFrames)
+		{
+			count = maxFrames;
+		}
+		if (count > RF_DRAIN_MAX_FRAMES)
+		{
+			count = RF_DRAIN_MAX_FRAMES;
+		}
+
+		if (count > 0)
+		{
+			struct iovec iov[RF_DRAIN_MAX_FRAMES * 2];
+			uint8_t headers[RF_DRAIN_MAX_FRAMES][RF_FRAME_HEADER_SIZE];
+			size_t ends[RF_DRAIN_MAX_FRAMES];
+			int iovCount = 0;
+			size_t total = 0;
+
+			// ヘッダとフレームが続けて配置されていれば、1フレームを1つの領域で書き出せる
+			int interleaved =
+				(ctxt->Payloads == &ctxt->Timestamps[RF_FRAME_HEADER_SIZE]) &&
+				(ctxt->PayloadStride == ctxt->TimestampStride);
+
+			// フレームごとの領域を並べる(折り返し位置で連続しなくなっても、領域は分かれている)
+			int32_t fi = SlotOf(ctxt->Index - ctxt->Count, ctxt);
+			for (int32_t di = 0; di < count; di++)
+			{
+				int32_t length = *LengthSlot(fi, ctxt);
+				if (interleaved)
+				{
+					iov[iovCount].iov_base = TimestampSlot(fi, ctxt);
+					iov[iovCount].iov_len = (size_t)(RF_FRAME_HEADER_SIZE + length);
+					iovCount += 1;
+				}
+				else
+				{
+					// ヘッダ分離レイアウトの場合は、同じ形式のヘッダを組み立てる
+					memset(headers[di], 0, RF_FRAME_HEADER_SIZE);
+					memcpy(&headers[di][0], TimestampSlot(fi, ctxt), sizeof(int64_t));
+					memcpy(&headers[di][sizeof(int64_t)], &length, sizeof(int32_t));
+					memcpy(&headers[di][sizeof(int64_t) + sizeof(int32_t)], StampSlot(fi, ctxt), sizeof(uint32_t));
+					iov[iovCount].iov_base = headers[di];
+					iov[iovCount].iov_len = RF_FRAME_HEADER_SIZE;
+					iovCount += 1;
+					if (length > 0)
+					{
+						iov[iovCount].iov_base = PayloadSlot(fi, ctxt);
+						iov[iovCount].iov_len = (size_t)length;
+						iovCount += 1;
+					}
+				}
+				total += (size_t)(RF_FRAME_HEADER_SIZE + length);
+				ends[di] = total;
+				fi = SlotOf(fi + 1, ctxt);
+			}
+
+			// 全て書き出すまで繰り返す(通常は1回で終わる)
+			struct iovec* iop = iov;
+			size_t written = resume;
+			int failed = 0;
+			SkipWritten(resume, &iop, &iovCount);
+			while ((written < total) && (failed == 0))
+			{
+				ssize_t n = writev(fd, iop, iovCount);
+				if (n <= 0)
+				{
+					if ((n < 0) && (errno == EINTR))
+					{
+						continue;
+					}
+					failed = 1;
+				}
+				else
+				{
+					written += (size_t)n;
+					SkipWritten((size_t)n, &iop, &iovCount);
+				}
+			}
+
+			// 書き出せたフレームを削除
+			while ((drained < count) && (ends[drained] <= written))
+			{
+				drained += 1;
+			}
+			ctxt->Count -= drained;
+
+			// 途中まで書き出したフレームは、書き出したバイト数を記録しておく
+			size_t done = (drained > 0) ? ends[drained - 1] : 0;
+			ctxt->DrainedBytes = (int32_t)(written - done);
+			ctxt->DrainedAt = ctxt->UpdateCount - ctxt->Count;
+			if ((failed != 0) && (drained == 0))
+			{
+				drained = -1;
+			}
+		}
+	}
+	return drained;
+}
+#endif
+
+/* -------------------------------------------------------------------
+*	Unit Test
+*/
+#ifdef _UNIT_TEST
+#include <assert.h>
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+/// <summary>
+/// <para>DrainToで書き出した内容を、パイプから読み出して確認する。</para>
+/// </summary>
+static void AssertDrained(int fd, int64_t timestamp, int32_t length, uint8_t last)
+{
+	uint8_t record[RF_FRAME_HEADER_SIZE + 8];
+	ssize_t n = read(fd, record, (size_t)(RF_FRAME_HEADER_SIZE + length));
+	int64_t ts;
+	int32_t len;
+	memcpy(&ts, &record[0], sizeof ts);
+	memcpy(&len, &record[sizeof ts], sizeof len);
+	assert(n == RF_FRAME_HEADER_SIZE + length);
+	assert(ts == timestamp);
+	assert(len == length);
+	assert((length == 0) || (record[RF_FRAME_HEADER_SIZE + length - 1] == last));
+}
+
+#define DRAIN_TEST_FRAME_SIZE (1024)
+#define DRAIN_TEST_RECORD_SIZE (RF_FRAME_HEADER_SIZE + DRAIN_TEST_FRAME_SIZE)
+static int32_t drainBuffer[RF_NEEDED_BUFFER_WORDS(RF_DRAIN_MAX_FRAMES, DRAIN_TEST_FRAME_SIZE)];
+static uint8_t drainStream[DRAIN_TEST_RECORD_SIZE * RF_DRAIN_MAX_FRAMES];
+
+/// <summary>
+/// <para>ノンブロッキングのファイルディスクリプタから、読み出せるだけ読み出す。</para>
+/// </summary>
+static int32_t ReadAvailable(int fd, uint8_t* dest, int32_t destSize)
+{
+	int32_t total = 0;
+	ssize_t n;
+	while ((total < destSize) &&
+		((n = read(fd, &dest[total], (size_t)(destSize - total))) > 0))
+	{
+		total += (int32_t)n;
+	}
+	return total;
+}
+
+/// <summary>
+/// <para>パイプの容量を超える量をDrainToで書き出し、途中で切れたフレームの扱いを確認する。</para>
+/// </summary>
+static void DrainShortWriteTest(void)
+{
+	RingedFrames ring;
+	uint8_t frame[DRAIN_TEST_FRAME_SIZE];
+	int64_t timestamp;
+	int pipes[2];
+	assert(pipe(pipes) == 0);
+	assert(fcntl(pipes[0], F_SETFL, O_NONBLOCK) == 0);
+	assert(fcntl(pipes[1], F_SETFL, O_NONBLOCK) == 0);
+
+	// -----------------------------------------
+	// 14-06 A frame cut by a short write is resumed, not written twice
+	RingedFrames_Init(RF_DRAIN_MAX_FRAMES, DRAIN_TEST_FRAME_SIZE, drainBuffer, &ring);
+	for (int32_t i = 0; i < RF_DRAIN_MAX_FRAMES; i++)
+	{
+		memset(frame, i, sizeof frame);
+		RingedFrames_Push(frame, DRAIN_TEST_FRAME_SIZE, 1460LL + i, &ring);
+	}
+	int32_t drained = RingedFrames_DrainTo(pipes[1], RF_DRAIN_MAX_FRAMES, &ring);
+	assert((0 < drained) && (drained < RF_DRAIN_MAX_FRAMES));
+	assert(RingedFrames_Count(&ring) == RF_DRAIN_MAX_FRAMES - drained);
+	int32_t n = ReadAvailable(pipes[0], drainStream, (int32_t)sizeof drainStream);
+	assert(n > drained * DRAIN_TEST_RECORD_SIZE);
+	while (RingedFrames_Count(&ring) > 0)
+	{
+		assert(RingedFrames_DrainTo(pipes[1], RF_DRAIN_MAX_FRAMES, &ring) != RF_DRAIN_BROKEN);
+		n += ReadAvailable(pipes[0], &drainStream[n], (int32_t)sizeof drainStream - n);
+	}
+	assert(n == (int32_t)sizeof drainStream);
+	for (int32_t i = 0; i < RF_DRAIN_MAX_FRAMES; i++)
+	{
+		const uint8_t* record = &drainStream[i * DRAIN_TEST_RECORD_SIZE];
+		int32_t len;
+		memcpy(&timestamp, &record[0], sizeof timestamp);
+		memcpy(&len, &record[sizeof timestamp], sizeof len);
+		assert(timestamp == 1460LL + i);
+		assert(len == DRAIN_TEST_FRAME_SIZE);
+		assert(record[RF_FRAME_HEADER_SIZE] == (uint8_t)i);
+		assert(record[DRAIN_TEST_RECORD_SIZE - 1] == (uint8_t)i);
+	}
+
+	// -----------------------------------------
+	// 14-07 The stream is reported broken when the cut frame is removed
+	for (int32_t i = 0; i < RF_DRAIN_MAX_FRAMES; i++)
+	{
+		RingedFrames_Push(frame, DRAIN_TEST_FRAME_SIZE, 1470LL + i, &ring);
+	}
+	drained = RingedFrames_DrainTo(pipes[1], RF_DRAIN_MAX_FRAMES, &ring);
+	assert((0 < drained) && (drained < RF_DRAIN_MAX_FRAMES));
+	ReadAvailable(pipes[0], drainStream, (int32_t)sizeof drainStream);
+	assert(RingedFrames_Pop(frame, sizeof frame, &timestamp, &ring) == DRAIN_TEST_FRAME_SIZE);
+	assert(RingedFrames_DrainTo(pipes[1], RF_DRAIN_MAX_FRAMES, &ring) == RF_DRAIN_BROKEN);
+	assert(RingedFrames_Count(&ring) == RF_DRAIN_MAX_FRAMES - drained - 1);
+	// 次からは、フレームの先頭から書き出す
+	RingedFrames_Push(frame, DRAIN_TEST_FRAME_SIZE, 1470LL + RF_DRAIN_MAX_FRAMES, &ring);
+	assert(RingedFrames_DrainTo(pipes[1], RF_DRAIN_MAX_FRAMES, &ring) > 0);
+	n = ReadAvailable(pipes[0], drainStream, DRAIN_TEST_RECORD_SIZE);
+	memcpy(&timestamp, &drainStream[0], sizeof timestamp);
+	assert(n == DRAIN_TEST_RECORD_SIZE);
+	assert(timestamp == 1470LL + drained + 1);
+
+	close(pipes[0]);
+	close(pipes[1]);
+}
+#endif
+
+/// <summary>
+/// <para>上書きされるフレームの通知を記録する。</para>
+/// </summary>
+typedef struct _EvictedLog
+{
+	int32_t Count;
+	int32_t Lengths[4];
+	int64_t Timestamps[4];
+	uint8_t Lasts[4];
+} EvictedLog;
+static void LogEvicted(const void* frame, int32_t length, int64_t timestamp, void* context)
+{
+	EvictedLog* log = (EvictedLog*)context;
+	if (log->Count < 4)
+	{
+		log->Lengths[log->Count] = length;
+		log->Timestamps[log->Count] = timestamp;
+		log->Lasts[log->Count] = (length > 0) ? ((const uint8_t*)frame)[length - 1] : 0;
+	}
+	log->Count += 1;
+}
+
+void RingedFrames_UnitTest(void)
+{
+	// -----------------------------------------
+	// 1-1
+	RingedFrames ring;
+	int32_t buffer[1 + RF_NEEDED_BUFFER_WORDS(3, 8) + 1];
+	uint8_t frame[8];
+	int32_t length;
+	int64_t timestamp;
+	const uint8_t* referer;
+	uint8_t dataBuffer[8];
+	int64_t updateCount;
+
+	// -----------------------------------------
+	// 1-1 Init
+	memset(buffer, -1, sizeof buffer);
+	RingedFrames_Init(3, 8, &buffer[1], &ring);
+	assert(RingedFrames_Count(&ring) == 0);
+	assert(RingedFrames_UpdateCount(&ring) == 0);
+	// -----------------------------------------
+	// 1-2 Init(self==nullptr)
+	RingedFrames_Init(5, 8, &buffer[1], nullptr);
+	assert(RingedFrames_Capacity(&ring) == 3);
+
+	// -----------------------------------------
+	// 2-1 Capacity(self==nullptr)
+	assert(RingedFrames_Capacity(nullptr) == 0);
+	// -----------------------------------------
+	// 2-2 Capacity
+	assert(RingedFrames_Capacity(&ring) == 3);
+
+	// -----------------------------------------
+	// 3-1 FrameSize(self==nullptr)
+	assert(RingedFrames_FrameSize(nullptr) == 0);
+	// -----------------------------------------
+	// 3-2 FrameSize
+	assert(RingedFrames_FrameSize(&ring) == 8);
+
+	// -----------------------------------------
+	// 4-1 Count(self==nullptr)
+	assert(RingedFrames_Count(nullptr) == 0);
+	// -----------------------------------------
+	// 4-2 Count
+	memset(frame, 0, sizeof frame);
+	frame[0] = 4;
+	frame[7] = 2;
+	assert(RingedFrames_Count(&ring) == 0);
+	RingedFrames_Push(frame, 8, 42LL, &ring);
+	assert(RingedFrames_Count(&ring) == 1);
+
+	// -----------------------------------------
+	// 5-1 UpdateCount(self==nullptr)
+	assert(RingedFrames_UpdateCount(nullptr) == 0);
+	// -----------------------------------------
+	// 5-2 UpdateCount
+	memset(frame, 0, sizeof frame);
+	frame[0] = 5;
+	frame[7] = 2;
+	updateCount = RingedFrames_UpdateCount(&ring);
+	RingedFrames_Push(frame, 8, 52LL, &ring);
+	assert(RingedFrames_UpdateCount(&ring) != updateCount);
+
+	// -----------------------------------------
+	// 6-1 Clear(self==nullptr)
+	RingedFrames_Clear(nullptr);
+	assert(RingedFrames_Count(&ring) == 2);
+	assert(RingedFrames_UpdateCount(&ring) != 0);
+	// -----------------------------------------
+	// 6-2 Clear
+	RingedFrames_Clear(&ring);
+	assert(RingedFrames_Count(&ring) == 0);
+	assert(RingedFrames_UpdateCount(&ring) == 0);
+
+	// -----------------------------------------
+	// 7-xx Push, Refer, Pop
+	memset(buffer, -1, sizeof buffer);
+	RingedFrames_Init(3, 8, &buffer[1], &ring);
+
+	// -----------------------------------------
+	// 7-01 Empty
+	RingedFrames_Clear(&ring);
+
+	// Check
+	assert(RingedFrames_Count(&ring) == 0);
+	referer = RingedFrames_ReferWithOld(0, &length, &timestamp, &ring);
+	assert(referer == nullptr);
+	assert(length == 0);
+	assert(timestamp == 0LL);
+	referer = RingedFrames_ReferWithNew(0, &length, &timestamp, &ring);
+	assert(referer == nullptr);
+	assert(length == 0);
+	assert(timestamp == 0LL);
+	length = RingedFrames_Pop(dataBuffer, sizeof dataBuffer, &timestamp, &ring);
+	assert(length < 0);
+	assert(timestamp == 0LL);
+
+	// -----------------------------------------
+	// 7-02 Push(self==nullptr)
+	memset(frame, 0, sizeof frame);
+	frame[0] = 7;
+	frame[7] = 2;
+	RingedFrames_Push(frame, 8, 72LL, nullptr);
+
+	// Check
+	assert(RingedFrames_Count(&ring) == 0);
+	referer = RingedFrames_ReferWithOld(0, &length, &timestamp, &ring);
+	assert(referer == nullptr);
+	assert(length == 0);
+	assert(timestamp == 0LL);
+	referer = RingedFrames_ReferWithNew(0, &length, &timestamp, &ring);
+	assert(referer == nullptr);
+	assert(length == 0);
+	assert(timestamp == 0LL);
+
+	// -----------------------------------------
+	// 7-03 Push 1st frame
+	updateCount = RingedFrames_UpdateCount(&ring);
+	memset(frame, 0, sizeof frame);
+	frame[0] = 7;
+	frame[7] = 3;
+	RingedFrames_Push(frame, 8, 73LL, &ring);
+
+	// Check
+	assert(RingedFrames_Count(&ring) == 1);
+	assert(RingedFrames_UpdateCount(&ring) != updateCount);
+	// Index -1 is not valid
+	referer = RingedFrames_ReferWithOld(-1, &length, &timestamp, &ring);
+	assert(referer == nullptr);
+	assert(length == 0);
+	assert(timestamp == 0LL);
+	// Index 0 is valid
+	referer = RingedFrames_ReferWithOld(0, &length, &timestamp, &ring);
+	assert(referer[0] == 7);
+	assert(referer[7] == 3);
+	assert(length == 8);
+	assert(timestamp == 73LL);
+	// Index 1 is not valid
+	referer = RingedFrames_ReferWithOld(1, &length, &timestamp, &ring);
+	assert(referer == nullptr);
+	assert(length == 0);
+	assert(timestamp == 0LL);
+	// Index -1 is not valid
+	referer = RingedFrames_ReferWithNew(-1, &length, &timestamp, &ring);
+	assert(referer == nullptr);
+	assert(length == 0);
+	assert(timestamp == 0LL);
+	// Index 0 is valid
+	referer = RingedFrames_ReferWithNew(0, &length, &timestamp, &ring);
+	assert(referer[0] == 7);
+	assert(referer[7] == 3);
+	assert(length == 8);
+	assert(timestamp == 73LL);
+	// Index 1 is not valid
+	referer = RingedFrames_ReferWithNew(1, &length, &timestamp, &ring);
+	assert(referer == nullptr);
+	assert(length == 0);
+	assert(timestamp == 0LL);
+
+	// -----------------------------------------
+	// 7-04 Push 2nd frame
+	updateCount = RingedFrames_UpdateCount(&ring);
+	memset(frame, 0, sizeof frame);
+	frame[0] = 7;
+	frame[6] = 4;
+	RingedFrames_Push(frame, 7, 74LL, &ring);
+
+	// Check
+	assert(RingedFrames_Count(&ring) == 2);
+	assert(RingedFrames_UpdateCount(&ring) != updateCount);
+	// Index 0 is valid
+	referer = RingedFrames_ReferWithOld(0, &length, &timestamp, &ring);
+	assert(referer[0] == 7);
+	assert(referer[7] == 3);
+	assert(length == 8);
+	assert(timestamp == 73LL);
+	// Index 1 is valid
+	referer = RingedFrames_ReferWithOld(1, &length, &timestamp, &ring);
+	assert(referer[0] == 7);
+	assert(referer[6] == 4);
+	assert(length == 7);
+	assert(timestamp == 74LL);
+	// Index 2 is not valid
+	referer = RingedFrames_ReferWithOld(2, &length, &timestamp, &ring);
+	assert(referer == nullptr);
+	assert(length == 0);
+	assert(timestamp == 0LL);
+	// Index 0 is valid
+	referer = RingedFrames_ReferWithNew(0, &length, &timestamp, &ring);
+	assert(referer[0] == 7);
+	assert(referer[6] == 4);
+	assert(length == 7);
+	assert(timestamp == 74LL);
+	// Index 1 is valid
+	referer = RingedFrames_ReferWithNew(1, &length, &timestamp, &ring);
+	assert(referer[0] == 7);
+	assert(referer[7] == 3);
+	assert(length == 8);
+	assert(timestamp == 73LL);
+	// Index 2 is not valid
+	referer = RingedFrames_ReferWithNew(2, &length, &timestamp, &ring);
+	assert(referer == nullptr);
+	assert(length == 0);
+	assert(timestamp == 0LL);
+
+	// -----------------------------------------
+	// 7-05 Push 3rd frame
+	updateCount = RingedFrames_UpdateCount(&ring);
+	memset(frame, 0, sizeof frame);
+	frame[0] = 7;
+	frame[7] = 5;
+	RingedFrames_Push(frame, 8, 75LL, &ring);
+
+	// Check
+	assert(RingedFrames_Count(&ring) == 3);
+	assert(RingedFrames_UpdateCount(&ring) != updateCount);
+	// Index 0 is valid
+	referer = RingedFrames_ReferWithOld(0, &length, &timestamp, &ring);
+	assert(referer[0] == 7);
+	assert(referer[7] == 3);
+	assert(length == 8);
+	assert(timestamp == 73LL);
+	// Index 2 is valid
+	referer = RingedFrames_ReferWithOld(2, &length, &timestamp, &ring);
+	assert(referer[0] == 7);
+	assert(referer[7] == 5);
+	assert(length == 8);
+	assert(timestamp == 75LL);
+	// Index 3 is not valid
+	referer = RingedFrames_ReferWithOld(3, &length, &timestamp, &ring);
+	assert(referer == nullptr);
+	assert(length == 0);
+	assert(timestamp == 0LL);
+	// Index 0 is valid
+	referer = RingedFrames_ReferWithNew(0, &length, &timestamp, &ring);
+	assert(referer[0] == 7);
+	assert(referer[7] == 5);
+	assert(length == 8);
+	assert(timestamp == 75LL);
+	// Index 2 is valid
+	referer = RingedFrames_ReferWithNew(2, &length, &timestamp, &ring);
+	assert(referer[0] == 7);
+	assert(referer[7] == 3);
+	assert(length == 8);
+	assert(timestamp == 73LL);
+	// Index 3 is not valid
+	referer = RingedFrames_ReferWithNew(3, &length, &timestamp, &ring);
+	assert(referer == nullptr);
+	assert(length == 0);
+	assert(timestamp == 0LL);
+
+	// -----------------------------------------
+	// 7-06 Push 4th frame, lost 1st frame
+	updateCount = RingedFrames_UpdateCount(&ring);
+	memset(frame, 0, sizeof frame);
+	frame[0] = 7;
+	frame[6] = 6;
+	RingedFrames_Push(frame, 7, 76LL, &ring);
+
+	// Check
+	assert(RingedFrames_Count(&ring) == 3);
+	assert(RingedFrames_UpdateCount(&ring) != updateCount);
+	// Index 0 is valid, but moved
+	referer = RingedFrames_ReferWithOld(0, &length, &timestamp, &ring);
+	assert(referer[0] == 7);
+	assert(referer[6] == 4);
+	assert(length == 7);
+	assert(timestamp == 74LL);
+	// Index 2 is valid, but moved
+	referer = RingedFrames_ReferWithOld(2, &length, &timestamp, &ring);
+	assert(referer[0] == 7);
+	assert(referer[6] == 6);
+	assert(length == 7);
+	assert(timestamp == 76LL);
+	// Index 0 is valid
+	referer = RingedFrames_ReferWithNew(0, &length, &timestamp, &ring);
+	assert(referer[0] == 7);
+	assert(referer[6] == 6);
+	assert(length == 7);
+	assert(timestamp == 76LL);
+	// Index 2 is valid
+	referer = RingedFrames_ReferWithNew(2, &length, &timestamp, &ring);
+	assert(referer[0] == 7);
+	assert(referer[6] == 4);
+	assert(length == 7);
+	assert(timestamp == 74LL);
+
+	// Do not destroy memories
+	assert(buffer[0] == -1);
+	assert(buffer[((sizeof buffer) / sizeof buffer[0]) - 1] == -1);
+
+	// -----------------------------------------
+	// 7-07 Pop
+	length = RingedFrames_Pop(dataBuffer, sizeof dataBuffer, &timestamp, &ring);
+	assert(dataBuffer[0] == 7);
+	assert(dataBuffer[6] == 4);
+	assert(length == 7);
+	assert(timestamp == 74LL);
+
+	assert(RingedFrames_Count(&ring) == 2);
+
+	// -----------------------------------------
+	// 7-08 Refer length only
+	referer = RingedFrames_ReferWithNew(0, &length, nullptr, &ring);
+	assert(referer[0] == 7);
+	assert(referer[6] == 6);
+	assert(length == 7);
+
+	// -----------------------------------------
+	// 7-09 Refer timestamp only
+	referer = RingedFrames_ReferWithNew(0, nullptr, &timestamp, &ring);
+	assert(referer[0] == 7);
+	assert(referer[6] == 6);
+	assert(timestamp == 76LL);
+
+	// -----------------------------------------
+	// 7-10 Push zero length frame
+	updateCount = RingedFrames_UpdateCount(&ring);
+	RingedFrames_Push(nullptr, 0, 710LL, &ring);
+
+	// Check
+	assert(RingedFrames_Count(&ring) == 3);
+	assert(RingedFrames_UpdateCount(&ring) != updateCount);
+	// Index 0 is valid, but length is zero
+	referer = RingedFrames_ReferWithNew(0, &length, &timestamp, &ring);
+	assert(referer != nullptr);
+	assert(length == 0);
+	assert(timestamp == 710LL);
+
+	// -----------------------------------------
+	// 7-11 Push oversized frame
+	updateCount = RingedFrames_UpdateCount(&ring);
+	RingedFrames_Push(frame, 9, 711LL, &ring);
+
+	// Check
+	assert(RingedFrames_Count(&ring) == 3);
+	assert(RingedFrames_UpdateCount(&ring) != updateCount);
+	// Index 0 is valid, but length is zero
+	referer = RingedFrames_ReferWithNew(0, &length, &timestamp, &ring);
+	assert(referer != nullptr);
+	assert(length == 0);
+	assert(timestamp == 711LL);
+
+	// -----------------------------------------
+	// 7-12 Push null frame
+	updateCount = RingedFrames_UpdateCount(&ring);
+	RingedFrames_Push(nullptr, 0, 712LL, &ring);
+
+	// Check
+	assert(RingedFrames_Count(&ring) == 3);
+	assert(RingedFrames_UpdateCount(&ring) != updateCount);
+	// Index 0 is valid, but length is zero
+	referer = RingedFrames_ReferWithNew(0, &length, &timestamp, &ring);
+	assert(referer != nullptr);
+	assert(length == 0);
+	assert(timestamp == 712LL);
+
+	// -----------------------------------------
+	// 7-13 Refer(self==nullptr)
+	updateCount = RingedFrames_UpdateCount(&ring);
+	memset(frame, 0, sizeof frame);
+	frame[0] = 7;
+	frame[6] = 13;
+	RingedFrames_Push(frame, 7, 713LL, &ring);
+
+	// Check
+	assert(RingedFrames_Count(&ring) == 3);
+	assert(RingedFrames_UpdateCount(&ring) != updateCount);
+	referer = RingedFrames_ReferWithNew(0, &length, &timestamp, nullptr);
+	assert(referer == nullptr);
+	assert(length == 0);
+	assert(timestamp == 0LL);
+
+	// -----------------------------------------
+	// 7-14 Pop but not enough buffer
+	updateCount = RingedFrames_UpdateCount(&ring);
+	memset(frame, 0, sizeof frame);
+	frame[0] = 7;
+	frame[5] = 1;
+	frame[6] = 141;
+	RingedFrames_Push(frame, 7, 7141LL, &ring);
+	memset(frame, 0, sizeof frame);
+	frame[0] = 7;
+	frame[7] = 142;
+	RingedFrames_Push(frame, 8, 7142LL, &ring);
+	memset(frame, 0, sizeof frame);
+	frame[0] = 7;
+	frame[5] = 143;
+	RingedFrames_Push(frame, 6, 7143LL, &ring);
+
+	length = RingedFrames_Pop(dataBuffer, 6, &timestamp, &ring);
+
+	// Check
+	assert(RingedFrames_Count(&ring) == 2);
+	assert(RingedFrames_UpdateCount(&ring) != updateCount);
+	assert(length == 6);
+	assert(timestamp == 7141LL);
+	assert(dataBuffer[0] == 7);
+	assert(dataBuffer[5] == 1);
+
+	// -----------------------------------------
+	// 7-14 Pop only timestamp
+	length = RingedFrames_Pop(nullptr, 0, &timestamp, &ring);
+
+	// Check
+	assert(RingedFrames_Count(&ring) == 1);
+	assert(length == 0);
+	assert(timestamp == 7142LL);
 
 	// -----------------------------------------
-	// 4-1 Count(self==nullptr)
-	assert(RingedFrames_Count(nullptr) == 0);
-	// -----------------------------------------
-	// 4-2 Count
-	memset(frame, 0, sizeof frame);
-	frame[0] = 4;
-	frame[7] = 2;
+	// 7-15 Pop without timestamp
+	length = RingedFrames_Pop(dataBuffer, sizeof dataBuffer, nullptr, &ring);
+
+	// Check
 	assert(RingedFrames_Count(&ring) == 0);
-	RingedFrames_Push(frame, 8, 42LL, &ring);
-	assert(RingedFrames_Count(&ring) == 1);
+	assert(length == 6);
+	assert(dataBuffer[0] == 7);
+	assert(dataBuffer[5] == 143);
 
 	// -----------------------------------------
-	// 5-1 UpdateCount(self==nullptr)
-	assert(RingedFrames_UpdateCount(nullptr) == 0);
-	// -----------------------------------------
-	// 5-2 UpdateCount
-	memset(frame, 0, sizeof frame);
-	frame[0] = 5;
-	frame[7] = 2;
+	// 7-16 Pop zero length frame
 	updateCount = RingedFrames_UpdateCount(&ring);
-	RingedFrames_Push(frame, 8, 52LL, &ring);
-	assert(RingedFrames_UpdateCount(&ring) != updateCount);
+	RingedFrames_Push(nullptr, 0, 716LL, &ring);
 
-	// -----------------------------------------
-	// 6-1 Clear(self==nullptr)
-	RingedFrames_Clear(nullptr);
-	assert(RingedFrames_Count(&ring) == 2);
-	assert(RingedFrames_UpdateCount(&ring) != 0);
-	// -----------------------------------------
-	// 6-2 Clear
-	RingedFrames_Clear(&ring);
+	length = RingedFrames_Pop(dataBuffer, sizeof dataBuffer, &timestamp, &ring);
+
+	// Check
 	assert(RingedFrames_Count(&ring) == 0);
-	assert(RingedFrames_UpdateCount(&ring) == 0);
+	assert(RingedFrames_UpdateCount(&ring) != updateCount);
+	assert(length == 0);
+	assert(timestamp == 716LL);
 
 	// -----------------------------------------
-	// 7-xx Push, Refer, Pop
+	// 8-xx Reserve, Commit, PeekOldest, Release
 	memset(buffer, -1, sizeof buffer);
 	RingedFrames_Init(3, 8, &buffer[1], &ring);
+	uint8_t* reserved;
 
 	// -----------------------------------------
-	// 7-01 Empty
-	RingedFrames_Clear(&ring);
+	// 8-01 Reserve(self==nullptr), Commit(self==nullptr)
+	assert(RingedFrames_Reserve(8, nullptr) == nullptr);
+	assert(RingedFrames_Commit(8, 801LL, nullptr) == 0);
+	// -----------------------------------------
+	// 8-02 Reserve invalid length
+	assert(RingedFrames_Reserve(0, &ring) == nullptr);
+	assert(RingedFrames_Reserve(9, &ring) == nullptr);
+	// -----------------------------------------
+	// 8-03 Commit without Reserve
+	assert(RingedFrames_Commit(8, 803LL, &ring) == 0);
+	assert(RingedFrames_Count(&ring) == 0);
 
-	// Check
+	// -----------------------------------------
+	// 8-04 Reserve and Commit
+	updateCount = RingedFrames_UpdateCount(&ring);
+	reserved = RingedFrames_Reserve(8, &ring);
+	assert(reserved != nullptr);
+	reserved[0] = 8;
+	reserved[5] = 4;
 	assert(RingedFrames_Count(&ring) == 0);
-	referer = RingedFrames_ReferWithOld(0, &length, &timestamp, &ring);
-	assert(referer == nullptr);
-	assert(length == 0);
-	assert(timestamp == 0LL);
+	assert(RingedFrames_Commit(6, 804LL, &ring) != 0);
+
+	// Check
+	assert(RingedFrames_Count(&ring) == 1);
+	assert(RingedFrames_UpdateCount(&ring) != updateCount);
 	referer = RingedFrames_ReferWithNew(0, &length, &timestamp, &ring);
-	assert(referer == nullptr);
-	assert(length == 0);
-	assert(timestamp == 0LL);
-	length = RingedFrames_Pop(dataBuffer, sizeof dataBuffer, &timestamp, &ring);
-	assert(length < 0);
-	assert(timestamp == 0LL);
+	assert(referer == reserved);
+	assert(referer[0] == 8);
+	assert(referer[5] == 4);
+	assert(length == 6);
+	assert(timestamp == 804LL);
+	// Commit twice is not allowed
+	assert(RingedFrames_Commit(6, 804LL, &ring) == 0);
+	assert(RingedFrames_Count(&ring) == 1);
 
 	// -----------------------------------------
-	// 7-02 Push(self==nullptr)
-	memset(frame, 0, sizeof frame);
-	frame[0] = 7;
-	frame[7] = 2;
-	RingedFrames_Push(frame, 8, 72LL, nullptr);
+	// 8-05 Commit longer than reserved
+	reserved = RingedFrames_Reserve(4, &ring);
+	assert(reserved != nullptr);
+	assert(RingedFrames_Commit(5, 805LL, &ring) != 0);
 
 	// Check
-	assert(RingedFrames_Count(&ring) == 0);
-	referer = RingedFrames_ReferWithOld(0, &length, &timestamp, &ring);
-	assert(referer == nullptr);
-	assert(length == 0);
-	assert(timestamp == 0LL);
+	assert(RingedFrames_Count(&ring) == 2);
 	referer = RingedFrames_ReferWithNew(0, &length, &timestamp, &ring);
-	assert(referer == nullptr);
+	assert(referer != nullptr);
 	assert(length == 0);
-	assert(timestamp == 0LL);
+	assert(timestamp == 805LL);
 
 	// -----------------------------------------
-	// 7-03 Push 1st frame
-	updateCount = RingedFrames_UpdateCount(&ring);
+	// 8-06 Reserve when full, oldest is removed
+	for (int32_t i = 0; i < 2; i++)
+	{
+		reserved = RingedFrames_Reserve(8, &ring);
+		reserved[0] = 8;
+		reserved[7] = (uint8_t)(60 + i);
+		RingedFrames_Commit(8, 8060LL + i, &ring);
+	}
+	assert(RingedFrames_Count(&ring) == 3);
+	reserved = RingedFrames_Reserve(8, &ring);
+	assert(reserved != nullptr);
+	assert(RingedFrames_Count(&ring) == 2);
+	referer = RingedFrames_ReferWithOld(0, &length, &timestamp, &ring);
+	assert(referer != (const uint8_t*)reserved);
+	assert(timestamp == 8060LL);
+	reserved[0] = 8;
+	reserved[7] = 62;
+	RingedFrames_Commit(8, 8062LL, &ring);
+	assert(RingedFrames_Count(&ring) == 3);
+
+	// -----------------------------------------
+	// 8-07 Push cancels the reservation
+	reserved = RingedFrames_Reserve(8, &ring);
 	memset(frame, 0, sizeof frame);
-	frame[0] = 7;
-	frame[7] = 3;
-	RingedFrames_Push(frame, 8, 73LL, &ring);
+	frame[0] = 8;
+	frame[7] = 7;
+	RingedFrames_Push(frame, 8, 807LL, &ring);
+	assert(RingedFrames_Commit(8, 807LL, &ring) == 0);
+	referer = RingedFrames_ReferWithNew(0, &length, &timestamp, &ring);
+	assert(referer[7] == 7);
+	assert(timestamp == 807LL);
 
-	// Check
-	assert(RingedFrames_Count(&ring) == 1);
-	assert(RingedFrames_UpdateCount(&ring) != updateCount);
-	// Index -1 is not valid
-	referer = RingedFrames_ReferWithOld(-1, &length, &timestamp, &ring);
-	assert(referer == nullptr);
-	assert(length == 0);
-	assert(timestamp == 0LL);
-	// Index 0 is valid
-	referer = RingedFrames_ReferWithOld(0, &length, &timestamp, &ring);
-	assert(referer[0] == 7);
-	assert(referer[7] == 3);
+	// -----------------------------------------
+	// 8-08 PeekOldest, Release
+	referer = RingedFrames_PeekOldest(&length, &timestamp, &ring);
+	assert(referer != nullptr);
+	assert(referer[0] == 8);
+	assert(referer[7] == 61);
 	assert(length == 8);
-	assert(timestamp == 73LL);
-	// Index 1 is not valid
-	referer = RingedFrames_ReferWithOld(1, &length, &timestamp, &ring);
-	assert(referer == nullptr);
-	assert(length == 0);
-	assert(timestamp == 0LL);
-	// Index -1 is not valid
-	referer = RingedFrames_ReferWithNew(-1, &length, &timestamp, &ring);
+	assert(timestamp == 8061LL);
+	assert(RingedFrames_Release(&ring) != 0);
+	assert(RingedFrames_Count(&ring) == 2);
+	referer = RingedFrames_PeekOldest(&length, &timestamp, &ring);
+	assert(referer[7] == 62);
+	assert(timestamp == 8062LL);
+	// -----------------------------------------
+	// 8-09 PeekOldest(self==nullptr), Release(self==nullptr)
+	referer = RingedFrames_PeekOldest(&length, &timestamp, nullptr);
 	assert(referer == nullptr);
 	assert(length == 0);
 	assert(timestamp == 0LL);
-	// Index 0 is valid
-	referer = RingedFrames_ReferWithNew(0, &length, &timestamp, &ring);
-	assert(referer[0] == 7);
-	assert(referer[7] == 3);
-	assert(length == 8);
-	assert(timestamp == 73LL);
-	// Index 1 is not valid
-	referer = RingedFrames_ReferWithNew(1, &length, &timestamp, &ring);
+	assert(RingedFrames_Release(nullptr) == 0);
+	// -----------------------------------------
+	// 8-10 Release until empty
+	assert(RingedFrames_Release(&ring) != 0);
+	assert(RingedFrames_Release(&ring) != 0);
+	assert(RingedFrames_Release(&ring) == 0);
+	assert(RingedFrames_Count(&ring) == 0);
+	referer = RingedFrames_PeekOldest(&length, &timestamp, &ring);
 	assert(referer == nullptr);
-	assert(length == 0);
-	assert(timestamp == 0LL);
+
+	// Do not destroy memories
+	assert(buffer[0] == -1);
+	assert(buffer[((sizeof buffer) / sizeof buffer[0]) - 1] == -1);
 
 	// -----------------------------------------
-	// 7-04 Push 2nd frame
-	updateCount = RingedFrames_UpdateCount(&ring);
-	memset(frame, 0, sizeof frame);
-	frame[0] = 7;
-	frame[6] = 4;
-	RingedFrames_Push(frame, 7, 74LL, &ring);
+	// 9-xx PushBatch, PopBatch
+	memset(buffer, -1, sizeof buffer);
+	RingedFrames_Init(3, 8, &buffer[1], &ring);
+	uint8_t frames[4][8];
+	const void* framePointers[4];
+	int32_t lengths[4];
+	int64_t timestamps[4];
+	uint8_t batchBuffer[32];
+	for (int32_t i = 0; i < 4; i++)
+	{
+		memset(frames[i], 0, sizeof frames[i]);
+		frames[i][0] = 9;
+		frames[i][7] = (uint8_t)i;
+		framePointers[i] = frames[i];
+		lengths[i] = 8;
+		timestamps[i] = 90LL + i;
+	}
 
-	// Check
+	// -----------------------------------------
+	// 9-01 PushBatch(self==nullptr), invalid arguments
+	assert(RingedFrames_PushBatch(framePointers, lengths, timestamps, 2, nullptr) == 0);
+	assert(RingedFrames_PushBatch(nullptr, lengths, timestamps, 2, &ring) == 0);
+	assert(RingedFrames_PushBatch(framePointers, lengths, timestamps, 0, &ring) == 0);
+	assert(RingedFrames_Count(&ring) == 0);
+	// -----------------------------------------
+	// 9-02 PopBatch(self==nullptr), empty
+	assert(RingedFrames_PopBatch(batchBuffer, sizeof batchBuffer, lengths, timestamps, 4, nullptr) == 0);
+	assert(RingedFrames_PopBatch(batchBuffer, sizeof batchBuffer, lengths, timestamps, 4, &ring) == 0);
+
+	// -----------------------------------------
+	// 9-03 PushBatch, same as Push one by one
+	assert(RingedFrames_PushBatch(framePointers, lengths, timestamps, 2, &ring) == 2);
 	assert(RingedFrames_Count(&ring) == 2);
-	assert(RingedFrames_UpdateCount(&ring) != updateCount);
-	// Index 0 is valid
-	referer = RingedFrames_ReferWithOld(0, &length, &timestamp, &ring);
-	assert(referer[0] == 7);
-	assert(referer[7] == 3);
-	assert(length == 8);
-	assert(timestamp == 73LL);
-	// Index 1 is valid
+	assert(RingedFrames_UpdateCount(&ring) == 2);
 	referer = RingedFrames_ReferWithOld(1, &length, &timestamp, &ring);
-	assert(referer[0] == 7);
-	assert(referer[6] == 4);
-	assert(length == 7);
-	assert(timestamp == 74LL);
-	// Index 2 is not valid
-	referer = RingedFrames_ReferWithOld(2, &length, &timestamp, &ring);
-	assert(referer == nullptr);
-	assert(length == 0);
-	assert(timestamp == 0LL);
-	// Index 0 is valid
-	referer = RingedFrames_ReferWithNew(0, &length, &timestamp, &ring);
-	assert(referer[0] == 7);
-	assert(referer[6] == 4);
-	assert(length == 7);
-	assert(timestamp == 74LL);
-	// Index 1 is valid
-	referer = RingedFrames_ReferWithNew(1, &length, &timestamp, &ring);
-	assert(referer[0] == 7);
-	assert(referer[7] == 3);
+	assert(referer[0] == 9);
+	assert(referer[7] == 1);
 	assert(length == 8);
-	assert(timestamp == 73LL);
-	// Index 2 is not valid
-	referer = RingedFrames_ReferWithNew(2, &length, &timestamp, &ring);
-	assert(referer == nullptr);
-	assert(length == 0);
-	assert(timestamp == 0LL);
+	assert(timestamp == 91LL);
 
 	// -----------------------------------------
-	// 7-05 Push 3rd frame
-	updateCount = RingedFrames_UpdateCount(&ring);
-	memset(frame, 0, sizeof frame);
-	frame[0] = 7;
-	frame[7] = 5;
-	RingedFrames_Push(frame, 8, 75LL, &ring);
-
-	// Check
+	// 9-04 PushBatch across the wrap point, oldest are overwritten
+	framePointers[1] = nullptr;
+	lengths[2] = 9;
+	lengths[3] = 5;
+	assert(RingedFrames_PushBatch(framePointers, lengths, timestamps, 4, &ring) == 4);
 	assert(RingedFrames_Count(&ring) == 3);
-	assert(RingedFrames_UpdateCount(&ring) != updateCount);
-	// Index 0 is valid
+	assert(RingedFrames_UpdateCount(&ring) == 6);
+	// Null and oversized frames are recorded as zero length
 	referer = RingedFrames_ReferWithOld(0, &length, &timestamp, &ring);
-	assert(referer[0] == 7);
-	assert(referer[7] == 3);
-	assert(length == 8);
-	assert(timestamp == 73LL);
-	// Index 2 is valid
-	referer = RingedFrames_ReferWithOld(2, &length, &timestamp, &ring);
-	assert(referer[0] == 7);
-	assert(referer[7] == 5);
-	assert(length == 8);
-	assert(timestamp == 75LL);
-	// Index 3 is not valid
-	referer = RingedFrames_ReferWithOld(3, &length, &timestamp, &ring);
-	assert(referer == nullptr);
 	assert(length == 0);
-	assert(timestamp == 0LL);
-	// Index 0 is valid
+	assert(timestamp == 91LL);
+	referer = RingedFrames_ReferWithOld(1, &length, &timestamp, &ring);
+	assert(length == 0);
+	assert(timestamp == 92LL);
+	referer = RingedFrames_ReferWithOld(2, &length, &timestamp, &ring);
+	assert(referer[0] == 9);
+	assert(referer[4] == 0);
+	assert(length == 5);
+	assert(timestamp == 93LL);
+	// Push one by one continues from the batch
+	RingedFrames_Push(frames[0], 8, 94LL, &ring);
+	referer = RingedFrames_ReferWithOld(0, &length, &timestamp, &ring);
+	assert(timestamp == 92LL);
 	referer = RingedFrames_ReferWithNew(0, &length, &timestamp, &ring);
-	assert(referer[0] == 7);
-	assert(referer[7] == 5);
-	assert(length == 8);
-	assert(timestamp == 75LL);
-	// Index 2 is valid
-	referer = RingedFrames_ReferWithNew(2, &length, &timestamp, &ring);
-	assert(referer[0] == 7);
-	assert(referer[7] == 3);
-	assert(length == 8);
-	assert(timestamp == 73LL);
-	// Index 3 is not valid
-	referer = RingedFrames_ReferWithNew(3, &length, &timestamp, &ring);
+	assert(referer[7] == 0);
+	assert(timestamp == 94LL);
+
+	// -----------------------------------------
+	// 9-05 PopBatch across the wrap point, frames are concatenated
+	memset(batchBuffer, 0, sizeof batchBuffer);
+	assert(RingedFrames_PopBatch(batchBuffer, sizeof batchBuffer, lengths, timestamps, 4, &ring) == 3);
+	assert(RingedFrames_Count(&ring) == 0);
+	assert(lengths[0] == 0);
+	assert(lengths[1] == 5);
+	assert(lengths[2] == 8);
+	assert(timestamps[0] == 92LL);
+	assert(timestamps[1] == 93LL);
+	assert(timestamps[2] == 94LL);
+	assert(batchBuffer[0] == 9);
+	assert(batchBuffer[5] == 9);
+	assert(batchBuffer[12] == 0);
+
+	// -----------------------------------------
+	// 9-06 PopBatch stops at the frame that does not fit
+	framePointers[1] = frames[1];
+	lengths[0] = 8;
+	lengths[1] = 8;
+	lengths[2] = 8;
+	assert(RingedFrames_PushBatch(framePointers, lengths, timestamps, 3, &ring) == 3);
+	assert(RingedFrames_PopBatch(batchBuffer, 12, lengths, timestamps, 4, &ring) == 1);
+	assert(RingedFrames_Count(&ring) == 2);
+	// maxFrames limits the number of frames
+	assert(RingedFrames_PopBatch(batchBuffer, sizeof batchBuffer, lengths, nullptr, 1, &ring) == 1);
+	assert(RingedFrames_Count(&ring) == 1);
+	assert(batchBuffer[7] == 1);
+
+	// -----------------------------------------
+	// 10-xx LowerBoundByTime, RangeByTime
+	RingedFrames_Init(3, 8, &buffer[1], &ring);
+	int32_t begin;
+	int32_t end;
+
+	// -----------------------------------------
+	// 10-01 self==nullptr
+	assert(RingedFrames_LowerBoundByTime(0LL, nullptr) < 0);
+	assert(RingedFrames_RangeByTime(0LL, 1LL, &begin, &end, nullptr) < 0);
+	assert(begin == 0);
+	assert(end == 0);
+	assert(RingedFrames_IsTimeOrdered(nullptr) == 0);
+	// -----------------------------------------
+	// 10-02 Empty
+	assert(RingedFrames_LowerBoundByTime(0LL, &ring) == 0);
+	assert(RingedFrames_RangeByTime(0LL, 1LL, &begin, &end, &ring) == 0);
+
+	// -----------------------------------------
+	// 10-03 Search across the wrap point
+	for (int32_t i = 1; i <= 5; i++)
+	{
+		RingedFrames_Push(nullptr, 0, 10LL * i, &ring);
+	}
+	// Stored 30, 40, 50
+	assert(RingedFrames_LowerBoundByTime(0LL, &ring) == 0);
+	assert(RingedFrames_LowerBoundByTime(30LL, &ring) == 0);
+	assert(RingedFrames_LowerBoundByTime(31LL, &ring) == 1);
+	assert(RingedFrames_LowerBoundByTime(50LL, &ring) == 2);
+	assert(RingedFrames_LowerBoundByTime(51LL, &ring) == 3);
+	assert(RingedFrames_RangeByTime(35LL, 50LL, &begin, &end, &ring) == 2);
+	assert(begin == 1);
+	assert(end == 3);
+	assert(RingedFrames_RangeByTime(40LL, 40LL, &begin, &end, &ring) == 1);
+	assert(begin == 1);
+	assert(end == 2);
+	assert(RingedFrames_RangeByTime(41LL, 49LL, &begin, &end, &ring) == 0);
+	assert(begin == end);
+	assert(RingedFrames_RangeByTime(50LL, 30LL, &begin, &end, &ring) == 0);
+	assert(RingedFrames_RangeByTime(0LL, 100LL, &begin, &end, nullptr) < 0);
+	assert(RingedFrames_RangeByTime(0LL, 100LL, nullptr, nullptr, &ring) == 3);
+
+	// -----------------------------------------
+	// 10-04 Without check, disordered frames are not detected
+	RingedFrames_Push(nullptr, 0, 45LL, &ring);
+	assert(RingedFrames_IsTimeOrdered(&ring) != 0);
+
+	// -----------------------------------------
+	// 10-05 Check detects disordered frames while they are stored
+	RingedFrames_Clear(&ring);
+	RingedFrames_SetTimeOrderCheck(1, &ring);
+	RingedFrames_Push(nullptr, 0, 10LL, &ring);
+	RingedFrames_Push(nullptr, 0, 20LL, &ring);
+	assert(RingedFrames_IsTimeOrdered(&ring) != 0);
+	RingedFrames_Push(nullptr, 0, 20LL, &ring);
+	assert(RingedFrames_IsTimeOrdered(&ring) == 0);
+	assert(RingedFrames_LowerBoundByTime(15LL, &ring) < 0);
+	assert(RingedFrames_RangeByTime(0LL, 100LL, &begin, &end, &ring) < 0);
+	// Still stored with the previous frame
+	RingedFrames_Push(nullptr, 0, 30LL, &ring);
+	assert(RingedFrames_IsTimeOrdered(&ring) == 0);
+	// The previous frame is overwritten
+	RingedFrames_Push(nullptr, 0, 40LL, &ring);
+	assert(RingedFrames_IsTimeOrdered(&ring) != 0);
+	assert(RingedFrames_LowerBoundByTime(25LL, &ring) == 1);
+
+	// -----------------------------------------
+	// 10-06 Check with PushBatch and Release
+	timestamps[0] = 50LL;
+	timestamps[1] = 45LL;
+	timestamps[2] = 60LL;
+	assert(RingedFrames_PushBatch(framePointers, lengths, timestamps, 3, &ring) == 3);
+	assert(RingedFrames_IsTimeOrdered(&ring) == 0);
+	RingedFrames_Release(&ring);
+	assert(RingedFrames_IsTimeOrdered(&ring) != 0);
+	assert(RingedFrames_LowerBoundByTime(50LL, &ring) == 1);
+	// Disordered against the last frame in the previous batch
+	timestamps[0] = 60LL;
+	assert(RingedFrames_PushBatch(framePointers, lengths, timestamps, 1, &ring) == 1);
+	assert(RingedFrames_IsTimeOrdered(&ring) == 0);
+
+	// -----------------------------------------
+	// 10-07 Disable check
+	RingedFrames_SetTimeOrderCheck(0, &ring);
+	assert(RingedFrames_IsTimeOrdered(&ring) != 0);
+
+	// -----------------------------------------
+	// 11-xx RingedFramesCursor
+	RingedFrames_Init(3, 8, &buffer[1], &ring);
+	RingedFramesCursor fast;
+	RingedFramesCursor slow;
+	int32_t index;
+
+	// -----------------------------------------
+	// 11-01 self==nullptr
+	RingedFramesCursor_Init(&ring, nullptr);
+	assert(RingedFramesCursor_Unread(&index, &ring, nullptr) == 0);
+	assert(index == 0);
+	assert(RingedFramesCursor_Advance(1, &ring, nullptr) == 0);
+	assert(RingedFramesCursor_Next(&length, &timestamp, &ring, nullptr) == nullptr);
+	assert(RingedFramesCursor_Lost(nullptr) == 0);
+	// -----------------------------------------
+	// 11-02 Frames pushed before Init are not read
+	RingedFrames_Push(nullptr, 0, 1100LL, &ring);
+	RingedFramesCursor_Init(&ring, &fast);
+	RingedFramesCursor_Init(&ring, &slow);
+	assert(RingedFramesCursor_Unread(&index, &ring, &fast) == 0);
+	referer = RingedFramesCursor_Next(&length, &timestamp, &ring, &fast);
 	assert(referer == nullptr);
 	assert(length == 0);
 	assert(timestamp == 0LL);
 
 	// -----------------------------------------
-	// 7-06 Push 4th frame, lost 1st frame
-	updateCount = RingedFrames_UpdateCount(&ring);
+	// 11-03 Each cursor reads every frame independently
 	memset(frame, 0, sizeof frame);
-	frame[0] = 7;
-	frame[6] = 6;
-	RingedFrames_Push(frame, 7, 76LL, &ring);
-
-	// Check
+	frame[0] = 11;
+	frame[7] = 3;
+	RingedFrames_Push(frame, 8, 1103LL, &ring);
+	RingedFrames_Push(nullptr, 0, 1104LL, &ring);
+	assert(RingedFramesCursor_Unread(&index, &ring, &fast) == 2);
+	assert(index == 1);
+	referer = RingedFramesCursor_Next(&length, &timestamp, &ring, &fast);
+	assert(referer == RingedFrames_ReferWithOld(1, nullptr, nullptr, &ring));
+	assert(referer[7] == 3);
+	assert(length == 8);
+	assert(timestamp == 1103LL);
+	referer = RingedFramesCursor_Next(&length, &timestamp, &ring, &fast);
+	assert(referer != nullptr);
+	assert(timestamp == 1104LL);
+	assert(RingedFramesCursor_Next(&length, &timestamp, &ring, &fast) == nullptr);
+	// The other cursor is not affected
+	assert(RingedFramesCursor_Unread(&index, &ring, &slow) == 2);
 	assert(RingedFrames_Count(&ring) == 3);
-	assert(RingedFrames_UpdateCount(&ring) != updateCount);
-	// Index 0 is valid, but moved
-	referer = RingedFrames_ReferWithOld(0, &length, &timestamp, &ring);
-	assert(referer[0] == 7);
-	assert(referer[6] == 4);
-	assert(length == 7);
-	assert(timestamp == 74LL);
-	// Index 2 is valid, but moved
-	referer = RingedFrames_ReferWithOld(2, &length, &timestamp, &ring);
-	assert(referer[0] == 7);
-	assert(referer[6] == 6);
-	assert(length == 7);
-	assert(timestamp == 76LL);
-	// Index 0 is valid
-	referer = RingedFrames_ReferWithNew(0, &length, &timestamp, &ring);
-	assert(referer[0] == 7);
-	assert(referer[6] == 6);
-	assert(length == 7);
-	assert(timestamp == 76LL);
-	// Index 2 is valid
-	referer = RingedFrames_ReferWithNew(2, &length, &timestamp, &ring);
-	assert(referer[0] == 7);
-	assert(referer[6] == 4);
-	assert(length == 7);
-	assert(timestamp == 74LL);
 
-	// Do not destroy memories
-	assert(buffer[0] == -1);
-	assert(buffer[((sizeof buffer) / sizeof buffer[0]) - 1] == -1);
+	// -----------------------------------------
+	// 11-04 Lost frames are counted
+	for (int32_t i = 0; i < 3; i++)
+	{
+		RingedFrames_Push(nullptr, 0, 1105LL + i, &ring);
+	}
+	assert(RingedFramesCursor_Unread(&index, &ring, &fast) == 3);
+	assert(index == 0);
+	assert(RingedFramesCursor_Lost(&fast) == 0);
+	assert(RingedFramesCursor_Unread(&index, &ring, &slow) == 3);
+	assert(RingedFramesCursor_Lost(&slow) == 2);
+	referer = RingedFramesCursor_Next(&length, &timestamp, &ring, &slow);
+	assert(timestamp == 1105LL);
 
 	// -----------------------------------------
-	// 7-07 Pop
-	length = RingedFrames_Pop(dataBuffer, sizeof dataBuffer, &timestamp, &ring);
-	assert(dataBuffer[0] == 7);
-	assert(dataBuffer[6] == 4);
-	assert(length == 7);
-	assert(timestamp == 74LL);
+	// 11-05 Advance
+	assert(RingedFramesCursor_Advance(0, &ring, &fast) == 0);
+	assert(RingedFramesCursor_Advance(2, &ring, &fast) == 2);
+	assert(RingedFramesCursor_Advance(2, &ring, &fast) == 1);
+	assert(RingedFramesCursor_Unread(&index, &ring, &fast) == 0);
+	assert(index == 3);
 
-	assert(RingedFrames_Count(&ring) == 2);
+	// -----------------------------------------
+	// 11-06 Popped frames are also lost
+	RingedFrames_Pop(nullptr, 0, nullptr, &ring);
+	RingedFrames_Pop(nullptr, 0, nullptr, &ring);
+	assert(RingedFramesCursor_Unread(&index, &ring, &slow) == 1);
+	assert(RingedFramesCursor_Lost(&slow) == 3);
 
 	// -----------------------------------------
-	// 7-08 Refer length only
-	referer = RingedFrames_ReferWithNew(0, &length, nullptr, &ring);
-	assert(referer[0] == 7);
-	assert(referer[6] == 6);
-	assert(length == 7);
+	// 11-07 Read again from the newest after Clear
+	RingedFrames_Clear(&ring);
+	RingedFrames_Push(nullptr, 0, 1107LL, &ring);
+	assert(RingedFramesCursor_Unread(&index, &ring, &fast) == 0);
+	RingedFrames_Push(nullptr, 0, 1108LL, &ring);
+	referer = RingedFramesCursor_Next(&length, &timestamp, &ring, &fast);
+	assert(timestamp == 1108LL);
+	// -----------------------------------------
+	// 11-08 Clear is detected even after pushing past the old position
+	RingedFrames_Clear(&ring);
+	for (int32_t i = 0; i < 3; i++)
+	{
+		RingedFrames_Push(nullptr, 0, 1110LL + i, &ring);
+	}
+	assert(RingedFramesCursor_Unread(&index, &ring, &fast) == 0);
+	assert(RingedFramesCursor_Lost(&fast) == 0);
+	RingedFrames_Push(nullptr, 0, 1113LL, &ring);
+	referer = RingedFramesCursor_Next(&length, &timestamp, &ring, &fast);
+	assert(timestamp == 1113LL);
 
 	// -----------------------------------------
-	// 7-09 Refer timestamp only
-	referer = RingedFrames_ReferWithNew(0, nullptr, &timestamp, &ring);
-	assert(referer[0] == 7);
-	assert(referer[6] == 6);
-	assert(timestamp == 76LL);
+	// 12-xx Power of two capacity
+	int32_t pow2Buffer[1 + RF_NEEDED_BUFFER_WORDS(4, 8) + 1];
+	memset(pow2Buffer, -1, sizeof pow2Buffer);
 
 	// -----------------------------------------
-	// 7-10 Push zero length frame
-	updateCount = RingedFrames_UpdateCount(&ring);
-	RingedFrames_Push(nullptr, 0, 710LL, &ring);
+	// 12-01 Init
+	RingedFrames_Init(3, 8, &pow2Buffer[1], &ring);
+	assert(ring.IndexMask < 0);
+	RingedFrames_Init(0, 8, &pow2Buffer[1], &ring);
+	assert(ring.IndexMask < 0);
+	RingedFrames_Init(1, 8, &pow2Buffer[1], &ring);
+	assert(ring.IndexMask == 0);
+	RingedFrames_Init(4, 8, &pow2Buffer[1], &ring);
+	assert(ring.IndexMask == 3);
 
-	// Check
-	assert(RingedFrames_Count(&ring) == 3);
-	assert(RingedFrames_UpdateCount(&ring) != updateCount);
-	// Index 0 is valid, but length is zero
-	referer = RingedFrames_ReferWithNew(0, &length, &timestamp, &ring);
-	assert(referer != nullptr);
-	assert(length == 0);
-	assert(timestamp == 710LL);
+	// -----------------------------------------
+	// 12-02 Push and Refer across the wrap point
+	for (int32_t i = 0; i < 6; i++)
+	{
+		memset(frame, 0, sizeof frame);
+		frame[0] = 12;
+		frame[7] = (uint8_t)i;
+		RingedFrames_Push(frame, 8, 1200LL + i, &ring);
+	}
+	assert(RingedFrames_Count(&ring) == 4);
+	assert(ring.Index == 2);
+	referer = RingedFrames_ReferWithOld(0, &length, &timestamp, &ring);
+	assert(referer[7] == 2);
+	assert(timestamp == 1202LL);
+	referer = RingedFrames_ReferWithOld(3, &length, &timestamp, &ring);
+	assert(referer[7] == 5);
+	assert(timestamp == 1205LL);
+	referer = RingedFrames_ReferWithOld(4, &length, &timestamp, &ring);
+	assert(referer == nullptr);
+	assert(RingedFrames_LowerBoundByTime(1204LL, &ring) == 2);
 
 	// -----------------------------------------
-	// 7-11 Push oversized frame
-	updateCount = RingedFrames_UpdateCount(&ring);
-	RingedFrames_Push(frame, 9, 711LL, &ring);
+	// 12-03 PushBatch, PopBatch across the wrap point
+	timestamps[0] = 1206LL;
+	timestamps[1] = 1207LL;
+	timestamps[2] = 1208LL;
+	lengths[0] = 8;
+	lengths[1] = 8;
+	lengths[2] = 8;
+	assert(RingedFrames_PushBatch(framePointers, lengths, timestamps, 3, &ring) == 3);
+	assert(ring.Index == 1);
+	assert(RingedFrames_PopBatch(batchBuffer, sizeof batchBuffer, lengths, timestamps, 4, &ring) == 4);
+	assert(timestamps[0] == 1205LL);
+	assert(timestamps[3] == 1208LL);
+	assert(RingedFrames_Count(&ring) == 0);
 
-	// Check
-	assert(RingedFrames_Count(&ring) == 3);
-	assert(RingedFrames_UpdateCount(&ring) != updateCount);
-	// Index 0 is valid, but length is zero
-	referer = RingedFrames_ReferWithNew(0, &length, &timestamp, &ring);
-	assert(referer != nullptr);
-	assert(length == 0);
-	assert(timestamp == 711LL);
+	// -----------------------------------------
+	// 13-xx Struct of arrays layout
+	int64_t soaBuffer[(2 + RF_SOA_NEEDED_BUFFER_WORDS(3, 7) + 1 + 1) / 2];
+	int32_t* soaWords = (int32_t*)soaBuffer;
+	int32_t soaWordCount = (int32_t)(sizeof soaBuffer) / (int32_t)sizeof(int32_t);
+	memset(soaBuffer, -1, sizeof soaBuffer);
 
 	// -----------------------------------------
-	// 7-12 Push null frame
-	updateCount = RingedFrames_UpdateCount(&ring);
-	RingedFrames_Push(nullptr, 0, 712LL, &ring);
+	// 13-01 InitSoa(self==nullptr), TotalLength(self==nullptr)
+	RingedFrames_InitSoa(3, 7, &soaWords[2], nullptr);
+	assert(RingedFrames_TotalLength(nullptr) == 0);
+	// -----------------------------------------
+	// 13-02 InitSoa
+	RingedFrames_InitSoa(3, 7, &soaWords[2], &ring);
+	assert(RingedFrames_Capacity(&ring) == 3);
+	assert(RingedFrames_FrameSize(&ring) == 7);
+	assert(RingedFrames_Count(&ring) == 0);
+	assert(RingedFrames_TotalLength(&ring) == 0);
 
-	// Check
+	// -----------------------------------------
+	// 13-03 Push, Refer across the wrap point
+	for (int32_t i = 0; i < 4; i++)
+	{
+		memset(frame, 0, sizeof frame);
+		frame[0] = 13;
+		frame[6] = (uint8_t)i;
+		RingedFrames_Push(frame, 4 + i, 1300LL + i, &ring);
+	}
 	assert(RingedFrames_Count(&ring) == 3);
-	assert(RingedFrames_UpdateCount(&ring) != updateCount);
-	// Index 0 is valid, but length is zero
+	referer = RingedFrames_ReferWithOld(0, &length, &timestamp, &ring);
+	assert(referer[0] == 13);
+	assert(length == 5);
+	assert(timestamp == 1301LL);
+	referer = RingedFrames_ReferWithOld(1, &length, &timestamp, &ring);
+	assert(referer[0] == 13);
+	assert(referer[5] == 0);
+	assert(length == 6);
+	assert(timestamp == 1302LL);
 	referer = RingedFrames_ReferWithNew(0, &length, &timestamp, &ring);
-	assert(referer != nullptr);
-	assert(length == 0);
-	assert(timestamp == 712LL);
-
+	assert(referer[6] == 3);
+	assert(length == 7);
+	assert(timestamp == 1303LL);
+	assert(RingedFrames_TotalLength(&ring) == 18);
+	// Timestamps are contiguous
+	assert(((const int64_t*)&soaWords[2])[0] == 1303LL);
+	assert(((const int64_t*)&soaWords[2])[1] == 1301LL);
+	assert(((const int64_t*)&soaWords[2])[2] == 1302LL);
 	// -----------------------------------------
-	// 7-13 Refer(self==nullptr)
-	updateCount = RingedFrames_UpdateCount(&ring);
-	memset(frame, 0, sizeof frame);
-	frame[0] = 7;
-	frame[6] = 13;
-	RingedFrames_Push(frame, 7, 713LL, &ring);
+	// 13-04 Search by time
+	assert(RingedFrames_LowerBoundByTime(1302LL, &ring) == 1);
+	assert(RingedFrames_RangeByTime(1302LL, 1303LL, &begin, &end, &ring) == 2);
 
-	// Check
-	assert(RingedFrames_Count(&ring) == 3);
-	assert(RingedFrames_UpdateCount(&ring) != updateCount);
-	referer = RingedFrames_ReferWithNew(0, &length, &timestamp, nullptr);
-	assert(referer == nullptr);
-	assert(length == 0);
-	assert(timestamp == 0LL);
+	// -----------------------------------------
+	// 13-05 Reserve, Commit, Pop
+	reserved = RingedFrames_Reserve(7, &ring);
+	assert(reserved != nullptr);
+	reserved[0] = 13;
+	reserved[6] = 5;
+	assert(RingedFrames_Commit(7, 1305LL, &ring) != 0);
+	length = RingedFrames_Pop(dataBuffer, sizeof dataBuffer, &timestamp, &ring);
+	assert(length == 6);
+	assert(timestamp == 1302LL);
+	assert(RingedFrames_TotalLength(&ring) == 14);
 
 	// -----------------------------------------
-	// 7-14 Pop but not enough buffer
-	updateCount = RingedFrames_UpdateCount(&ring);
-	memset(frame, 0, sizeof frame);
-	frame[0] = 7;
-	frame[5] = 1;
-	frame[6] = 141;
-	RingedFrames_Push(frame, 7, 7141LL, &ring);
-	memset(frame, 0, sizeof frame);
-	frame[0] = 7;
-	frame[7] = 142;
-	RingedFrames_Push(frame, 8, 7142LL, &ring);
-	memset(frame, 0, sizeof frame);
-	frame[0] = 7;
-	frame[5] = 143;
-	RingedFrames_Push(frame, 6, 7143LL, &ring);
+	// 13-06 PushBatch, PopBatch
+	lengths[0] = 7;
+	lengths[1] = 3;
+	timestamps[0] = 1306LL;
+	timestamps[1] = 1307LL;
+	assert(RingedFrames_PushBatch(framePointers, lengths, timestamps, 2, &ring) == 2);
+	assert(RingedFrames_TotalLength(&ring) == 17);
+	assert(RingedFrames_PopBatch(batchBuffer, sizeof batchBuffer, lengths, timestamps, 4, &ring) == 3);
+	assert(lengths[0] == 7);
+	assert(lengths[1] == 7);
+	assert(lengths[2] == 3);
+	assert(timestamps[0] == 1305LL);
+	assert(timestamps[2] == 1307LL);
+	assert(batchBuffer[0] == 13);
+	assert(batchBuffer[6] == 5);
+	assert(batchBuffer[7] == 9);
+	assert(batchBuffer[14] == 9);
+	assert(RingedFrames_TotalLength(&ring) == 0);
+
+#if defined(__unix__) || defined(__APPLE__)
+	// -----------------------------------------
+	// 14-xx DrainTo
+	int pipes[2];
+	assert(pipe(pipes) == 0);
 
-	length = RingedFrames_Pop(dataBuffer, 6, &timestamp, &ring);
+	// -----------------------------------------
+	// 14-01 DrainTo(self==nullptr), invalid fd
+	assert(RingedFrames_DrainTo(pipes[1], 4, nullptr) < 0);
+	assert(RingedFrames_DrainTo(-1, 4, &ring) < 0);
+	// -----------------------------------------
+	// 14-02 Empty
+	assert(RingedFrames_DrainTo(pipes[1], 4, &ring) == 0);
 
-	// Check
-	assert(RingedFrames_Count(&ring) == 2);
-	assert(RingedFrames_UpdateCount(&ring) != updateCount);
-	assert(length == 6);
-	assert(timestamp == 7141LL);
-	assert(dataBuffer[0] == 7);
-	assert(dataBuffer[5] == 1);
+	// -----------------------------------------
+	// 14-03 Struct of arrays layout, across the wrap point
+	for (int32_t i = 0; i < 3; i++)
+	{
+		memset(frame, 0, sizeof frame);
+		frame[0] = 14;
+		frame[2 + i] = (uint8_t)(30 + i);
+		RingedFrames_Push(frame, 3 + i, 1430LL + i, &ring);
+	}
+	RingedFrames_Push(nullptr, 0, 1433LL, &ring);
+	assert(RingedFrames_DrainTo(pipes[1], 2, &ring) == 2);
+	assert(RingedFrames_Count(&ring) == 1);
+	AssertDrained(pipes[0], 1431LL, 4, 31);
+	AssertDrained(pipes[0], 1432LL, 5, 32);
+	assert(RingedFrames_DrainTo(pipes[1], 4, &ring) == 1);
+	AssertDrained(pipes[0], 1433LL, 0, 0);
+	assert(RingedFrames_Count(&ring) == 0);
 
 	// -----------------------------------------
-	// 7-14 Pop only timestamp
-	length = RingedFrames_Pop(nullptr, 0, &timestamp, &ring);
+	// 14-04 Interleaved layout
+	RingedFrames_Init(3, 8, &buffer[1], &ring);
+	for (int32_t i = 0; i < 5; i++)
+	{
+		memset(frame, 0, sizeof frame);
+		frame[0] = 14;
+		frame[7] = (uint8_t)(40 + i);
+		RingedFrames_Push(frame, 8, 1440LL + i, &ring);
+	}
+	assert(RingedFrames_DrainTo(pipes[1], 100, &ring) == 3);
+	AssertDrained(pipes[0], 1442LL, 8, 42);
+	AssertDrained(pipes[0], 1443LL, 8, 43);
+	AssertDrained(pipes[0], 1444LL, 8, 44);
+	assert(RingedFrames_Count(&ring) == 0);
 
-	// Check
+	// -----------------------------------------
+	// 14-05 Nothing is removed when writing fails
+	RingedFrames_Push(frame, 8, 1450LL, &ring);
+	close(pipes[0]);
+	close(pipes[1]);
+	assert(RingedFrames_DrainTo(pipes[1], 4, &ring) < 0);
 	assert(RingedFrames_Count(&ring) == 1);
+
+	DrainShortWriteTest();
+#endif
+
+	// -----------------------------------------
+	// 15-01 ReadStable(self==nullptr)
+	timestamp = -1LL;
+	assert(RingedFrames_ReadStable(0, dataBuffer, sizeof dataBuffer, &timestamp, nullptr) == RF_READ_PENDING);
+	assert(timestamp == 0LL);
+	// -----------------------------------------
+	// 15-02 Not pushed yet
+	RingedFrames_Init(3, 8, &buffer[1], &ring);
+	assert(RingedFrames_ReadStable(0, dataBuffer, sizeof dataBuffer, &timestamp, &ring) == RF_READ_PENDING);
+	assert(RingedFrames_ReadStable(-1, dataBuffer, sizeof dataBuffer, &timestamp, &ring) == RF_READ_PENDING);
+	// -----------------------------------------
+	// 15-03 Generation stamp is recorded in bytes 12-15 of the header
+	for (int32_t i = 0; i < 3; i++)
+	{
+		memset(frame, 0, sizeof frame);
+		frame[0] = 15;
+		frame[7] = (uint8_t)(30 + i);
+		RingedFrames_Push(frame, 8, 1530LL + i, &ring);
+	}
+	assert(buffer[1 + 3] == 2);
+	assert(buffer[1 + RF_STRIDE_WORDS(8) * 2 + 3] == 6);
+	length = RingedFrames_ReadStable(1, dataBuffer, sizeof dataBuffer, &timestamp, &ring);
+	assert(length == 8);
+	assert(timestamp == 1531LL);
+	assert(dataBuffer[0] == 15);
+	assert(dataBuffer[7] == 31);
+	assert(RingedFrames_ReadStable(3, dataBuffer, sizeof dataBuffer, &timestamp, &ring) == RF_READ_PENDING);
+	// -----------------------------------------
+	// 15-04 Overwritten
+	frame[7] = 33;
+	RingedFrames_Push(frame, 8, 1533LL, &ring);
+	assert(RingedFrames_ReadStable(0, dataBuffer, sizeof dataBuffer, &timestamp, &ring) == RF_READ_OVERWRITTEN);
+	assert(timestamp == 0LL);
+	length = RingedFrames_ReadStable(3, dataBuffer, 4, &timestamp, &ring);
+	assert(length == 4);
+	assert(timestamp == 1533LL);
+	// -----------------------------------------
+	// 15-05 Frame being overwritten is detected
+	referer = (const uint8_t*)RingedFrames_Reserve(8, &ring);
+	assert(referer != nullptr);
+	assert(RingedFrames_ReadStable(1, dataBuffer, sizeof dataBuffer, &timestamp, &ring) == RF_READ_OVERWRITTEN);
+	length = RingedFrames_ReadStable(2, dataBuffer, sizeof dataBuffer, &timestamp, &ring);
+	assert(length == 8);
+	assert(RingedFrames_Commit(8, 1534LL, &ring) != 0);
+	length = RingedFrames_ReadStable(4, nullptr, 0, &timestamp, &ring);
 	assert(length == 0);
-	assert(timestamp == 7142LL);
+	assert(timestamp == 1534LL);
+	// -----------------------------------------
+	// 15-06 Popped frame can be read until it is overwritten
+	assert(RingedFrames_Pop(nullptr, 0, nullptr, &ring) >= 0);
+	length = RingedFrames_ReadStable(2, dataBuffer, sizeof dataBuffer, &timestamp, &ring);
+	assert(length == 8);
+	assert(timestamp == 1532LL);
+	// -----------------------------------------
+	// 15-07 PushBatch stamps every frame
+	{
+		const void* frames[2] = { frame, frame };
+		int32_t lengths[2] = { 5, 6 };
+		int64_t timestamps[2] = { 1535LL, 1536LL };
+		assert(RingedFrames_PushBatch(frames, lengths, timestamps, 2, &ring) == 2);
+	}
+	assert(RingedFrames_ReadStable(2, dataBuffer, sizeof dataBuffer, &timestamp, &ring) == RF_READ_OVERWRITTEN);
+	assert(RingedFrames_ReadStable(5, dataBuffer, sizeof dataBuffer, &timestamp, &ring) == 5);
+	assert(timestamp == 1535LL);
+	assert(RingedFrames_ReadStable(6, dataBuffer, sizeof dataBuffer, &timestamp, &ring) == 6);
+	assert(timestamp == 1536LL);
+	// -----------------------------------------
+	// 15-08 Struct of arrays layout
+	RingedFrames_InitSoa(3, 7, &soaWords[2], &ring);
+	RingedFrames_Push(frame, 7, 1580LL, &ring);
+	assert(soaWords[2 + 3 * 3] == 2);
+	length = RingedFrames_ReadStable(0, dataBuffer, sizeof dataBuffer, &timestamp, &ring);
+	assert(length == 7);
+	assert(timestamp == 1580LL);
+	assert(dataBuffer[0] == 15);
 
 	// -----------------------------------------
-	// 7-15 Pop without timestamp
-	length = RingedFrames_Pop(dataBuffer, sizeof dataBuffer, nullptr, &ring);
+	// 16-01 SetPolicy, SetEvictedCallback(self==nullptr)
+	RingedFrames_SetPolicy(RF_POLICY_REJECT_NEWEST, nullptr);
+	RingedFrames_SetEvictedCallback(LogEvicted, nullptr, nullptr);
+	// -----------------------------------------
+	// 16-02 Default policy is overwrite oldest
+	RingedFrames_Init(3, 8, &buffer[1], &ring);
+	assert(ring.Policy == RF_POLICY_OVERWRITE_OLDEST);
+	for (int32_t i = 0; i < 4; i++)
+	{
+		assert(RingedFrames_Push(frame, 8, 1620LL + i, &ring) != 0);
+	}
+	assert(RingedFrames_Count(&ring) == 3);
+	RingedFrames_PeekOldest(&length, &timestamp, &ring);
+	assert(timestamp == 1621LL);
+	// -----------------------------------------
+	// 16-03 Invalid policy is ignored
+	RingedFrames_SetPolicy(9, &ring);
+	assert(ring.Policy == RF_POLICY_OVERWRITE_OLDEST);
 
-	// Check
-	assert(RingedFrames_Count(&ring) == 0);
-	assert(length == 6);
-	assert(dataBuffer[0] == 7);
-	assert(dataBuffer[5] == 143);
+	// -----------------------------------------
+	// 16-04 Reject newest
+	RingedFrames_Init(3, 8, &buffer[1], &ring);
+	RingedFrames_SetPolicy(RF_POLICY_REJECT_NEWEST, &ring);
+	for (int32_t i = 0; i < 3; i++)
+	{
+		assert(RingedFrames_Push(frame, 8, 1640LL + i, &ring) != 0);
+	}
+	assert(RingedFrames_Push(frame, 8, 1643LL, &ring) == 0);
+	assert(RingedFrames_Count(&ring) == 3);
+	assert(RingedFrames_UpdateCount(&ring) == 3);
+	RingedFrames_PeekOldest(&length, &timestamp, &ring);
+	assert(timestamp == 1640LL);
+	referer = RingedFrames_ReferWithNew(0, &length, &timestamp, &ring);
+	assert(timestamp == 1642LL);
+	// -----------------------------------------
+	// 16-05 Reject newest, Reserve
+	assert(RingedFrames_Reserve(8, &ring) == nullptr);
+	assert(RingedFrames_Commit(8, 1645LL, &ring) == 0);
+	assert(RingedFrames_Count(&ring) == 3);
+	// -----------------------------------------
+	// 16-06 Reject newest, PushBatch keeps the first frames
+	assert(RingedFrames_Release(&ring) != 0);
+	{
+		const void* frames[3] = { frame, frame, frame };
+		int32_t lengths[3] = { 1, 2, 3 };
+		int64_t timestamps[3] = { 1646LL, 1647LL, 1648LL };
+		assert(RingedFrames_PushBatch(frames, lengths, timestamps, 3, &ring) == 1);
+	}
+	referer = RingedFrames_ReferWithNew(0, &length, &timestamp, &ring);
+	assert(length == 1);
+	assert(timestamp == 1646LL);
+	// -----------------------------------------
+	// 16-07 Pushable again after Pop
+	assert(RingedFrames_Pop(nullptr, 0, nullptr, &ring) >= 0);
+	assert(RingedFrames_Push(frame, 8, 1649LL, &ring) != 0);
 
 	// -----------------------------------------
-	// 7-16 Pop zero length frame
-	updateCount = RingedFrames_UpdateCount(&ring);
-	RingedFrames_Push(nullptr, 0, 716LL, &ring);
+	// 16-08 Evicted callback is called before the oldest is overwritten
+	{
+		EvictedLog log;
+		memset(&log, 0, sizeof log);
+		RingedFrames_Init(3, 8, &buffer[1], &ring);
+		RingedFrames_SetEvictedCallback(LogEvicted, &log, &ring);
+		for (int32_t i = 0; i < 4; i++)
+		{
+			memset(frame, 0, sizeof frame);
+			frame[4 + i % 4] = (uint8_t)(80 + i);
+			RingedFrames_Push(frame, 5 + (i % 4), 1680LL + i, &ring);
+		}
+		assert(log.Count == 1);
+		assert(log.Lengths[0] == 5);
+		assert(log.Timestamps[0] == 1680LL);
+		assert(log.Lasts[0] == 80);
+		// -----------------------------------------
+		// 16-09 Not called for Pop and Release
+		RingedFrames_Pop(nullptr, 0, nullptr, &ring);
+		RingedFrames_Release(&ring);
+		assert(log.Count == 1);
+		// -----------------------------------------
+		// 16-10 Called by Reserve when full
+		RingedFrames_Push(frame, 8, 1690LL, &ring);
+		RingedFrames_Push(frame, 8, 1691LL, &ring);
+		assert(log.Count == 1);
+		assert(RingedFrames_Reserve(8, &ring) != nullptr);
+		assert(log.Count == 2);
+		assert(log.Timestamps[1] == 1683LL);
+		assert(RingedFrames_Commit(8, 1692LL, &ring) != 0);
+		assert(log.Count == 2);
+		// -----------------------------------------
+		// 16-11 PushBatch reports every lost frame in order, including skipped ones
+		{
+			const void* frames[4] = { frame, frame, frame, frame };
+			int32_t lengths[4] = { 1, 2, 3, 4 };
+			int64_t timestamps[4] = { 1693LL, 1694LL, 1695LL, 1696LL };
+			assert(RingedFrames_PushBatch(frames, lengths, timestamps, 4, &ring) == 4);
+		}
+		assert(log.Count == 6);
+		assert(log.Timestamps[2] == 1690LL);
+		assert(log.Timestamps[3] == 1691LL);
+		referer = RingedFrames_ReferWithOld(0, &length, &timestamp, &ring);
+		assert(timestamp == 1694LL);
+		// -----------------------------------------
+		// 16-12 Not called when rejecting
+		RingedFrames_SetPolicy(RF_POLICY_REJECT_NEWEST, &ring);
+		assert(RingedFrames_Push(frame, 8, 1697LL, &ring) == 0);
+		assert(log.Count == 6);
+		// -----------------------------------------
+		// 16-13 Callback can be removed
+		RingedFrames_SetPolicy(RF_POLICY_OVERWRITE_OLDEST, &ring);
+		RingedFrames_SetEvictedCallback(nullptr, nullptr, &ring);
+		assert(RingedFrames_Push(frame, 8, 1698LL, &ring) != 0);
+		assert(log.Count == 6);
+		// -----------------------------------------
+		// 16-14 Capacity 0 rejects every frame, whatever the policy
+		{
+			int32_t zeroBuffer[2];
+			RingedFrames zero;
+			memset(zeroBuffer, 0x5a, sizeof zeroBuffer);
+			RingedFrames_Init(0, 8, &zeroBuffer[1], &zero);
+			RingedFrames_SetEvictedCallback(LogEvicted, &log, &zero);
+			assert(RingedFrames_Push(frame, 8, 1699LL, &zero) == 0);
+			RingedFrames_SetPolicy(RF_POLICY_REJECT_NEWEST, &zero);
+			assert(RingedFrames_Push(frame, 8, 1700LL, &zero) == 0);
+			assert(RingedFrames_Reserve(8, &zero) == nullptr);
+			assert(RingedFrames_Count(&zero) == 0);
+			assert(log.Count == 6);
+			assert(zeroBuffer[0] == 0x5a5a5a5a);
+			assert(zeroBuffer[1] == 0x5a5a5a5a);
+		}
+	}
 
-	length = RingedFrames_Pop(dataBuffer, sizeof dataBuffer, &timestamp, &ring);
+	// -----------------------------------------
+	// 17-xx Snapshot, Restore
+	{
+		uint8_t image[RF_SNAPSHOT_HEADER_SIZE + (RF_SNAPSHOT_RECORD_HEADER_SIZE + 8) * 3];
+		int32_t largeBuffer[1 + RF_NEEDED_BUFFER_WORDS(5, 8) + 1];
+		int32_t smallBuffer[1 + RF_NEEDED_BUFFER_WORDS(2, 4) + 1];
+		RingedFrames large;
+		RingedFrames small;
+		memset(largeBuffer, -1, sizeof largeBuffer);
+		memset(smallBuffer, -1, sizeof smallBuffer);
+		RingedFrames_Init(5, 8, &largeBuffer[1], &large);
+		RingedFrames_Init(2, 4, &smallBuffer[1], &small);
+		// -----------------------------------------
+		// 17-01 Snapshot(self==nullptr), Restore(self==nullptr)
+		assert(RingedFrames_SnapshotSize(nullptr) == 0);
+		assert(RingedFrames_Snapshot(image, sizeof image, nullptr) < 0);
+		assert(RingedFrames_Restore(image, sizeof image, nullptr) < 0);
+		// -----------------------------------------
+		// 17-02 Snapshot of empty ring is just the header
+		RingedFrames_Init(3, 8, &buffer[1], &ring);
+		assert(RingedFrames_SnapshotSize(&ring) == RF_SNAPSHOT_HEADER_SIZE);
+		assert(RingedFrames_Snapshot(image, sizeof image, &ring) == RF_SNAPSHOT_HEADER_SIZE);
+		assert(RingedFrames_Restore(image, RF_SNAPSHOT_HEADER_SIZE, &large) == 0);
+		assert(RingedFrames_Count(&large) == 0);
+		// -----------------------------------------
+		// 17-03 Snapshot holds only the used bytes, oldest to newest, in little endian
+		for (int32_t i = 0; i < 4; i++)
+		{
+			memset(frame, 0x70 + i, sizeof frame);
+			RingedFrames_Push(frame, 2 + i, 1700LL + i, &ring);
+		}
+		assert(RingedFrames_SnapshotSize(&ring) ==
+			RF_SNAPSHOT_HEADER_SIZE + RF_SNAPSHOT_RECORD_HEADER_SIZE * 3 + 3 + 4 + 5);
+		assert(RingedFrames_Snapshot(image, RingedFrames_SnapshotSize(&ring) - 1, &ring) < 0);
+		assert(RingedFrames_Snapshot(nullptr, sizeof image, &ring) < 0);
+		assert(RingedFrames_Snapshot(image, sizeof image, &ring) == RingedFrames_SnapshotSize(&ring));
+		assert((image[0] == 'R') && (image[1] == 'F') && (image[2] == 'S') && (image[3] == 'S'));
+		assert(image[8] == 3);
+		assert(image[16] == 4);
+		assert(image[RF_SNAPSHOT_HEADER_SIZE] == (uint8_t)(1701LL & 0xFF));
+		assert(image[RF_SNAPSHOT_HEADER_SIZE + 8] == 3);
+		assert(image[RF_SNAPSHOT_HEADER_SIZE + RF_SNAPSHOT_RECORD_HEADER_SIZE] == 0x71);
+		// -----------------------------------------
+		// 17-04 Snapshot does not change the ring
+		assert(RingedFrames_Count(&ring) == 3);
+		assert(RingedFrames_UpdateCount(&ring) == 4);
+		// -----------------------------------------
+		// 17-05 Restore into a larger ring keeps every frame and update number
+		RingedFrames_Push(frame, 8, 1799LL, &large);
+		assert(RingedFrames_Restore(image, RingedFrames_SnapshotSize(&ring), &large) == 3);
+		assert(RingedFrames_Count(&large) == 3);
+		assert(RingedFrames_UpdateCount(&large) == 4);
+		for (int32_t i = 0; i < 3; i++)
+		{
+			referer = RingedFrames_ReferWithOld(i, &length, &timestamp, &large);
+			assert(length == 3 + i);
+			assert(timestamp == 1701LL + i);
+			assert(referer[length - 1] == 0x71 + i);
+		}
+		assert(RingedFrames_ReadStable(3, dataBuffer, sizeof dataBuffer, &timestamp, &large) == 5);
+		assert(timestamp == 1703LL);
+		assert(RingedFrames_ReadStable(4, dataBuffer, sizeof dataBuffer, &timestamp, &large) == RF_READ_PENDING);
+		// -----------------------------------------
+		// 17-06 Restored ring continues as usual
+		RingedFrames_Push(frame, 8, 1704LL, &large);
+		assert(RingedFrames_Count(&large) == 4);
+		assert(RingedFrames_UpdateCount(&large) == 5);
+		referer = RingedFrames_ReferWithNew(0, &length, &timestamp, &large);
+		assert(timestamp == 1704LL);
+		// -----------------------------------------
+		// 17-07 Restore into a smaller ring keeps the newest, too long frames become empty
+		assert(RingedFrames_Restore(image, RingedFrames_SnapshotSize(&ring), &small) == 2);
+		assert(RingedFrames_Count(&small) == 2);
+		assert(RingedFrames_UpdateCount(&small) == 4);
+		referer = RingedFrames_ReferWithOld(0, &length, &timestamp, &small);
+		assert(length == 4);
+		assert(timestamp == 1702LL);
+		referer = RingedFrames_ReferWithOld(1, &length, &timestamp, &small);
+		assert(length == 0);
+		assert(timestamp == 1703LL);
+		// -----------------------------------------
+		// 17-08 Invalid snapshots do not change the ring
+		assert(RingedFrames_Restore(nullptr, sizeof image, &large) < 0);
+		assert(RingedFrames_Restore(image, RingedFrames_SnapshotSize(&ring) - 1, &large) < 0);
+		assert(RingedFrames_Restore(image, RF_SNAPSHOT_HEADER_SIZE - 1, &large) < 0);
+		image[0] = 0;
+		assert(RingedFrames_Restore(image, sizeof image, &large) < 0);
+		assert(RingedFrames_Count(&large) == 4);
+		assert(RingedFrames_UpdateCount(&large) == 5);
+		// -----------------------------------------
+		// 17-09 Restore into a ring of capacity 0 fails
+		{
+			int32_t zeroBuffer[2];
+			RingedFrames zero;
+			memset(zeroBuffer, 0x5a, sizeof zeroBuffer);
+			RingedFrames_Init(0, 8, &zeroBuffer[1], &zero);
+			int32_t imageSize = RingedFrames_Snapshot(image, sizeof image, &ring);
+			assert(imageSize > 0);
+			assert(RingedFrames_Restore(image, imageSize, &zero) < 0);
+			assert(RingedFrames_Count(&zero) == 0);
+			assert(RingedFrames_UpdateCount(&zero) == 0);
+			assert(zeroBuffer[0] == 0x5a5a5a5a);
+			assert(zeroBuffer[1] == 0x5a5a5a5a);
+		}
+		// -----------------------------------------
+		// 17-10 Snapshot fails when its size exceeds INT32_MAX
+		RingedFrames_Init(2, 4, &smallBuffer[1], &small);
+		RingedFrames_Push(frame, 4, 1710LL, &small);
+		RingedFrames_Push(frame, 4, 1711LL, &small);
+		for (int32_t i = 0; i < 2; i++)
+		{
+			// 巨大なフレームが蓄積されている状態を、長さだけ書き換えて作る
+			int32_t huge = INT32_MAX / 2;
+			memcpy(&small.Lengths[i * small.LengthStride], &huge, sizeof huge);
+		}
+		assert(RingedFrames_SnapshotSize(&small) < 0);
+		assert(RingedFrames_Snapshot(image, sizeof image, &small) < 0);
+		RingedFrames_Clear(&small);
+		assert(RingedFrames_SnapshotSize(&small) == RF_SNAPSHOT_HEADER_SIZE);
+
+		// Do not destroy memories
+		assert(largeBuffer[0] == -1);
+		assert(largeBuffer[((sizeof largeBuffer) / sizeof largeBuffer[0]) - 1] == -1);
+		assert(smallBuffer[0] == -1);
+		assert(smallBuffer[((sizeof smallBuffer) / sizeof smallBuffer[0]) - 1] == -1);
+	}
 
-	// Check
-	assert(RingedFrames_Count(&ring) == 0);
-	assert(RingedFrames_UpdateCount(&ring) != updateCount);
-	assert(length == 0);
-	assert(timestamp == 716LL);
+	// Do not destroy memories
+	assert(soaWords[1] == -1);
+	assert(soaWords[soaWordCount - 1] == -1);
+
+	// Do not destroy memories
+	assert(pow2Buffer[0] == -1);
+	assert(pow2Buffer[((sizeof pow2Buffer) / sizeof pow2Buffer[0]) - 1] == -1);
+	assert(buffer[0] == -1);
+	assert(buffer[((sizeof buffer) / sizeof buffer[0]) - 1] == -1);
 }
 #endif
@@ -0,0 +1,404 @@
+﻿/** ------------------------------------------------------------------
+*
+*	@file	SpscFrames.c
+*	@brief	Single-producer/single-consumer frame ring buffer
+*	@author	H.Someya
+*	@date	2026/10/17
+*
+MIT License
+
+Copyright (c) 2021 Hirobumi Someya
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*
+*/
+#include "SpscFrames.h"
+#include <string.h>
+#include <stdatomic.h>
+#include "nullptr.h"
+
+/* -------------------------------------------------------------------
+*	Privates
+*/
+/// <summary>
+/// <para>位置をacquireで読み出す。</para>
+/// <para>相手スレッドが書いた位置と、それ以前に書かれたフレームを観測できる。</para>
+/// </summary>
+static int64_t LoadAcquire(const int64_t* position)
+{
+	return atomic_load_explicit(
+		(const _Atomic int64_t*)position, memory_order_acquire);
+}
+/// <summary>
+/// <para>自スレッドが所有する位置を読み出す。</para>
+/// </summary>
+static int64_t LoadRelaxed(const int64_t* position)
+{
+	return atomic_load_explicit(
+		(const _Atomic int64_t*)position, memory_order_relaxed);
+}
+/// <summary>
+/// <para>位置をreleaseで書き込む。</para>
+/// <para>それ以前のフレームの読み書きを、相手スレッドに公開する。</para>
+/// </summary>
+static void StoreRelease(int64_t value, int64_t* position)
+{
+	atomic_store_explicit(
+		(_Atomic int64_t*)position, value, memory_order_release);
+}
+
+/// <summary>
+/// <para>位置に対応するフレームヘッダを取得する。</para>
+/// </summary>
+static uint8_t* HeaderAt(int64_t position, const SpscFrames* ctxt)
+{
+	int32_t fi = (int32_t)(position % ctxt->Capacity);
+	int32_t bi = RF_STRIDE_WORDS(ctxt->FrameSize) * fi;
+	return (uint8_t*)&ctxt->Buffer[bi];
+}
+
+/* -------------------------------------------------------------------
+*	Services
+*/
+
+/// <summary>
+/// <para>SPSCフレームリングバッファを初期化する。</para>
+/// <para>生産者、消費者のスレッドを開始する前に呼び出すこと。</para>
+/// </summary>
+/// <param name="capacity">最大蓄積可能フレーム数。</param>
+/// <param name="frameSize">最大フレームサイズ。</param>
+/// <param name="buffer">動作に必要なバッファ。
+/// SPSC_NEEDED_BUFFER_WORDS分の要素数を持つ領域を確保して指定すること。</param>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>なし。</returns>
+void SpscFrames_Init(
+	int32_t capacity, int32_t frameSize,
+	int32_t* buffer,
+	SpscFrames* ctxt)
+{
+	if (ctxt != nullptr)
+	{
+		memset(ctxt, 0, sizeof(SpscFrames));
+		ctxt->Capacity = capacity;
+		ctxt->FrameSize = frameSize;
+		ctxt->Buffer = buffer;
+	}
+}
+
+/// <summary>
+/// <para>現在のフレーム蓄積数を取得する。</para>
+/// <para>別スレッドから操作中の場合は、取得した時点の概算となる。</para>
+/// </summary>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>現在のフレーム蓄積数。</returns>
+int32_t SpscFrames_Count(
+	const SpscFrames* ctxt)
+{
+	int32_t result = 0;
+	if (ctxt != nullptr)
+	{
+		// Tailを先に読むことで、Head - Tailが負にならないようにする
+		int64_t tail = LoadAcquire(&ctxt->Tail);
+		int64_t head = LoadAcquire(&ctxt->Head);
+		result = (int32_t)(head - tail);
+	}
+	return result;
+}
+
+/// <summary>
+/// <para>最大蓄積可能フレーム数を取得する。</para>
+/// </summary>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>最大蓄積可能フレーム数。</returns>
+int32_t SpscFrames_Capacity(
+	const SpscFrames* ctxt)
+{
+	int32_t result = 0;
+	if (ctxt != nullptr)
+	{
+		result = ctxt->Capacity;
+	}
+	return result;
+}
+
+/// <summary>
+/// <para>最大フレームサイズを取得する。</para>
+/// </summary>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>最大フレームサイズ。</returns>
+int32_t SpscFrames_FrameSize(
+	const SpscFrames* ctxt)
+{
+	int32_t result = 0;
+	if (ctxt != nullptr)
+	{
+		result = ctxt->FrameSize;
+	}
+	return result;
+}
+
+/// <summary>
+/// <para>フレームをPushする。生産者スレッドからのみ呼び出すこと。</para>
+/// <para>消費者が読み出し中のフレームを壊さないよう、最古を上書きせず失敗する。</para>
+/// <para>フレームが無効(null、長さ不正)の場合は、長さ0で記録する。</para>
+/// </summary>
+/// <param name="frame">フレーム。</param>
+/// <param name="length">フレームの長さ。</param>
+/// <param name="timestamp">タイムスタンプ。</param>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>0:満杯で失敗、非0:成功。</returns>
+int SpscFrames_Push(
+	const void* frame, int32_t length,
+	int64_t timestamp,
+	SpscFrames* ctxt)
+{
+	int result = 0;
+	if ((ctxt != nullptr) &&
+		(ctxt->Capacity > 0))
+	{
+		// 書き込み位置は自分しか更新しない
+		int64_t head = LoadRelaxed(&ctxt->Head);
+
+		// 満杯判定は、まずキャッシュした読み出し位置で行う
+		if (head - ctxt->CachedTail >= ctxt->Capacity)
+		{
+			// 満杯に見える場合だけ、消費者の位置を読み直す
+			ctxt->CachedTail = LoadAcquire(&ctxt->Tail);
+		}
+
+		if (head - ctxt->CachedTail < ctxt->Capacity)
+		{
+			// ヘッダを記録
+			uint8_t* header = HeaderAt(head, ctxt);
+			memset(header, 0, RF_FRAME_HEADER_SIZE);
+			// 0～7バイト目にタイムスタンプを記録
+			int64_t* tsp = (int64_t*)&header[0];
+			*tsp = timestamp;
+			// 8～11バイト目に長さを記録
+			int32_t* lenp = (int32_t*)&header[sizeof(int64_t)];
+			*lenp = length;
+
+			// フレームを記録
+			uint8_t* fp = &header[RF_FRAME_HEADER_SIZE];
+			if ((frame != nullptr) &&
+				(0 < length) && (length <= ctxt->FrameSize))
+			{
+				memcpy(fp, frame, (size_t)length);
+			}
+			else
+			{
+				// フレームが記録されない場合は長さを0にする
+				*lenp = 0;
+			}
+
+			// 書き込んだフレームを消費者に公開
+			StoreRelease(head + 1, &ctxt->Head);
+
+			result = 1;
+		}
+	}
+	return result;
+}
+
+/// <summary>
+/// <para>最古のフレームをPopする。消費者スレッドからのみ呼び出すこと。</para>
+/// <para>フレームが無い場合は負を返す。</para>
+/// <para>格納先が足りない場合は、格納できる分だけ返す。</para>
+/// </summary>
+/// <param name="buffer">フレームの格納先バッファ。</param>
+/// <param name="bufferSize">フレーム格納先バッファのサイズ。</param>
+/// <param name="timestamp">タイムスタンプの格納先。</param>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>フレーム長。</returns>
+int32_t SpscFrames_Pop(
+	void* buffer, int32_t bufferSize,
+	int64_t* timestamp,
+	SpscFrames* ctxt)
+{
+	// 結果を初期化
+	int32_t length = -1;
+	if (timestamp != nullptr)
+	{
+		*timestamp = 0LL;
+	}
+
+	if (ctxt != nullptr)
+	{
+		// 読み出し位置は自分しか更新しない
+		int64_t tail = LoadRelaxed(&ctxt->Tail);
+
+		// 空判定は、まずキャッシュした書き込み位置で行う
+		if (tail >= ctxt->CachedHead)
+		{
+			// 空に見える場合だけ、生産者の位置を読み直す
+			ctxt->CachedHead = LoadAcquire(&ctxt->Head);
+		}
+
+		if (tail < ctxt->CachedHead)
+		{
+			// ヘッダを取得
+			const uint8_t* header = HeaderAt(tail, ctxt);
+			// 0～7バイト目にタイムスタンプが記録されている
+			if (timestamp != nullptr)
+			{
+				const int64_t* tsp = (const int64_t*)&header[0];
+				*timestamp = *tsp;
+			}
+			// 8～11バイト目に長さが記録されている
+			const int32_t* lenp = (const int32_t*)&header[sizeof(int64_t)];
+			length = *lenp;
+			if (length > bufferSize)
+			{
+				length = bufferSize;
+			}
+
+			// フレームを報告
+			if ((buffer != nullptr) &&
+				(length > 0))
+			{
+				memcpy(buffer, &header[RF_FRAME_HEADER_SIZE], (size_t)length);
+			}
+
+			// 読み終えたスロットを生産者に返す
+			StoreRelease(tail + 1, &ctxt->Tail);
+		}
+	}
+
+	return length;
+}
+
+/* -------------------------------------------------------------------
+*	Unit Test
+*/
+#ifdef _UNIT_TEST
+#include "Assertions.h"
+
+void SpscFrames_UnitTest(void)
+{
+	Assertions* assertions = Assertions_Instance();
+	SpscFrames ring;
+	int32_t buffer[1 + SPSC_NEEDED_BUFFER_WORDS(3, 8) + 1];
+	uint8_t frame[8];
+	uint8_t dataBuffer[8];
+	int32_t length;
+	int64_t timestamp;
+	int pushed;
+
+	// -----------------------------------------
+	// 1-1 Init(ctxt==nullptr)
+	SpscFrames_Init(3, 8, &buffer[1], nullptr);
+	// -----------------------------------------
+	// 1-2 Init
+	memset(buffer, -1, sizeof buffer);
+	SpscFrames_Init(3, 8, &buffer[1], &ring);
+	Assertions_Assert(SpscFrames_Count(&ring) == 0, assertions);
+	Assertions_Assert(SpscFrames_Capacity(&ring) == 3, assertions);
+	Assertions_Assert(SpscFrames_FrameSize(&ring) == 8, assertions);
+	// -----------------------------------------
+	// 1-3 Head and Tail are on different cache lines
+	Assertions_Assert(
+		(uintptr_t)&ring.Tail - (uintptr_t)&ring.Head >= SPSC_CACHE_LINE_SIZE,
+		assertions);
+
+	// -----------------------------------------
+	// 2-1 Count, Capacity, FrameSize(ctxt==nullptr)
+	Assertions_Assert(SpscFrames_Count(nullptr) == 0, assertions);
+	Assertions_Assert(SpscFrames_Capacity(nullptr) == 0, assertions);
+	Assertions_Assert(SpscFrames_FrameSize(nullptr) == 0, assertions);
+
+	// -----------------------------------------
+	// 3-1 Pop empty
+	length = SpscFrames_Pop(dataBuffer, sizeof dataBuffer, &timestamp, &ring);
+	Assertions_Assert(length < 0, assertions);
+	Assertions_Assert(timestamp == 0LL, assertions);
+	// -----------------------------------------
+	// 3-2 Push(ctxt==nullptr)
+	pushed = SpscFrames_Push(frame, 8, 32LL, nullptr);
+	Assertions_Assert(pushed == 0, assertions);
+	// -----------------------------------------
+	// 3-3 Push until full
+	for (int32_t i = 0; i < 3; i++)
+	{
+		memset(frame, 0, sizeof frame);
+		frame[0] = 3;
+		frame[7] = (uint8_t)i;
+		pushed = SpscFrames_Push(frame, 8, 330LL + i, &ring);
+		Assertions_Assert(pushed != 0, assertions);
+	}
+	Assertions_Assert(SpscFrames_Count(&ring) == 3, assertions);
+	// -----------------------------------------
+	// 3-4 Push full, oldest is not overwritten
+	pushed = SpscFrames_Push(frame, 8, 34LL, &ring);
+	Assertions_Assert(pushed == 0, assertions);
+	Assertions_Assert(SpscFrames_Count(&ring) == 3, assertions);
+	// -----------------------------------------
+	// 3-5 Pop oldest
+	length = SpscFrames_Pop(dataBuffer, sizeof dataBuffer, &timestamp, &ring);
+	Assertions_Assert(length == 8, assertions);
+	Assertions_Assert(timestamp == 330LL, assertions);
+	Assertions_Assert(dataBuffer[0] == 3, assertions);
+	Assertions_Assert(dataBuffer[7] == 0, assertions);
+	Assertions_Assert(SpscFrames_Count(&ring) == 2, assertions);
+	// -----------------------------------------
+	// 3-6 Push after Pop, wraps around
+	memset(frame, 0, sizeof frame);
+	frame[0] = 3;
+	frame[5] = 6;
+	pushed = SpscFrames_Push(frame, 6, 36LL, &ring);
+	Assertions_Assert(pushed != 0, assertions);
+	Assertions_Assert(SpscFrames_Count(&ring) == 3, assertions);
+	// -----------------------------------------
+	// 3-7 Pop but not enough buffer
+	length = SpscFrames_Pop(dataBuffer, 4, &timestamp, &ring);
+	Assertions_Assert(length == 4, assertions);
+	Assertions_Assert(timestamp == 331LL, assertions);
+	// -----------------------------------------
+	// 3-8 Pop without buffer and timestamp
+	length = SpscFrames_Pop(nullptr, 0, nullptr, &ring);
+	Assertions_Assert(length == 0, assertions);
+	// -----------------------------------------
+	// 3-9 Pop wrapped frame
+	length = SpscFrames_Pop(dataBuffer, sizeof dataBuffer, &timestamp, &ring);
+	Assertions_Assert(length == 6, assertions);
+	Assertions_Assert(timestamp == 36LL, assertions);
+	Assertions_Assert(dataBuffer[0] == 3, assertions);
+	Assertions_Assert(dataBuffer[5] == 6, assertions);
+	Assertions_Assert(SpscFrames_Count(&ring) == 0, assertions);
+
+	// -----------------------------------------
+	// 4-1 Push oversized frame is recorded as zero length
+	pushed = SpscFrames_Push(frame, 9, 41LL, &ring);
+	Assertions_Assert(pushed != 0, assertions);
+	length = SpscFrames_Pop(dataBuffer, sizeof dataBuffer, &timestamp, &ring);
+	Assertions_Assert(length == 0, assertions);
+	Assertions_Assert(timestamp == 41LL, assertions);
+	// -----------------------------------------
+	// 4-2 Push null frame is recorded as zero length
+	pushed = SpscFrames_Push(nullptr, 8, 42LL, &ring);
+	Assertions_Assert(pushed != 0, assertions);
+	length = SpscFrames_Pop(dataBuffer, sizeof dataBuffer, &timestamp, &ring);
+	Assertions_Assert(length == 0, assertions);
+	Assertions_Assert(timestamp == 42LL, assertions);
+
+	// Do not destroy memories
+	Assertions_Assert(buffer[0] == -1, assertions);
+	Assertions_Assert(
+		buffer[((sizeof buffer) / sizeof buffer[0]) - 1] == -1, assertions);
+}
+#endif
@@ -0,0 +1,449 @@
+﻿/** ------------------------------------------------------------------
+*
+*	@file	WindowedAggregates.c
+*	@brief	Incremental sum, count, min and max over a sliding window
+*	@author	H.Someya
+*	@date	2026/10/17
+*
+MIT License
+
+Copyright (c) 2021 Hirobumi Someya
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*
+*/
+#include "WindowedAggregates.h"
+#include <string.h>
+#include "nullptr.h"
+
+/* -------------------------------------------------------------------
+*	Privates
+*/
+/// <summary>
+/// <para>番号に対応する、履歴や候補列上の位置を取得する。</para>
+/// </summary>
+static int32_t SlotOf(int64_t number, const WindowedAggregates* ctxt)
+{
+	return (int32_t)(number % ctxt->Capacity);
+}
+
+/// <summary>
+/// <para>窓の最古の値を取り除く。</para>
+/// <para>候補列の先頭がその値であれば、候補列からも取り除く。</para>
+/// </summary>
+static void RemoveOldest(WindowedAggregates* ctxt)
+{
+	int64_t number = ctxt->Tail;
+	ctxt->Sum -= ctxt->Values[SlotOf(number, ctxt)];
+	if ((ctxt->MinFront < ctxt->MinBack) &&
+		(ctxt->MinQueue[SlotOf(ctxt->MinFront, ctxt)] == number))
+	{
+		ctxt->MinFront += 1;
+	}
+	if ((ctxt->MaxFront < ctxt->MaxBack) &&
+		(ctxt->MaxQueue[SlotOf(ctxt->MaxFront, ctxt)] == number))
+	{
+		ctxt->MaxFront += 1;
+	}
+	ctxt->Tail += 1;
+}
+
+/// <summary>
+/// <para>候補列の位置にある値を取得する。</para>
+/// </summary>
+static int64_t QueuedValue(const int64_t* queue, int64_t position, const WindowedAggregates* ctxt)
+{
+	return ctxt->Values[SlotOf(queue[SlotOf(position, ctxt)], ctxt)];
+}
+
+/* -------------------------------------------------------------------
+*	Services
+*/
+
+/// <summary>
+/// <para>窓集計を初期化する。</para>
+/// </summary>
+/// <param name="capacity">窓に含められる最大の値の数。</param>
+/// <param name="timeSpan">窓の時間幅。最新のタイムスタンプからtimeSpan未満の値を窓に含める。
+/// 0以下の場合は、直近のcapacity個を窓とする。</param>
+/// <param name="buffer">動作に必要なバッファ。
+/// WA_NEEDED_BUFFER_WORDS分の要素数を持つ、8バイト境界の領域を確保して指定すること。</param>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>なし。</returns>
+void WindowedAggregates_Init(
+	int32_t capacity,
+	int64_t timeSpan,
+	int32_t* buffer,
+	WindowedAggregates* ctxt)
+{
+	if (ctxt != nullptr)
+	{
+		memset(ctxt, 0, sizeof(WindowedAggregates));
+		ctxt->Capacity = capacity;
+		ctxt->TimeSpan = timeSpan;
+		if ((buffer != nullptr) &&
+			(capacity > 0))
+		{
+			// タイムスタンプ、値、最小値候補列、最大値候補列の順に配置する
+			int64_t* words = (int64_t*)buffer;
+			ctxt->Timestamps = &words[0];
+			ctxt->Values = &words[capacity];
+			ctxt->MinQueue = &words[2 * capacity];
+			ctxt->MaxQueue = &words[3 * capacity];
+		}
+	}
+}
+
+/// <summary>
+/// <para>クリアする。</para>
+/// </summary>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>なし。</returns>
+void WindowedAggregates_Clear(
+	WindowedAggregates* ctxt)
+{
+	if (ctxt != nullptr)
+	{
+		ctxt->Head = 0;
+		ctxt->Tail = 0;
+		ctxt->Sum = 0;
+		ctxt->MinFront = 0;
+		ctxt->MinBack = 0;
+		ctxt->MaxFront = 0;
+		ctxt->MaxBack = 0;
+	}
+}
+
+/// <summary>
+/// <para>値をPushする。</para>
+/// <para>窓から外れた値は、古い方から取り除く。</para>
+/// <para>時間幅を指定した場合、タイムスタンプは単調増加していること。</para>
+/// </summary>
+/// <param name="value">値。</param>
+/// <param name="timestamp">タイムスタンプ。</param>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>なし。</returns>
+void WindowedAggregates_Push(
+	int64_t value,
+	int64_t timestamp,
+	WindowedAggregates* ctxt)
+{
+	if ((ctxt != nullptr) &&
+		(ctxt->Values != nullptr))
+	{
+		// 満杯の場合は、最古を先に取り除く(候補列も空きができる)
+		if (ctxt->Head - ctxt->Tail >= ctxt->Capacity)
+		{
+			RemoveOldest(ctxt);
+		}
+
+		// 履歴に追加
+		int32_t si = SlotOf(ctxt->Head, ctxt);
+		ctxt->Timestamps[si] = timestamp;
+		ctxt->Values[si] = value;
+		ctxt->Sum += value;
+
+		// 新しい値以上の候補は、新しい値より先に窓から外れるので最小値になり得ない
+		while ((ctxt->MinFront < ctxt->MinBack) &&
+			(QueuedValue(ctxt->MinQueue, ctxt->MinBack - 1, ctxt) >= value))
+		{
+			ctxt->MinBack -= 1;
+		}
+		ctxt->MinQueue[SlotOf(ctxt->MinBack, ctxt)] = ctxt->Head;
+		ctxt->MinBack += 1;
+
+		// 同様に、新しい値以下の候補は最大値になり得ない
+		while ((ctxt->MaxFront < ctxt->MaxBack) &&
+			(QueuedValue(ctxt->MaxQueue, ctxt->MaxBack - 1, ctxt) <= value))
+		{
+			ctxt->MaxBack -= 1;
+		}
+		ctxt->MaxQueue[SlotOf(ctxt->MaxBack, ctxt)] = ctxt->Head;
+		ctxt->MaxBack += 1;
+
+		ctxt->Head += 1;
+
+		// 時間幅から外れた値を取り除く
+		WindowedAggregates_Expire(timestamp, ctxt);
+	}
+}
+
+/// <summary>
+/// <para>指定時刻で、時間幅から外れた値を取り除く。</para>
+/// <para>Pushが無い間も窓を進めるために使用する。時間幅を指定していない場合は何もしない。</para>
+/// </summary>
+/// <param name="now">現在時刻(タイムスタンプと同じ単位)。</param>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>なし。</returns>
+void WindowedAggregates_Expire(
+	int64_t now,
+	WindowedAggregates* ctxt)
+{
+	if ((ctxt != nullptr) &&
+		(ctxt->TimeSpan > 0))
+	{
+		while ((ctxt->Tail < ctxt->Head) &&
+			(now - ctxt->Timestamps[SlotOf(ctxt->Tail, ctxt)] >= ctxt->TimeSpan))
+		{
+			RemoveOldest(ctxt);
+		}
+	}
+}
+
+/// <summary>
+/// <para>窓の値の数を取得する。</para>
+/// </summary>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>窓の値の数。</returns>
+int32_t WindowedAggregates_Count(
+	const WindowedAggregates* ctxt)
+{
+	int32_t result = 0;
+	if (ctxt != nullptr)
+	{
+		result = (int32_t)(ctxt->Head - ctxt->Tail);
+	}
+	return result;
+}
+
+/// <summary>
+/// <para>窓の値の合計を取得する。</para>
+/// </summary>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>窓の値の合計。値が無い場合は0。</returns>
+int64_t WindowedAggregates_Sum(
+	const WindowedAggregates* ctxt)
+{
+	int64_t result = 0;
+	if (ctxt != nullptr)
+	{
+		result = ctxt->Sum;
+	}
+	return result;
+}
+
+/// <summary>
+/// <para>窓の値の最小値を取得する。</para>
+/// </summary>
+/// <param name="value">最小値の格納先。</param>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>0:値なし、非0:取得した。</returns>
+int WindowedAggregates_Min(
+	int64_t* value,
+	const WindowedAggregates* ctxt)
+{
+	int result = 0;
+	if ((ctxt != nullptr) &&
+		(ctxt->MinFront < ctxt->MinBack))
+	{
+		if (value != nullptr)
+		{
+			*value = QueuedValue(ctxt->MinQueue, ctxt->MinFront, ctxt);
+		}
+		result = 1;
+	}
+	return result;
+}
+
+/// <summary>
+/// <para>窓の値の最大値を取得する。</para>
+/// </summary>
+/// <param name="value">最大値の格納先。</param>
+/// <param name="ctxt">コンテキスト。</param>
+/// <returns>0:値なし、非0:取得した。</returns>
+int WindowedAggregates_Max(
+	int64_t* value,
+	const WindowedAggregates* ctxt)
+{
+	int result = 0;
+	if ((ctxt != nullptr) &&
+		(ctxt->MaxFront < ctxt->MaxBack))
+	{
+		if (value != nullptr)
+		{
+			*value = QueuedValue(ctxt->MaxQueue, ctxt->MaxFront, ctxt);
+		}
+		result = 1;
+	}
+	return result;
+}
+
+/* -------------------------------------------------------------------
+*	Unit Test
+*/
+#ifdef _UNIT_TEST
+#include "Assertions.h"
+
+/// <summary>
+/// <para>窓集計の結果を、窓の値を全て走査した結果と比べる。</para>
+/// </summary>
+static int MatchesScan(
+	const int64_t* values, const int64_t* timestamps, int32_t pushed,
+	int32_t capacity, int64_t timeSpan, int64_t now,
+	const WindowedAggregates* aggregates)
+{
+	int32_t count = 0;
+	int64_t sum = 0;
+	int64_t minValue = 0;
+	int64_t maxValue = 0;
+	for (int32_t i = pushed - 1; (i >= 0) && (count < capacity); i--)
+	{
+		if ((timeSpan > 0) && (now - timestamps[i] >= timeSpan))
+		{
+			break;
+		}
+		if ((count == 0) || (values[i] < minValue))
+		{
+			minValue = values[i];
+		}
+		if ((count == 0) || (values[i] > maxValue))
+		{
+			maxValue = values[i];
+		}
+		sum += values[i];
+		count += 1;
+	}
+
+	int64_t actualMin = -1;
+	int64_t actualMax = -1;
+	int hasMin = WindowedAggregates_Min(&actualMin, aggregates);
+	int hasMax = WindowedAggregates_Max(&actualMax, aggregates);
+	return (WindowedAggregates_Count(aggregates) == count) &&
+		(WindowedAggregates_Sum(aggregates) == sum) &&
+		((hasMin != 0) == (count > 0)) &&
+		((hasMax != 0) == (count > 0)) &&
+		((count == 0) || ((actualMin == minValue) && (actualMax == maxValue)));
+}
+
+void WindowedAggregates_UnitTest(void)
+{
+	Assertions* assertions = Assertions_Instance();
+	WindowedAggregates aggregates;
+	int64_t buffer[(2 + WA_NEEDED_BUFFER_WORDS(16) + 1) / 2 + 1];
+	int32_t* words = (int32_t*)buffer;
+	int32_t wordCount = (int32_t)(sizeof buffer) / (int32_t)sizeof(int32_t);
+	int64_t values[200];
+	int64_t timestamps[200];
+	int64_t value;
+	uint32_t random = 12345u;
+
+	// -----------------------------------------
+	// 1-1 Init(ctxt==nullptr)
+	WindowedAggregates_Init(5, 0, &words[2], nullptr);
+	// -----------------------------------------
+	// 1-2 Init
+	memset(buffer, -1, sizeof buffer);
+	WindowedAggregates_Init(5, 0, &words[2], &aggregates);
+	Assertions_Assert(WindowedAggregates_Count(&aggregates) == 0, assertions);
+	Assertions_Assert(WindowedAggregates_Sum(&aggregates) == 0, assertions);
+	Assertions_Assert(WindowedAggregates_Min(&value, &aggregates) == 0, assertions);
+	Assertions_Assert(WindowedAggregates_Max(&value, &aggregates) == 0, assertions);
+	// -----------------------------------------
+	// 1-3 Functions(ctxt==nullptr)
+	WindowedAggregates_Push(1, 1, nullptr);
+	WindowedAggregates_Expire(1, nullptr);
+	WindowedAggregates_Clear(nullptr);
+	Assertions_Assert(WindowedAggregates_Count(nullptr) == 0, assertions);
+	Assertions_Assert(WindowedAggregates_Sum(nullptr) == 0, assertions);
+	Assertions_Assert(WindowedAggregates_Min(&value, nullptr) == 0, assertions);
+	Assertions_Assert(WindowedAggregates_Max(&value, nullptr) == 0, assertions);
+
+	// -----------------------------------------
+	// 2-1 Last N values
+	WindowedAggregates_Push(5, 0, &aggregates);
+	WindowedAggregates_Push(3, 0, &aggregates);
+	WindowedAggregates_Push(8, 0, &aggregates);
+	Assertions_Assert(WindowedAggregates_Count(&aggregates) == 3, assertions);
+	Assertions_Assert(WindowedAggregates_Sum(&aggregates) == 16, assertions);
+	Assertions_Assert((WindowedAggregates_Min(&value, &aggregates) != 0) && (value == 3), assertions);
+	Assertions_Assert((WindowedAggregates_Max(&value, &aggregates) != 0) && (value == 8), assertions);
+	// -----------------------------------------
+	// 2-2 Oldest values leave the window
+	WindowedAggregates_Push(4, 0, &aggregates);
+	WindowedAggregates_Push(9, 0, &aggregates);
+	WindowedAggregates_Push(6, 0, &aggregates);
+	WindowedAggregates_Push(7, 0, &aggregates);
+	Assertions_Assert(WindowedAggregates_Count(&aggregates) == 5, assertions);
+	Assertions_Assert(WindowedAggregates_Sum(&aggregates) == 8 + 4 + 9 + 6 + 7, assertions);
+	Assertions_Assert((WindowedAggregates_Min(&value, &aggregates) != 0) && (value == 4), assertions);
+	Assertions_Assert((WindowedAggregates_Max(&value, &aggregates) != 0) && (value == 9), assertions);
+	// -----------------------------------------
+	// 2-3 Expire does nothing without time span
+	WindowedAggregates_Expire(1000, &aggregates);
+	Assertions_Assert(WindowedAggregates_Count(&aggregates) == 5, assertions);
+	// -----------------------------------------
+	// 2-4 Clear
+	WindowedAggregates_Clear(&aggregates);
+	Assertions_Assert(WindowedAggregates_Count(&aggregates) == 0, assertions);
+	Assertions_Assert(WindowedAggregates_Sum(&aggregates) == 0, assertions);
+	Assertions_Assert(WindowedAggregates_Min(&value, &aggregates) == 0, assertions);
+	// -----------------------------------------
+	// 2-5 Compare with scanning, last N values
+	for (int32_t i = 0; i < 200; i++)
+	{
+		random = random * 1103515245u + 12345u;
+		values[i] = (int64_t)((random >> 16) % 100) - 50;
+		timestamps[i] = i;
+		WindowedAggregates_Push(values[i], timestamps[i], &aggregates);
+		Assertions_Assert(
+			MatchesScan(values, timestamps, i + 1, 5, 0, timestamps[i], &aggregates),
+			assertions);
+	}
+
+	// -----------------------------------------
+	// 3-1 Last T time units
+	WindowedAggregates_Init(16, 10, &words[2], &aggregates);
+	WindowedAggregates_Push(5, 100, &aggregates);
+	WindowedAggregates_Push(1, 105, &aggregates);
+	WindowedAggregates_Push(7, 109, &aggregates);
+	Assertions_Assert(WindowedAggregates_Count(&aggregates) == 3, assertions);
+	WindowedAggregates_Push(3, 110, &aggregates);
+	Assertions_Assert(WindowedAggregates_Count(&aggregates) == 3, assertions);
+	Assertions_Assert(WindowedAggregates_Sum(&aggregates) == 11, assertions);
+	Assertions_Assert((WindowedAggregates_Min(&value, &aggregates) != 0) && (value == 1), assertions);
+	// -----------------------------------------
+	// 3-2 Expire without Push
+	WindowedAggregates_Expire(115, &aggregates);
+	Assertions_Assert(WindowedAggregates_Count(&aggregates) == 2, assertions);
+	Assertions_Assert((WindowedAggregates_Min(&value, &aggregates) != 0) && (value == 3), assertions);
+	Assertions_Assert((WindowedAggregates_Max(&value, &aggregates) != 0) && (value == 7), assertions);
+	WindowedAggregates_Expire(200, &aggregates);
+	Assertions_Assert(WindowedAggregates_Count(&aggregates) == 0, assertions);
+	Assertions_Assert(WindowedAggregates_Sum(&aggregates) == 0, assertions);
+	Assertions_Assert(WindowedAggregates_Max(&value, &aggregates) == 0, assertions);
+	// -----------------------------------------
+	// 3-3 Compare with scanning, last T time units bounded by capacity
+	WindowedAggregates_Clear(&aggregates);
+	for (int32_t i = 0; i < 200; i++)
+	{
+		random = random * 1103515245u + 12345u;
+		values[i] = (int64_t)((random >> 16) % 1000);
+		timestamps[i] = ((i > 0) ? timestamps[i - 1] : 0) + (int64_t)((random >> 8) % 3);
+		WindowedAggregates_Push(values[i], timestamps[i], &aggregates);
+		Assertions_Assert(
+			MatchesScan(values, timestamps, i + 1, 16, 10, timestamps[i], &aggregates),
+			assertions);
+	}
+
+	// Do not destroy memories
+	Assertions_Assert(words[1] == -1, assertions);
+	Assertions_Assert(words[2 + WA_NEEDED_BUFFER_WORDS(16)] == -1, assertions);
+	Assertions_Assert(words[wordCount - 1] == -1, assertions);
+}
+#endif